@@ -0,0 +1,90 @@
+#include <steem/chain/account_balance_buffer.hpp>
+#include <steem/chain/database.hpp>
+
+namespace steem { namespace chain {
+
+void account_balance_buffer::add_balance( const account_object& a, const asset& delta )
+{
+   FC_ASSERT( delta.amount >= 0, "Only additions are buffered" );
+
+   if( delta.symbol == STEEM_SYMBOL )
+      deltas( a ).balance += delta;
+   else if( delta.symbol == VESTS_SYMBOL )
+      deltas( a ).vesting_shares += delta;
+   else
+      FC_ASSERT( false, "invalid symbol" );
+}
+
+void account_balance_buffer::add_reward_balance( const account_object& a, const asset& value_delta, const asset& share_delta )
+{
+   FC_ASSERT( value_delta.amount >= 0 && share_delta.amount >= 0, "Only additions are buffered" );
+
+   auto& d = deltas( a );
+
+   if( value_delta.symbol == STEEM_SYMBOL )
+   {
+      if( share_delta.amount.value == 0 )
+      {
+         d.reward_steem_balance += value_delta;
+      }
+      else
+      {
+         d.reward_vesting_steem += value_delta;
+         d.reward_vesting_balance += share_delta;
+      }
+   }
+   else if( value_delta.symbol == SBD_SYMBOL )
+   {
+      FC_ASSERT( share_delta.amount.value == 0 );
+      d.reward_sbd_balance += value_delta;
+   }
+   else
+   {
+      FC_ASSERT( false, "invalid symbol" );
+   }
+}
+
+void account_balance_buffer::add_curation_rewards( const account_object& a, share_type delta )
+{
+   deltas( a ).curation_rewards += delta;
+}
+
+void account_balance_buffer::add_posting_rewards( const account_object& a, share_type delta )
+{
+   deltas( a ).posting_rewards += delta;
+}
+
+void account_balance_buffer::flush( database& db, const account_object& a )
+{
+   auto itr = _deltas.find( a.id );
+   if( itr == _deltas.end() )
+      return;
+
+   apply( db, a, itr->second );
+   _deltas.erase( itr );
+}
+
+void account_balance_buffer::flush( database& db )
+{
+   for( const auto& entry : _deltas )
+      apply( db, db.get< account_object >( entry.first ), entry.second );
+
+   _deltas.clear();
+}
+
+void account_balance_buffer::apply( database& db, const account_object& a, const account_deltas& d )
+{
+   db.modify( a, [&]( account_object& acnt )
+   {
+      acnt.balance += d.balance;
+      acnt.vesting_shares += d.vesting_shares;
+      acnt.reward_steem_balance += d.reward_steem_balance;
+      acnt.reward_sbd_balance += d.reward_sbd_balance;
+      acnt.reward_vesting_balance += d.reward_vesting_balance;
+      acnt.reward_vesting_steem += d.reward_vesting_steem;
+      acnt.curation_rewards += d.curation_rewards;
+      acnt.posting_rewards += d.posting_rewards;
+   });
+}
+
+} } // steem::chain
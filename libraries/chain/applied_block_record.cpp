@@ -0,0 +1,102 @@
+#include <steem/chain/applied_block_record.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+namespace steem { namespace chain {
+
+async_block_subscription::async_block_subscription( const std::string& name, const async_block_handler_t& handler, size_t max_queue_size )
+   : _name( name ), _handler( handler ), _max_queue_size( std::max< size_t >( max_queue_size, 1 ) ), _last_block_num( 0 )
+{
+   _thread.reset( new boost::thread( [this]() { thread_main(); } ) );
+}
+
+async_block_subscription::~async_block_subscription()
+{
+   stop();
+}
+
+void async_block_subscription::push( const applied_block_record_ptr& record )
+{
+   boost::unique_lock< boost::mutex > lock( _mutex );
+   FC_ASSERT( !_stop, "Subscription ${n} is stopped", ("n", _name) );
+
+   while( _queue.size() >= _max_queue_size )
+      _cond.wait( lock );
+
+   _queue.push_back( record );
+   _cond.notify_all();
+}
+
+void async_block_subscription::wait()
+{
+   boost::unique_lock< boost::mutex > lock( _mutex );
+
+   while( _queue.size() || _busy )
+      _cond.wait( lock );
+}
+
+void async_block_subscription::stop()
+{
+   if( !_thread ) return;
+
+   {
+      boost::unique_lock< boost::mutex > lock( _mutex );
+      _stop = true;
+      _cond.notify_all();
+   }
+
+   _thread->join();
+   _thread.reset();
+}
+
+size_t async_block_subscription::queued_blocks()const
+{
+   boost::unique_lock< boost::mutex > lock( _mutex );
+   return _queue.size() + ( _busy ? 1 : 0 );
+}
+
+void async_block_subscription::thread_main()
+{
+   while( true )
+   {
+      applied_block_record_ptr record;
+
+      {
+         boost::unique_lock< boost::mutex > lock( _mutex );
+
+         while( _queue.empty() && !_stop )
+            _cond.wait( lock );
+
+         // Remaining records are handled before stopping so that the plugin matches the chain state
+         if( _queue.empty() )
+            break;
+
+         record = _queue.front();
+         _queue.pop_front();
+         _busy = true;
+         _cond.notify_all();
+      }
+
+      try
+      {
+         _handler( record );
+      }
+      catch( const fc::exception& e )
+      {
+         elog( "${n} failed to handle block ${b}: ${e}", ("n", _name)("b", record->block_num)("e", e.to_detail_string()) );
+      }
+      catch( const std::exception& e )
+      {
+         elog( "${n} failed to handle block ${b}: ${e}", ("n", _name)("b", record->block_num)("e", e.what()) );
+      }
+
+      _last_block_num = record->block_num;
+
+      boost::unique_lock< boost::mutex > lock( _mutex );
+      _busy = false;
+      _cond.notify_all();
+   }
+}
+
+} } // steem::chain
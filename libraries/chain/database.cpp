@@ -1,4 +1,5 @@
 #include <steem/protocol/steem_operations.hpp>
+#include <steem/protocol/transaction_util.hpp>
 
 #include <steem/chain/block_summary_object.hpp>
 #include <steem/chain/compound.hpp>
@@ -358,14 +359,21 @@ optional<signed_block> database::fetch_block_by_number( uint32_t block_num )cons
 
 const signed_transaction database::get_recent_transaction( const transaction_id_type& trx_id ) const
 { try {
-   auto& index = get_index<transaction_index>().indices().get<by_trx_id>();
-   auto itr = index.find(trx_id);
-   FC_ASSERT(itr != index.end());
-   signed_transaction trx;
-   fc::raw::unpack_from_buffer( itr->packed_trx, trx );
-   return trx;;
+   const signed_transaction* trx = _recent_tx_cache.find( trx_id );
+   FC_ASSERT( trx != nullptr );
+   return *trx;
 } FC_CAPTURE_AND_RETHROW() }
 
+void database::add_validated_transaction( const transaction_id_type& trx_id, const signed_transaction& trx, flat_set< public_key_type > signature_keys )
+{
+   _validated_tx_cache.insert( trx_id, trx, std::move( signature_keys ) );
+}
+
+void database::remove_validated_transaction( const transaction_id_type& trx_id )
+{
+   _validated_tx_cache.remove( trx_id );
+}
+
 std::vector< block_id_type > database::get_block_ids_on_fork( block_id_type head_of_fork ) const
 { try {
    pair<fork_database::branch_type, fork_database::branch_type> branches = _fork_db.fetch_branch_from(head_block_id(), head_of_fork);
@@ -677,11 +685,25 @@ bool database::_push_block(const signed_block& new_block)
          if( new_head->data.block_num() > head_block_num() )
          {
             // wlog( "Switching to fork: ${id}", ("id",new_head->data.id()) );
+            auto switch_start = fc::time_point::now();
             auto branches = _fork_db.fetch_branch_from(new_head->data.id(), head_block_id());
+            fork_switch_info info;
+            uint32_t old_head_num = head_block_num();
 
-            // pop blocks until we hit the forked block
-            while( head_block_id() != branches.second.back()->data.previous )
-               pop_block();
+            // Blocks linked from the unlinked pool extend head, both branches then end with head itself
+            if( branches.first.back() == branches.second.back() )
+            {
+               branches.first.pop_back();
+            }
+            else
+            {
+               // pop blocks until we hit the forked block
+               while( head_block_id() != branches.second.back()->data.previous )
+               {
+                  pop_block();
+                  ++info.undone_blocks;
+               }
+            }
 
             // push all blocks on the new fork
             for( auto ritr = branches.first.rbegin(); ritr != branches.first.rend(); ++ritr )
@@ -693,8 +715,22 @@ bool database::_push_block(const signed_block& new_block)
                    auto session = start_undo_session();
                    apply_block( (*ritr)->data, skip );
                    session.push();
+                   ++info.applied_blocks;
                 }
                 catch ( const fc::exception& e ) { except = e; }
+                if( except && (*ritr)->num > new_block.block_num() && new_block.block_num() > old_head_num )
+                {
+                   // Blocks past new_block came from the unlinked pool, and the chain up to new_block is
+                   // already longer than the one we left.  Keep it and only drop the invalid blocks.
+                   wlog( "Dropping invalid block ${id} linked from the unlinked pool", ("id",(*ritr)->data.id()) );
+                   while( ritr != branches.first.rend() )
+                   {
+                      _fork_db.remove( (*ritr)->data.id() );
+                      ++ritr;
+                   }
+                   _fork_db.set_head( _fork_db.fetch_block( head_block_id() ) );
+                   break;
+                }
                 if( except )
                 {
                    // wlog( "exception thrown while switching forks ${e}", ("e",except->to_detail_string() ) );
@@ -720,6 +756,9 @@ bool database::_push_block(const signed_block& new_block)
                    throw *except;
                 }
             }
+
+            info.time = fc::time_point::now() - switch_start;
+            _last_fork_switch = info;
             return true;
          }
          else
@@ -729,8 +768,12 @@ bool database::_push_block(const signed_block& new_block)
 
    try
    {
+      util::block_profiler::block_scope profile_block( _block_profiler, new_block.block_num() );
+      util::block_profiler::phase_scope undo_phase( _block_profiler, "start_undo_session" );
       auto session = start_undo_session();
+      undo_phase.end();
       apply_block(new_block, skip);
+      undo_phase.next( "push_undo_session" );
       session.push();
    }
    catch( const fc::exception& e )
@@ -789,12 +832,32 @@ void database::_push_transaction( const signed_transaction& trx )
    // apply the changes.
 
    auto temp_session = start_undo_session();
-   _apply_transaction( trx );
+   auto trx_id = _apply_transaction( trx );
    _pending_tx.push_back( trx );
+   _pending_tx_ids.push_back( trx_id );
 
    notify_changed_objects();
    // The transaction applied successfully. Merge its changes into the pending block session.
    temp_session.squash();
+
+   // Extend the pending block while every pending transaction fits in it. A prefix of the pending
+   // transactions applies to the head block state exactly as it did here, so it needs no re-validation.
+   if( _pending_block_tx_count + 1 == _pending_tx.size() )
+   {
+      size_t new_tx_size = _pending_block_tx_size + fc::raw::pack_size( trx );
+      if( max_block_header_size() + new_tx_size < get_dynamic_global_properties().maximum_block_size )
+      {
+         ++_pending_block_tx_count;
+         _pending_block_tx_size = new_tx_size;
+         _pending_block_skip_flags |= get_node_properties().skip_flags;
+      }
+   }
+}
+
+size_t database::max_block_header_size()
+{
+   static const size_t header_size = fc::raw::pack_size( signed_block_header() ) + 4;
+   return header_size;
 }
 
 signed_block database::generate_block(
@@ -834,67 +897,88 @@ signed_block database::_generate_block(
    if( !(skip & skip_witness_signature) )
       FC_ASSERT( witness_obj.signing_key == block_signing_private_key.get_public_key() );
 
-   static const size_t max_block_header_size = fc::raw::pack_size( signed_block_header() ) + 4;
    auto maximum_block_size = get_dynamic_global_properties().maximum_block_size; //STEEM_MAX_BLOCK_SIZE;
-   size_t total_block_size = max_block_header_size;
+   size_t total_block_size = max_block_header_size();
 
    signed_block pending_block;
 
-   //
-   // The following code throws away existing pending_tx_session and
-   // rebuilds it by re-applying pending transactions.
-   //
-   // This rebuild is necessary because pending transactions' validity
-   // and semantics may have changed since they were received, because
-   // time-based semantics are evaluated based on the current block
-   // time.  These changes can only be reflected in the database when
-   // the value of the "when" variable is known, which means we need to
-   // re-apply pending transactions in this method.
-   //
-   _pending_tx_session.reset();
-   _pending_tx_session = start_undo_session();
+   // A block's transactions are applied before its timestamp becomes the head block time, so they
+   // evaluate exactly as they did when they were pushed onto the head block.  The pending block built
+   // as they were pushed can be used as is, unless one of them expires before the new block.  Only
+   // mining operations depended on the producing witness, and they are disabled since hardfork 17.
+   // Transactions pushed with checks this block would not skip have to be checked again.
+   bool pending_block_is_current = _pending_tx_session.valid() && _pending_block_tx_count <= _pending_tx.size() &&
+                                   has_hardfork( STEEM_HARDFORK_0_17__770 ) && ( _pending_block_skip_flags & ~skip ) == 0;
+   for( size_t i = 0; pending_block_is_current && i < _pending_block_tx_count; ++i )
+      pending_block_is_current = _pending_tx[i].expiration >= when;
 
-   uint64_t postponed_tx_count = 0;
-   // pop pending state (reset to head block state)
-   for( const signed_transaction& tx : _pending_tx )
+   if( pending_block_is_current )
    {
-      // Only include transactions that have not expired yet for currently generating block,
-      // this should clear problem transactions and allow block production to continue
+      pending_block.transactions.assign( _pending_tx.begin(), _pending_tx.begin() + _pending_block_tx_count );
+      if( _pending_block_tx_count < _pending_tx.size() )
+         wlog( "Postponed ${n} transactions due to block size limit", ("n", _pending_tx.size() - _pending_block_tx_count) );
+   }
+   else
+   {
+      //
+      // The following code throws away existing pending_tx_session and
+      // rebuilds it by re-applying pending transactions.
+      //
+      // This rebuild is necessary because pending transactions' validity
+      // and semantics may have changed since they were received, because
+      // time-based semantics are evaluated based on the current block
+      // time.  These changes can only be reflected in the database when
+      // the value of the "when" variable is known, which means we need to
+      // re-apply pending transactions in this method.
+      //
+      _pending_tx_session.reset();
+      _pending_tx_session = start_undo_session();
 
-      if( tx.expiration < when )
-         continue;
+      uint64_t postponed_tx_count = 0;
+      // pop pending state (reset to head block state)
+      for( const signed_transaction& tx : _pending_tx )
+      {
+         // Only include transactions that have not expired yet for currently generating block,
+         // this should clear problem transactions and allow block production to continue
 
-      uint64_t new_total_size = total_block_size + fc::raw::pack_size( tx );
+         if( tx.expiration < when )
+            continue;
 
-      // postpone transaction if it would make block too big
-      if( new_total_size >= maximum_block_size )
-      {
-         postponed_tx_count++;
-         continue;
-      }
+         uint64_t new_total_size = total_block_size + fc::raw::pack_size( tx );
 
-      try
-      {
-         auto temp_session = start_undo_session();
-         _apply_transaction( tx );
-         temp_session.squash();
+         // postpone transaction if it would make block too big
+         if( new_total_size >= maximum_block_size )
+         {
+            postponed_tx_count++;
+            continue;
+         }
+
+         try
+         {
+            auto temp_session = start_undo_session();
+            _apply_transaction( tx );
+            temp_session.squash();
 
-         total_block_size += fc::raw::pack_size( tx );
-         pending_block.transactions.push_back( tx );
+            total_block_size += fc::raw::pack_size( tx );
+            pending_block.transactions.push_back( tx );
+         }
+         catch ( const fc::exception& e )
+         {
+            // Do nothing, transaction will not be re-applied
+            //wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
+            //wlog( "The transaction was ${t}", ("t", tx) );
+         }
       }
-      catch ( const fc::exception& e )
+      if( postponed_tx_count > 0 )
       {
-         // Do nothing, transaction will not be re-applied
-         //wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
-         //wlog( "The transaction was ${t}", ("t", tx) );
+         wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
       }
    }
-   if( postponed_tx_count > 0 )
-   {
-      wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
-   }
 
    _pending_tx_session.reset();
+   _pending_block_tx_count = 0;
+   _pending_block_tx_size = 0;
+   _pending_block_skip_flags = 0;
 
    // We have temporarily broken the invariant that
    // _pending_tx_session is the result of applying _pending_tx, as
@@ -952,6 +1036,9 @@ void database::pop_block()
    try
    {
       _pending_tx_session.reset();
+      _pending_block_tx_count = 0;
+      _pending_block_tx_size = 0;
+      _pending_block_skip_flags = 0;
       auto head_id = head_block_id();
 
       /// save the head block so we can recover its transactions
@@ -973,7 +1060,11 @@ void database::clear_pending()
    {
       assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
       _pending_tx.clear();
+      _pending_tx_ids.clear();
       _pending_tx_session.reset();
+      _pending_block_tx_count = 0;
+      _pending_block_tx_size = 0;
+      _pending_block_skip_flags = 0;
    }
    FC_CAPTURE_AND_RETHROW()
 }
@@ -1010,11 +1101,32 @@ void database::notify_pre_apply_operation( operation_notification& note )
 void database::notify_post_apply_operation( const operation_notification& note )
 {
    STEEM_TRY_NOTIFY( _post_apply_operation_signal, note )
+
+   if( _async_block_record && is_processing_block() )
+   {
+      _async_block_record->operations.emplace_back();
+      auto& applied = _async_block_record->operations.back();
+      applied.trx_id = note.trx_id;
+      applied.trx_in_block = note.trx_in_block;
+      applied.op_in_trx = note.op_in_trx;
+      applied.virtual_op = note.virtual_op;
+      applied.timestamp = head_block_time();
+      applied.op = note.op;
+   }
 }
 
 void database::notify_pre_apply_block( const block_notification& note )
 {
    STEEM_TRY_NOTIFY( _pre_apply_block_signal, note )
+
+   _async_block_record.reset();
+   if( _async_block_subscriptions.size() )
+   {
+      _async_block_record = std::make_shared< applied_block_record >();
+      _async_block_record->block_id = note.block_id;
+      _async_block_record->block_num = note.block_num;
+      _async_block_record->header = note.block;
+   }
 }
 
 void database::notify_irreversible_block( uint32_t block_num )
@@ -1025,6 +1137,16 @@ void database::notify_irreversible_block( uint32_t block_num )
 void database::notify_post_apply_block( const block_notification& note )
 {
    STEEM_TRY_NOTIFY( _post_apply_block_signal, note )
+
+   if( _async_block_record )
+   {
+      _async_block_record->last_irreversible_block = get_dynamic_global_properties().last_irreversible_block_num;
+      applied_block_record_ptr record = std::move( _async_block_record );
+      _async_block_record.reset();
+
+      for( const auto& subscription : _async_block_subscriptions )
+         subscription->push( record );
+   }
 }
 
 void database::notify_pre_apply_transaction( const transaction_notification& note )
@@ -1283,6 +1405,12 @@ void database::adjust_proxied_witness_votes( const account_object& a,
 
 void database::adjust_proxied_witness_votes( const account_object& a, share_type delta, int depth )
 {
+   if( _witness_vote_tally && depth == 0 )
+   {
+      _witness_vote_tally->adjust_proxied_witness_votes( *this, a, delta );
+      return;
+   }
+
    if( a.proxy != STEEM_PROXY_TO_SELF_ACCOUNT )
    {
       /// nested proxies are not supported, vote will not propagate
@@ -1491,9 +1619,20 @@ void database::process_vesting_withdrawals()
 
    const auto& cprops = get_dynamic_global_properties();
 
+   // Route destinations are paid once, after the last withdrawal, unless they withdraw themselves
+   account_balance_buffer balances;
+   // Witnesses are adjusted once for all the vesting moved
+   witness_vote_tally vote_tally;
+   _witness_vote_tally = &vote_tally;
+   BOOST_SCOPE_EXIT( this_ )
+   {
+      this_->_witness_vote_tally = nullptr;
+   } BOOST_SCOPE_EXIT_END
+
    while( current != widx.end() && current->next_vesting_withdrawal <= head_block_time() )
    {
       const auto& from_account = *current; ++current;
+      balances.flush( *this, from_account );
 
       /**
       *  Let T = total tokens in vesting fund
@@ -1526,10 +1665,7 @@ void database::process_vesting_withdrawals()
             {
                const auto& to_account = get< account_object, by_name >( itr->to_account );
 
-               modify( to_account, [&]( account_object& a )
-               {
-                  a.vesting_shares.amount += to_deposit;
-               });
+               balances.add_balance( to_account, asset( to_deposit, VESTS_SYMBOL ) );
 
                adjust_proxied_witness_votes( to_account, to_deposit );
 
@@ -1553,10 +1689,7 @@ void database::process_vesting_withdrawals()
 
             if( to_deposit > 0 )
             {
-               modify( to_account, [&]( account_object& a )
-               {
-                  a.balance += converted_steem;
-               });
+               balances.add_balance( to_account, converted_steem );
 
                modify( cprops, [&]( dynamic_global_property_object& o )
                {
@@ -1574,6 +1707,9 @@ void database::process_vesting_withdrawals()
 
       auto converted_steem = asset( to_convert, VESTS_SYMBOL ) * cprops.get_vesting_share_price();
 
+      // A route to itself
+      balances.flush( *this, from_account );
+
       modify( from_account, [&]( account_object& a )
       {
          a.vesting_shares.amount -= to_withdraw;
@@ -1602,6 +1738,11 @@ void database::process_vesting_withdrawals()
 
       push_virtual_operation( fill_vesting_withdraw_operation( from_account.name, from_account.name, asset( to_convert, VESTS_SYMBOL ), converted_steem ) );
    }
+
+   balances.flush( *this );
+
+   _witness_vote_tally = nullptr;
+   vote_tally.flush( *this );
 }
 
 void database::adjust_total_payout( const comment_object& cur, const asset& sbd_created, const asset& curator_sbd_value, const asset& beneficiary_value )
@@ -1616,25 +1757,31 @@ void database::adjust_total_payout( const comment_object& cur, const asset& sbd_
    /// TODO: potentially modify author's total payout numbers as well
 }
 
+/**
+ *  The work shared by the comments paid out in one block.  The vote buffers are reused from one comment
+ *  to the next.  Reward balances and statistics, which nothing reads during the payouts, are summed and
+ *  written once per account after the last comment.
+ */
+struct comment_cashout_batch
+{
+   /// Votes of the comment being paid, in index order
+   vector< const comment_vote_object* >      votes;
+   /// Its votes with a weight, in the order curators are paid
+   vector< const comment_vote_object* >      curators;
+
+   account_balance_buffer                    balances;
+};
+
 /**
  *  This method will iterate through all comment_vote_objects and give them
  *  (max_rewards * weight) / c.total_vote_weight.
  *
+ *  Expects batch.votes to hold the votes of c.
+ *
  *  @returns unclaimed rewards.
  */
-share_type database::pay_curators( const comment_object& c, share_type& max_rewards )
+share_type database::pay_curators( const comment_object& c, share_type& max_rewards, comment_cashout_batch& batch )
 {
-   struct cmp
-   {
-      bool operator()( const comment_vote_object* obj, const comment_vote_object* obj2 ) const
-      {
-         if( obj->weight == obj2->weight )
-            return obj->voter < obj2->voter;
-         else
-            return obj->weight > obj2->weight;
-      }
-   };
-
    try
    {
       uint128_t total_weight( c.total_vote_weight );
@@ -1648,17 +1795,25 @@ share_type database::pay_curators( const comment_object& c, share_type& max_rewa
       }
       else if( c.total_vote_weight > 0 )
       {
-         const auto& cvidx = get_index<comment_vote_index>().indices().get<by_comment_voter>();
-         auto itr = cvidx.lower_bound( c.id );
-
-         std::set< const comment_vote_object*, cmp > proxy_set;
-         while( itr != cvidx.end() && itr->comment == c.id )
+         // Votes without weight claim nothing.  A voter votes once per comment, so the order is total.
+         batch.curators.clear();
+         for( const comment_vote_object* vote : batch.votes )
          {
-            proxy_set.insert( &( *itr ) );
-            ++itr;
+            if( vote->weight > 0 )
+               batch.curators.push_back( vote );
          }
 
-         for( auto& item : proxy_set )
+         std::sort( batch.curators.begin(), batch.curators.end(), []( const comment_vote_object* obj, const comment_vote_object* obj2 )
+         {
+            if( obj->weight == obj2->weight )
+               return obj->voter < obj2->voter;
+            else
+               return obj->weight > obj2->weight;
+         });
+
+         bool to_reward_balance = has_hardfork( STEEM_HARDFORK_0_17__659 );
+
+         for( const comment_vote_object* item : batch.curators )
          {
             uint128_t weight( item->weight );
             auto claim = ( ( max_rewards.value * weight ) / total_weight ).to_uint64();
@@ -1666,15 +1821,12 @@ share_type database::pay_curators( const comment_object& c, share_type& max_rewa
             {
                unclaimed_rewards -= claim;
                const auto& voter = get( item->voter );
-               auto reward = create_vesting( voter, asset( claim, STEEM_SYMBOL ), has_hardfork( STEEM_HARDFORK_0_17__659 ) );
+               auto reward = create_vesting( voter, asset( claim, STEEM_SYMBOL ), to_reward_balance );
 
                push_virtual_operation( curation_reward_operation( voter.name, reward, c.author, to_string( c.permlink ) ) );
 
                #ifndef IS_LOW_MEM
-                  modify( voter, [&]( account_object& a )
-                  {
-                     a.curation_rewards += claim;
-                  });
+                  batch.balances.add_curation_rewards( voter, claim );
                #endif
             }
          }
@@ -1692,11 +1844,17 @@ void fill_comment_reward_context_local_state( util::comment_reward_context& ctx,
    ctx.max_sbd = comment.max_accepted_payout;
 }
 
-share_type database::cashout_comment_helper( util::comment_reward_context& ctx, const comment_object& comment )
+share_type database::cashout_comment_helper( util::comment_reward_context& ctx, const comment_object& comment, comment_cashout_batch& batch )
 {
    try
    {
       share_type claimed_reward = 0;
+      share_type author_rewards = 0;
+
+      const auto& vote_idx = get_index< comment_vote_index >().indices().get< by_comment_voter >();
+      batch.votes.clear();
+      for( auto vote_itr = vote_idx.lower_bound( comment.id ); vote_itr != vote_idx.end() && vote_itr->comment == comment.id; ++vote_itr )
+         batch.votes.push_back( &*vote_itr );
 
       if( comment.net_rshares > 0 )
       {
@@ -1704,7 +1862,7 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
 
          if( has_hardfork( STEEM_HARDFORK_0_17__774 ) )
          {
-            const auto rf = get_reward_fund( comment );
+            const auto& rf = get_reward_fund( comment );
             ctx.reward_curve = rf.author_reward_curve;
             ctx.content_constant = rf.content_constant;
          }
@@ -1717,7 +1875,7 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
             share_type curation_tokens = ( ( reward_tokens * get_curation_rewards_percent( comment ) ) / STEEM_100_PERCENT ).to_uint64();
             share_type author_tokens = reward_tokens.to_uint64() - curation_tokens;
 
-            author_tokens += pay_curators( comment, curation_tokens );
+            author_tokens += pay_curators( comment, curation_tokens, batch );
             share_type total_beneficiary = 0;
             claimed_reward = author_tokens + curation_tokens;
 
@@ -1744,15 +1902,8 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
             push_virtual_operation( comment_reward_operation( comment.author, to_string( comment.permlink ), to_sbd( asset( claimed_reward, STEEM_SYMBOL ) ) ) );
 
             #ifndef IS_LOW_MEM
-               modify( comment, [&]( comment_object& c )
-               {
-                  c.author_rewards += author_tokens;
-               });
-
-               modify( get_account( comment.author ), [&]( account_object& a )
-               {
-                  a.posting_rewards += author_tokens;
-               });
+               author_rewards = author_tokens;
+               batch.balances.add_posting_rewards( author, author_tokens );
             #endif
 
          }
@@ -1763,6 +1914,10 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
 
       modify( comment, [&]( comment_object& c )
       {
+         #ifndef IS_LOW_MEM
+            c.author_rewards += author_rewards;
+         #endif
+
          /**
          * A payout is only made for positive rshares, negative rshares hang around
          * for the next time this post might get an upvote.
@@ -1792,25 +1947,22 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
 
       push_virtual_operation( comment_payout_update_operation( comment.author, to_string( comment.permlink ) ) );
 
-      const auto& vote_idx = get_index< comment_vote_index >().indices().get< by_comment_voter >();
-      auto vote_itr = vote_idx.lower_bound( comment.id );
-      while( vote_itr != vote_idx.end() && vote_itr->comment == comment.id )
+      if( !has_hardfork( STEEM_HARDFORK_0_12__177 ) || calculate_discussion_payout_time( comment ) != fc::time_point_sec::maximum() )
       {
-         const auto& cur_vote = *vote_itr;
-         ++vote_itr;
-         if( !has_hardfork( STEEM_HARDFORK_0_12__177 ) || calculate_discussion_payout_time( comment ) != fc::time_point_sec::maximum() )
+         for( const comment_vote_object* cur_vote : batch.votes )
          {
-            modify( cur_vote, [&]( comment_vote_object& cvo )
+            modify( *cur_vote, [&]( comment_vote_object& cvo )
             {
                cvo.num_changes = -1;
             });
          }
-         else
-         {
+      }
+      else
+      {
 #ifdef CLEAR_VOTES
-            remove( cur_vote );
+         for( const comment_vote_object* cur_vote : batch.votes )
+            remove( *cur_vote );
 #endif
-         }
       }
 
       return claimed_reward;
@@ -1862,6 +2014,12 @@ void database::process_comment_cashout()
 
    const auto& cidx        = get_index< comment_index >().indices().get< by_cashout_time >();
    const auto& com_by_root = get_index< comment_index >().indices().get< by_root >();
+   comment_cashout_batch batch;
+   _reward_balance_buffer = &batch.balances;
+   BOOST_SCOPE_EXIT( this_ )
+   {
+      this_->_reward_balance_buffer = nullptr;
+   } BOOST_SCOPE_EXIT_END
 
    auto current = cidx.begin();
    //  add all rshares about to be cashed out to the reward funds. This ensures equal satoshi per rshare payment
@@ -1901,7 +2059,7 @@ void database::process_comment_cashout()
          auto fund_id = get_reward_fund( *current ).id._id;
          ctx.total_reward_shares2 = funds[ fund_id ].recent_claims;
          ctx.total_reward_fund_steem = funds[ fund_id ].reward_balance;
-         funds[ fund_id ].steem_awarded += cashout_comment_helper( ctx, *current );
+         funds[ fund_id ].steem_awarded += cashout_comment_helper( ctx, *current, batch );
       }
       else
       {
@@ -1912,7 +2070,7 @@ void database::process_comment_cashout()
             ctx.total_reward_shares2 = gpo.total_reward_shares2;
             ctx.total_reward_fund_steem = gpo.total_reward_fund_steem;
 
-            auto reward = cashout_comment_helper( ctx, comment );
+            auto reward = cashout_comment_helper( ctx, comment, batch );
 
             if( reward > 0 )
             {
@@ -1927,6 +2085,9 @@ void database::process_comment_cashout()
       current = cidx.begin();
    }
 
+   _reward_balance_buffer = nullptr;
+   batch.balances.flush( *this );
+
    // Write the cached fund state back to the database
    if( funds.size() )
    {
@@ -2031,8 +2192,12 @@ void database::process_funds()
 
 void database::process_savings_withdraws()
 {
+  if( !is_event_due( savings_withdraw_event ) )
+     return;
+
   const auto& idx = get_index< savings_withdraw_index >().indices().get< by_complete_from_rid >();
   auto itr = idx.begin();
+  uint64_t processed = 0;
   while( itr != idx.end() ) {
      if( itr->complete > head_block_time() )
         break;
@@ -2047,7 +2212,10 @@ void database::process_savings_withdraws()
 
      remove( *itr );
      itr = idx.begin();
+     ++processed;
   }
+
+  reschedule_event( savings_withdraw_event, itr == idx.end() ? time_point_sec::maximum() : itr->complete, processed );
 }
 
 #ifdef STEEM_ENABLE_SMT
@@ -2227,6 +2395,9 @@ share_type database::pay_reward_funds( share_type reward )
  */
 void database::process_conversions()
 {
+   if( !is_event_due( convert_request_event ) )
+      return;
+
    auto now = head_block_time();
    const auto& request_by_date = get_index< convert_request_index >().indices().get< by_conversion_date >();
    auto itr = request_by_date.begin();
@@ -2237,6 +2408,7 @@ void database::process_conversions()
 
    asset net_sbd( 0, SBD_SYMBOL );
    asset net_steem( 0, STEEM_SYMBOL );
+   uint64_t processed = 0;
 
    while( itr != request_by_date.end() && itr->conversion_date <= now )
    {
@@ -2251,8 +2423,11 @@ void database::process_conversions()
 
       remove( *itr );
       itr = request_by_date.begin();
+      ++processed;
    }
 
+   reschedule_event( convert_request_event, itr == request_by_date.end() ? time_point_sec::maximum() : itr->conversion_date, processed );
+
    const auto& props = get_dynamic_global_properties();
    modify( props, [&]( dynamic_global_property_object& p )
    {
@@ -2276,13 +2451,20 @@ asset database::to_steem( const asset& sbd )const
 void database::account_recovery_processing()
 {
    // Clear expired recovery requests
-   const auto& rec_req_idx = get_index< account_recovery_request_index >().indices().get< by_expiration >();
-   auto rec_req = rec_req_idx.begin();
-
-   while( rec_req != rec_req_idx.end() && rec_req->expires <= head_block_time() )
+   if( is_event_due( account_recovery_request_expiration_event ) )
    {
-      remove( *rec_req );
-      rec_req = rec_req_idx.begin();
+      const auto& rec_req_idx = get_index< account_recovery_request_index >().indices().get< by_expiration >();
+      auto rec_req = rec_req_idx.begin();
+      uint64_t processed = 0;
+
+      while( rec_req != rec_req_idx.end() && rec_req->expires <= head_block_time() )
+      {
+         remove( *rec_req );
+         rec_req = rec_req_idx.begin();
+         ++processed;
+      }
+
+      reschedule_event( account_recovery_request_expiration_event, rec_req == rec_req_idx.end() ? time_point_sec::maximum() : rec_req->expires, processed );
    }
 
    // Clear invalid historical authorities
@@ -2296,25 +2478,36 @@ void database::account_recovery_processing()
    }
 
    // Apply effective recovery_account changes
-   const auto& change_req_idx = get_index< change_recovery_account_request_index >().indices().get< by_effective_date >();
-   auto change_req = change_req_idx.begin();
-
-   while( change_req != change_req_idx.end() && change_req->effective_on <= head_block_time() )
+   if( is_event_due( change_recovery_account_event ) )
    {
-      modify( get_account( change_req->account_to_recover ), [&]( account_object& a )
+      const auto& change_req_idx = get_index< change_recovery_account_request_index >().indices().get< by_effective_date >();
+      auto change_req = change_req_idx.begin();
+      uint64_t processed = 0;
+
+      while( change_req != change_req_idx.end() && change_req->effective_on <= head_block_time() )
       {
-         a.recovery_account = change_req->recovery_account;
-      });
+         modify( get_account( change_req->account_to_recover ), [&]( account_object& a )
+         {
+            a.recovery_account = change_req->recovery_account;
+         });
+
+         remove( *change_req );
+         change_req = change_req_idx.begin();
+         ++processed;
+      }
 
-      remove( *change_req );
-      change_req = change_req_idx.begin();
+      reschedule_event( change_recovery_account_event, change_req == change_req_idx.end() ? time_point_sec::maximum() : change_req->effective_on, processed );
    }
 }
 
 void database::expire_escrow_ratification()
 {
+   if( !is_event_due( escrow_ratification_expiration_event ) )
+      return;
+
    const auto& escrow_idx = get_index< escrow_index >().indices().get< by_ratification_deadline >();
    auto escrow_itr = escrow_idx.lower_bound( false );
+   uint64_t processed = 0;
 
    while( escrow_itr != escrow_idx.end() && !escrow_itr->is_approved() && escrow_itr->ratification_deadline <= head_block_time() )
    {
@@ -2326,13 +2519,22 @@ void database::expire_escrow_ratification()
       adjust_balance( old_escrow.from, old_escrow.pending_fee );
 
       remove( old_escrow );
+      ++processed;
    }
+
+   // Approved escrows do not expire, they are ordered after all the unapproved ones
+   reschedule_event( escrow_ratification_expiration_event,
+      escrow_itr == escrow_idx.end() || escrow_itr->is_approved() ? time_point_sec::maximum() : escrow_itr->ratification_deadline, processed );
 }
 
 void database::process_decline_voting_rights()
 {
+   if( !is_event_due( decline_voting_rights_event ) )
+      return;
+
    const auto& request_idx = get_index< decline_voting_rights_request_index >().indices().get< by_effective_date >();
    auto itr = request_idx.begin();
+   uint64_t processed = 0;
 
    while( itr != request_idx.end() && itr->effective_date <= head_block_time() )
    {
@@ -2355,7 +2557,10 @@ void database::process_decline_voting_rights()
 
       remove( *itr );
       itr = request_idx.begin();
+      ++processed;
    }
+
+   reschedule_event( decline_voting_rights_event, itr == request_idx.end() ? time_point_sec::maximum() : itr->effective_date, processed );
 }
 
 time_point_sec database::head_block_time()const
@@ -2489,6 +2694,7 @@ void database::initialize_indexes()
    add_core_index< reward_fund_index                       >(*this);
    add_core_index< vesting_delegation_index                >(*this);
    add_core_index< vesting_delegation_expiration_index     >(*this);
+   add_core_index< scheduled_event_index                   >(*this);
 #ifdef STEEM_ENABLE_SMT
    add_core_index< smt_token_index                         >(*this);
    add_core_index< smt_event_token_index                   >(*this);
@@ -2746,6 +2952,8 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
               ;
    }
 
+   util::block_profiler::block_scope profile_block( _block_profiler, block_num );
+
    detail::with_skip_flags( *this, skip, [&]()
    {
       _apply_block( next_block );
@@ -2784,6 +2992,7 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
       {
          _next_flush_block = 0;
          //ilog( "Flushing database shared memory at block ${b}", ("b", block_num) );
+         util::block_profiler::phase_scope phase( _block_profiler, "flush_shared_memory" );
          chainbase::database::flush();
       }
    }
@@ -2833,6 +3042,7 @@ void database::_apply_block( const signed_block& next_block )
 { try {
    block_notification note( next_block );
 
+   util::block_profiler::phase_scope phase( _block_profiler, "pre_apply_block_handlers" );
    notify_pre_apply_block( note );
 
    const uint32_t next_block_num = note.block_num;
@@ -2853,6 +3063,7 @@ void database::_apply_block( const signed_block& next_block )
    {
       // For every existing before the head_block_time (genesis time), apply the hardfork
       // This allows the test net to launch with past hardforks and apply the next harfork when running
+      phase.next( "genesis_hardforks" );
 
       uint32_t n;
       for( n=0; n<STEEM_NUM_HARDFORKS; n++ )
@@ -2886,6 +3097,7 @@ void database::_apply_block( const signed_block& next_block )
       }
    }
 
+   phase.next( "merkle_check" );
    if( !( skip & skip_merkle_check ) )
    {
       auto merkle_root = next_block.calculate_merkle_root();
@@ -2904,6 +3116,7 @@ void database::_apply_block( const signed_block& next_block )
       }
    }
 
+   phase.next( "validate_header" );
    const witness_object& signing_witness = validate_block_header(skip, next_block);
 
    const auto& gprops = get_dynamic_global_properties();
@@ -2939,6 +3152,7 @@ void database::_apply_block( const signed_block& next_block )
       );
    }
 
+   phase.next( "transactions" );
    for( const auto& trx : next_block.transactions )
    {
       /* We do not need to push the undo state for each transaction
@@ -2955,36 +3169,48 @@ void database::_apply_block( const signed_block& next_block )
    _current_op_in_trx = 0;
    _current_virtual_op = 0;
 
+   phase.next( "update_global_properties" );
    update_global_dynamic_data(next_block);
    update_signing_witness(signing_witness, next_block);
 
    update_last_irreversible_block();
 
    create_block_summary(next_block);
+   phase.next( "clear_expired" );
    clear_expired_transactions();
    clear_expired_orders();
    clear_expired_delegations();
+   phase.next( "update_witness_schedule" );
    update_witness_schedule(*this);
 
+   phase.next( "update_median_feed" );
    update_median_feed();
    update_virtual_supply();
 
+   phase.next( "process_funds" );
    clear_null_account_balance();
    process_funds();
+   phase.next( "process_conversions" );
    process_conversions();
+   phase.next( "process_comment_cashout" );
    process_comment_cashout();
+   phase.next( "process_vesting_withdrawals" );
    process_vesting_withdrawals();
+   phase.next( "process_savings_and_rewards" );
    process_savings_withdraws();
    pay_liquidity_reward();
    update_virtual_supply();
 
+   phase.next( "process_expirations" );
    account_recovery_processing();
    expire_escrow_ratification();
    process_decline_voting_rights();
 
+   phase.next( "process_hardforks" );
    process_hardforks();
 
    // notify observers that the block has been applied
+   phase.next( "post_apply_block_handlers" );
    notify_post_apply_block( note );
 
    notify_changed_objects();
@@ -3123,7 +3349,7 @@ void database::apply_transaction(const signed_transaction& trx, uint32_t skip)
    detail::with_skip_flags( *this, skip, [&]() { _apply_transaction(trx); });
 }
 
-void database::_apply_transaction(const signed_transaction& trx)
+transaction_id_type database::_apply_transaction(const signed_transaction& trx)
 { try {
    transaction_notification note(trx);
    _current_trx_id = note.transaction_id;
@@ -3132,7 +3358,11 @@ void database::_apply_transaction(const signed_transaction& trx)
 
    uint32_t skip = get_node_properties().skip_flags;
 
-   if( !(skip&skip_validate) )   /* issue #505 explains why this skip_flag is disabled */
+   // A transaction validated while pending is not validated again, see validated_transaction_cache
+   const flat_set< public_key_type >* signature_keys = _validated_tx_cache.find( trx_id, trx );
+   flat_set< public_key_type > recovered_keys;
+
+   if( !(skip&skip_validate) && signature_keys == nullptr )   /* issue #505 explains why this skip_flag is disabled */
       trx.validate();
 
    auto& trx_idx = get_index<transaction_index>();
@@ -3150,7 +3380,13 @@ void database::_apply_transaction(const signed_transaction& trx)
 
       try
       {
-         trx.verify_authority( chain_id, get_active, get_owner, get_posting, STEEM_MAX_SIG_CHECK_DEPTH );
+         if( signature_keys == nullptr )
+         {
+            recovered_keys = trx.get_signature_keys( chain_id );
+            signature_keys = &recovered_keys;
+         }
+
+         steem::protocol::verify_authority( trx.operations, *signature_keys, get_active, get_owner, get_posting, STEEM_MAX_SIG_CHECK_DEPTH );
       }
       catch( protocol::tx_missing_active_auth& e )
       {
@@ -3187,7 +3423,6 @@ void database::_apply_transaction(const signed_transaction& trx)
       create<transaction_object>([&](transaction_object& transaction) {
          transaction.trx_id = trx_id;
          transaction.expiration = trx.expiration;
-         fc::raw::pack_to_buffer( transaction.packed_trx, trx );
       });
    }
 
@@ -3203,8 +3438,18 @@ void database::_apply_transaction(const signed_transaction& trx)
    }
    _current_trx_id = transaction_id_type();
 
+   // Keep what was validated for transactions entering the pending state, and forget it once they are in a block
+   if( is_processing_block() )
+      _validated_tx_cache.remove( trx_id );
+   else if( recovered_keys.size() )
+      _validated_tx_cache.insert( trx_id, trx, std::move( recovered_keys ) );
+
+   if( !(skip & skip_transaction_dupe_check) )
+      _recent_tx_cache.insert( trx_id, trx );
+
    notify_post_apply_transaction( note );
 
+   return trx_id;
 } FC_CAPTURE_AND_RETHROW( (trx) ) }
 
 void database::apply_operation(const operation& op)
@@ -3345,6 +3590,25 @@ boost::signals2::connection database::add_irreversible_block_handler( const irre
    return connect_impl(_on_irreversible_block, func, plugin, group, "<-irreversible");
 }
 
+std::shared_ptr< async_block_subscription > database::add_async_block_handler( const async_block_handler_t& func,
+   const abstract_plugin& plugin, size_t max_queue_size )
+{
+   auto subscription = std::make_shared< async_block_subscription >( plugin.get_name(), func, max_queue_size );
+   _async_block_subscriptions.push_back( subscription );
+   return subscription;
+}
+
+void database::remove_async_block_handler( const std::shared_ptr< async_block_subscription >& subscription )
+{
+   if( !subscription ) return;
+
+   auto itr = std::find( _async_block_subscriptions.begin(), _async_block_subscriptions.end(), subscription );
+   if( itr != _async_block_subscriptions.end() )
+      _async_block_subscriptions.erase( itr );
+
+   subscription->stop();
+}
+
 boost::signals2::connection database::add_pre_reindex_handler(const reindex_handler_t& func,
    const abstract_plugin& plugin, int32_t group )
 {
@@ -3787,25 +4051,39 @@ void database::clear_expired_transactions()
    const auto& dedupe_index = transaction_idx.indices().get< by_expiration >();
    while( ( !dedupe_index.empty() ) && ( head_block_time() > dedupe_index.begin()->expiration ) )
       remove( *dedupe_index.begin() );
+
+   _validated_tx_cache.remove_expired( head_block_time() );
+   _recent_tx_cache.remove_expired( head_block_time() );
 }
 
 void database::clear_expired_orders()
 {
+   if( !is_event_due( limit_order_expiration_event ) )
+      return;
+
    auto now = head_block_time();
    const auto& orders_by_exp = get_index<limit_order_index>().indices().get<by_expiration>();
    auto itr = orders_by_exp.begin();
+   uint64_t processed = 0;
    while( itr != orders_by_exp.end() && itr->expiration < now )
    {
       cancel_order( *itr );
       itr = orders_by_exp.begin();
+      ++processed;
    }
+
+   reschedule_event( limit_order_expiration_event, itr == orders_by_exp.end() ? time_point_sec::maximum() : itr->expiration, processed );
 }
 
 void database::clear_expired_delegations()
 {
+   if( !is_event_due( vesting_delegation_expiration_event ) )
+      return;
+
    auto now = head_block_time();
    const auto& delegations_by_exp = get_index< vesting_delegation_expiration_index, by_expiration >();
    auto itr = delegations_by_exp.begin();
+   uint64_t processed = 0;
    while( itr != delegations_by_exp.end() && itr->expiration < now )
    {
       modify( get_account( itr->delegator ), [&]( account_object& a )
@@ -3817,7 +4095,67 @@ void database::clear_expired_delegations()
 
       remove( *itr );
       itr = delegations_by_exp.begin();
+      ++processed;
    }
+
+   reschedule_event( vesting_delegation_expiration_event, itr == delegations_by_exp.end() ? time_point_sec::maximum() : itr->expiration, processed );
+}
+
+namespace {
+
+/// Orders and delegations are removed once head block time is past their expiration, everything else when it is reached
+time_point_sec event_due_time( scheduled_event_type type, const time_point_sec& deadline )
+{
+   bool after_deadline = type == limit_order_expiration_event || type == vesting_delegation_expiration_event;
+   if( after_deadline && deadline < time_point_sec::maximum() )
+      return deadline + 1;
+   return deadline;
+}
+
+} // anonymous
+
+void database::schedule_event( scheduled_event_type type, const time_point_sec& deadline )
+{
+   time_point_sec due = event_due_time( type, deadline );
+   const auto* event = find< scheduled_event_object, by_type >( type );
+
+   if( event == nullptr )
+   {
+      create< scheduled_event_object >( [&]( scheduled_event_object& e )
+      {
+         e.type = type;
+         e.next_due = due;
+      });
+   }
+   else if( due < event->next_due )
+   {
+      modify( *event, [&]( scheduled_event_object& e )
+      {
+         e.next_due = due;
+      });
+   }
+}
+
+bool database::is_event_due( scheduled_event_type type )const
+{
+   // Most blocks stop at the first check, nothing at all is due
+   const auto& due_idx = get_index< scheduled_event_index, by_next_due >();
+   if( due_idx.empty() || due_idx.begin()->next_due > head_block_time() )
+      return false;
+
+   const auto* event = find< scheduled_event_object, by_type >( type );
+   return event != nullptr && event->next_due <= head_block_time();
+}
+
+void database::reschedule_event( scheduled_event_type type, const time_point_sec& next_deadline, uint64_t processed )
+{
+   ++_scheduled_event_stats[ type ].dispatches;
+   _scheduled_event_stats[ type ].processed += processed;
+
+   modify( get< scheduled_event_object, by_type >( type ), [&]( scheduled_event_object& e )
+   {
+      e.next_due = event_due_time( type, next_deadline );
+   });
 }
 #ifdef STEEM_ENABLE_SMT
 template< typename smt_balance_object_type, class balance_operator_type >
@@ -4130,6 +4468,12 @@ void database::adjust_reward_balance( const account_object& a, const asset& valu
    }
 #endif
 
+   if( _reward_balance_buffer )
+   {
+      _reward_balance_buffer->add_reward_balance( a, value_delta, share_delta );
+      return;
+   }
+
    modify_reward_balance(a, value_delta, share_delta, check_balance);
 }
 
@@ -4151,6 +4495,13 @@ void database::adjust_reward_balance( const account_name_type& name, const asset
 #endif
 
    const auto& a = get_account( name );
+
+   if( _reward_balance_buffer )
+   {
+      _reward_balance_buffer->add_reward_balance( a, value_delta, share_delta );
+      return;
+   }
+
    modify_reward_balance(a, value_delta, share_delta, check_balance);
 }
 
@@ -2,6 +2,10 @@
 
 #include <steem/chain/database_exceptions.hpp>
 
+#include <fc/io/raw.hpp>
+
+#include <iterator>
+
 namespace steem { namespace chain {
 
 fork_database::fork_database()
@@ -11,6 +15,8 @@ void fork_database::reset()
 {
    _head.reset();
    _index.clear();
+   _unlinked_index.clear();
+   _unlinked_size = 0;
 }
 
 void fork_database::pop_block()
@@ -42,9 +48,10 @@ shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
    {
       wlog( "Pushing block to fork database that failed to link: ${id}, ${num}", ("id",b.id())("num",b.block_num()) );
       wlog( "Head: ${num}, ${id}", ("num",_head->data.block_num())("id",_head->data.id()) );
+      _push_unlinked( item );
       throw;
-      _unlinked_index.insert( item );
    }
+   _push_next( item );
    return _head;
 }
 
@@ -72,23 +79,74 @@ void  fork_database::_push_block(const item_ptr& item)
 
 /**
  *  Iterate through the unlinked cache and insert anything that
- *  links to the newly inserted item.  This will start a recursive
- *  set of calls performing a depth-first insertion of pending blocks as
- *  _push_next(..) calls _push_block(...) which will in turn call _push_next
+ *  links to the newly inserted item, then anything that links to
+ *  those, depth-first.
  */
 void fork_database::_push_next( const item_ptr& new_item )
 {
-    auto& prev_idx = _unlinked_index.get<by_previous>();
+   auto& prev_idx = _unlinked_index.get<by_previous>();
+   if( prev_idx.empty() )
+      return;
+
+   vector< item_ptr > linked( 1, new_item );
+   while( linked.size() )
+   {
+      auto parent = linked.back();
+      linked.pop_back();
+
+      auto itr = prev_idx.find( parent->id );
+      while( itr != prev_idx.end() )
+      {
+         auto tmp = *itr;
+         prev_idx.erase( itr );
+         _unlinked_size -= tmp->size;
+         tmp->size = 0;
 
-    auto itr = prev_idx.find( new_item->id );
-    while( itr != prev_idx.end() )
-    {
-       auto tmp = *itr;
-       prev_idx.erase( itr );
-       _push_block( tmp );
+         try
+         {
+            _push_block( tmp );
+            linked.push_back( tmp );
+         }
+         catch( const fc::exception& e )
+         {
+            // Too old by now, or it builds on an invalid block
+            wlog( "Dropping unlinked block ${id}: ${e}", ("id",tmp->id)("e",e.to_string()) );
+         }
 
-       itr = prev_idx.find( new_item->id );
-    }
+         itr = prev_idx.find( parent->id );
+      }
+   }
+}
+
+void fork_database::_push_unlinked( const item_ptr& item )
+{
+   // Blocks too far ahead of head would be evicted before they could link
+   if( _head && item->num > _head->num + MAX_BLOCK_REORDERING )
+      return;
+
+   item->size = fc::raw::pack_size( item->data );
+   if( !_unlinked_index.insert( item ).second )
+      return;
+
+   _unlinked_size += item->size;
+   _prune_unlinked();
+}
+
+void fork_database::_prune_unlinked()
+{
+   auto& by_num_idx = _unlinked_index.get<block_num>();
+   while( _unlinked_size > _max_unlinked_size && by_num_idx.size() )
+   {
+      auto last = std::prev( by_num_idx.end() );
+      _unlinked_size -= (*last)->size;
+      by_num_idx.erase( last );
+   }
+}
+
+void fork_database::set_max_unlinked_size( uint32_t s )
+{
+   _max_unlinked_size = s;
+   _prune_unlinked();
 }
 
 void fork_database::set_max_size( uint32_t s )
@@ -114,7 +172,10 @@ void fork_database::set_max_size( uint32_t s )
       while( itr != by_num_idx.end() )
       {
          if( (*itr)->num < std::max(int64_t(0),int64_t(_head->num) - _max_size) )
+         {
+            _unlinked_size -= (*itr)->size;
             by_num_idx.erase(itr);
+         }
          else
             break;
          itr = by_num_idx.begin();
@@ -180,13 +241,13 @@ pair<fork_database::branch_type,fork_database::branch_type>
    auto second_branch = *second_branch_itr;
 
 
-   while( first_branch->data.block_num() > second_branch->data.block_num() )
+   while( first_branch->num > second_branch->num )
    {
       result.first.push_back(first_branch);
       first_branch = first_branch->prev.lock();
       FC_ASSERT(first_branch);
    }
-   while( second_branch->data.block_num() > first_branch->data.block_num() )
+   while( second_branch->num > first_branch->num )
    {
       result.second.push_back( second_branch );
       second_branch = second_branch->prev.lock();
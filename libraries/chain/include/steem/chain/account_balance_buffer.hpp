@@ -0,0 +1,54 @@
+#pragma once
+#include <steem/chain/account_object.hpp>
+
+#include <map>
+
+namespace steem { namespace chain {
+
+   class database;
+
+   /**
+    *  Sums additions to the balances and reward statistics of accounts over a phase of block processing,
+    *  to write each account once instead of once per payment.  Every modify of an account_object
+    *  checks its position in the account indexes.  Reward heavy blocks pay the same authors, curators and
+    *  withdraw route destinations many times.
+    *
+    *  Nothing may read a buffered field of an account until the account is flushed.  Liquid SBD is not
+    *  buffered, since its interest depends on the balance at the time of each change.
+    */
+   class account_balance_buffer
+   {
+      public:
+         /// STEEM or VESTS, added to balance or vesting_shares
+         void add_balance( const account_object& a, const asset& delta );
+         void add_reward_balance( const account_object& a, const asset& value_delta, const asset& share_delta );
+         void add_curation_rewards( const account_object& a, share_type delta );
+         void add_posting_rewards( const account_object& a, share_type delta );
+
+         /// Writes what was added to a, if anything
+         void flush( database& db, const account_object& a );
+         /// Writes every account, in id order
+         void flush( database& db );
+
+         bool empty()const { return _deltas.empty(); }
+
+      private:
+         struct account_deltas
+         {
+            asset       balance                 = asset( 0, STEEM_SYMBOL );
+            asset       vesting_shares          = asset( 0, VESTS_SYMBOL );
+            asset       reward_steem_balance    = asset( 0, STEEM_SYMBOL );
+            asset       reward_sbd_balance      = asset( 0, SBD_SYMBOL );
+            asset       reward_vesting_balance  = asset( 0, VESTS_SYMBOL );
+            asset       reward_vesting_steem    = asset( 0, STEEM_SYMBOL );
+            share_type  curation_rewards        = 0;
+            share_type  posting_rewards         = 0;
+         };
+
+         account_deltas& deltas( const account_object& a ) { return _deltas[ a.id ]; }
+         static void apply( database& db, const account_object& a, const account_deltas& d );
+
+         std::map< account_id_type, account_deltas > _deltas;
+   };
+
+} } // steem::chain
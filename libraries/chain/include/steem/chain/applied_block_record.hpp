@@ -0,0 +1,92 @@
+#pragma once
+
+#include <steem/protocol/block.hpp>
+#include <steem/protocol/operations.hpp>
+
+#include <steem/chain/steem_object_types.hpp>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+namespace steem { namespace chain {
+
+/// An operation applied in a block, with what a post apply operation handler would have seen
+struct applied_operation
+{
+   transaction_id_type     trx_id;
+   uint32_t                trx_in_block = 0;
+   uint32_t                op_in_trx = 0;
+   uint32_t                virtual_op = 0;
+   fc::time_point_sec      timestamp;        ///< Head block time when the operation was applied
+   steem::protocol::operation op;
+};
+
+/**
+ * Everything a block did that a plugin indexing the chain needs, captured while the block is applied.
+ * Records are shared by all subscribers and never modified once delivered.
+ *
+ * A record for a block number at or below the one of a record delivered before means that the blocks
+ * from that number on were undone by a fork switch.  Blocks up to last_irreversible_block will not be.
+ */
+struct applied_block_record
+{
+   block_id_type                       block_id;
+   uint32_t                            block_num = 0;
+   steem::protocol::signed_block_header header;
+   uint32_t                            last_irreversible_block = 0;
+   vector< applied_operation >         operations;
+};
+
+typedef std::shared_ptr< const applied_block_record > applied_block_record_ptr;
+typedef std::function< void( const applied_block_record_ptr& ) > async_block_handler_t;
+
+/**
+ * Delivers applied block records to one plugin on a thread of its own, in the order the blocks were
+ * applied.  The queue is bounded, block application waits when the plugin falls that far behind.
+ *
+ * The handler must not read chainbase, the chain has moved on by the time it runs.  It works from the
+ * record and from state the plugin owns.
+ */
+class async_block_subscription
+{
+   public:
+      async_block_subscription( const std::string& name, const async_block_handler_t& handler, size_t max_queue_size );
+      ~async_block_subscription();
+
+      const std::string& name()const { return _name; }
+
+      void push( const applied_block_record_ptr& record );
+
+      /// Blocks until every queued record has been handled
+      void wait();
+
+      /// Handles the remaining records and stops the thread
+      void stop();
+
+      size_t   queued_blocks()const;
+      /// Number of the last block handled
+      uint32_t last_block_num()const { return _last_block_num; }
+
+   private:
+      void thread_main();
+
+      std::string                               _name;
+      async_block_handler_t                     _handler;
+      size_t                                    _max_queue_size;
+
+      std::deque< applied_block_record_ptr >    _queue;
+      bool                                      _busy = false;
+      bool                                      _stop = false;
+      mutable boost::mutex                      _mutex;
+      boost::condition_variable                 _cond;
+      std::unique_ptr< boost::thread >          _thread;
+      std::atomic< uint32_t >                   _last_block_num;
+};
+
+} } // steem::chain
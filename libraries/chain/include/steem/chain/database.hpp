@@ -2,6 +2,7 @@
  * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
  */
 #pragma once
+#include <steem/chain/applied_block_record.hpp>
 #include <steem/chain/block_log.hpp>
 #include <steem/chain/block_notification.hpp>
 #include <steem/chain/fork_database.hpp>
@@ -9,9 +10,15 @@
 #include <steem/chain/hardfork_property_object.hpp>
 #include <steem/chain/node_property_object.hpp>
 #include <steem/chain/operation_notification.hpp>
+#include <steem/chain/recent_transaction_cache.hpp>
+#include <steem/chain/scheduled_event_object.hpp>
 #include <steem/chain/transaction_notification.hpp>
+#include <steem/chain/validated_transaction_cache.hpp>
+#include <steem/chain/account_balance_buffer.hpp>
+#include <steem/chain/witness_vote_tally.hpp>
 
 #include <steem/chain/util/advanced_benchmark_dumper.hpp>
+#include <steem/chain/util/block_profiler.hpp>
 #include <steem/chain/util/signal.hpp>
 
 #include <steem/protocol/protocol.hpp>
@@ -23,6 +30,7 @@
 
 #include <fc/log/logger.hpp>
 
+#include <array>
 #include <map>
 
 namespace steem { namespace chain {
@@ -37,6 +45,7 @@ namespace steem { namespace chain {
 
    class database_impl;
    class custom_operation_interpreter;
+   struct comment_cashout_batch;
 
    namespace util {
       struct comment_reward_context;
@@ -52,6 +61,22 @@ namespace steem { namespace chain {
       uint32_t last_block_number = 0;
    };
 
+   /// How often the processing of a scheduled event type ran, and how many objects it processed
+   struct scheduled_event_stats
+   {
+      uint64_t dispatches = 0;
+      uint64_t processed = 0;
+   };
+
+   /// Blocks undone and applied to switch to a longer fork, and how long it took.  No blocks are undone
+   /// when the blocks linked from the unlinked pool simply extend head.
+   struct fork_switch_info
+   {
+      uint32_t undone_blocks = 0;
+      uint32_t applied_blocks = 0;
+      fc::microseconds time;
+   };
+
    /**
     *   @class database
     *   @brief tracks the blockchain state in an extensible manner
@@ -153,8 +178,24 @@ namespace steem { namespace chain {
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
          const signed_transaction   get_recent_transaction( const transaction_id_type& trx_id )const;
+
+         /**
+          *  Records that trx passed validate() and that its signatures recover to signature_keys, for
+          *  transactions checked before they reach the write thread.  Applying trx then skips both.
+          */
+         void add_validated_transaction( const transaction_id_type& trx_id, const signed_transaction& trx, flat_set< public_key_type > signature_keys );
+         void remove_validated_transaction( const transaction_id_type& trx_id );
+
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
+         const fork_database&       get_fork_db()const { return _fork_db; }
+         /// The last fork switch done by push_block, valid when push_block returns true
+         const fork_switch_info&    get_last_fork_switch()const { return _last_fork_switch; }
+
+         /// Per phase timing of applied blocks, off until enabled
+         util::block_profiler&       get_block_profiler() { return _block_profiler; }
+         const util::block_profiler& get_block_profiler()const { return _block_profiler; }
+
          chain_id_type steem_chain_id;
          chain_id_type get_chain_id() const;
          void set_chain_id( const std::string& _chain_id_name );
@@ -284,6 +325,16 @@ namespace steem { namespace chain {
          boost::signals2::connection add_pre_reindex_handler           ( const reindex_handler_t&              func, const abstract_plugin& plugin, int32_t group = -1 );
          boost::signals2::connection add_post_reindex_handler          ( const reindex_handler_t&              func, const abstract_plugin& plugin, int32_t group = -1 );
 
+         /**
+          * Opt-in alternative to the apply handlers for plugins that only index what blocks did: a record of
+          * each applied block and its operations is delivered to func on a thread of the plugin's own, after
+          * the block is applied and outside of the write lock.  See async_block_subscription.
+          */
+         std::shared_ptr< async_block_subscription > add_async_block_handler( const async_block_handler_t& func, const abstract_plugin& plugin, size_t max_queue_size = 1000 );
+         /// Stops delivering records to the subscription, after it handled the queued ones
+         void remove_async_block_handler( const std::shared_ptr< async_block_subscription >& subscription );
+         const vector< std::shared_ptr< async_block_subscription > >& get_async_block_subscriptions()const { return _async_block_subscriptions; }
+
          //////////////////// db_witness_schedule.cpp ////////////////////
 
          /**
@@ -363,8 +414,8 @@ namespace steem { namespace chain {
           */
          void clear_witness_votes( const account_object& a );
          void process_vesting_withdrawals();
-         share_type pay_curators( const comment_object& c, share_type& max_rewards );
-         share_type cashout_comment_helper( util::comment_reward_context& ctx, const comment_object& comment );
+         share_type pay_curators( const comment_object& c, share_type& max_rewards, comment_cashout_batch& batch );
+         share_type cashout_comment_helper( util::comment_reward_context& ctx, const comment_object& comment, comment_cashout_batch& batch );
          void process_comment_cashout();
          void process_funds();
          void process_conversions();
@@ -377,6 +428,13 @@ namespace steem { namespace chain {
          void process_decline_voting_rights();
          void update_median_feed();
 
+         /**
+          * Must be called whenever an object of the event type is created with a deadline, or its deadline moves,
+          * so that it is processed at the end of the first block at or after the deadline.
+          */
+         void schedule_event( scheduled_event_type type, const time_point_sec& deadline );
+         const std::array< scheduled_event_stats, scheduled_event_type_count >& get_scheduled_event_stats()const { return _scheduled_event_stats; }
+
          asset get_liquidity_reward()const;
          asset get_content_reward()const;
          asset get_producer_reward();
@@ -424,6 +482,8 @@ namespace steem { namespace chain {
           * can be reapplied at the proper time */
          std::deque< signed_transaction >       _popped_tx;
          vector< signed_transaction >           _pending_tx;
+         /// ids of _pending_tx in the same order, so that readers look them up without hashing the transactions
+         vector< transaction_id_type >          _pending_tx_ids;
 
          bool apply_order( const limit_order_object& new_order_object );
          bool fill_order( const limit_order_object& order, const asset& pays, const asset& receives );
@@ -482,10 +542,20 @@ namespace steem { namespace chain {
       private:
          optional< chainbase::database::session > _pending_tx_session;
 
+         /// The next block we would produce, kept up to date as transactions are pushed: the longest
+         /// prefix of _pending_tx that fits in a block, the size of its transactions and the checks skipped
+         /// while applying them
+         size_t                                   _pending_block_tx_count = 0;
+         size_t                                   _pending_block_tx_size = 0;
+         uint32_t                                 _pending_block_skip_flags = 0;
+
+         static size_t max_block_header_size();
+
          void apply_block( const signed_block& next_block, uint32_t skip = skip_nothing );
          void apply_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
          void _apply_block( const signed_block& next_block );
-         void _apply_transaction( const signed_transaction& trx );
+         /// @return the id of trx
+         transaction_id_type _apply_transaction( const signed_transaction& trx );
          void apply_operation( const operation& op );
 
 
@@ -505,6 +575,11 @@ namespace steem { namespace chain {
          void clear_expired_delegations();
          void process_header_extensions( const signed_block& next_block );
 
+         /// True when the processing of the event type has work in the current block
+         bool is_event_due( scheduled_event_type type )const;
+         /// Records that the processing ran, next_deadline is the first one left or maximum() if there is none
+         void reschedule_event( scheduled_event_type type, const time_point_sec& next_deadline, uint64_t processed );
+
          void init_hardforks();
          void process_hardforks();
          void apply_hardfork( uint32_t hardfork );
@@ -521,6 +596,19 @@ namespace steem { namespace chain {
          std::unique_ptr< database_impl > _my;
 
          fork_database                 _fork_db;
+         validated_transaction_cache   _validated_tx_cache;
+         /// While set, adjust_reward_balance adds to it instead of modifying the account
+         account_balance_buffer*       _reward_balance_buffer = nullptr;
+         /// While set, adjust_proxied_witness_votes adds to it instead of modifying proxies and witnesses
+         witness_vote_tally*           _witness_vote_tally = nullptr;
+         recent_transaction_cache      _recent_tx_cache;
+         fork_switch_info              _last_fork_switch;
+
+         std::array< scheduled_event_stats, scheduled_event_type_count > _scheduled_event_stats;
+
+         vector< std::shared_ptr< async_block_subscription > > _async_block_subscriptions;
+         /// The record of the block being applied, only built while there are subscriptions
+         std::shared_ptr< applied_block_record >              _async_block_record;
          fc::time_point_sec            _hardfork_times[ STEEM_NUM_HARDFORKS + 1 ];
          protocol::hardfork_version    _hardfork_versions[ STEEM_NUM_HARDFORKS + 1 ];
 
@@ -556,6 +644,7 @@ namespace steem { namespace chain {
          std::string                   _json_schema;
 
          util::advanced_benchmark_dumper  _benchmark_dumper;
+         util::block_profiler             _block_profiler;
 
          fc::signal<void(const operation_notification&)>       _pre_apply_operation_signal;
          /**
@@ -53,10 +53,13 @@ struct pending_transactions_restorer
 
    ~pending_transactions_restorer()
    {
+      // Expired transactions are dropped without applying them, they would only fail
+      auto now = _db.head_block_time();
+
       for( const auto& tx : _db._popped_tx )
       {
          try {
-            if( !_db.is_known_transaction( tx.id() ) ) {
+            if( tx.expiration >= now && !_db.is_known_transaction( tx.id() ) ) {
                // since push_transaction() takes a signed_transaction,
                // the operation_results field will be ignored.
                _db._push_transaction( tx );
@@ -69,7 +72,7 @@ struct pending_transactions_restorer
       {
          try
          {
-            if( !_db.is_known_transaction( tx.id() ) ) {
+            if( tx.expiration >= now && !_db.is_known_transaction( tx.id() ) ) {
                // since push_transaction() takes a signed_transaction,
                // the operation_results field will be ignored.
                _db._push_transaction( tx );
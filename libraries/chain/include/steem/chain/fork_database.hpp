@@ -29,6 +29,8 @@ namespace steem { namespace chain {
        * building on top of it.
        */
       bool                  invalid = false;
+      /** Serialized size of the block, only computed while it waits in the unlinked pool */
+      uint32_t              size = 0;
       block_id_type         id;
       signed_block          data;
    };
@@ -44,6 +46,12 @@ namespace steem { namespace chain {
     *
     *  Every time a block is pushed into the fork DB the
     *  block with the highest block_num will be returned.
+    *
+    *  Blocks that do not link are kept in a pool of unlinked
+    *  blocks, bounded in bytes, until their previous block
+    *  arrives.  When the pool is full the blocks furthest ahead
+    *  of head are evicted first, they need the most missing
+    *  blocks before they can link.
     */
    class fork_database
    {
@@ -51,6 +59,8 @@ namespace steem { namespace chain {
          typedef vector<item_ptr> branch_type;
          /// The maximum number of blocks that may be skipped in an out-of-order push
          const static int MAX_BLOCK_REORDERING = 1024;
+         /// The default memory bound of the unlinked block pool, in bytes of serialized blocks
+         const static uint32_t DEFAULT_MAX_UNLINKED_SIZE = 64 * 1024 * 1024;
 
          fork_database();
          void reset();
@@ -91,13 +101,21 @@ namespace steem { namespace chain {
          > fork_multi_index_type;
 
          void set_max_size( uint32_t s );
+         void set_max_unlinked_size( uint32_t s );
+
+         size_t                           unlinked_block_count()const { return _unlinked_index.size(); }
+         uint64_t                         unlinked_size()const { return _unlinked_size; }
 
       private:
          /** @return a pointer to the newly pushed item */
          void _push_block(const item_ptr& b );
          void _push_next(const item_ptr& newly_inserted);
+         void _push_unlinked(const item_ptr& item);
+         void _prune_unlinked();
 
          uint32_t                 _max_size = 1024;
+         uint32_t                 _max_unlinked_size = DEFAULT_MAX_UNLINKED_SIZE;
+         uint64_t                 _unlinked_size = 0;
 
          fork_multi_index_type    _unlinked_index;
          fork_multi_index_type    _index;
@@ -0,0 +1,57 @@
+#pragma once
+#include <steem/protocol/transaction.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+
+namespace steem { namespace chain {
+
+   using steem::protocol::signed_transaction;
+   using steem::protocol::transaction_id_type;
+
+   /**
+    *  Keeps the transactions applied within their expiration window, for get_recent_transaction
+    *  which serves them to peers.  This used to be a packed copy in every transaction_object.
+    *
+    *  The cache is not part of the chain state: it is not undone with blocks and starts empty
+    *  after a restart.  Entries are removed when their transaction expires.
+    */
+   class recent_transaction_cache
+   {
+      public:
+         /** @return the transaction, or nullptr if it is not cached */
+         const signed_transaction* find( const transaction_id_type& id )const;
+
+         /** Keeps trx unless it is already cached, transactions are applied again while pending */
+         void insert( const transaction_id_type& id, const signed_transaction& trx );
+         void remove_expired( fc::time_point_sec now );
+         void clear();
+
+         size_t size()const { return _index.size(); }
+
+      private:
+         struct recent_transaction
+         {
+            transaction_id_type              id;
+            fc::time_point_sec               expiration;
+            signed_transaction               trx;
+         };
+
+         struct by_id;
+         struct by_expiration;
+         typedef boost::multi_index_container<
+            recent_transaction,
+            boost::multi_index::indexed_by<
+               boost::multi_index::hashed_unique< boost::multi_index::tag< by_id >,
+                  boost::multi_index::member< recent_transaction, transaction_id_type, &recent_transaction::id >, std::hash< fc::ripemd160 > >,
+               boost::multi_index::ordered_non_unique< boost::multi_index::tag< by_expiration >,
+                  boost::multi_index::member< recent_transaction, fc::time_point_sec, &recent_transaction::expiration > >
+            >
+         > recent_transaction_index;
+
+         recent_transaction_index   _index;
+   };
+
+} } // steem::chain
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <steem/chain/steem_object_types.hpp>
+
+#include <boost/multi_index/composite_key.hpp>
+
+namespace steem { namespace chain {
+
+   /**
+    * Kinds of chain state that expire or become effective at a point in time, and are processed at the end
+    * of the block in which that happens.
+    */
+   enum scheduled_event_type
+   {
+      limit_order_expiration_event,
+      vesting_delegation_expiration_event,
+      convert_request_event,
+      savings_withdraw_event,
+      account_recovery_request_expiration_event,
+      change_recovery_account_event,
+      escrow_ratification_expiration_event,
+      decline_voting_rights_event,
+      scheduled_event_type_count
+   };
+
+   /**
+    * The earliest head block time at which the processing of one event type has something to do.
+    *
+    * Blocks in which no event type is due pay one lookup in the by_next_due index instead of probing every
+    * index with deadlines.  The time may be earlier than the actual first deadline, the processing then finds
+    * nothing and schedules the next one, but it is never later: everything that creates or moves a deadline
+    * calls database::schedule_event.  Being chain state, it is undone together with the objects it covers.
+    */
+   class scheduled_event_object : public object< scheduled_event_object_type, scheduled_event_object >
+   {
+      scheduled_event_object() = delete;
+
+      public:
+         template< typename Constructor, typename Allocator >
+         scheduled_event_object( Constructor&& c, allocator< Allocator > a )
+         {
+            c( *this );
+         }
+
+         id_type                 id;
+
+         scheduled_event_type    type = limit_order_expiration_event;
+         time_point_sec          next_due;
+   };
+
+   struct by_type;
+   struct by_next_due;
+   typedef multi_index_container<
+      scheduled_event_object,
+      indexed_by<
+         ordered_unique< tag< by_id >, member< scheduled_event_object, scheduled_event_object_id_type, &scheduled_event_object::id > >,
+         ordered_unique< tag< by_type >, member< scheduled_event_object, scheduled_event_type, &scheduled_event_object::type > >,
+         ordered_unique< tag< by_next_due >,
+            composite_key< scheduled_event_object,
+               member< scheduled_event_object, time_point_sec, &scheduled_event_object::next_due >,
+               member< scheduled_event_object, scheduled_event_object_id_type, &scheduled_event_object::id >
+            >
+         >
+      >,
+      allocator< scheduled_event_object >
+   > scheduled_event_index;
+
+} } // steem::chain
+
+FC_REFLECT_ENUM( steem::chain::scheduled_event_type,
+   (limit_order_expiration_event)
+   (vesting_delegation_expiration_event)
+   (convert_request_event)
+   (savings_withdraw_event)
+   (account_recovery_request_expiration_event)
+   (change_recovery_account_event)
+   (escrow_ratification_expiration_event)
+   (decline_voting_rights_event)
+   (scheduled_event_type_count) )
+
+FC_REFLECT( steem::chain::scheduled_event_object, (id)(type)(next_due) )
+CHAINBASE_SET_INDEX_TYPE( steem::chain::scheduled_event_object, steem::chain::scheduled_event_index )
@@ -65,6 +65,7 @@ enum object_type
    reward_fund_object_type,
    vesting_delegation_object_type,
    vesting_delegation_expiration_object_type,
+   scheduled_event_object_type,
 #ifdef STEEM_ENABLE_SMT
    // SMT objects
    smt_token_object_type,
@@ -103,6 +104,7 @@ class block_stats_object;
 class reward_fund_object;
 class vesting_delegation_object;
 class vesting_delegation_expiration_object;
+class scheduled_event_object;
 
 #ifdef STEEM_ENABLE_SMT
 class smt_token_object;
@@ -140,6 +142,7 @@ typedef oid< block_stats_object                     > block_stats_id_type;
 typedef oid< reward_fund_object                     > reward_fund_id_type;
 typedef oid< vesting_delegation_object              > vesting_delegation_id_type;
 typedef oid< vesting_delegation_expiration_object   > vesting_delegation_expiration_id_type;
+typedef oid< scheduled_event_object                 > scheduled_event_object_id_type;
 
 #ifdef STEEM_ENABLE_SMT
 typedef oid< smt_token_object                       > smt_token_id_type;
@@ -238,6 +241,7 @@ FC_REFLECT_ENUM( steem::chain::object_type,
                  (reward_fund_object_type)
                  (vesting_delegation_object_type)
                  (vesting_delegation_expiration_object_type)
+                 (scheduled_event_object_type)
 
 #ifdef STEEM_ENABLE_SMT
                  (smt_token_object_type)
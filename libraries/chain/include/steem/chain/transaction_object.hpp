@@ -1,7 +1,6 @@
 #pragma once
 #include <steem/protocol/transaction.hpp>
 
-#include <steem/chain/buffer_type.hpp>
 #include <steem/chain/steem_object_types.hpp>
 
 #include <boost/multi_index/hashed_index.hpp>
@@ -9,12 +8,14 @@
 namespace steem { namespace chain {
 
    using steem::protocol::signed_transaction;
-   using chainbase::t_vector;
 
    /**
     * The purpose of this object is to enable the detection of duplicate transactions. When a transaction is included
     * in a block a transaction_object is added. At the end of block processing all transaction_objects that have
     * expired can be removed from the index.
+    *
+    * Only the id and expiration are kept, so that the object has a fixed size and creating, undoing and removing it
+    * does not allocate.  The transaction itself is kept by the recent_transaction_cache, outside of shared memory.
     */
    class transaction_object : public object< transaction_object_type, transaction_object >
    {
@@ -23,16 +24,12 @@ namespace steem { namespace chain {
       public:
          template< typename Constructor, typename Allocator >
          transaction_object( Constructor&& c, allocator< Allocator > a )
-            : packed_trx( a )
          {
             c( *this );
          }
 
          id_type              id;
 
-         typedef buffer_type t_packed_trx;
-
-         t_packed_trx         packed_trx;
          transaction_id_type  trx_id;
          time_point_sec       expiration;
    };
@@ -51,33 +48,6 @@ namespace steem { namespace chain {
 
 } } // steem::chain
 
-FC_REFLECT( steem::chain::transaction_object, (id)(packed_trx)(trx_id)(expiration) )
+FC_REFLECT( steem::chain::transaction_object, (id)(trx_id)(expiration) )
 CHAINBASE_SET_INDEX_TYPE( steem::chain::transaction_object, steem::chain::transaction_index )
 
-namespace helpers
-{
-   template <>
-   class index_statistic_provider<steem::chain::transaction_index>
-   {
-   public:
-      typedef steem::chain::transaction_index IndexType;
-      typedef typename steem::chain::transaction_object::t_packed_trx t_packed_trx;
-
-      index_statistic_info gather_statistics(const IndexType& index, bool onlyStaticInfo) const
-      {
-         index_statistic_info info;
-         gather_index_static_data(index, &info);
-
-         if(onlyStaticInfo == false)
-         {
-            for(const auto& o : index)
-            {
-               info._item_additional_allocation += o.packed_trx.capacity()*sizeof(t_packed_trx::value_type);
-            }
-         }
-
-         return info;
-      }
-   };
-
-} /// namespace helpers
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+#include <fc/variant.hpp>
+#include <fc/reflect/variant.hpp>
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace steem { namespace chain { namespace util {
+
+/**
+ * Times the phases of block application, for the blocks it samples.
+ *
+ * Unlike advanced_benchmark_dumper, which sums time per operation and per plugin over the whole run,
+ * this keeps one trace per sampled block, so that a slow block can be broken down into the phases of
+ * database::apply_block.  The last max_blocks traces are kept, summarized into percentiles per phase,
+ * and exported in the Chrome trace event format (chrome://tracing, Perfetto).
+ *
+ * Blocks are traced and phases timed on the write thread only.  Configuration and the kept traces may
+ * be read from any thread.  When disabled, or for blocks not sampled, a phase costs one branch.
+ */
+class block_profiler
+{
+   public:
+      struct phase_event
+      {
+         std::string       name;
+         /// Offset from the start of the block
+         int64_t           start_us = 0;
+         int64_t           duration_us = 0;
+      };
+
+      struct block_trace
+      {
+         uint32_t                   block_num = 0;
+         fc::time_point             start;
+         int64_t                    duration_us = 0;
+         std::vector< phase_event > phases;
+      };
+
+      struct phase_summary
+      {
+         std::string name;
+         uint32_t    count = 0;
+         int64_t     mean_us = 0;
+         int64_t     p50_us = 0;
+         int64_t     p90_us = 0;
+         int64_t     p99_us = 0;
+         int64_t     max_us = 0;
+      };
+
+      /// Traces a block for as long as it lives, when the block is sampled.  Nested scopes do nothing.
+      class block_scope
+      {
+         public:
+            block_scope( block_profiler& profiler, uint32_t block_num );
+            ~block_scope();
+
+         private:
+            block_profiler* _profiler = nullptr;
+      };
+
+      /**
+       * Times consecutive phases of the traced block.  The current phase ends when next() starts the
+       * following one, or when the scope ends.
+       */
+      class phase_scope
+      {
+         public:
+            phase_scope( block_profiler& profiler, const char* name );
+            ~phase_scope();
+
+            void next( const char* name );
+            void end();
+
+         private:
+
+            block_trace*   _trace = nullptr;
+            const char*    _name = nullptr;
+            fc::time_point _start;
+      };
+
+      void set_enabled( bool enabled ) { _enabled = enabled; }
+      bool is_enabled()const { return _enabled; }
+
+      /// Traces one block in every sample_interval
+      void     set_sample_interval( uint32_t interval ) { _sample_interval = std::max< uint32_t >( interval, 1 ); }
+      uint32_t get_sample_interval()const { return _sample_interval; }
+
+      void     set_max_blocks( uint32_t max_blocks );
+      uint32_t get_max_blocks()const { return _max_blocks; }
+
+      std::vector< block_trace >    get_traces()const;
+      /// Percentiles of every phase over the kept traces, with the whole block as "block"
+      std::vector< phase_summary >  get_summary()const;
+
+      /// Trace event JSON object, one complete event per phase and one per block
+      fc::variant to_chrome_trace()const;
+      void        save_chrome_trace( const fc::path& path )const;
+
+      void clear();
+
+   private:
+      std::atomic< bool >        _enabled{ false };
+      std::atomic< uint32_t >    _sample_interval{ 1 };
+      std::atomic< uint32_t >    _max_blocks{ 1000 };
+
+      /// The block being traced, owned by the write thread
+      std::unique_ptr< block_trace > _current;
+
+      std::deque< block_trace >  _traces;
+      mutable boost::mutex       _traces_mutex;
+};
+
+} } } // steem::chain::util
+
+FC_REFLECT( steem::chain::util::block_profiler::phase_event, (name)(start_us)(duration_us) )
+FC_REFLECT( steem::chain::util::block_profiler::block_trace, (block_num)(start)(duration_us)(phases) )
+FC_REFLECT( steem::chain::util::block_profiler::phase_summary, (name)(count)(mean_us)(p50_us)(p90_us)(p99_us)(max_us) )
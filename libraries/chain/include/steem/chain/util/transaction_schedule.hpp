@@ -0,0 +1,52 @@
+#pragma once
+
+#include <steem/protocol/operations.hpp>
+#include <steem/protocol/transaction.hpp>
+
+#include <vector>
+
+namespace steem { namespace chain { namespace util {
+
+/**
+ * Whether applying op in another position among the transactions of its block, relative to transactions
+ * that share none of its impacted accounts, leaves the chain state unchanged.
+ *
+ * That holds for operations that only modify objects owned by their impacted accounts and create or
+ * remove none, since object ids follow the order of creation.  Most operations do not qualify: votes
+ * and comments create objects and update parent posts, SBD balance changes pay interest out of the
+ * global properties, markets, witnesses and vesting share global objects, and custom_json feeds plugin
+ * evaluators that may do anything.
+ *
+ * Authority changes do not qualify either.  A transaction of any account may be signed through the
+ * account_auths of the changed one, and whether its signatures verify depends on the order.
+ */
+bool is_reorderable_operation( const steem::protocol::operation& op );
+
+/**
+ * A partition of the transactions of a block into waves, such that the transactions of one wave share
+ * no impacted account and every transaction comes after the transactions it conflicts with.  A
+ * transaction with an operation that is not reorderable conflicts with everything and is alone in its
+ * wave.  Applying the block wave by wave gives the same accounts, balances and authorities as applying
+ * it in order; the ids of the transaction_objects of the dupe check follow the order of application.
+ *
+ * The chain still applies transactions serially: chainbase has one writer and one undo stack, and
+ * plugins observe operations in order.  This is the scheduling half of parallel execution, used to
+ * measure how much of the chain it could cover.
+ */
+struct transaction_schedule
+{
+   /// Wave of every transaction, in block order
+   std::vector< uint32_t > waves;
+   uint32_t                wave_count = 0;
+   /// Transactions applied alone because of an operation that is not reorderable
+   uint32_t                serial_count = 0;
+
+   /// Transaction indices, wave by wave, in block order within a wave
+   std::vector< uint32_t > execution_order()const;
+   /// Number of transactions in the largest wave
+   uint32_t                max_wave_size()const;
+};
+
+transaction_schedule schedule_transactions( const std::vector< steem::protocol::signed_transaction >& trxs );
+
+} } } // steem::chain::util
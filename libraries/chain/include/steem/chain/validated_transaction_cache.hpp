@@ -0,0 +1,63 @@
+#pragma once
+#include <steem/protocol/transaction.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+
+namespace steem { namespace chain {
+
+   using steem::protocol::signed_transaction;
+   using steem::protocol::transaction_id_type;
+   using steem::protocol::signature_type;
+   using steem::protocol::public_key_type;
+
+   /**
+    *  Keeps the keys recovered from the signatures of pending transactions.  Pending
+    *  transactions are applied again after every block, and once more when they are
+    *  included in a block; with their keys at hand only the authority check against
+    *  the current state and the evaluators have to run again.
+    *
+    *  Signature recovery and validate() depend on nothing but the transaction, so the
+    *  cached result stays correct as long as the signatures match.  Entries are removed
+    *  when their transaction is applied in a block or expires.
+    */
+   class validated_transaction_cache
+   {
+      public:
+         /** @return the keys recovered from trx, or nullptr if trx was not validated with these signatures */
+         const flat_set< public_key_type >* find( const transaction_id_type& id, const signed_transaction& trx )const;
+
+         void insert( const transaction_id_type& id, const signed_transaction& trx, flat_set< public_key_type > signature_keys );
+         void remove( const transaction_id_type& id );
+         void remove_expired( fc::time_point_sec now );
+         void clear();
+
+         size_t size()const { return _index.size(); }
+
+      private:
+         struct validated_transaction
+         {
+            transaction_id_type              id;
+            fc::time_point_sec               expiration;
+            vector< signature_type >         signatures;
+            flat_set< public_key_type >      signature_keys;
+         };
+
+         struct by_id;
+         struct by_expiration;
+         typedef boost::multi_index_container<
+            validated_transaction,
+            boost::multi_index::indexed_by<
+               boost::multi_index::hashed_unique< boost::multi_index::tag< by_id >,
+                  boost::multi_index::member< validated_transaction, transaction_id_type, &validated_transaction::id >, std::hash< fc::ripemd160 > >,
+               boost::multi_index::ordered_non_unique< boost::multi_index::tag< by_expiration >,
+                  boost::multi_index::member< validated_transaction, fc::time_point_sec, &validated_transaction::expiration > >
+            >
+         > validated_transaction_index;
+
+         validated_transaction_index   _index;
+   };
+
+} } // steem::chain
@@ -0,0 +1,49 @@
+#pragma once
+#include <steem/chain/account_object.hpp>
+#include <steem/chain/witness_objects.hpp>
+
+#include <array>
+#include <map>
+#include <vector>
+
+namespace steem { namespace chain {
+
+   class database;
+
+   /**
+    *  Sums the witness vote changes that follow vesting changes over a phase of block processing, to
+    *  modify each proxy and each witness once instead of once per change.  Every change of witness votes
+    *  repositions the witness in by_vote_name, and a power down can reach thirty witnesses per account.
+    *
+    *  The proxy chain and the witness votes of an account are looked up once per phase.  The witnesses
+    *  are adjusted with the net change of the phase, against the same virtual time as the changes they
+    *  replace, which leaves them as the changes applied one by one would.  Nothing in the phase may
+    *  change a proxy or a witness vote, or read witness votes, before flush().
+    */
+   class witness_vote_tally
+   {
+      public:
+         /// Records what database::adjust_proxied_witness_votes( a, delta ) does
+         void adjust_proxied_witness_votes( const database& db, const account_object& a, share_type delta );
+
+         void flush( database& db );
+
+         bool empty()const { return _witness_deltas.empty() && _proxied_deltas.empty(); }
+
+      private:
+         struct resolved_voter
+         {
+            /// The proxies the votes of the account go through, in order of depth
+            vector< account_id_type >  proxies;
+            /// The witnesses the votes end up on, none when the proxy chain is too deep
+            vector< witness_id_type >  witnesses;
+         };
+
+         const resolved_voter& resolve( const database& db, const account_object& a );
+
+         std::map< account_id_type, resolved_voter >    _voters;
+         std::map< account_id_type, std::array< share_type, STEEM_MAX_PROXY_RECURSION_DEPTH > > _proxied_deltas;
+         std::map< witness_id_type, share_type >        _witness_deltas;
+   };
+
+} } // steem::chain
@@ -0,0 +1,37 @@
+#include <steem/chain/recent_transaction_cache.hpp>
+
+namespace steem { namespace chain {
+
+const signed_transaction* recent_transaction_cache::find( const transaction_id_type& id )const
+{
+   const auto& by_id_idx = _index.get< by_id >();
+   auto itr = by_id_idx.find( id );
+   return itr == by_id_idx.end() ? nullptr : &itr->trx;
+}
+
+void recent_transaction_cache::insert( const transaction_id_type& id, const signed_transaction& trx )
+{
+   auto& by_id_idx = _index.get< by_id >();
+   if( by_id_idx.find( id ) != by_id_idx.end() )
+      return;
+
+   recent_transaction entry;
+   entry.id = id;
+   entry.expiration = trx.expiration;
+   entry.trx = trx;
+   _index.insert( std::move( entry ) );
+}
+
+void recent_transaction_cache::remove_expired( fc::time_point_sec now )
+{
+   // Same bound as the dupe check, transaction_objects are removed once head block time passes expiration
+   auto& by_expiration_idx = _index.get< by_expiration >();
+   by_expiration_idx.erase( by_expiration_idx.begin(), by_expiration_idx.lower_bound( now ) );
+}
+
+void recent_transaction_cache::clear()
+{
+   _index.clear();
+}
+
+} } // steem::chain
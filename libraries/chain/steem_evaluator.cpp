@@ -832,7 +832,7 @@ void escrow_transfer_evaluator::do_apply( const escrow_transfer_operation& o )
       _db.adjust_balance( from_account, -steem_spent );
       _db.adjust_balance( from_account, -sbd_spent );
 
-      _db.create<escrow_object>([&]( escrow_object& esc )
+      const auto& escrow = _db.create<escrow_object>([&]( escrow_object& esc )
       {
          esc.escrow_id              = o.escrow_id;
          esc.from                   = o.from;
@@ -844,6 +844,8 @@ void escrow_transfer_evaluator::do_apply( const escrow_transfer_operation& o )
          esc.steem_balance          = o.steem_amount;
          esc.pending_fee            = o.fee;
       });
+
+      _db.schedule_event( escrow_ratification_expiration_event, escrow.ratification_deadline );
    }
    FC_CAPTURE_AND_RETHROW( (o) )
 }
@@ -1771,7 +1773,7 @@ void convert_evaluator::do_apply( const convert_operation& o )
   if( _db.has_hardfork( STEEM_HARDFORK_0_16__551) )
      steem_conversion_delay = STEEM_CONVERSION_DELAY;
 
-  _db.create<convert_request_object>( [&]( convert_request_object& obj )
+  const auto& request = _db.create<convert_request_object>( [&]( convert_request_object& obj )
   {
       obj.owner           = o.owner;
       obj.requestid       = o.requestid;
@@ -1779,6 +1781,8 @@ void convert_evaluator::do_apply( const convert_operation& o )
       obj.conversion_date = _db.head_block_time() + steem_conversion_delay;
   });
 
+  _db.schedule_event( convert_request_event, request.conversion_date );
+
 }
 
 void limit_order_create_evaluator::do_apply( const limit_order_create_operation& o )
@@ -1799,6 +1803,8 @@ void limit_order_create_evaluator::do_apply( const limit_order_create_operation&
        obj.expiration = o.expiration;
    });
 
+   _db.schedule_event( limit_order_expiration_event, order.expiration );
+
    bool filled = _db.apply_order( order );
 
    if( o.fill_or_kill ) FC_ASSERT( filled, "Cancelling order because it was not filled." );
@@ -1822,6 +1828,8 @@ void limit_order_create2_evaluator::do_apply( const limit_order_create2_operatio
        obj.expiration = o.expiration;
    });
 
+   _db.schedule_event( limit_order_expiration_event, order.expiration );
+
    bool filled = _db.apply_order( order );
 
    if( o.fill_or_kill ) FC_ASSERT( filled, "Cancelling order because it was not filled." );
@@ -1877,12 +1885,14 @@ void request_account_recovery_evaluator::do_apply( const request_account_recover
          }
       }
 
-      _db.create< account_recovery_request_object >( [&]( account_recovery_request_object& req )
+      const auto& new_request = _db.create< account_recovery_request_object >( [&]( account_recovery_request_object& req )
       {
          req.account_to_recover = o.account_to_recover;
          req.new_owner_authority = o.new_owner_authority;
          req.expires = _db.head_block_time() + STEEM_ACCOUNT_RECOVERY_REQUEST_EXPIRATION_PERIOD;
       });
+
+      _db.schedule_event( account_recovery_request_expiration_event, new_request.expires );
    }
    else if( o.new_owner_authority.weight_threshold == 0 ) // Cancel Request if authority is open
    {
@@ -1906,6 +1916,8 @@ void request_account_recovery_evaluator::do_apply( const request_account_recover
          req.new_owner_authority = o.new_owner_authority;
          req.expires = _db.head_block_time() + STEEM_ACCOUNT_RECOVERY_REQUEST_EXPIRATION_PERIOD;
       });
+
+      _db.schedule_event( account_recovery_request_expiration_event, request->expires );
    }
 }
 
@@ -1953,12 +1965,14 @@ void change_recovery_account_evaluator::do_apply( const change_recovery_account_
 
    if( request == change_recovery_idx.end() ) // New request
    {
-      _db.create< change_recovery_account_request_object >( [&]( change_recovery_account_request_object& req )
+      const auto& new_request = _db.create< change_recovery_account_request_object >( [&]( change_recovery_account_request_object& req )
       {
          req.account_to_recover = o.account_to_recover;
          req.recovery_account = o.new_recovery_account;
          req.effective_on = _db.head_block_time() + STEEM_OWNER_AUTH_RECOVERY_PERIOD;
       });
+
+      _db.schedule_event( change_recovery_account_event, new_request.effective_on );
    }
    else if( account_to_recover.recovery_account != o.new_recovery_account ) // Change existing request
    {
@@ -1967,6 +1981,8 @@ void change_recovery_account_evaluator::do_apply( const change_recovery_account_
          req.recovery_account = o.new_recovery_account;
          req.effective_on = _db.head_block_time() + STEEM_OWNER_AUTH_RECOVERY_PERIOD;
       });
+
+      _db.schedule_event( change_recovery_account_event, request->effective_on );
    }
    else // Request exists and changing back to current recovery account
    {
@@ -1993,7 +2009,7 @@ void transfer_from_savings_evaluator::do_apply( const transfer_from_savings_oper
 
    FC_ASSERT( _db.get_savings_balance( from, op.amount.symbol ) >= op.amount );
    _db.adjust_savings_balance( from, -op.amount );
-   _db.create<savings_withdraw_object>( [&]( savings_withdraw_object& s ) {
+   const auto& withdraw = _db.create<savings_withdraw_object>( [&]( savings_withdraw_object& s ) {
       s.from   = op.from;
       s.to     = op.to;
       s.amount = op.amount;
@@ -2004,6 +2020,8 @@ void transfer_from_savings_evaluator::do_apply( const transfer_from_savings_oper
       s.complete = _db.head_block_time() + STEEM_SAVINGS_WITHDRAW_TIME;
    });
 
+   _db.schedule_event( savings_withdraw_event, withdraw.complete );
+
    _db.modify( from, [&]( account_object& a )
    {
       a.savings_withdraw_requests++;
@@ -2035,11 +2053,13 @@ void decline_voting_rights_evaluator::do_apply( const decline_voting_rights_oper
    {
       FC_ASSERT( itr == request_idx.end(), "Cannot create new request because one already exists." );
 
-      _db.create< decline_voting_rights_request_object >( [&]( decline_voting_rights_request_object& req )
+      const auto& request = _db.create< decline_voting_rights_request_object >( [&]( decline_voting_rights_request_object& req )
       {
          req.account = account.name;
          req.effective_date = _db.head_block_time() + STEEM_OWNER_AUTH_RECOVERY_PERIOD;
       });
+
+      _db.schedule_event( decline_voting_rights_event, request.effective_date );
    }
    else
    {
@@ -2268,13 +2288,15 @@ void delegate_vesting_shares_evaluator::do_apply( const delegate_vesting_shares_
          FC_ASSERT( delegation->vesting_shares.amount > 0, "Delegation would set vesting_shares to zero, but it is already zero");
       }
 
-      _db.create< vesting_delegation_expiration_object >( [&]( vesting_delegation_expiration_object& obj )
+      const auto& expiration = _db.create< vesting_delegation_expiration_object >( [&]( vesting_delegation_expiration_object& obj )
       {
          obj.delegator = op.delegator;
          obj.vesting_shares = delta;
          obj.expiration = std::max( _db.head_block_time() + STEEM_CASHOUT_WINDOW_SECONDS, delegation->min_delegation_time );
       });
 
+      _db.schedule_event( vesting_delegation_expiration_event, expiration.expiration );
+
       _db.modify( delegatee, [&]( account_object& a )
       {
          a.received_vesting_shares -= delta;
@@ -0,0 +1,202 @@
+#include <steem/chain/util/block_profiler.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <map>
+
+namespace steem { namespace chain { namespace util {
+
+block_profiler::block_scope::block_scope( block_profiler& profiler, uint32_t block_num )
+{
+   if( !profiler._enabled || profiler._current || block_num % profiler._sample_interval != 0 )
+      return;
+
+   _profiler = &profiler;
+   _profiler->_current.reset( new block_trace() );
+   _profiler->_current->block_num = block_num;
+   _profiler->_current->start = fc::time_point::now();
+}
+
+block_profiler::block_scope::~block_scope()
+{
+   if( !_profiler )
+      return;
+
+   std::unique_ptr< block_trace > trace = std::move( _profiler->_current );
+
+   // Blocks that failed to apply are not kept, their phases stop where the exception was thrown
+   if( std::uncaught_exception() )
+      return;
+
+   trace->duration_us = ( fc::time_point::now() - trace->start ).count();
+
+   boost::unique_lock< boost::mutex > guard( _profiler->_traces_mutex );
+   _profiler->_traces.push_back( std::move( *trace ) );
+   while( _profiler->_traces.size() > _profiler->_max_blocks )
+      _profiler->_traces.pop_front();
+}
+
+block_profiler::phase_scope::phase_scope( block_profiler& profiler, const char* name )
+   : _trace( profiler._current.get() )
+{
+   if( _trace )
+   {
+      _name = name;
+      _start = fc::time_point::now();
+   }
+}
+
+block_profiler::phase_scope::~phase_scope()
+{
+   end();
+}
+
+void block_profiler::phase_scope::next( const char* name )
+{
+   if( !_trace )
+      return;
+
+   end();
+   _name = name;
+   _start = fc::time_point::now();
+}
+
+void block_profiler::phase_scope::end()
+{
+   if( !_trace || !_name )
+      return;
+
+   phase_event event;
+   event.name = _name;
+   event.start_us = ( _start - _trace->start ).count();
+   event.duration_us = ( fc::time_point::now() - _start ).count();
+   _trace->phases.push_back( std::move( event ) );
+   _name = nullptr;
+}
+
+void block_profiler::set_max_blocks( uint32_t max_blocks )
+{
+   _max_blocks = std::max< uint32_t >( max_blocks, 1 );
+
+   boost::unique_lock< boost::mutex > guard( _traces_mutex );
+   while( _traces.size() > _max_blocks )
+      _traces.pop_front();
+}
+
+std::vector< block_profiler::block_trace > block_profiler::get_traces()const
+{
+   boost::unique_lock< boost::mutex > guard( _traces_mutex );
+   return std::vector< block_trace >( _traces.begin(), _traces.end() );
+}
+
+namespace {
+
+int64_t percentile( const std::vector< int64_t >& sorted, uint32_t pct )
+{
+   // nearest rank
+   size_t rank = ( sorted.size() * pct + 99 ) / 100;
+   return sorted[ rank > 0 ? rank - 1 : 0 ];
+}
+
+} // anonymous
+
+std::vector< block_profiler::phase_summary > block_profiler::get_summary()const
+{
+   // Phases are listed in the order they first appear, which is the order they run in
+   std::vector< std::string > names = { "block" };
+   std::map< std::string, std::vector< int64_t > > durations;
+
+   {
+      boost::unique_lock< boost::mutex > guard( _traces_mutex );
+      for( const auto& trace : _traces )
+      {
+         durations[ "block" ].push_back( trace.duration_us );
+         for( const auto& phase : trace.phases )
+         {
+            auto& phase_durations = durations[ phase.name ];
+            if( phase_durations.empty() )
+               names.push_back( phase.name );
+            phase_durations.push_back( phase.duration_us );
+         }
+      }
+   }
+
+   std::vector< phase_summary > result;
+   for( const auto& name : names )
+   {
+      auto& values = durations[ name ];
+      if( values.empty() )
+         continue;
+
+      std::sort( values.begin(), values.end() );
+
+      phase_summary summary;
+      summary.name = name;
+      summary.count = values.size();
+      int64_t total = 0;
+      for( int64_t v : values )
+         total += v;
+      summary.mean_us = total / int64_t( values.size() );
+      summary.p50_us = percentile( values, 50 );
+      summary.p90_us = percentile( values, 90 );
+      summary.p99_us = percentile( values, 99 );
+      summary.max_us = values.back();
+      result.push_back( std::move( summary ) );
+   }
+
+   return result;
+}
+
+fc::variant block_profiler::to_chrome_trace()const
+{
+   fc::variants events;
+
+   for( const auto& trace : get_traces() )
+   {
+      int64_t block_ts = trace.start.time_since_epoch().count();
+
+      events.push_back( fc::mutable_variant_object()
+         ( "name", "block " + std::to_string( trace.block_num ) )
+         ( "cat", "block" )
+         ( "ph", "X" )
+         ( "ts", block_ts )
+         ( "dur", trace.duration_us )
+         ( "pid", 1 )
+         ( "tid", 1 )
+         ( "args", fc::mutable_variant_object()( "block_num", trace.block_num ) ) );
+
+      for( const auto& phase : trace.phases )
+      {
+         events.push_back( fc::mutable_variant_object()
+            ( "name", phase.name )
+            ( "cat", "phase" )
+            ( "ph", "X" )
+            ( "ts", block_ts + phase.start_us )
+            ( "dur", phase.duration_us )
+            ( "pid", 1 )
+            ( "tid", 1 )
+            ( "args", fc::mutable_variant_object()( "block_num", trace.block_num ) ) );
+      }
+   }
+
+   return fc::mutable_variant_object()
+      ( "traceEvents", events )
+      ( "displayTimeUnit", "ms" );
+}
+
+void block_profiler::save_chrome_trace( const fc::path& path )const
+{
+   // Timestamps are written as numbers, trace viewers don't accept fc's quoted 64 bit integers
+   fc::json::save_to_file( to_chrome_trace(), path, false, fc::json::legacy_generator );
+}
+
+void block_profiler::clear()
+{
+   boost::unique_lock< boost::mutex > guard( _traces_mutex );
+   _traces.clear();
+}
+
+} } } // steem::chain::util
@@ -0,0 +1,111 @@
+#include <steem/chain/util/transaction_schedule.hpp>
+#include <steem/chain/util/impacted.hpp>
+
+#include <steem/protocol/config.hpp>
+
+#include <algorithm>
+#include <map>
+
+namespace steem { namespace chain { namespace util {
+
+using namespace steem::protocol;
+
+struct reorderable_operation_visitor
+{
+   typedef bool result_type;
+
+   template< typename T >
+   bool operator()( const T& )const { return false; }
+
+   bool operator()( const transfer_operation& op )const
+   {
+      return op.amount.symbol == STEEM_SYMBOL;
+   }
+
+   bool operator()( const transfer_to_savings_operation& op )const
+   {
+      return op.amount.symbol == STEEM_SYMBOL;
+   }
+
+   bool operator()( const account_update_operation& op )const
+   {
+      // Updating the owner authority records the previous one in a new owner_authority_history_object.
+      // Active and posting authorities may be used through account_auths to sign for other accounts.
+      return !op.owner && !op.active && !op.posting;
+   }
+
+   bool operator()( const custom_operation& )const { return true; }
+};
+
+bool is_reorderable_operation( const operation& op )
+{
+   return op.visit( reorderable_operation_visitor() );
+}
+
+std::vector< uint32_t > transaction_schedule::execution_order()const
+{
+   std::vector< uint32_t > order( waves.size() );
+   for( uint32_t i = 0; i < order.size(); ++i )
+      order[i] = i;
+
+   std::stable_sort( order.begin(), order.end(), [&]( uint32_t a, uint32_t b ) { return waves[a] < waves[b]; } );
+   return order;
+}
+
+uint32_t transaction_schedule::max_wave_size()const
+{
+   std::vector< uint32_t > sizes( wave_count );
+   for( uint32_t w : waves )
+      ++sizes[w];
+
+   return sizes.empty() ? 0 : *std::max_element( sizes.begin(), sizes.end() );
+}
+
+transaction_schedule schedule_transactions( const std::vector< signed_transaction >& trxs )
+{
+   transaction_schedule schedule;
+   schedule.waves.reserve( trxs.size() );
+
+   // First wave each account is free in, and first wave after the last serial transaction
+   std::map< account_name_type, uint32_t > free_from;
+   uint32_t floor = 0;
+   flat_set< account_name_type > impacted;
+
+   for( const auto& trx : trxs )
+   {
+      bool reorderable = std::all_of( trx.operations.begin(), trx.operations.end(),
+         []( const operation& op ) { return is_reorderable_operation( op ); } );
+
+      uint32_t wave = 0;
+
+      if( reorderable )
+      {
+         impacted.clear();
+         steem::app::transaction_get_impacted_accounts( trx, impacted );
+
+         wave = floor;
+         for( const auto& name : impacted )
+         {
+            auto itr = free_from.find( name );
+            if( itr != free_from.end() )
+               wave = std::max( wave, itr->second );
+         }
+
+         for( const auto& name : impacted )
+            free_from[ name ] = wave + 1;
+      }
+      else
+      {
+         wave = schedule.wave_count;
+         floor = wave + 1;
+         ++schedule.serial_count;
+      }
+
+      schedule.waves.push_back( wave );
+      schedule.wave_count = std::max( schedule.wave_count, wave + 1 );
+   }
+
+   return schedule;
+}
+
+} } } // steem::chain::util
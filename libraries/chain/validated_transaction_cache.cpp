@@ -0,0 +1,48 @@
+#include <steem/chain/validated_transaction_cache.hpp>
+
+namespace steem { namespace chain {
+
+const flat_set< public_key_type >* validated_transaction_cache::find( const transaction_id_type& id, const signed_transaction& trx )const
+{
+   const auto& by_id_idx = _index.get< by_id >();
+   auto itr = by_id_idx.find( id );
+
+   // The id does not cover the signatures, the same transaction may arrive signed differently
+   if( itr == by_id_idx.end() || itr->signatures != trx.signatures )
+      return nullptr;
+
+   return &itr->signature_keys;
+}
+
+void validated_transaction_cache::insert( const transaction_id_type& id, const signed_transaction& trx, flat_set< public_key_type > signature_keys )
+{
+   auto& by_id_idx = _index.get< by_id >();
+   auto itr = by_id_idx.find( id );
+   if( itr != by_id_idx.end() )
+      by_id_idx.erase( itr );
+
+   validated_transaction entry;
+   entry.id = id;
+   entry.expiration = trx.expiration;
+   entry.signatures = trx.signatures;
+   entry.signature_keys = std::move( signature_keys );
+   _index.insert( std::move( entry ) );
+}
+
+void validated_transaction_cache::remove( const transaction_id_type& id )
+{
+   _index.get< by_id >().erase( id );
+}
+
+void validated_transaction_cache::remove_expired( fc::time_point_sec now )
+{
+   auto& by_expiration_idx = _index.get< by_expiration >();
+   by_expiration_idx.erase( by_expiration_idx.begin(), by_expiration_idx.lower_bound( now ) );
+}
+
+void validated_transaction_cache::clear()
+{
+   _index.clear();
+}
+
+} } // steem::chain
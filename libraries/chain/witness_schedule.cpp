@@ -5,6 +5,8 @@
 
 #include <steem/protocol/config.hpp>
 
+#include <algorithm>
+
 namespace steem { namespace chain {
 
 void reset_virtual_schedule_time( database& db )
@@ -27,6 +29,18 @@ void reset_virtual_schedule_time( database& db )
    }
 }
 
+/**
+ * The witness at the middle of active once ordered by less.  Witnesses that compare equal have the same
+ * value, so selecting it gives the value a full sort would.
+ */
+template< typename Less >
+const witness_object& median_witness( vector< const witness_object* >& active, Less less )
+{
+   auto median = active.begin() + active.size() / 2;
+   std::nth_element( active.begin(), median, active.end(), less );
+   return **median;
+}
+
 void update_median_witness_props( database& db )
 {
    const witness_schedule_object& wso = db.get_witness_schedule_object();
@@ -38,33 +52,26 @@ void update_median_witness_props( database& db )
       active.push_back( &db.get_witness( wso.current_shuffled_witnesses[i] ) );
    }
 
-   /// sort them by account_creation_fee
-   std::sort( active.begin(), active.end(), [&]( const witness_object* a, const witness_object* b )
+   /// select the median of each property, the ordering of the other witnesses does not matter
+   asset median_account_creation_fee = median_witness( active, []( const witness_object* a, const witness_object* b )
    {
       return a->props.account_creation_fee.amount < b->props.account_creation_fee.amount;
-   } );
-   asset median_account_creation_fee = active[active.size()/2]->props.account_creation_fee;
+   } ).props.account_creation_fee;
 
-   /// sort them by maximum_block_size
-   std::sort( active.begin(), active.end(), [&]( const witness_object* a, const witness_object* b )
+   uint32_t median_maximum_block_size = median_witness( active, []( const witness_object* a, const witness_object* b )
    {
       return a->props.maximum_block_size < b->props.maximum_block_size;
-   } );
-   uint32_t median_maximum_block_size = active[active.size()/2]->props.maximum_block_size;
+   } ).props.maximum_block_size;
 
-   /// sort them by sbd_interest_rate
-   std::sort( active.begin(), active.end(), [&]( const witness_object* a, const witness_object* b )
+   uint16_t median_sbd_interest_rate = median_witness( active, []( const witness_object* a, const witness_object* b )
    {
       return a->props.sbd_interest_rate < b->props.sbd_interest_rate;
-   } );
-   uint16_t median_sbd_interest_rate = active[active.size()/2]->props.sbd_interest_rate;
+   } ).props.sbd_interest_rate;
 
-   /// sort them by account_subsidy_limit
-   std::sort( active.begin(), active.end(), [&]( const witness_object* a, const witness_object* b )
+   uint32_t median_account_subsidy_limit = median_witness( active, []( const witness_object* a, const witness_object* b )
    {
       return a->props.account_subsidy_limit < b->props.account_subsidy_limit;
-   } );
-   uint32_t median_account_subsidy_limit = active[active.size()/2]->props.account_subsidy_limit;
+   } ).props.account_subsidy_limit;
 
    db.modify( wso, [&]( witness_schedule_object& _wso )
    {
@@ -201,7 +208,7 @@ void update_witness_schedule4( database& db )
 
       for( uint32_t i = 0; i < wso.num_scheduled_witnesses; i++ )
       {
-         auto witness = db.get_witness( wso.current_shuffled_witnesses[ i ] );
+         const auto& witness = db.get_witness( wso.current_shuffled_witnesses[ i ] );
          if( witness_versions.find( witness.running_version ) == witness_versions.end() )
             witness_versions[ witness.running_version ] = 1;
          else
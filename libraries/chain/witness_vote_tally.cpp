@@ -0,0 +1,76 @@
+#include <steem/chain/witness_vote_tally.hpp>
+#include <steem/chain/database.hpp>
+
+namespace steem { namespace chain {
+
+void witness_vote_tally::adjust_proxied_witness_votes( const database& db, const account_object& a, share_type delta )
+{
+   const resolved_voter& voter = resolve( db, a );
+
+   for( size_t depth = 0; depth < voter.proxies.size(); ++depth )
+   {
+      auto itr = _proxied_deltas.find( voter.proxies[ depth ] );
+      if( itr == _proxied_deltas.end() )
+      {
+         itr = _proxied_deltas.emplace( voter.proxies[ depth ], std::array< share_type, STEEM_MAX_PROXY_RECURSION_DEPTH >() ).first;
+         itr->second.fill( 0 );
+      }
+
+      itr->second[ depth ] += delta;
+   }
+
+   // Witnesses touched by opposite changes are still adjusted, as their virtual position moves either way
+   for( const auto& witness : voter.witnesses )
+      _witness_deltas[ witness ] += delta;
+}
+
+const witness_vote_tally::resolved_voter& witness_vote_tally::resolve( const database& db, const account_object& a )
+{
+   auto itr = _voters.find( a.id );
+   if( itr != _voters.end() )
+      return itr->second;
+
+   resolved_voter voter;
+   const account_object* current = &a;
+
+   while( current->proxy != STEEM_PROXY_TO_SELF_ACCOUNT )
+   {
+      /// nested proxies are not supported, vote will not propagate
+      if( voter.proxies.size() >= STEEM_MAX_PROXY_RECURSION_DEPTH )
+         return _voters.emplace( a.id, std::move( voter ) ).first->second;
+
+      current = &db.get_account( current->proxy );
+      voter.proxies.push_back( current->id );
+   }
+
+   const auto& vidx = db.get_index< witness_vote_index >().indices().get< by_account_witness >();
+   for( auto vitr = vidx.lower_bound( boost::make_tuple( current->name, account_name_type() ) );
+        vitr != vidx.end() && vitr->account == current->name;
+        ++vitr )
+   {
+      voter.witnesses.push_back( db.get< witness_object, by_name >( vitr->witness ).id );
+   }
+
+   return _voters.emplace( a.id, std::move( voter ) ).first->second;
+}
+
+void witness_vote_tally::flush( database& db )
+{
+   for( const auto& proxied : _proxied_deltas )
+   {
+      db.modify( db.get< account_object >( proxied.first ), [&]( account_object& acc )
+      {
+         for( size_t depth = 0; depth < STEEM_MAX_PROXY_RECURSION_DEPTH; ++depth )
+            acc.proxied_vsf_votes[ depth ] += proxied.second[ depth ];
+      });
+   }
+
+   for( const auto& witness : _witness_deltas )
+      db.adjust_witness_vote( db.get( witness.first ), witness.second );
+
+   _proxied_deltas.clear();
+   _witness_deltas.clear();
+   _voters.clear();
+}
+
+} } // steem::chain
@@ -23,6 +23,8 @@
  */
 #include <graphene/net/core_messages.hpp>
 
+#include <cstring>
+
 
 namespace graphene { namespace net {
 
@@ -45,6 +47,41 @@ namespace graphene { namespace net {
   const core_message_type_enum check_firewall_reply_message::type            = core_message_type_enum::check_firewall_reply_message_type;
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
+  const core_message_type_enum compact_block_message::type                   = core_message_type_enum::compact_block_message_type;
+  const core_message_type_enum get_compact_block_transactions_message::type  = core_message_type_enum::get_compact_block_transactions_message_type;
+  const core_message_type_enum compact_block_transactions_message::type      = core_message_type_enum::compact_block_transactions_message_type;
+  const core_message_type_enum transport_cipher_switch_message::type         = core_message_type_enum::transport_cipher_switch_message_type;
+
+  compact_block_message::compact_block_message(const block_message& full_block, const item_hash_t& block_message_hash) :
+    header(full_block.block),
+    block_id(full_block.block_id),
+    block_message_hash(block_message_hash)
+  {
+    short_transaction_ids.reserve(full_block.block.transactions.size());
+    for (const signed_transaction& trx : full_block.block.transactions)
+      short_transaction_ids.push_back(short_transaction_id(trx.id()));
+  }
+
+  compact_block_transactions_message::compact_block_transactions_message(const block_message& full_block,
+                                                                         const std::vector<uint32_t>& transaction_indices) :
+    block_id(full_block.block_id)
+  {
+    const std::vector<signed_transaction>& block_transactions = full_block.block.transactions;
+    for (size_t i = 0; i < transaction_indices.size(); ++i)
+      if (transaction_indices[i] >= block_transactions.size() || (i > 0 && transaction_indices[i] <= transaction_indices[i - 1]))
+        return;
+
+    transactions.reserve(transaction_indices.size());
+    for (uint32_t index : transaction_indices)
+      transactions.push_back(block_transactions[index]);
+  }
+
+  uint64_t compact_block_message::short_transaction_id(const transaction_id_type& id)
+  {
+    uint64_t result;
+    memcpy(&result, id.data(), sizeof(result));
+    return result;
+  }
 
 } } // graphene::net
 
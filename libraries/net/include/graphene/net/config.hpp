@@ -57,6 +57,21 @@
 
 #define GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES        (1024 * 1024)
 
+/**
+ * Socket reads and writes, encryption and message framing of peer connections run on
+ * this many I/O threads.  Received messages are handed to the p2p thread, which runs
+ * all state changing logic.  0 keeps the I/O on the p2p thread.  Connections are only
+ * moved to I/O threads while no bandwidth limit is set, and their traffic is not part
+ * of the rate limiter's bandwidth statistics, so the pool is opt in.
+ */
+#define GRAPHENE_NET_DEFAULT_IO_THREADS                      0
+
+/**
+ * Number of received messages of a single connection that may wait for the p2p thread
+ * before its I/O thread stops reading from the socket.
+ */
+#define GRAPHENE_NET_MAX_PENDING_MESSAGE_DELIVERIES          16
+
 /**
  * When we receive a message from the network, we advertise it to
  * our peers and save a copy in a cache were we will find it if
@@ -81,6 +96,14 @@
 
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
+/**
+ * Upper bound, in bytes, on the sync blocks we have requested or received but
+ * not yet pushed to the blockchain.  Requests in flight are counted at the
+ * average size of the sync blocks received so far.
+ */
+#define GRAPHENE_NET_DEFAULT_SYNC_BLOCK_MEMORY_BUDGET        (256 * 1024 * 1024)
+#define GRAPHENE_NET_INITIAL_SYNC_BLOCK_SIZE_ESTIMATE        (4 * 1024)
+
 /**
  * During normal operation, how many items will be fetched from each
  * peer at a time.  This will only come into play when the network
@@ -104,6 +127,19 @@
 
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
 
+/**
+ * Transactions are advertised to our peers after waiting this long for more
+ * transactions to advertise with them, so that one inventory message carries
+ * many item ids instead of one.  Blocks are advertised without waiting.
+ */
+#define GRAPHENE_NET_INVENTORY_COALESCE_INTERVAL_MS          50
+
+/**
+ * Maximum number of transactions received from peers that are handed to the
+ * client in one call, which validates them under a single database lock
+ */
+#define GRAPHENE_NET_MAX_TRANSACTIONS_TO_HANDLE_AT_ONE_TIME  1000
+
 #define GRAPHENE_NET_MAX_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME 200
 #define GRAPHENE_NET_MAX_NUMBER_OF_BLOCKS_TO_PREFETCH           (10 * GRAPHENE_NET_MAX_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME)
 
@@ -137,3 +173,11 @@
 #define GRAPHENE_NET_PORT_WAIT_DELAY_SECONDS                   5
 
 #define GRAPHENE_NET_MAX_PEERDB_SIZE                           1000
+
+/**
+ * Changes to the peer database are appended to its journal, which is folded into
+ * the database file once it holds this many entries per peer in the database
+ */
+#define GRAPHENE_NET_PEERDB_JOURNAL_ENTRIES_PER_PEER           4
+
+#define GRAPHENE_NET_PEER_STATISTICS_INTERVAL_MINUTES          1
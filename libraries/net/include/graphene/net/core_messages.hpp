@@ -44,6 +44,7 @@ namespace graphene { namespace net {
   using steem::protocol::block_id_type;
   using steem::protocol::transaction_id_type;
   using steem::protocol::signed_block;
+  using steem::protocol::signed_block_header;
 
   typedef fc::ecc::public_key_data node_id_t;
   typedef fc::ripemd160 item_hash_t;
@@ -86,6 +87,10 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    compact_block_message_type                   = 5018,
+    get_compact_block_transactions_message_type  = 5019,
+    compact_block_transactions_message_type      = 5020,
+    transport_cipher_switch_message_type         = 5021,
     core_message_type_last                       = 5099
   };
 
@@ -397,6 +402,77 @@ namespace graphene { namespace net {
     std::vector<current_connection_data> current_connections;
   };
 
+  /**
+   * A block sent as its header and the short ids of its transactions.  Sent instead of a
+   * block_message in reply to a fetch_items_message for compact_block_message_type, the
+   * receiver rebuilds the block from transactions it already has and requests the rest
+   * with a get_compact_block_transactions_message.
+   */
+  struct compact_block_message
+  {
+    static const core_message_type_enum type;
+
+    signed_block_header   header;
+    block_id_type         block_id;
+    item_hash_t           block_message_hash; // the hash of the full block_message that was requested
+    std::vector<uint64_t> short_transaction_ids;
+
+    compact_block_message() {}
+    compact_block_message(const block_message& full_block, const item_hash_t& block_message_hash);
+
+    /** the first eight bytes of the transaction id */
+    static uint64_t short_transaction_id(const transaction_id_type& id);
+  };
+
+  struct get_compact_block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    block_id_type         block_id;
+    std::vector<uint32_t> transaction_indices;
+
+    get_compact_block_transactions_message() {}
+    get_compact_block_transactions_message(const block_id_type& block_id, std::vector<uint32_t> transaction_indices) :
+      block_id(block_id),
+      transaction_indices(std::move(transaction_indices))
+    {}
+  };
+
+  struct compact_block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    block_id_type                   block_id;
+    std::vector<signed_transaction> transactions; // in the order they were requested, empty if the block is unknown
+
+    compact_block_transactions_message() {}
+    compact_block_transactions_message(const block_id_type& block_id) :
+      block_id(block_id)
+    {}
+    /**
+     * The reply to a get_compact_block_transactions_message for full_block.  The indices must be strictly
+     * increasing and in the block, which bounds the reply by the size of the block, or the reply is empty.
+     */
+    compact_block_transactions_message(const block_message& full_block, const std::vector<uint32_t>& transaction_indices);
+  };
+
+  /**
+   * Sent to a peer that listed `cipher` in the transport_ciphers of its hello.  Every byte the
+   * sender writes after this message is encrypted with `cipher`, the receiver switches its read
+   * side as soon as it has read the message.
+   */
+  struct transport_cipher_switch_message
+  {
+    static const core_message_type_enum type;
+
+    std::string cipher;
+
+    transport_cipher_switch_message() {}
+    transport_cipher_switch_message(const std::string& cipher) :
+      cipher(cipher)
+    {}
+  };
+
 
 } } // graphene::net
 
@@ -421,6 +497,10 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (compact_block_message_type)
+                 (get_compact_block_transactions_message_type)
+                 (compact_block_transactions_message_type)
+                 (transport_cipher_switch_message_type)
                  (core_message_type_last) )
 
 FC_REFLECT( graphene::net::trx_message, (trx) )
@@ -505,6 +585,16 @@ FC_REFLECT(graphene::net::get_current_connections_reply_message, (upload_rate_on
                                                             (download_rate_one_hour)
                                                             (current_connections))
 
+FC_REFLECT( graphene::net::compact_block_message, (header)
+                                                  (block_id)
+                                                  (block_message_hash)
+                                                  (short_transaction_ids) )
+FC_REFLECT( graphene::net::get_compact_block_transactions_message, (block_id)
+                                                                   (transaction_indices) )
+FC_REFLECT( graphene::net::compact_block_transactions_message, (block_id)
+                                                               (transactions) )
+FC_REFLECT( graphene::net::transport_cipher_switch_message, (cipher) )
+
 #include <unordered_map>
 #include <fc/crypto/city.hpp>
 #include <fc/crypto/sha224.hpp>
@@ -23,6 +23,7 @@
  */
 #pragma once
 #include <fc/network/tcp_socket.hpp>
+#include <fc/thread/thread.hpp>
 #include <graphene/net/message.hpp>
 
 namespace graphene { namespace net {
@@ -47,6 +48,13 @@ namespace graphene { namespace net {
        ~message_oriented_connection();
        fc::tcp_socket& get_socket();
 
+       /**
+        * Runs socket I/O, encryption and framing of this connection on io_thread.  Received
+        * messages are still delivered on the thread that created the connection.  Must be
+        * called before the connection is established, nullptr keeps everything on that thread.
+        */
+       void set_io_thread(fc::thread* io_thread);
+
        void accept();
        void bind(const fc::ip::endpoint& local_endpoint);
        void connect_to(const fc::ip::endpoint& remote_endpoint);
@@ -30,6 +30,7 @@
 
 #include <steem/protocol/types.hpp>
 
+#include <functional>
 #include <list>
 
 namespace graphene { namespace net {
@@ -92,6 +93,16 @@ namespace graphene { namespace net {
           */
          virtual void handle_transaction( const graphene::net::trx_message& trx_msg ) = 0;
 
+         /**
+          *  @brief Called with a batch of transactions that came in from the network,
+          *         each of which should be validated on its own
+          *
+          *  @returns one entry per transaction, the exception thrown while validating it
+          *           or nothing if it is safe to broadcast on
+          *  @throws exception if the batch could not be handled at all
+          */
+         virtual std::vector<fc::oexception> handle_transactions( const std::vector<graphene::net::trx_message>& trx_msgs ) = 0;
+
          /**
           *  @brief Called when a new message comes in from the network other than a
           *         block or a transaction.  Currently there are no other possible
@@ -118,6 +129,12 @@ namespace graphene { namespace net {
           */
          virtual message get_item( const item_id& id ) = 0;
 
+         /**
+          *  Returns the transactions in our pending pool whose id is accepted by filter.
+          *  Used to rebuild blocks received in compact form.
+          */
+         virtual std::vector<signed_transaction> get_pending_transactions( const std::function<bool(const transaction_id_type&)>& filter ) = 0;
+
          /**
           * Returns a synopsis of the blockchain used for syncing.
           * This consists of a list of selected item hashes from our current preferred
@@ -36,8 +36,18 @@ struct node_configuration
 
    uint32_t maximum_number_of_blocks_to_handle_at_one_time = GRAPHENE_NET_MAX_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME;
    uint32_t maximum_number_of_sync_blocks_to_prefetch = GRAPHENE_NET_MAX_NUMBER_OF_BLOCKS_TO_PREFETCH;
+   /** number of sync block requests kept outstanding to each peer */
    uint32_t maximum_blocks_per_peer_during_syncing = GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING;
+   /** bytes of sync blocks that may be requested or waiting to be pushed to the blockchain */
+   uint64_t sync_block_memory_budget = GRAPHENE_NET_DEFAULT_SYNC_BLOCK_MEMORY_BUDGET;
    int64_t active_ignored_request_timeout_microseconds = 6000000;
+   /** number of threads doing socket I/O and encryption for peer connections, 0 to use the p2p thread.  The traffic of
+       connections on I/O threads is left out of the bandwidth statistics */
+   uint32_t io_thread_count = GRAPHENE_NET_DEFAULT_IO_THREADS;
+   /** request blocks from peers that support it as a header and short transaction ids */
+   bool enable_compact_blocks = true;
+   /** preferred authenticated cipher for peer connections, empty to stay on the legacy AES-256-CBC transport */
+   std::string transport_cipher = "aes-256-gcm";
 };
 
 } }
@@ -55,5 +65,9 @@ FC_REFLECT(graphene::net::node_configuration,
    (maximum_number_of_blocks_to_handle_at_one_time)
    (maximum_number_of_sync_blocks_to_prefetch)
    (maximum_blocks_per_peer_during_syncing)
+   (sync_block_memory_budget)
    (active_ignored_request_timeout_microseconds)
+   (io_thread_count)
+   (enable_compact_blocks)
+   (transport_cipher)
 )
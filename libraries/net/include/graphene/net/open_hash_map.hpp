@@ -0,0 +1,223 @@
+#pragma once
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace net {
+
+  namespace detail
+  {
+    /** per process seed, so that peers cannot choose item hashes that pile up in one probe sequence */
+    inline uint64_t open_hash_seed()
+    {
+      static const uint64_t seed = (uint64_t(std::random_device()()) << 32) ^ std::random_device()();
+      return seed;
+    }
+
+    inline uint64_t open_hash_mix(uint64_t x)
+    {
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdULL;
+      x ^= x >> 33;
+      x *= 0xc4ceb9fe1a85ec53ULL;
+      x ^= x >> 33;
+      return x;
+    }
+
+    /** seeded hash of a 20 byte digest, one mixing round per word so that no collision holds for every seed */
+    inline uint64_t open_hash_digest(const char* digest, uint64_t h = open_hash_seed())
+    {
+      uint64_t words[2];
+      uint32_t last_word;
+      memcpy(words, digest, sizeof(words));
+      memcpy(&last_word, digest + sizeof(words), sizeof(last_word));
+      h = open_hash_mix(h ^ words[0]);
+      h = open_hash_mix(h ^ words[1]);
+      return open_hash_mix(h ^ last_word);
+    }
+  }
+
+  /**
+   * Hash map with open addressing and linear probing, for the item and message hashes the
+   * p2p code looks up on every inventory message.  Entries live in one flat array, there is
+   * no allocation per entry and erasing shifts the following entries back instead of
+   * leaving tombstones.
+   *
+   * Iterators and references are invalidated by insert and erase.  Key and Value must be
+   * default constructible and movable.
+   */
+  template<typename Key, typename Value, typename Hash>
+  class open_hash_map
+  {
+  public:
+    typedef std::pair<Key, Value> value_type;
+
+    template<typename Map, typename Reference>
+    class iterator_base : public boost::iterator_facade<iterator_base<Map, Reference>, value_type, boost::forward_traversal_tag, Reference>
+    {
+    public:
+      iterator_base() {}
+      iterator_base(Map* map, size_t index) : _map(map), _index(index) { skip_empty(); }
+      template<typename OtherMap, typename OtherReference>
+      iterator_base(const iterator_base<OtherMap, OtherReference>& other) : _map(other._map), _index(other._index) {}
+    private:
+      friend class boost::iterator_core_access;
+      template<typename, typename> friend class iterator_base;
+      friend class open_hash_map;
+
+      void skip_empty()
+      {
+        while (_index < _map->_slots.size() && !_map->_slots[_index].used)
+          ++_index;
+      }
+      void increment() { ++_index; skip_empty(); }
+      template<typename OtherMap, typename OtherReference>
+      bool equal(const iterator_base<OtherMap, OtherReference>& other) const { return _index == other._index; }
+      Reference dereference() const { return _map->_slots[_index].value; }
+
+      Map*   _map = nullptr;
+      size_t _index = 0;
+    };
+    typedef iterator_base<open_hash_map, value_type&> iterator;
+    typedef iterator_base<const open_hash_map, const value_type&> const_iterator;
+
+    open_hash_map() {}
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, _slots.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, _slots.size()); }
+
+    iterator find(const Key& key) { return iterator(this, find_index(key)); }
+    const_iterator find(const Key& key) const { return const_iterator(this, find_index(key)); }
+    size_t count(const Key& key) const { return find_index(key) == _slots.size() ? 0 : 1; }
+
+    /** does nothing and returns false if the key is already present, like std::unordered_map */
+    std::pair<iterator, bool> insert(value_type value)
+    {
+      if ((_size + 1) * 4 > _slots.size() * 3)
+        rehash(std::max<size_t>(size_t(minimum_capacity), _slots.size() * 2));
+
+      size_t index = home(value.first);
+      for (; _slots[index].used; index = (index + 1) & _mask)
+        if (_slots[index].value.first == value.first)
+          return std::make_pair(iterator(this, index), false);
+
+      _slots[index].value = std::move(value);
+      _slots[index].used = true;
+      ++_size;
+      return std::make_pair(iterator(this, index), true);
+    }
+
+    Value& operator[](const Key& key)
+    {
+      return insert(value_type(key, Value())).first->second;
+    }
+
+    size_t erase(const Key& key)
+    {
+      size_t index = find_index(key);
+      if (index == _slots.size())
+        return 0;
+      erase_index(index);
+      return 1;
+    }
+    void erase(const_iterator position) { erase_index(position._index); }
+
+    void clear()
+    {
+      _slots.clear();
+      _size = 0;
+      _mask = 0;
+    }
+
+    /**
+     * Gives memory back after a flood, call after erasing many entries.  Only shrinks a table
+     * that is less than a quarter full, to half full, so that steady insert and erase traffic
+     * doesn't rehash back and forth.
+     */
+    void shrink_to_fit()
+    {
+      if (_slots.size() <= size_t(minimum_capacity) || _size * 4 >= _slots.size())
+        return;
+      size_t capacity = size_t(minimum_capacity);
+      while (_size * 2 > capacity)
+        capacity *= 2;
+      rehash(capacity);
+    }
+
+  private:
+    enum { minimum_capacity = 16 };
+
+    size_t home(const Key& key) const { return size_t(_hash(key)) & _mask; }
+
+    size_t find_index(const Key& key) const
+    {
+      if (_size == 0)
+        return _slots.size();
+      for (size_t index = home(key); _slots[index].used; index = (index + 1) & _mask)
+        if (_slots[index].value.first == key)
+          return index;
+      return _slots.size();
+    }
+
+    void erase_index(size_t hole)
+    {
+      // move back every following entry of the probe run that may not live beyond the hole
+      for (size_t index = (hole + 1) & _mask; _slots[index].used; index = (index + 1) & _mask)
+      {
+        size_t entry_home = home(_slots[index].value.first);
+        bool entry_may_move = hole <= index ? (entry_home <= hole || entry_home > index)
+                                            : (entry_home <= hole && entry_home > index);
+        if (entry_may_move)
+        {
+          _slots[hole].value = std::move(_slots[index].value);
+          hole = index;
+        }
+      }
+      _slots[hole].value = value_type();
+      _slots[hole].used = false;
+      --_size;
+    }
+
+    void rehash(size_t capacity)
+    {
+      std::vector<slot> old_slots(capacity);
+      old_slots.swap(_slots);
+      _mask = capacity - 1;
+      _size = 0;
+      for (slot& old_slot : old_slots)
+        if (old_slot.used)
+        {
+          size_t index = home(old_slot.value.first);
+          while (_slots[index].used)
+            index = (index + 1) & _mask;
+          _slots[index].value = std::move(old_slot.value);
+          _slots[index].used = true;
+          ++_size;
+        }
+    }
+
+    // the flag sits next to the entry, so a probe touches one cache line
+    struct slot
+    {
+      value_type value;
+      bool       used = false;
+    };
+
+    std::vector<slot>       _slots;
+    size_t                  _size = 0;
+    size_t                  _mask = 0;
+    Hash                    _hash;
+  };
+
+} } // graphene::net
@@ -28,6 +28,7 @@
 #include <graphene/net/message_oriented_connection.hpp>
 #include <graphene/net/stcp_socket.hpp>
 #include <graphene/net/config.hpp>
+#include <graphene/net/timestamped_item_set.hpp>
 
 #include <boost/tuple/tuple.hpp>
 
@@ -40,7 +41,10 @@
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <functional>
+#include <map>
 #include <queue>
+#include <unordered_set>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
 
@@ -217,7 +221,7 @@ namespace graphene { namespace net
       uint16_t outbound_port = 0;
       /// @}
 
-      typedef std::unordered_map<item_id, fc::time_point> item_to_time_map_type;
+      typedef open_hash_map<item_id, fc::time_point, item_id_hasher> item_to_time_map_type;
 
       /// blockchain synchronization state data
       /// @{
@@ -234,27 +238,56 @@ namespace graphene { namespace net
       bool inhibit_fetching_sync_blocks = false;
       /// @}
 
+      /// how well the peer served us since its record in the peer database was last updated
+      /// @{
+      uint32_t blocks_delivered = 0;
+      uint32_t blocks_rejected = 0;
+      uint32_t requests_timed_out = 0;
+      fc::time_point last_statistics_time;
+      uint64_t bytes_received_at_last_statistics_time = 0;
+      /// @}
+
       /// non-synchronization state data
       /// @{
-      struct timestamped_item_id
-      {
-        item_id            item;
-        fc::time_point_sec timestamp;
-        timestamped_item_id(const item_id& item, const fc::time_point_sec timestamp) :
-          item(item),
-          timestamp(timestamp)
-        {}
-      };
-      struct timestamp_index{};
-      typedef boost::multi_index_container<timestamped_item_id,
-                                           boost::multi_index::indexed_by<boost::multi_index::hashed_unique<boost::multi_index::member<timestamped_item_id, item_id, &timestamped_item_id::item>,
-                                                                                                            std::hash<item_id> >,
-                                                                          boost::multi_index::ordered_non_unique<boost::multi_index::tag<timestamp_index>,
-                                                                                                                 boost::multi_index::member<timestamped_item_id, fc::time_point_sec, &timestamped_item_id::timestamp> > > > timestamped_items_set_type;
+      typedef graphene::net::timestamped_item_id timestamped_item_id;
+      typedef timestamped_item_set timestamped_items_set_type;
       timestamped_items_set_type inventory_peer_advertised_to_us;
       timestamped_items_set_type inventory_advertised_to_peer;
 
       item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+      bool supports_compact_blocks = false; /// peer announced in its hello that it can send and receive compact blocks
+      std::vector<std::string> transport_ciphers; /// authenticated ciphers the peer can decrypt, from its hello
+      /**
+       * A compact block being rebuilt from the transactions we already have.  A transaction is
+       * missing while its slot in the block is still empty.
+       */
+      struct partial_compact_block
+      {
+        signed_block          block;
+        item_hash_t           block_message_hash;
+        std::vector<uint64_t> short_transaction_ids;
+        fc::time_point        transactions_requested_time; /// when we asked the peer for the missing transactions
+
+        partial_compact_block() {}
+        /** starts out with every transaction of the compact block missing */
+        explicit partial_compact_block(const compact_block_message& compact_block);
+
+        std::vector<uint32_t> get_missing_transaction_indices() const;
+        std::unordered_set<uint64_t> get_missing_short_ids() const;
+        /** fills in the missing transactions find_transaction returns for their short id */
+        void add_transactions(const std::function<fc::optional<signed_transaction>(uint64_t)>& find_transaction);
+        /** fills in the missing transactions whose short id one of these has */
+        void add_transactions(std::vector<signed_transaction> transactions);
+        /** fills in the peer's reply to get_missing_transaction_indices(), false if the reply doesn't have as many */
+        bool add_missing_transactions(const std::vector<signed_transaction>& transactions);
+        /**
+         * The rebuilt block_message, nothing if it isn't the block we requested.  A short id can match the
+         * wrong transaction, in which case the merkle root or the hash of the message won't match.
+         */
+        fc::optional<message> get_block_message() const;
+      };
+      std::map<block_id_type, partial_compact_block> compact_blocks_awaiting_transactions; /// compact blocks from this peer we've requested missing transactions for
       /// @}
 
       // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
@@ -280,6 +313,7 @@ namespace graphene { namespace net
       virtual ~peer_connection();
 
       fc::tcp_socket& get_socket();
+      void set_io_thread(fc::thread* io_thread);
       void accept_connection();
       void connect_to(const fc::ip::endpoint& remote_endpoint, fc::optional<fc::ip::endpoint> local_endpoint = fc::optional<fc::ip::endpoint>());
 
@@ -313,6 +347,8 @@ namespace graphene { namespace net
       bool is_inventory_advertised_to_us_list_full() const;
       bool performing_firewall_check() const;
       fc::optional<fc::ip::endpoint> get_endpoint_for_connecting() const;
+      /** forgets the compact blocks whose missing transactions we requested before requested_before, returns their block message hashes */
+      std::vector<item_hash_t> expire_compact_blocks_awaiting_transactions(fc::time_point requested_before);
     private:
       void send_queued_messages_task();
       void accept_connection_task();
@@ -343,4 +379,3 @@ FC_REFLECT_ENUM(graphene::net::peer_connection::connection_negotiation_status, (
                                                                           (closing)
                                                                           (closed) )
 
-FC_REFLECT( graphene::net::peer_connection::timestamped_item_id, (item)(timestamp));
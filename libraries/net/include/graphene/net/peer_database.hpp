@@ -53,7 +53,17 @@ namespace graphene { namespace net {
     uint32_t                          number_of_failed_connection_attempts;
     fc::optional<fc::exception>       last_error;
 
+    /// connection quality measured while we were connected, averaged over time
+    /// @{
+    fc::microseconds                  round_trip_delay;              /// zero until measured
+    uint64_t                          bytes_per_second = 0;          /// rate the peer sent us data at
+    uint32_t                          blocks_delivered = 0;          /// blocks we requested that arrived
+    uint32_t                          blocks_rejected = 0;           /// blocks that failed to push
+    uint32_t                          requests_timed_out = 0;        /// times we gave up waiting for requested items
+    /// @}
+
     potential_peer_record() :
+      last_connection_disposition(never_attempted_to_connect),
       number_of_successful_connection_attempts(0),
     number_of_failed_connection_attempts(0){}
 
@@ -65,7 +75,19 @@ namespace graphene { namespace net {
       last_connection_disposition(last_connection_disposition),
       number_of_successful_connection_attempts(0),
       number_of_failed_connection_attempts(0)
-    {}  
+    {}
+
+    /**
+     * Higher is better.  Adds up to 1000 points each for connecting reliably, round trip delay,
+     * download rate and the share of requested blocks that arrived and were valid.  Depends only
+     * on the record, so the database can keep its records sorted by it.
+     */
+    int64_t score() const;
+
+    /** folds the measurements of one connection into the averages and counters */
+    void record_connection_statistics(fc::microseconds measured_round_trip_delay, uint64_t measured_bytes_per_second,
+                                      uint32_t new_blocks_delivered, uint32_t new_blocks_rejected,
+                                      uint32_t new_requests_timed_out);
   };
 
   namespace detail
@@ -92,6 +114,11 @@ namespace graphene { namespace net {
   }
 
 
+  /**
+   * The peers we know about, kept in a json file with a journal beside it.  Changes are
+   * appended to the journal when flush() is called, so scores survive a crash, and the journal
+   * is folded into the json file when it grows and on close.  Iterates best scoring peer first.
+   */
   class peer_database
   {
   public:
@@ -101,6 +128,8 @@ namespace graphene { namespace net {
     void open(const fc::path& databaseFilename);
     void close();
     void clear();
+    /** writes the changes made since the last flush to the journal, the node does this every second */
+    void flush();
 
     void erase(const fc::ip::endpoint& endpointToErase);
 
@@ -119,4 +148,5 @@ namespace graphene { namespace net {
 } } // end namespace graphene::net
 
 FC_REFLECT_ENUM(graphene::net::potential_peer_last_connection_disposition, (never_attempted_to_connect)(last_connection_failed)(last_connection_rejected)(last_connection_handshaking_failed)(last_connection_succeeded))
-FC_REFLECT(graphene::net::potential_peer_record, (endpoint)(last_seen_time)(last_connection_disposition)(last_connection_attempt_time)(number_of_successful_connection_attempts)(number_of_failed_connection_attempts)(last_error) )
+FC_REFLECT(graphene::net::potential_peer_record, (endpoint)(last_seen_time)(last_connection_disposition)(last_connection_attempt_time)(number_of_successful_connection_attempts)(number_of_failed_connection_attempts)(last_error)
+                                                (round_trip_delay)(bytes_per_second)(blocks_delivered)(blocks_rejected)(requests_timed_out) )
@@ -26,11 +26,22 @@
 #include <fc/crypto/aes.hpp>
 #include <fc/crypto/elliptic.hpp>
 
+#include <string>
+#include <vector>
+
+struct evp_cipher_ctx_st;
+
 namespace graphene { namespace net {
 
 /**
  *  Uses ECDH to negotiate a aes key for communicating
  *  with other nodes on the network.
+ *
+ *  A connection starts out with AES-256-CBC in both directions, which is what every
+ *  node understands.  Once both sides have agreed on it (see transport_cipher_switch_message),
+ *  each direction can be switched to an authenticated cipher.  Authenticated data is sent
+ *  in frames of a 4 byte little endian payload length, the ciphertext and a 16 byte tag,
+ *  with the length covered by the tag.  Each direction has its own key and a counter nonce.
  */
 class stcp_socket : public virtual fc::iostream
 {
@@ -53,11 +64,35 @@ class stcp_socket : public virtual fc::iostream
     virtual void     flush();
     virtual void     close();
 
+    /** bytes a caller of write_frame() must reserve in front of and behind the payload */
+    static const size_t frame_prefix_size = 4;
+    static const size_t frame_suffix_size = 16;
+
+    /**
+     *  Encrypts buffer[frame_prefix_size, frame_prefix_size + len) in place and writes it
+     *  with a single call to the socket.  With the legacy cipher len must be a multiple of 16.
+     *  The reserved bytes around the payload are overwritten.
+     */
+    void             write_frame( char* buffer, size_t len );
+
+    /** names of the authenticated ciphers this build can use, in order of preference */
+    static std::vector<std::string> get_authenticated_ciphers();
+    static bool      is_authenticated_cipher_supported( const std::string& cipher );
+
+    /** everything written after this call is encrypted with cipher */
+    void             set_send_cipher( const std::string& cipher );
+    /** everything read after this call is decrypted with cipher, must not be called with unread data buffered */
+    void             set_receive_cipher( const std::string& cipher );
+    const std::string& get_send_cipher() const { return _send_cipher_name; }
+    const std::string& get_receive_cipher() const { return _recv_cipher_name; }
+
     using istream::get;
     void             get( char& c ) { read( &c, 1 ); }
     fc::sha512       get_shared_secret() const { return _shared_secret; }
   private:
     void do_key_exchange();
+    void init_aead( const std::string& cipher, bool sending );
+    size_t read_aead_frame( char* buffer, size_t len );
 
     fc::sha512           _shared_secret;
     fc::ecc::private_key _priv_key;
@@ -66,8 +101,18 @@ class stcp_socket : public virtual fc::iostream
     fc::tcp_socket       _sock;
     fc::aes_encoder      _send_aes;
     fc::aes_decoder      _recv_aes;
-    std::shared_ptr<char> _read_buffer;
-    std::shared_ptr<char> _write_buffer;
+    std::vector<char>    _read_buffer;
+    size_t               _read_buffer_position = 0;
+    std::vector<char>    _write_buffer;
+    bool                 _is_initiator = false;
+
+    // authenticated ciphers, not in use while the names are empty
+    std::string          _send_cipher_name;
+    std::string          _recv_cipher_name;
+    std::shared_ptr<evp_cipher_ctx_st> _send_aead;
+    std::shared_ptr<evp_cipher_ctx_st> _recv_aead;
+    uint64_t             _send_nonce = 0;
+    uint64_t             _recv_nonce = 0;
 #ifndef NDEBUG
     bool _read_buffer_in_use;
     bool _write_buffer_in_use;
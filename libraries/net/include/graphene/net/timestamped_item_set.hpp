@@ -0,0 +1,82 @@
+#pragma once
+
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/open_hash_map.hpp>
+
+#include <fc/time.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace graphene { namespace net {
+
+  struct item_hash_hasher
+  {
+    size_t operator()(const fc::ripemd160& hash) const
+    {
+      static_assert(sizeof(hash._hash) == 20, "expected a 160 bit hash");
+      return detail::open_hash_digest((const char*)hash._hash, seed);
+    }
+    uint64_t seed = detail::open_hash_seed();
+  };
+
+  struct item_id_hasher
+  {
+    size_t operator()(const item_id& item) const
+    {
+      return detail::open_hash_digest((const char*)item.item_hash._hash, seed ^ item.item_type);
+    }
+    uint64_t seed = detail::open_hash_seed();
+  };
+
+  struct timestamped_item_id
+  {
+    item_id            item;
+    fc::time_point_sec timestamp;
+    timestamped_item_id(const item_id& item, const fc::time_point_sec timestamp) :
+      item(item),
+      timestamp(timestamp)
+    {}
+  };
+
+  /**
+   * A set of item ids that remembers when each item was added, used for the inventory we
+   * exchange with peers.  Items are kept in an open_hash_map and, for expiry, in a ring of
+   * one-second buckets in the order they were added, so expiring old items only touches the
+   * buckets that are dropped.
+   *
+   * Adding an item that is already present does not change its timestamp.
+   */
+  class timestamped_item_set
+  {
+  public:
+    typedef open_hash_map<item_id, fc::time_point_sec, item_id_hasher> map_type;
+    typedef map_type::const_iterator const_iterator;
+
+    const_iterator find(const item_id& item) const { return _items.find(item); }
+    const_iterator begin() const { return _items.begin(); }
+    const_iterator end() const { return _items.end(); }
+    size_t size() const { return _items.size(); }
+    bool empty() const { return _items.empty(); }
+
+    /** returns false if the item was already in the set */
+    bool insert(const timestamped_item_id& item);
+    size_t erase(const item_id& item) { return _items.erase(item); }
+    /** removes all items added before oldest_to_keep, returns the number removed */
+    size_t expire(fc::time_point_sec oldest_to_keep);
+    void clear();
+
+  private:
+    struct bucket
+    {
+      fc::time_point_sec   timestamp;
+      std::vector<item_id> items; // may name items erased or re-added since, checked on expiry
+    };
+
+    map_type           _items;
+    std::deque<bucket> _buckets;
+  };
+
+} } // graphene::net
+
+FC_REFLECT( graphene::net::timestamped_item_id, (item)(timestamp) )
@@ -31,6 +31,7 @@
 #include <graphene/net/message_oriented_connection.hpp>
 #include <graphene/net/stcp_socket.hpp>
 #include <graphene/net/config.hpp>
+#include <graphene/net/core_messages.hpp>
 
 #include <atomic>
 
@@ -41,13 +42,23 @@
 
 #ifndef NDEBUG
 # define VERIFY_CORRECT_THREAD() assert(_thread->is_current())
+# define VERIFY_IO_THREAD() assert(_io_thread ? _io_thread->is_current() : _thread->is_current())
 #else
 # define VERIFY_CORRECT_THREAD() do {} while (0)
+# define VERIFY_IO_THREAD() do {} while (0)
 #endif
 
 namespace graphene { namespace net {
   namespace detail
   {
+    /** State shared with the message deliveries queued on the p2p thread, which may outlive the connection */
+    struct message_delivery_state
+    {
+      bool destroyed = false;       // connection is being destroyed, deliveries must not touch it
+      bool failed = false;          // a message could not be handled, the connection is being closed
+      std::atomic<uint32_t> pending{0};
+    };
+
     class message_oriented_connection_impl
     {
     private:
@@ -55,21 +66,37 @@ namespace graphene { namespace net {
       message_oriented_connection_delegate *_delegate;
       stcp_socket _sock;
       fc::future<void> _read_loop_done;
-      uint64_t _bytes_received;
-      uint64_t _bytes_sent;
+      std::atomic<uint64_t> _bytes_received;
+      std::atomic<uint64_t> _bytes_sent;
 
-      fc::time_point _connected_time;
-      fc::time_point _last_message_received_time;
-      fc::time_point _last_message_sent_time;
+      std::atomic<fc::time_point> _connected_time;
+      std::atomic<fc::time_point> _last_message_received_time;
+      std::atomic<fc::time_point> _last_message_sent_time;
 
       bool _send_message_in_progress;
 #ifndef NDEBUG
       fc::thread* _thread;
 #endif
+      fc::thread* _node_thread;
+      fc::thread* _io_thread;
+
+      std::shared_ptr<message_delivery_state> _delivery_state;
+      fc::future<void> _last_delivery;    // written by the I/O thread only while the read loop runs
 
       void read_loop();
       void start_read_loop();
+      void deliver_message(message&& received_message);
+      void deliver_connection_closed();
+
+      template<typename Functor>
+      auto run_on_io_thread(Functor&& f, const char* desc) -> decltype(f())
+      {
+        if (!_io_thread || _io_thread->is_current())
+          return f();
+        return _io_thread->async(std::forward<Functor>(f), desc).wait();
+      }
     public:
+      void set_io_thread(fc::thread* io_thread);
       fc::tcp_socket& get_socket();
       void accept();
       void connect_to(const fc::ip::endpoint& remote_endpoint);
@@ -98,10 +125,13 @@ namespace graphene { namespace net {
       _delegate(delegate),
       _bytes_received(0),
       _bytes_sent(0),
-      _send_message_in_progress(false)
+      _send_message_in_progress(false),
 #ifndef NDEBUG
-      ,_thread(&fc::thread::current())
+      _thread(&fc::thread::current()),
 #endif
+      _node_thread(&fc::thread::current()),
+      _io_thread(nullptr),
+      _delivery_state(std::make_shared<message_delivery_state>())
     {
     }
     message_oriented_connection_impl::~message_oriented_connection_impl()
@@ -116,31 +146,103 @@ namespace graphene { namespace net {
       return _sock.get_socket();
     }
 
+    void message_oriented_connection_impl::set_io_thread(fc::thread* io_thread)
+    {
+      VERIFY_CORRECT_THREAD();
+      FC_ASSERT(!_read_loop_done.valid(), "the I/O thread must be set before the connection is established");
+      _io_thread = io_thread;
+    }
+
+    void message_oriented_connection_impl::start_read_loop()
+    {
+      if (_io_thread)
+        _read_loop_done = _io_thread->async([=](){ read_loop(); }, "message read_loop");
+      else
+        _read_loop_done = fc::async([=](){ read_loop(); }, "message read_loop");
+    }
+
     void message_oriented_connection_impl::accept()
     {
       VERIFY_CORRECT_THREAD();
-      _sock.accept();
+      run_on_io_thread([this](){ _sock.accept(); }, "stcp accept");
       assert(!_read_loop_done.valid()); // check to be sure we never launch two read loops
-      _read_loop_done = fc::async([=](){ read_loop(); }, "message read_loop");
+      start_read_loop();
     }
 
     void message_oriented_connection_impl::connect_to(const fc::ip::endpoint& remote_endpoint)
     {
       VERIFY_CORRECT_THREAD();
-      _sock.connect_to(remote_endpoint);
+      run_on_io_thread([this, &remote_endpoint](){ _sock.connect_to(remote_endpoint); }, "stcp connect_to");
       FC_ASSERT(!_read_loop_done.valid()); // check to be sure we never launch two read loops
-      _read_loop_done = fc::async([=](){ read_loop(); }, "message read_loop");
+      start_read_loop();
     }
 
     void message_oriented_connection_impl::bind(const fc::ip::endpoint& local_endpoint)
     {
       VERIFY_CORRECT_THREAD();
-      _sock.bind(local_endpoint);
+      run_on_io_thread([this, &local_endpoint](){ _sock.bind(local_endpoint); }, "stcp bind");
+    }
+
+    void message_oriented_connection_impl::deliver_message(message&& received_message)
+    {
+      VERIFY_IO_THREAD();
+
+      // Throttle reading when the p2p thread does not keep up with this connection
+      if (_delivery_state->pending >= GRAPHENE_NET_MAX_PENDING_MESSAGE_DELIVERIES && _last_delivery.valid())
+        _last_delivery.wait();
+
+      std::shared_ptr<message_delivery_state> state = _delivery_state;
+      fc::future<void> previous_delivery = _last_delivery;
+      ++state->pending;
+
+      // fc queues tasks posted from other threads without locking, in the order they were posted
+      _last_delivery = _node_thread->async([this, state, previous_delivery, msg = std::move(received_message)]() mutable
+      {
+        // A handler may yield, wait for it so that messages of a connection are handled one by one
+        if (previous_delivery.valid() && !previous_delivery.ready())
+          previous_delivery.wait();
+
+        --state->pending;
+        if (state->destroyed || state->failed)
+          return;
+
+        try
+        {
+          _delegate->on_message(_self, msg);
+        }
+        catch ( const fc::canceled_exception& )
+        {
+          throw;
+        }
+        catch ( const fc::exception& e )
+        {
+          wlog( "message transmission failed ${er}", ("er", e.to_detail_string() ) );
+          state->failed = true;
+          close_connection();
+        }
+      }, "deliver message");
+    }
+
+    void message_oriented_connection_impl::deliver_connection_closed()
+    {
+      VERIFY_IO_THREAD();
+
+      std::shared_ptr<message_delivery_state> state = _delivery_state;
+      fc::future<void> previous_delivery = _last_delivery;
+
+      _node_thread->async([this, state, previous_delivery]() mutable
+      {
+        if (previous_delivery.valid() && !previous_delivery.ready())
+          previous_delivery.wait();
+
+        if (!state->destroyed)
+          _delegate->on_connection_closed(_self);
+      }, "deliver connection closed");
     }
 
     void message_oriented_connection_impl::read_loop()
     {
-      VERIFY_CORRECT_THREAD();
+      VERIFY_IO_THREAD();
       const int BUFFER_SIZE = 16;
       const int LEFTOVER = BUFFER_SIZE - sizeof(message_header);
       static_assert(BUFFER_SIZE >= sizeof(message_header), "insufficient buffer");
@@ -172,8 +274,18 @@ namespace graphene { namespace net {
           }
           m.data.resize(m.size); // truncate off the padding bytes
 
+          // the peer encrypts everything after this message with the new cipher
+          if (m.msg_type == core_message_type_enum::transport_cipher_switch_message_type)
+            _sock.set_receive_cipher(m.as<transport_cipher_switch_message>().cipher);
+
           _last_message_received_time = fc::time_point::now();
 
+          if (_io_thread)
+          {
+            deliver_message(std::move(m));
+            continue;
+          }
+
           try
           {
             // message handling errors are warnings...
@@ -220,7 +332,12 @@ namespace graphene { namespace net {
       }
 
       if (call_on_connection_closed)
-        _delegate->on_connection_closed(_self);
+      {
+        if (_io_thread)
+          deliver_connection_closed();
+        else
+          _delegate->on_connection_closed(_self);
+      }
 
       if (exception_to_rethrow)
         throw *exception_to_rethrow;
@@ -260,25 +377,32 @@ namespace graphene { namespace net {
            elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
         //pad the message we send to a multiple of 16 bytes
         size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
-        std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
+        // leave room for the frame length and tag so the socket can encrypt in place
+        std::unique_ptr<char[]> frame(new char[stcp_socket::frame_prefix_size + size_with_padding + stcp_socket::frame_suffix_size]);
+        char* padded_message = frame.get() + stcp_socket::frame_prefix_size;
 
-        memcpy(padded_message.get(), (char*)&message_to_send, sizeof(message_header));
-        memcpy(padded_message.get() + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
-        char* paddingSpace = padded_message.get() + sizeof(message_header) + message_to_send.size;
+        memcpy(padded_message, (char*)&message_to_send, sizeof(message_header));
+        memcpy(padded_message + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
+        char* paddingSpace = padded_message + sizeof(message_header) + message_to_send.size;
         size_t toClean = size_with_padding - size_of_message_and_header;
         memset(paddingSpace, 0, toClean);
 
-        _sock.write(padded_message.get(), size_with_padding);
-        _sock.flush();
-        _bytes_sent += size_with_padding;
-        _last_message_sent_time = fc::time_point::now();
+        run_on_io_thread([&]()
+        {
+          _sock.write_frame(frame.get(), size_with_padding);
+          if (message_to_send.msg_type == core_message_type_enum::transport_cipher_switch_message_type)
+            _sock.set_send_cipher(message_to_send.as<transport_cipher_switch_message>().cipher);
+          _sock.flush();
+          _bytes_sent += size_with_padding;
+          _last_message_sent_time = fc::time_point::now();
+        }, "send message");
       } FC_RETHROW_EXCEPTIONS( warn, "unable to send message" );
     }
 
     void message_oriented_connection_impl::close_connection()
     {
       VERIFY_CORRECT_THREAD();
-      _sock.close();
+      run_on_io_thread([this](){ _sock.close(); }, "stcp close");
     }
 
     void message_oriented_connection_impl::destroy_connection(const char* caller)
@@ -295,6 +419,37 @@ namespace graphene { namespace net {
              "The task calling send_message() should have been canceled already");
       assert(!_send_message_in_progress);
 
+      if (_io_thread)
+      {
+        // The read loop runs on another thread, closing the socket makes it finish
+        _delivery_state->destroyed = true;
+        try
+        {
+          if (_read_loop_done.valid() && !_read_loop_done.ready())
+            run_on_io_thread([this](){ _sock.close(); }, "stcp close");
+          if (_read_loop_done.valid())
+            _read_loop_done.wait();
+        }
+        catch ( const fc::exception& e )
+        {
+          wlog( "Exception thrown while stopping message_oriented_connection's read_loop, ignoring: ${e}", ("e",e) );
+        }
+        catch (...)
+        {
+          wlog( "Exception thrown while stopping message_oriented_connection's read_loop, ignoring" );
+        }
+
+        // Stop a delivery still running on this thread, like canceling the read loop does without I/O threads
+        try
+        {
+          _last_delivery.cancel_and_wait(__FUNCTION__);
+        }
+        catch (...)
+        {
+        }
+        return;
+      }
+
       try
       {
         _read_loop_done.cancel_and_wait(__FUNCTION__);
@@ -356,6 +511,11 @@ namespace graphene { namespace net {
     return my->get_socket();
   }
 
+  void message_oriented_connection::set_io_thread(fc::thread* io_thread)
+  {
+    my->set_io_thread(io_thread);
+  }
+
   void message_oriented_connection::accept()
   {
     my->accept();
@@ -125,52 +125,46 @@ namespace graphene { namespace net {
   namespace detail
   {
     namespace bmi = boost::multi_index;
+    /**
+     * Messages we've recently received or sent, so we can hand them to peers that ask for them.
+     * Messages are dropped cache_duration_in_blocks blocks after they were cached, the expiry ring
+     * has one bucket of message hashes per block so dropping touches only the expiring messages.
+     */
     class blockchain_tied_message_cache
     {
     private:
       static const uint32_t cache_duration_in_blocks = GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS;
 
-      struct message_hash_index{};
-      struct message_contents_hash_index{};
-      struct block_clock_index{};
       struct message_info
       {
-        message_hash_type message_hash;
         message           message_body;
-        uint32_t          block_clock_when_received;
+        uint32_t          block_clock_when_received = 0;
 
         // for network performance stats
         message_propagation_data propagation_data;
         fc::uint160_t     message_contents_hash; // hash of whatever the message contains (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
+      };
 
-        message_info( const message_hash_type& message_hash,
-                      const message&           message_body,
-                      uint32_t                 block_clock_when_received,
-                      const message_propagation_data& propagation_data,
-                      fc::uint160_t            message_contents_hash ) :
-          message_hash( message_hash ),
-          message_body( message_body ),
-          block_clock_when_received( block_clock_when_received ),
-          propagation_data( propagation_data ),
-          message_contents_hash( message_contents_hash )
-        {}
+      struct short_id_hasher
+      {
+        size_t operator()(uint64_t short_id) const { return detail::open_hash_mix(detail::open_hash_seed() ^ short_id); }
       };
-      typedef boost::multi_index_container
-        < message_info,
-            bmi::indexed_by< bmi::ordered_unique< bmi::tag<message_hash_index>,
-                                                  bmi::member<message_info, message_hash_type, &message_info::message_hash> >,
-                             bmi::ordered_non_unique< bmi::tag<message_contents_hash_index>,
-                                                      bmi::member<message_info, fc::uint160_t, &message_info::message_contents_hash> >,
-                             bmi::ordered_non_unique< bmi::tag<block_clock_index>,
-                                                      bmi::member<message_info, uint32_t, &message_info::block_clock_when_received> > >
-        > message_cache_container;
-
-      message_cache_container _message_cache;
+
+      /// entries are allocated separately to keep the probed slots small
+      open_hash_map<message_hash_type, std::unique_ptr<message_info>, item_hash_hasher> _message_cache;
+      /// message hash by the first 8 bytes of its contents hash, the short transaction id of compact blocks.  Only the
+      /// first message with a given prefix is indexed, a second one can only be found by its message hash
+      open_hash_map<uint64_t, message_hash_type, short_id_hasher> _message_hash_by_contents_prefix;
+      /// hashes of the messages cached at each block clock, the last bucket is the current block clock
+      std::deque<std::vector<message_hash_type>> _expiry_ring;
 
       uint32_t block_clock;
 
+      const message_info* find_by_contents_hash( const fc::uint160_t& hash_of_message_contents ) const;
+
     public:
       blockchain_tied_message_cache() :
+        _expiry_ring( 1 ),
         block_clock( 0 )
       {}
       void block_accepted();
@@ -178,15 +172,33 @@ namespace graphene { namespace net {
                         const message_propagation_data& propagation_data, const fc::uint160_t& message_content_hash );
       message get_message( const message_hash_type& hash_of_message_to_lookup );
       message_propagation_data get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const;
+      fc::optional<message> find_message_by_contents_hash( const fc::uint160_t& hash_of_message_contents_to_lookup, uint32_t message_type ) const;
+      fc::optional<signed_transaction> find_transaction_by_short_id( uint64_t short_transaction_id ) const;
+      bool contains( const message_hash_type& hash_of_message ) const { return _message_cache.count( hash_of_message ) != 0; }
       size_t size() const { return _message_cache.size(); }
     };
 
     void blockchain_tied_message_cache::block_accepted()
     {
       ++block_clock;
-      if( block_clock > cache_duration_in_blocks )
-        _message_cache.get<block_clock_index>().erase(_message_cache.get<block_clock_index>().begin(),
-                                                      _message_cache.get<block_clock_index>().lower_bound(block_clock - cache_duration_in_blocks ) );
+      _expiry_ring.emplace_back();
+      if( _expiry_ring.size() <= cache_duration_in_blocks + 1 )
+        return;
+
+      for( const message_hash_type& expired_message_hash : _expiry_ring.front() )
+      {
+        auto iter = _message_cache.find( expired_message_hash );
+        if( iter == _message_cache.end() )
+          continue;
+        uint64_t contents_prefix = compact_block_message::short_transaction_id( iter->second->message_contents_hash );
+        auto prefix_iter = _message_hash_by_contents_prefix.find( contents_prefix );
+        if( prefix_iter != _message_hash_by_contents_prefix.end() && prefix_iter->second == expired_message_hash )
+          _message_hash_by_contents_prefix.erase( prefix_iter );
+        _message_cache.erase( iter );
+      }
+      _expiry_ring.pop_front();
+      _message_cache.shrink_to_fit();
+      _message_hash_by_contents_prefix.shrink_to_fit();
     }
 
     void blockchain_tied_message_cache::cache_message( const message& message_to_cache,
@@ -194,34 +206,68 @@ namespace graphene { namespace net {
                                                      const message_propagation_data& propagation_data,
                                                      const fc::uint160_t& message_content_hash )
     {
-      _message_cache.insert( message_info(hash_of_message_to_cache,
-                                         message_to_cache,
-                                         block_clock,
-                                         propagation_data,
-                                         message_content_hash ) );
+      if( _message_cache.find( hash_of_message_to_cache ) != _message_cache.end() )
+        return;
+
+      std::unique_ptr<message_info> info( new message_info{ message_to_cache, block_clock, propagation_data, message_content_hash } );
+      _message_cache.insert( std::make_pair( hash_of_message_to_cache, std::move( info ) ) );
+
+      _expiry_ring.back().push_back( hash_of_message_to_cache );
+      if( message_content_hash != fc::uint160_t() )
+        _message_hash_by_contents_prefix.insert( std::make_pair( compact_block_message::short_transaction_id( message_content_hash ),
+                                                                 hash_of_message_to_cache ) );
     }
 
     message blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup )
     {
-      message_cache_container::index<message_hash_index>::type::const_iterator iter =
-         _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
-      if( iter != _message_cache.get<message_hash_index>().end() )
-        return iter->message_body;
+      auto iter = _message_cache.find( hash_of_message_to_lookup );
+      if( iter != _message_cache.end() )
+        return iter->second->message_body;
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    const blockchain_tied_message_cache::message_info* blockchain_tied_message_cache::find_by_contents_hash( const fc::uint160_t& hash_of_message_contents ) const
+    {
+      auto prefix_iter = _message_hash_by_contents_prefix.find( compact_block_message::short_transaction_id( hash_of_message_contents ) );
+      if( prefix_iter == _message_hash_by_contents_prefix.end() )
+        return nullptr;
+      auto iter = _message_cache.find( prefix_iter->second );
+      if( iter == _message_cache.end() || iter->second->message_contents_hash != hash_of_message_contents )
+        return nullptr;
+      return iter->second.get();
+    }
+
     message_propagation_data blockchain_tied_message_cache::get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const
     {
       if( hash_of_message_contents_to_lookup != fc::uint160_t() )
       {
-        message_cache_container::index<message_contents_hash_index>::type::const_iterator iter =
-           _message_cache.get<message_contents_hash_index>().find(hash_of_message_contents_to_lookup );
-        if( iter != _message_cache.get<message_contents_hash_index>().end() )
-          return iter->propagation_data;
+        const message_info* info = find_by_contents_hash( hash_of_message_contents_to_lookup );
+        if( info )
+          return info->propagation_data;
       }
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    fc::optional<message> blockchain_tied_message_cache::find_message_by_contents_hash( const fc::uint160_t& hash_of_message_contents_to_lookup,
+                                                                                       uint32_t message_type ) const
+    {
+      const message_info* info = find_by_contents_hash( hash_of_message_contents_to_lookup );
+      if( info && info->message_body.msg_type == message_type )
+        return info->message_body;
+      return fc::optional<message>();
+    }
+
+    fc::optional<signed_transaction> blockchain_tied_message_cache::find_transaction_by_short_id( uint64_t short_transaction_id ) const
+    {
+      auto prefix_iter = _message_hash_by_contents_prefix.find( short_transaction_id );
+      if( prefix_iter == _message_hash_by_contents_prefix.end() )
+        return fc::optional<signed_transaction>();
+      auto iter = _message_cache.find( prefix_iter->second );
+      if( iter != _message_cache.end() && iter->second->message_body.msg_type == trx_message_type )
+        return iter->second->message_body.as<trx_message>().trx;
+      return fc::optional<signed_transaction>();
+    }
+
     // when requesting items from peers, we want to prioritize any blocks before
     // transactions, but otherwise request items in the order we heard about them
     struct prioritized_item_id
@@ -260,9 +306,12 @@ namespace graphene { namespace net {
 #define NODE_DELEGATE_METHOD_NAMES (has_item) \
                                    (handle_message) \
                                    (handle_block) \
+                                   (handle_sync_block) \
                                    (handle_transaction) \
+                                   (handle_transactions) \
                                    (get_block_ids) \
                                    (get_item) \
+                                   (get_pending_transactions) \
                                    (get_blockchain_synopsis) \
                                    (sync_status) \
                                    (connection_count_changed) \
@@ -356,11 +405,18 @@ namespace graphene { namespace net {
       bool has_item( const net::item_id& id ) override;
       void handle_message( const message& ) override;
       bool handle_block( const graphene::net::block_message& block_message, bool sync_mode, std::vector<fc::uint160_t>& contained_transaction_message_ids ) override;
+      /**
+       * handle_block without switching to the delegate thread, used to apply sync blocks on their own thread.
+       * Its calls are counted as handle_sync_block, apart from the handle_block calls made at the same time.
+       */
+      bool handle_block_on_calling_thread( const graphene::net::block_message& block_message, bool sync_mode, std::vector<fc::uint160_t>& contained_transaction_message_ids );
       void handle_transaction( const graphene::net::trx_message& transaction_message ) override;
+      std::vector<fc::oexception> handle_transactions( const std::vector<graphene::net::trx_message>& transaction_messages ) override;
       std::vector<item_hash_t> get_block_ids(const std::vector<item_hash_t>& blockchain_synopsis,
                                              uint32_t& remaining_item_count,
                                              uint32_t limit = 2000) override;
       message get_item( const item_id& id ) override;
+      std::vector<signed_transaction> get_pending_transactions( const std::function<bool(const transaction_id_type&)>& filter ) override;
       std::vector<item_hash_t> get_blockchain_synopsis(const item_hash_t& reference_point,
                                                        uint32_t number_of_blocks_after_reference_point) override;
       void     sync_status( uint32_t item_type, uint32_t item_count ) override;
@@ -420,6 +476,11 @@ namespace graphene { namespace net {
       active_sync_requests_map              _active_sync_requests; /// list of sync blocks we've asked for from peers but have not yet received
       std::list<graphene::net::block_message> _new_received_sync_items; /// list of sync blocks we've just received but haven't yet tried to process
       std::list<graphene::net::block_message> _received_sync_items; /// list of sync blocks we've received, but can't yet process because we are still missing blocks that come earlier in the chain
+      std::unordered_map<item_hash_t, uint32_t> _received_sync_item_sizes; /// message size of every sync block we've received and haven't finished pushing to the client
+      uint64_t                  _received_sync_items_size = 0; /// sum of _received_sync_item_sizes
+      uint32_t                  _average_sync_block_size = GRAPHENE_NET_INITIAL_SYNC_BLOCK_SIZE_ESTIMATE;
+      bool                      _sync_fetching_limited_by_memory_budget = false;
+      std::shared_ptr<fc::thread> _sync_apply_thread; /// pushes sync blocks to the client, so this thread keeps downloading while they are applied
       // @}
 
       fc::future<void> _process_backlog_of_sync_blocks_done;
@@ -448,6 +509,22 @@ namespace graphene { namespace net {
       fc::promise<void>::ptr        _retrigger_advertise_inventory_loop_promise;
       fc::future<void>              _advertise_inventory_loop_done;
       std::unordered_set<item_id>   _new_inventory; /// list of items we have received but not yet advertised to our peers
+      bool                          _coalescing_inventory = false; /// true while waiting for more transactions to advertise
+      // @}
+
+      /// used by the task that hands the transactions we fetched to the client in batches
+      // @{
+      struct transaction_to_push
+      {
+        message                        transaction_message;
+        message_hash_type              message_hash;
+        fc::time_point                 receive_time;
+        node_id_t                      originating_node_id;
+        fc::optional<fc::ip::endpoint> originating_endpoint;
+      };
+      fc::promise<void>::ptr           _retrigger_push_transactions_loop_promise;
+      fc::future<void>                 _push_transactions_loop_done;
+      std::vector<transaction_to_push> _transactions_to_push;
       // @}
 
       fc::future<void>     _terminate_inactive_connections_loop_done;
@@ -492,6 +569,9 @@ namespace graphene { namespace net {
 
       fc::rate_limiting_group _rate_limiter;
 
+      std::vector<std::shared_ptr<fc::thread>> _io_threads; /// socket I/O and encryption of peer connections, see io_thread_count
+      uint32_t _next_io_thread = 0;
+
       uint32_t _last_reported_number_of_connections; // number of connections last reported to the client (to avoid sending duplicate messages)
 
       fc::future<void> _fetch_updated_peer_lists_loop_done;
@@ -507,6 +587,7 @@ namespace graphene { namespace net {
 
       fc::time_point_sec _bandwidth_monitor_last_update_time;
       fc::future<void> _bandwidth_monitor_loop_done;
+      fc::time_point _last_peer_statistics_time;
 
       fc::future<void> _dump_node_status_task_done;
 
@@ -558,10 +639,16 @@ namespace graphene { namespace net {
       void advertise_inventory_loop();
       void trigger_advertise_inventory_loop();
 
+      void push_transactions_loop();
+      void trigger_push_transactions_loop();
+      void push_transactions(const std::vector<transaction_to_push>& transactions, size_t first, size_t last);
+
       void terminate_inactive_connections_loop();
 
       void fetch_updated_peer_lists_loop();
       void update_bandwidth_data(uint32_t bytes_read_this_second, uint32_t bytes_written_this_second);
+      void record_peer_statistics(peer_connection* peer);
+      int64_t get_peer_score(const peer_connection_ptr& peer);
       void bandwidth_monitor_loop();
       void dump_node_status_task();
 
@@ -636,12 +723,30 @@ namespace graphene { namespace net {
       void on_get_current_connections_reply_message(peer_connection* originating_peer,
                                                     const get_current_connections_reply_message& get_current_connections_reply_message_received);
 
+      void on_compact_block_message(peer_connection* originating_peer,
+                                    const compact_block_message& compact_block_message_received);
+
+      void on_get_compact_block_transactions_message(peer_connection* originating_peer,
+                                                     const get_compact_block_transactions_message& get_compact_block_transactions_message_received);
+
+      void on_compact_block_transactions_message(peer_connection* originating_peer,
+                                                 const compact_block_transactions_message& compact_block_transactions_message_received);
+
+      void send_compact_block(peer_connection* peer, const message& full_block_message, const item_hash_t& block_message_hash);
+      void process_reconstructed_compact_block(peer_connection* originating_peer, const peer_connection::partial_compact_block& partial_block);
+      void request_full_block_after_compact_block_failure(peer_connection* originating_peer, const item_hash_t& block_message_hash);
+      void switch_transport_cipher(peer_connection* peer);
+
       void on_connection_closed(peer_connection* originating_peer) override;
 
       void send_sync_block_to_node_delegate(const graphene::net::block_message& block_message_to_send);
       void process_backlog_of_sync_blocks();
       void trigger_process_backlog_of_sync_blocks();
-      void process_block_during_sync(peer_connection* originating_peer, const graphene::net::block_message& block_message, const message_hash_type& message_hash);
+      void process_block_during_sync(peer_connection* originating_peer, const graphene::net::block_message& block_message, const message_hash_type& message_hash, uint32_t message_size);
+      fc::thread* get_sync_apply_thread();
+      uint64_t get_sync_block_memory_in_use() const;
+      void release_received_sync_item(const item_hash_t& block_id);
+      void prune_unreachable_sync_items();
       void process_block_during_normal_operation(peer_connection* originating_peer, const graphene::net::block_message& block_message, const message_hash_type& message_hash);
       void process_block_message(peer_connection* originating_peer, const message& message_to_process, const message_hash_type& message_hash);
 
@@ -656,6 +761,7 @@ namespace graphene { namespace net {
 
       void accept_connection_task(peer_connection_ptr new_peer);
       void accept_loop();
+      fc::thread* get_io_thread_for_new_connection();
       void send_hello_message(const peer_connection_ptr& peer);
       void connect_to_task(peer_connection_ptr new_peer, const fc::ip::endpoint& remote_endpoint);
       bool is_connection_to_endpoint_in_progress(const fc::ip::endpoint& remote_endpoint);
@@ -870,6 +976,13 @@ namespace graphene { namespace net {
       {
         wlog( "unexpected exception on close ${e}", ("e", e) );
       }
+
+      for (const std::shared_ptr<fc::thread>& io_thread : _io_threads)
+        io_thread->quit();
+      _io_threads.clear();
+      if (_sync_apply_thread)
+        _sync_apply_thread->quit();
+      _sync_apply_thread.reset();
       ilog( "done" );
     }
 
@@ -930,9 +1043,10 @@ namespace graphene { namespace net {
             bool initiated_connection_this_pass = false;
             _potential_peer_database_updated = false;
 
-            for (peer_database::iterator iter = _potential_peer_db.begin();
-                 iter != _potential_peer_db.end() && is_wanting_new_connections();
-                 ++iter)
+            // try the best scoring peers first.  Connecting updates their records, which may reorder the
+            // database, so pick the candidates before connecting to any of them
+            std::vector<fc::ip::endpoint> endpoints_to_connect_to;
+            for (peer_database::iterator iter = _potential_peer_db.begin(); iter != _potential_peer_db.end(); ++iter)
             {
               fc::microseconds delay_until_retry = fc::seconds((iter->number_of_failed_connection_attempts + 1) * _node_configuration.peer_connection_retry_timeout);
 
@@ -941,10 +1055,17 @@ namespace graphene { namespace net {
                     iter->last_connection_disposition != last_connection_rejected &&
                     iter->last_connection_disposition != last_connection_handshaking_failed) ||
                    (fc::time_point::now() - iter->last_connection_attempt_time) > delay_until_retry))
-              {
-                connect_to_endpoint(iter->endpoint);
-                initiated_connection_this_pass = true;
-              }
+                endpoints_to_connect_to.push_back(iter->endpoint);
+            }
+
+            for (const fc::ip::endpoint& endpoint : endpoints_to_connect_to)
+            {
+              if (!is_wanting_new_connections())
+                break;
+              if (is_connection_to_endpoint_in_progress(endpoint))
+                continue;
+              connect_to_endpoint(endpoint);
+              initiated_connection_this_pass = true;
             }
 
             if (!initiated_connection_this_pass && !_potential_peer_database_updated)
@@ -1008,10 +1129,7 @@ namespace graphene { namespace net {
     bool node_impl::have_already_received_sync_item( const item_hash_t& item_hash )
     {
       VERIFY_CORRECT_THREAD();
-      return std::find_if(_received_sync_items.begin(), _received_sync_items.end(),
-                          [&item_hash]( const graphene::net::block_message& message ) { return message.block_id == item_hash; } ) != _received_sync_items.end() ||
-             std::find_if(_new_received_sync_items.begin(), _new_received_sync_items.end(),
-                          [&item_hash]( const graphene::net::block_message& message ) { return message.block_id == item_hash; } ) != _new_received_sync_items.end();                          ;
+      return _received_sync_item_sizes.find(item_hash) != _received_sync_item_sizes.end();
     }
 
     void node_impl::request_sync_item_from_peer( const peer_connection_ptr& peer, const item_hash_t& item_to_request )
@@ -1053,13 +1171,26 @@ namespace graphene { namespace net {
           {
             ASSERT_TASK_NOT_PREEMPTED();
             std::set<item_hash_t> sync_items_to_request;
+            uint64_t sync_block_memory_in_use = get_sync_block_memory_in_use();
+            _sync_fetching_limited_by_memory_budget = false;
 
-            // for each idle peer that we're syncing with
+            // the best scoring peers in the peer database get first pick of the blocks to fetch, the others
+            // take over what they don't get to and whatever is left when one of them disconnects
+            std::vector<std::pair<int64_t, peer_connection_ptr> > peers_by_score;
             for( const peer_connection_ptr& peer : _active_connections )
+              if( peer->we_need_sync_items_from_peer )
+                peers_by_score.emplace_back( get_peer_score( peer ), peer );
+            std::stable_sort( peers_by_score.begin(), peers_by_score.end(),
+                              []( const std::pair<int64_t, peer_connection_ptr>& a, const std::pair<int64_t, peer_connection_ptr>& b ) { return a.first > b.first; } );
+
+            // for each peer that we're syncing with.  We don't wait for a peer to deliver all the blocks we asked
+            // for, its window of outstanding requests is topped up so that it never runs dry
+            for( const auto& peer_and_score : peers_by_score )
             {
+              const peer_connection_ptr& peer = peer_and_score.second;
               if( peer->we_need_sync_items_from_peer &&
                   sync_item_requests_to_send.find(peer) == sync_item_requests_to_send.end() && // if we've already scheduled a request for this peer, don't consider scheduling another
-                  peer->idle() )
+                  peer->sync_items_requested_from_peer.size() < _node_configuration.maximum_blocks_per_peer_during_syncing )
               {
                 if (!peer->inhibit_fetching_sync_blocks)
                 {
@@ -1072,10 +1203,21 @@ namespace graphene { namespace net {
                         sync_items_to_request.find(item_to_potentially_request) == sync_items_to_request.end() &&  // we have already decided to request it from another peer during this iteration
                         _active_sync_requests.find(item_to_potentially_request) == _active_sync_requests.end() ) // we've requested it in a previous iteration and we're still waiting for it to arrive
                     {
+                      // stop once the blocks we're waiting for and the blocks waiting to be pushed would exceed
+                      // our memory budget, we'll be triggered again when the client has accepted some of them
+                      if( sync_block_memory_in_use > 0 &&
+                          sync_block_memory_in_use + _average_sync_block_size > _node_configuration.sync_block_memory_budget )
+                      {
+                        _sync_fetching_limited_by_memory_budget = true;
+                        break;
+                      }
+
                       // then schedule a request from this peer
-                      sync_item_requests_to_send[peer].push_back(item_to_potentially_request);
+                      std::vector<item_hash_t>& requests_for_peer = sync_item_requests_to_send[peer];
+                      requests_for_peer.push_back(item_to_potentially_request);
                       sync_items_to_request.insert( item_to_potentially_request );
-                      if (sync_item_requests_to_send[peer].size() >= _node_configuration.maximum_blocks_per_peer_during_syncing)
+                      sync_block_memory_in_use += _average_sync_block_size;
+                      if (requests_for_peer.size() + peer->sync_items_requested_from_peer.size() >= _node_configuration.maximum_blocks_per_peer_during_syncing)
                         break;
                     }
                   }
@@ -1221,7 +1363,12 @@ namespace graphene { namespace net {
                         ("endpoint", peer_and_items.peer->get_remote_endpoint())("id", id));
               }
 
-            peer_and_items.peer->send_message(fetch_items_message(items_by_type.first,
+            uint32_t item_type_to_request = items_by_type.first;
+            if (item_type_to_request == core_message_type_enum::block_message_type &&
+                _node_configuration.enable_compact_blocks && peer_and_items.peer->supports_compact_blocks)
+              item_type_to_request = core_message_type_enum::compact_block_message_type;
+
+            peer_and_items.peer->send_message(fetch_items_message(item_type_to_request,
                                                                   items_by_type.second));
           }
         }
@@ -1259,6 +1406,27 @@ namespace graphene { namespace net {
     {
       while (!_advertise_inventory_loop_done.canceled())
       {
+        // give transactions arriving right behind these a chance to be advertised in the same
+        // inventory messages, a block cuts the wait short
+        bool inventory_contains_block = std::any_of(_new_inventory.begin(), _new_inventory.end(),
+                                                    [](const item_id& item) { return item.item_type != trx_message_type; });
+        if (!_new_inventory.empty() && !inventory_contains_block)
+        {
+          _coalescing_inventory = true;
+          _retrigger_advertise_inventory_loop_promise = fc::promise<void>::ptr(new fc::promise<void>("graphene::net::coalesce_inventory"));
+          try
+          {
+            _retrigger_advertise_inventory_loop_promise->wait(fc::milliseconds(GRAPHENE_NET_INVENTORY_COALESCE_INTERVAL_MS));
+          }
+          catch (const fc::timeout_exception&)
+          {
+          }
+          _retrigger_advertise_inventory_loop_promise.reset();
+          _coalescing_inventory = false;
+          if (_advertise_inventory_loop_done.canceled())
+            break;
+        }
+
         dlog("beginning an iteration of advertise inventory");
         // swap inventory into local variable, clearing the node's copy
         std::unordered_set<item_id> inventory_to_advertise;
@@ -1329,6 +1497,80 @@ namespace graphene { namespace net {
         _retrigger_advertise_inventory_loop_promise->set_value();
     }
 
+    void node_impl::push_transactions_loop()
+    {
+      while (!_push_transactions_loop_done.canceled())
+      {
+        if (_transactions_to_push.empty())
+        {
+          _retrigger_push_transactions_loop_promise = fc::promise<void>::ptr(new fc::promise<void>("graphene::net::retrigger_push_transactions_loop"));
+          _retrigger_push_transactions_loop_promise->wait();
+          _retrigger_push_transactions_loop_promise.reset();
+          // let the transactions that were read along with this one queue up behind it
+          fc::yield();
+          continue;
+        }
+
+        std::vector<transaction_to_push> transactions;
+        transactions.swap(_transactions_to_push);
+        for (size_t first = 0; first < transactions.size(); first += GRAPHENE_NET_MAX_TRANSACTIONS_TO_HANDLE_AT_ONE_TIME)
+          push_transactions(transactions, first, std::min<size_t>(transactions.size(), first + GRAPHENE_NET_MAX_TRANSACTIONS_TO_HANDLE_AT_ONE_TIME));
+      }
+    }
+
+    void node_impl::trigger_push_transactions_loop()
+    {
+      VERIFY_CORRECT_THREAD();
+      if( _retrigger_push_transactions_loop_promise )
+        _retrigger_push_transactions_loop_promise->set_value();
+    }
+
+    void node_impl::push_transactions(const std::vector<transaction_to_push>& transactions, size_t first, size_t last)
+    {
+      VERIFY_CORRECT_THREAD();
+      std::vector<trx_message> transaction_messages;
+      transaction_messages.reserve(last - first);
+      for (size_t i = first; i < last; ++i)
+        transaction_messages.push_back(transactions[i].transaction_message.as<trx_message>());
+
+      dlog("passing ${count} transactions to client", ("count", transaction_messages.size()));
+      std::vector<fc::oexception> results;
+      try
+      {
+        results = _delegate->handle_transactions(transaction_messages);
+        FC_ASSERT(results.size() == transaction_messages.size(), "client returned ${results} results for ${count} transactions",
+                  ("results", results.size())("count", transaction_messages.size()));
+      }
+      catch ( const fc::canceled_exception& )
+      {
+        for (size_t i = first; i < last; ++i)
+          _message_ids_currently_being_processed.erase(transactions[i].message_hash);
+        throw;
+      }
+      catch ( const fc::exception& e )
+      {
+        results.assign(transaction_messages.size(), e);
+      }
+      fc::time_point message_validated_time = fc::time_point::now();
+
+      for (size_t i = first; i < last; ++i)
+      {
+        const transaction_to_push& transaction = transactions[i];
+        _message_ids_currently_being_processed.erase(transaction.message_hash);
+        if (results[i - first])
+        {
+          wlog( "client rejected message sent by peer ${peer}, ${e}", ("peer", transaction.originating_endpoint)("e", *results[i - first]) );
+          // record it so we don't try to fetch this item again
+          _recently_failed_items.insert(peer_connection::timestamped_item_id(item_id(trx_message_type, transaction.message_hash), fc::time_point::now()));
+          continue;
+        }
+
+        // the client validated the transaction, broadcast it to our other peers
+        message_propagation_data propagation_data{transaction.receive_time, message_validated_time, transaction.originating_node_id};
+        broadcast( transaction.transaction_message, propagation_data );
+      }
+    }
+
     void node_impl::terminate_inactive_connections_loop()
     {
       std::list<peer_connection_ptr> peers_to_disconnect_gently;
@@ -1389,6 +1631,9 @@ namespace graphene { namespace net {
         fc::time_point active_disconnect_threshold = fc::time_point::now() - fc::seconds(active_disconnect_timeout);
         fc::time_point active_send_keepalive_threshold = fc::time_point::now() - fc::seconds(active_send_keepalive_timeout);
         fc::time_point active_ignored_request_threshold = fc::time_point::now() - active_ignored_request_timeout;
+        // the missing transactions of a compact block get half of the block request's timeout, which
+        // leaves the other half for the full block we fall back to
+        fc::time_point compact_block_transactions_threshold = fc::time_point::now() - fc::microseconds(active_ignored_request_timeout.count() / 2);
         for( const peer_connection_ptr& active_peer : _active_connections )
         {
           if( active_peer->connection_initiation_time < active_disconnect_threshold &&
@@ -1435,8 +1680,16 @@ namespace graphene { namespace net {
                   disconnect_due_to_request_timeout = true;
                   break;
                 }
+            if (!disconnect_due_to_request_timeout)
+              for (const item_hash_t& block_message_hash : active_peer->expire_compact_blocks_awaiting_transactions(compact_block_transactions_threshold))
+              {
+                wlog("Peer ${peer} didn't send the missing transactions of compact block ${id}, fetching the full block",
+                     ("peer", active_peer->get_remote_endpoint())("id", block_message_hash));
+                request_full_block_after_compact_block_failure(active_peer.get(), block_message_hash);
+              }
             if (disconnect_due_to_request_timeout)
             {
+              ++active_peer->requests_timed_out;
               // we should probably disconnect nicely and give them a reason, but right now the logic
               // for rescheduling the requests only executes when the connection is fully closed,
               // and we want to get those requests rescheduled as soon as possible
@@ -1556,9 +1809,7 @@ namespace graphene { namespace net {
       // this has nothing to do with updating the peer list, but we need to prune this list
       // at regular intervals, this is a fine place to do it.
       fc::time_point_sec oldest_failed_ids_to_keep(fc::time_point::now() - fc::minutes(GRAPHENE_NET_PRUNE_FAILED_IDS_MINUTES));
-      auto oldest_failed_ids_to_keep_iter = _recently_failed_items.get<peer_connection::timestamp_index>().lower_bound(oldest_failed_ids_to_keep);
-      auto begin_iter = _recently_failed_items.get<peer_connection::timestamp_index>().begin();
-      _recently_failed_items.get<peer_connection::timestamp_index>().erase(begin_iter, oldest_failed_ids_to_keep_iter);
+      _recently_failed_items.expire(oldest_failed_ids_to_keep);
 
       if (!_node_is_shutting_down && !_fetch_updated_peer_lists_loop_done.canceled() )
          _fetch_updated_peer_lists_loop_done = schedule_task( [this](){ fetch_updated_peer_lists_loop(); },
@@ -1605,12 +1856,63 @@ namespace graphene { namespace net {
       update_bandwidth_data(bytes_read_this_second, bytes_written_this_second);
       _bandwidth_monitor_last_update_time = current_time;
 
+      // keep the scores in the peer database current for long lived connections too
+      if (fc::time_point::now() - _last_peer_statistics_time > fc::minutes(GRAPHENE_NET_PEER_STATISTICS_INTERVAL_MINUTES))
+      {
+        for (const peer_connection_ptr& peer : _active_connections)
+          record_peer_statistics(peer.get());
+        _last_peer_statistics_time = fc::time_point::now();
+      }
+
+      // the peer database journals the changes made since the last time around in one write
+      _potential_peer_db.flush();
+
       if (!_node_is_shutting_down && !_bandwidth_monitor_loop_done.canceled())
         _bandwidth_monitor_loop_done = schedule_task( [=](){ bandwidth_monitor_loop(); },
                                                      fc::time_point::now() + fc::seconds(GRAPHENE_NET_BANDWIDTH_MONITOR_INTERVAL_SECONDS),
                                                      "bandwidth_monitor_loop" );
     }
 
+    void node_impl::record_peer_statistics(peer_connection* peer)
+    {
+      VERIFY_CORRECT_THREAD();
+      fc::time_point now = fc::time_point::now();
+      if (peer->last_statistics_time == fc::time_point())
+        peer->last_statistics_time = peer->get_connection_time();
+      int64_t seconds = (now - peer->last_statistics_time).to_seconds();
+      fc::optional<fc::ip::endpoint> inbound_endpoint = peer->get_endpoint_for_connecting();
+      if (!inbound_endpoint || seconds <= 0)
+        return;
+
+      uint64_t bytes_received = peer->get_total_bytes_received();
+      fc::optional<potential_peer_record> updated_peer_record = _potential_peer_db.lookup_entry_for_endpoint(*inbound_endpoint);
+      if (updated_peer_record)
+      {
+        updated_peer_record->record_connection_statistics(peer->round_trip_delay,
+                                                          (bytes_received - peer->bytes_received_at_last_statistics_time) / seconds,
+                                                          peer->blocks_delivered, peer->blocks_rejected, peer->requests_timed_out);
+        _potential_peer_db.update_entry(*updated_peer_record);
+      }
+
+      peer->last_statistics_time = now;
+      peer->bytes_received_at_last_statistics_time = bytes_received;
+      peer->blocks_delivered = 0;
+      peer->blocks_rejected = 0;
+      peer->requests_timed_out = 0;
+    }
+
+    int64_t node_impl::get_peer_score(const peer_connection_ptr& peer)
+    {
+      fc::optional<fc::ip::endpoint> inbound_endpoint = peer->get_endpoint_for_connecting();
+      if (inbound_endpoint)
+      {
+        fc::optional<potential_peer_record> peer_record = _potential_peer_db.lookup_entry_for_endpoint(*inbound_endpoint);
+        if (peer_record)
+          return peer_record->score();
+      }
+      return potential_peer_record().score();
+    }
+
     void node_impl::dump_node_status_task()
     {
       dump_node_status();
@@ -1846,6 +2148,18 @@ namespace graphene { namespace net {
       case core_message_type_enum::get_current_connections_reply_message_type:
         on_get_current_connections_reply_message(originating_peer, received_message.as<get_current_connections_reply_message>());
         break;
+      case core_message_type_enum::compact_block_message_type:
+        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+        break;
+      case core_message_type_enum::get_compact_block_transactions_message_type:
+        on_get_compact_block_transactions_message(originating_peer, received_message.as<get_compact_block_transactions_message>());
+        break;
+      case core_message_type_enum::compact_block_transactions_message_type:
+        on_compact_block_transactions_message(originating_peer, received_message.as<compact_block_transactions_message>());
+        break;
+      case core_message_type_enum::transport_cipher_switch_message_type:
+        // already acted on by the connection, which switched its receive cipher after reading it
+        break;
 
       default:
         // ignore any message in between core_message_type_first and _last that we don't handle above
@@ -1890,6 +2204,10 @@ namespace graphene { namespace net {
         user_data["last_known_fork_block_number"] = _hard_fork_block_numbers.back();
 
       user_data["chain_id"] = _delegate->get_chain_id();
+      if (_node_configuration.enable_compact_blocks)
+        user_data["compact_blocks"] = true;
+      if (!_node_configuration.transport_cipher.empty())
+        user_data["transport_ciphers"] = stcp_socket::get_authenticated_ciphers();
 
       return user_data;
     }
@@ -1915,6 +2233,10 @@ namespace graphene { namespace net {
         originating_peer->last_known_fork_block_number = user_data["last_known_fork_block_number"].as<uint32_t>();
       if (user_data.contains("chain_id"))
         originating_peer->chain_id = user_data["chain_id"].as<steem::protocol::chain_id_type>();
+      if (user_data.contains("compact_blocks"))
+        originating_peer->supports_compact_blocks = user_data["compact_blocks"].as_bool();
+      if (user_data.contains("transport_ciphers"))
+        originating_peer->transport_ciphers = user_data["transport_ciphers"].as<std::vector<std::string>>();
     }
 
     void node_impl::on_hello_message( peer_connection* originating_peer, const hello_message& hello_message_received )
@@ -2111,6 +2433,7 @@ namespace graphene { namespace net {
             originating_peer->send_message(message(connection_accepted_message()));
             dlog("Received a hello_message from peer ${peer}, sending reply to accept connection",
                  ("peer", originating_peer->get_remote_endpoint()));
+            switch_transport_cipher(originating_peer);
           }
         }
       }
@@ -2796,9 +3119,14 @@ namespace graphene { namespace net {
            ("type", fetch_items_message_received.item_type)
            ("endpoint", originating_peer->get_remote_endpoint()));
 
+      // a request for compact blocks is looked up like a request for the full blocks, we only
+      // change the form of the reply
+      const bool send_compact_blocks = fetch_items_message_received.item_type == compact_block_message_type;
+      const uint32_t item_type = send_compact_blocks ? uint32_t(block_message_type) : fetch_items_message_received.item_type;
+
       fc::optional<message> last_block_message_sent;
 
-      std::list<message> reply_messages;
+      std::list<std::pair<item_hash_t, message> > reply_messages;
       for (const item_hash_t& item_hash : fetch_items_message_received.items_to_fetch)
       {
         try
@@ -2807,8 +3135,8 @@ namespace graphene { namespace net {
           dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                ("endpoint", originating_peer->get_remote_endpoint())
                ("id", requested_message.id()));
-          reply_messages.push_back(requested_message);
-          if (fetch_items_message_received.item_type == block_message_type)
+          reply_messages.emplace_back(item_hash, requested_message);
+          if (item_type == block_message_type)
             last_block_message_sent = requested_message;
           continue;
         }
@@ -2817,7 +3145,7 @@ namespace graphene { namespace net {
            // it wasn't in our local cache, that's ok ask the client
         }
 
-        item_id item_to_fetch(fetch_items_message_received.item_type, item_hash);
+        item_id item_to_fetch(item_type, item_hash);
         try
         {
           message requested_message = _delegate->get_item(item_to_fetch);
@@ -2825,14 +3153,14 @@ namespace graphene { namespace net {
                ("id", requested_message.id())
                ("size", requested_message.size)
                ("endpoint", originating_peer->get_remote_endpoint()));
-          reply_messages.push_back(requested_message);
-          if (fetch_items_message_received.item_type == block_message_type)
+          reply_messages.emplace_back(item_hash, requested_message);
+          if (item_type == block_message_type)
             last_block_message_sent = requested_message;
           continue;
         }
         catch (fc::key_not_found_exception&)
         {
-          reply_messages.push_back(item_not_available_message(item_to_fetch));
+          reply_messages.emplace_back(item_hash, item_not_available_message(item_to_fetch));
           dlog("received item request from peer ${endpoint} but we don't have it",
                ("endpoint", originating_peer->get_remote_endpoint()));
         }
@@ -2846,12 +3174,14 @@ namespace graphene { namespace net {
         originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
       }
 
-      for (const message& reply : reply_messages)
+      for (const auto& reply : reply_messages)
       {
-        if (reply.msg_type == block_message_type)
-          originating_peer->send_item(item_id(block_message_type, reply.as<graphene::net::block_message>().block_id));
+        if (reply.second.msg_type == block_message_type && send_compact_blocks)
+          send_compact_block(originating_peer, reply.second, reply.first);
+        else if (reply.second.msg_type == block_message_type)
+          originating_peer->send_item(item_id(block_message_type, reply.second.as<graphene::net::block_message>().block_id));
         else
-          originating_peer->send_message(reply);
+          originating_peer->send_message(reply.second);
       }
     }
 
@@ -3024,6 +3354,7 @@ namespace graphene { namespace net {
       _terminating_connections.erase(originating_peer_ptr);
       if (_active_connections.find(originating_peer_ptr) != _active_connections.end())
       {
+        record_peer_statistics(originating_peer);
         _active_connections.erase(originating_peer_ptr);
 
         if (inbound_endpoint && originating_peer_ptr->get_remote_endpoint())
@@ -3104,7 +3435,9 @@ namespace graphene { namespace net {
                 "p2p pushing sync block #${block_num} ${block_hash}",
                 ("block_num", block_message_to_send.block.block_num())
                 ("block_hash", block_message_to_send.block_id));
-        _delegate->handle_block(block_message_to_send, true, contained_transaction_message_ids);
+        get_sync_apply_thread()->async([this, &block_message_to_send, &contained_transaction_message_ids]() {
+          return _delegate->handle_block_on_calling_thread(block_message_to_send, true, contained_transaction_message_ids);
+        }, "handle sync block").wait();
 
         auto bn = block_message_to_send.block.block_num();
         //if(bn % 1000 == 0)
@@ -3151,6 +3484,8 @@ namespace graphene { namespace net {
         handle_message_exception = e;
       }
 
+      release_received_sync_item(block_message_to_send.block_id);
+
       // build up lists for any potentially-blocking operations we need to do, then do them
       // at the end of this function
       std::set<peer_connection_ptr> peers_with_newly_empty_item_lists;
@@ -3249,7 +3584,10 @@ namespace graphene { namespace net {
               peer->inhibit_fetching_sync_blocks = true;
             }
             else
+            {
               peers_to_disconnect[peer] = std::make_pair(std::string("You offered us a block that we reject as invalid"), fc::oexception(handle_message_exception));
+              ++peer->blocks_rejected;
+            }
           }
         }
       }
@@ -3394,6 +3732,8 @@ namespace graphene { namespace net {
                   }
                 }
               }
+              release_received_sync_item(received_block_iter->block_id);
+              _received_sync_items.erase(received_block_iter);
               for( const peer_connection_ptr& peer : peers_needing_next_batch )
                 fetch_next_batch_of_item_ids_from_peer(peer.get());
             }
@@ -3416,6 +3756,10 @@ namespace graphene { namespace net {
 
       dlog("leaving process_backlog_of_sync_blocks, ${count} processed", ("count", blocks_processed));
 
+      if (blocks_processed == 0 && _handle_message_calls_in_progress.empty() &&
+          _received_sync_items_size >= _node_configuration.sync_block_memory_budget)
+        prune_unreachable_sync_items();
+
       if (!_suspend_fetching_sync_blocks)
         trigger_fetch_sync_items_loop();
     }
@@ -3427,11 +3771,69 @@ namespace graphene { namespace net {
         _process_backlog_of_sync_blocks_done = async_task([=](){ process_backlog_of_sync_blocks(); }, "process_backlog_of_sync_blocks");
     }
 
+    fc::thread* node_impl::get_sync_apply_thread()
+    {
+      VERIFY_CORRECT_THREAD();
+      if (!_sync_apply_thread)
+        _sync_apply_thread = std::make_shared<fc::thread>("p2p sync apply");
+      return _sync_apply_thread.get();
+    }
+
+    uint64_t node_impl::get_sync_block_memory_in_use() const
+    {
+      VERIFY_CORRECT_THREAD();
+      return _received_sync_items_size + uint64_t(_active_sync_requests.size()) * _average_sync_block_size;
+    }
+
+    void node_impl::release_received_sync_item(const item_hash_t& block_id)
+    {
+      VERIFY_CORRECT_THREAD();
+      auto iter = _received_sync_item_sizes.find(block_id);
+      if (iter == _received_sync_item_sizes.end())
+        return;
+
+      _received_sync_items_size -= iter->second;
+      _received_sync_item_sizes.erase(iter);
+
+      if (_sync_fetching_limited_by_memory_budget)
+        trigger_fetch_sync_items_loop();
+    }
+
+    void node_impl::prune_unreachable_sync_items()
+    {
+      VERIFY_CORRECT_THREAD();
+      // blocks no syncing peer will lead us to (e.g. the peer that offered them switched forks or
+      // disconnected) would hold on to the memory budget forever
+      std::unordered_set<item_hash_t> reachable_items;
+      for (const peer_connection_ptr& peer : _active_connections)
+        reachable_items.insert(peer->ids_of_items_to_get.begin(), peer->ids_of_items_to_get.end());
+
+      unsigned pruned_count = 0;
+      for (auto iter = _received_sync_items.begin(); iter != _received_sync_items.end();)
+      {
+        if (reachable_items.find(iter->block_id) == reachable_items.end())
+        {
+          release_received_sync_item(iter->block_id);
+          iter = _received_sync_items.erase(iter);
+          ++pruned_count;
+        }
+        else
+          ++iter;
+      }
+      if (pruned_count)
+        wlog("dropped ${count} sync blocks that no peer is offering anymore", ("count", pruned_count));
+    }
+
     void node_impl::process_block_during_sync( peer_connection* originating_peer,
-                                               const graphene::net::block_message& block_message_to_process, const message_hash_type& message_hash )
+                                               const graphene::net::block_message& block_message_to_process, const message_hash_type& message_hash,
+                                               uint32_t message_size )
     {
       dlog( "received a sync block from peer ${endpoint}", ("endpoint", originating_peer->get_remote_endpoint() ) );
 
+      if (_received_sync_item_sizes.emplace(block_message_to_process.block_id, message_size).second)
+        _received_sync_items_size += message_size;
+      _average_sync_block_size = uint32_t((uint64_t(_average_sync_block_size) * 15 + message_size) / 16);
+
       // add it to the front of _received_sync_items, then process _received_sync_items to try to
       // pass as many messages as possible to the client.
       _new_received_sync_items.push_front( block_message_to_process );
@@ -3578,6 +3980,7 @@ namespace graphene { namespace net {
         disconnect_reason = "You offered me a block that I have deemed to be invalid";
 
         peers_to_disconnect.insert( originating_peer->shared_from_this() );
+        ++originating_peer->blocks_rejected;
         for (const peer_connection_ptr& peer : _active_connections)
           if (!peer->ids_of_items_to_get.empty() && peer->ids_of_items_to_get.front() == block_message_to_process.block_id)
             peers_to_disconnect.insert(peer);
@@ -3612,6 +4015,7 @@ namespace graphene { namespace net {
       if (item_iter != originating_peer->items_requested_from_peer.end())
       {
         originating_peer->items_requested_from_peer.erase(item_iter);
+        ++originating_peer->blocks_delivered;
         process_block_during_normal_operation(originating_peer, block_message_to_process, message_hash);
         if (originating_peer->idle())
           trigger_fetch_items_loop();
@@ -3624,6 +4028,7 @@ namespace graphene { namespace net {
         if (sync_item_iter != originating_peer->sync_items_requested_from_peer.end())
         {
           originating_peer->sync_items_requested_from_peer.erase(sync_item_iter);
+          ++originating_peer->blocks_delivered;
           // if exceptions are throw here after removing the sync item from the list (above),
           // it could leave our sync in a stalled state.  Wrap a try/catch around the rest
           // of the function so we can log if this ever happens.
@@ -3631,7 +4036,7 @@ namespace graphene { namespace net {
           {
             originating_peer->last_sync_item_received_time = fc::time_point::now();
             _active_sync_requests.erase(block_message_to_process.block_id);
-            process_block_during_sync(originating_peer, block_message_to_process, message_hash);
+            process_block_during_sync(originating_peer, block_message_to_process, message_hash, message_to_process.size);
             if (originating_peer->idle())
             {
               // we have finished fetching a batch of items, so we either need to grab another batch of items
@@ -3642,6 +4047,17 @@ namespace graphene { namespace net {
               else
                 trigger_fetch_sync_items_loop();
             }
+            else
+            {
+              // keep the pipeline full: ask for more item ids before the peer's list runs dry, and
+              // top up its window of outstanding requests once half of it has arrived
+              if (!originating_peer->item_ids_requested_from_peer &&
+                  originating_peer->number_of_unfetched_item_ids > 0 &&
+                  originating_peer->ids_of_items_to_get.size() < GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH)
+                fetch_next_batch_of_item_ids_from_peer(originating_peer);
+              if (originating_peer->sync_items_requested_from_peer.size() <= _node_configuration.maximum_blocks_per_peer_during_syncing / 2)
+                trigger_fetch_sync_items_loop();
+            }
             return;
           }
           catch (const fc::canceled_exception& e)
@@ -3936,6 +4352,166 @@ namespace graphene { namespace net {
       VERIFY_CORRECT_THREAD();
     }
 
+    void node_impl::send_compact_block(peer_connection* peer, const message& full_block_message, const item_hash_t& block_message_hash)
+    {
+      VERIFY_CORRECT_THREAD();
+      graphene::net::block_message full_block = full_block_message.as<graphene::net::block_message>();
+      peer->send_message(compact_block_message(full_block, block_message_hash));
+    }
+
+    void node_impl::on_compact_block_message(peer_connection* originating_peer,
+                                             const compact_block_message& compact_block_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      if (originating_peer->items_requested_from_peer.find(item_id(block_message_type, compact_block_message_received.block_message_hash)) ==
+          originating_peer->items_requested_from_peer.end())
+      {
+        wlog("received a compact block ${block_id} I didn't ask for from peer ${endpoint}, disconnecting from peer",
+             ("endpoint", originating_peer->get_remote_endpoint())
+             ("block_id", compact_block_message_received.block_id));
+        fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me a block that I didn't ask for, block_id: ${block_id}",
+                                                    ("block_id", compact_block_message_received.block_id)));
+        disconnect_from_peer(originating_peer, "You sent me a block that I didn't ask for", true, detailed_error);
+        return;
+      }
+
+      peer_connection::partial_compact_block partial_block(compact_block_message_received);
+
+      // almost all transactions were relayed to us before the block, look for them in our message cache first
+      partial_block.add_transactions([this](uint64_t short_id) { return _message_cache.find_transaction_by_short_id(short_id); });
+
+      // then in the pending pool, which also holds transactions that reached the blockchain without the p2p network
+      std::unordered_set<uint64_t> missing_short_ids = partial_block.get_missing_short_ids();
+      if (!missing_short_ids.empty())
+        partial_block.add_transactions(_delegate->get_pending_transactions(
+          [&missing_short_ids](const transaction_id_type& id) {
+            return missing_short_ids.find(compact_block_message::short_transaction_id(id)) != missing_short_ids.end();
+          }));
+
+      std::vector<uint32_t> missing_transaction_indices = partial_block.get_missing_transaction_indices();
+      dlog("received compact block ${block_id} with ${count} transactions from peer ${endpoint}, ${missing} missing",
+           ("block_id", compact_block_message_received.block_id)
+           ("count", compact_block_message_received.short_transaction_ids.size())
+           ("missing", missing_transaction_indices.size())
+           ("endpoint", originating_peer->get_remote_endpoint()));
+
+      if (missing_transaction_indices.empty())
+      {
+        process_reconstructed_compact_block(originating_peer, partial_block);
+        return;
+      }
+
+      originating_peer->send_message(get_compact_block_transactions_message(compact_block_message_received.block_id,
+                                                                            std::move(missing_transaction_indices)));
+      partial_block.transactions_requested_time = fc::time_point::now();
+      originating_peer->compact_blocks_awaiting_transactions[compact_block_message_received.block_id] = std::move(partial_block);
+    }
+
+    void node_impl::on_get_compact_block_transactions_message(peer_connection* originating_peer,
+                                                              const get_compact_block_transactions_message& get_compact_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const block_id_type& block_id = get_compact_block_transactions_message_received.block_id;
+
+      fc::optional<message> full_block_message = _message_cache.find_message_by_contents_hash(block_id, block_message_type);
+      if (!full_block_message)
+      {
+        try
+        {
+          full_block_message = _delegate->get_item(item_id(block_message_type, block_id));
+        }
+        catch (const fc::exception&)
+        {
+          // an empty reply tells the peer to fetch the full block
+        }
+      }
+
+      if (full_block_message && full_block_message->msg_type == block_message_type)
+        originating_peer->send_message(compact_block_transactions_message(full_block_message->as<graphene::net::block_message>(),
+                                                                          get_compact_block_transactions_message_received.transaction_indices));
+      else
+        originating_peer->send_message(compact_block_transactions_message(block_id));
+    }
+
+    void node_impl::on_compact_block_transactions_message(peer_connection* originating_peer,
+                                                          const compact_block_transactions_message& compact_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      auto iter = originating_peer->compact_blocks_awaiting_transactions.find(compact_block_transactions_message_received.block_id);
+      if (iter == originating_peer->compact_blocks_awaiting_transactions.end())
+      {
+        dlog("ignoring transactions for compact block ${block_id} from peer ${endpoint}, we aren't waiting for them",
+             ("block_id", compact_block_transactions_message_received.block_id)
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        return;
+      }
+
+      peer_connection::partial_compact_block partial_block = std::move(iter->second);
+      originating_peer->compact_blocks_awaiting_transactions.erase(iter);
+
+      if (!partial_block.add_missing_transactions(compact_block_transactions_message_received.transactions))
+      {
+        request_full_block_after_compact_block_failure(originating_peer, partial_block.block_message_hash);
+        return;
+      }
+
+      process_reconstructed_compact_block(originating_peer, partial_block);
+    }
+
+    void node_impl::process_reconstructed_compact_block(peer_connection* originating_peer, const peer_connection::partial_compact_block& partial_block)
+    {
+      VERIFY_CORRECT_THREAD();
+      fc::optional<message> block_message_to_process = partial_block.get_block_message();
+      if (!block_message_to_process)
+      {
+        wlog("compact block ${num} from peer ${endpoint} was rebuilt with the wrong transactions, fetching the full block",
+             ("num", partial_block.block.block_num())
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        request_full_block_after_compact_block_failure(originating_peer, partial_block.block_message_hash);
+        return;
+      }
+
+      process_block_message(originating_peer, *block_message_to_process, partial_block.block_message_hash);
+    }
+
+    void node_impl::request_full_block_after_compact_block_failure(peer_connection* originating_peer, const item_hash_t& block_message_hash)
+    {
+      VERIFY_CORRECT_THREAD();
+      originating_peer->send_message(fetch_items_message(block_message_type, std::vector<item_hash_t>{block_message_hash}));
+    }
+
+    /**
+     * Moves our side of the connection to an authenticated cipher if the peer can decrypt one we
+     * support, preferring the configured one.  The peer switches its own side when it accepts our hello.
+     */
+    void node_impl::switch_transport_cipher(peer_connection* peer)
+    {
+      VERIFY_CORRECT_THREAD();
+      if (_node_configuration.transport_cipher.empty() || peer->transport_ciphers.empty())
+        return;
+
+      auto peer_supports = [&](const std::string& cipher) {
+        return std::find(peer->transport_ciphers.begin(), peer->transport_ciphers.end(), cipher) != peer->transport_ciphers.end();
+      };
+
+      std::string cipher;
+      if (stcp_socket::is_authenticated_cipher_supported(_node_configuration.transport_cipher) &&
+          peer_supports(_node_configuration.transport_cipher))
+        cipher = _node_configuration.transport_cipher;
+      else
+        for (const std::string& supported_cipher : stcp_socket::get_authenticated_ciphers())
+          if (peer_supports(supported_cipher))
+          {
+            cipher = supported_cipher;
+            break;
+          }
+
+      if (cipher.empty())
+        return;
+      dlog("switching transport to ${cipher} for peer ${peer}", ("cipher", cipher)("peer", peer->get_remote_endpoint()));
+      peer->send_message(message(transport_cipher_switch_message(cipher)));
+    }
+
 
     // this handles any message we get that doesn't require any special processing.
     // currently, this is any message other than block messages and p2p-specific
@@ -3965,18 +4541,28 @@ namespace graphene { namespace net {
         if (originating_peer->idle())
           trigger_fetch_items_loop();
 
+        // Transactions are handed to the delegate in batches by push_transactions_loop, once each no
+        // matter how many peers send them
+        if (message_to_process.msg_type == trx_message_type)
+        {
+          if (_message_ids_currently_being_processed.find(message_hash) != _message_ids_currently_being_processed.end() ||
+              _message_cache.contains(message_hash))
+          {
+            dlog("already handling or handled transaction ${hash}, not passing it to the client again", ("hash", message_hash));
+            return;
+          }
+          _message_ids_currently_being_processed.insert(message_hash);
+          _transactions_to_push.push_back(transaction_to_push{message_to_process, message_hash, message_receive_time,
+                                                              originating_peer->node_id, originating_peer->get_remote_endpoint()});
+          trigger_push_transactions_loop();
+          return;
+        }
+
         // Next: have the delegate process the message
         fc::time_point message_validated_time;
         try
         {
-          if (message_to_process.msg_type == trx_message_type)
-          {
-            trx_message transaction_message_to_process = message_to_process.as<trx_message>();
-            dlog("passing message containing transaction ${trx} to client", ("trx", transaction_message_to_process.trx.id()));
-            _delegate->handle_transaction(transaction_message_to_process);
-          }
-          else
-            _delegate->handle_message( message_to_process );
+          _delegate->handle_message( message_to_process );
           message_validated_time = fc::time_point::now();
         }
         catch ( const fc::canceled_exception& )
@@ -4210,6 +4796,28 @@ namespace graphene { namespace net {
         wlog( "Exception thrown while terminating Advertise inventory loop, ignoring" );
       }
 
+      try
+      {
+        _push_transactions_loop_done.cancel("node_impl::close()");
+        // cancel() is currently broken, so we need to wake up the task to allow it to finish
+        trigger_push_transactions_loop();
+        _push_transactions_loop_done.wait();
+        dlog("Push transactions loop terminated");
+      }
+      catch ( const fc::canceled_exception& )
+      {
+        dlog("Push transactions loop terminated");
+      }
+      catch ( const fc::exception& e )
+      {
+        wlog( "Exception thrown while terminating Push transactions loop, ignoring: ${e}", ("e", e) );
+      }
+      catch (...)
+      {
+        wlog( "Exception thrown while terminating Push transactions loop, ignoring" );
+      }
+      _transactions_to_push.clear();
+
 
       // Next, terminate our existing connections.  First, close all of the connections nicely.
       // This will close the sockets and may result in calls to our "on_connection_closing"
@@ -4341,11 +4949,27 @@ namespace graphene { namespace net {
       send_hello_message(new_peer);
     }
 
+    fc::thread* node_impl::get_io_thread_for_new_connection()
+    {
+      VERIFY_CORRECT_THREAD();
+      // The rate limiter is not thread safe, connections of a rate limited node stay on this thread
+      if (_node_configuration.io_thread_count == 0 ||
+          _rate_limiter.get_upload_limit() || _rate_limiter.get_download_limit())
+        return nullptr;
+
+      while (_io_threads.size() < _node_configuration.io_thread_count)
+        _io_threads.push_back(std::make_shared<fc::thread>("p2p io " + std::to_string(_io_threads.size())));
+
+      return _io_threads[_next_io_thread++ % _node_configuration.io_thread_count].get();
+    }
+
     void node_impl::accept_loop()
     {
       while ( !_accept_loop_complete.canceled() )
       {
         peer_connection_ptr new_peer(peer_connection::make_shared(this));
+        fc::thread* io_thread = get_io_thread_for_new_connection();
+        new_peer->set_io_thread(io_thread);
 
         try
         {
@@ -4355,7 +4979,8 @@ namespace graphene { namespace net {
             return;
           new_peer->connection_initiation_time = fc::time_point::now();
           _handshaking_connections.insert( new_peer );
-          _rate_limiter.add_tcp_socket( &new_peer->get_socket() );
+          if (!io_thread)
+            _rate_limiter.add_tcp_socket( &new_peer->get_socket() );
           std::weak_ptr<peer_connection> new_weak_peer(new_peer);
           new_peer->accept_or_connect_task_done = async_task( [this, new_weak_peer]() {
             peer_connection_ptr new_peer(new_weak_peer.lock());
@@ -4710,6 +5335,7 @@ namespace graphene { namespace net {
              !_fetch_sync_items_loop_done.valid() &&
              !_fetch_item_loop_done.valid() &&
              !_advertise_inventory_loop_done.valid() &&
+             !_push_transactions_loop_done.valid() &&
              !_terminate_inactive_connections_loop_done.valid() &&
              !_fetch_updated_peer_lists_loop_done.valid() &&
              !_bandwidth_monitor_loop_done.valid() &&
@@ -4720,6 +5346,7 @@ namespace graphene { namespace net {
       _fetch_sync_items_loop_done = async_task( [=]() { fetch_sync_items_loop(); }, "fetch_sync_items_loop" );
       _fetch_item_loop_done = async_task( [=]() { fetch_items_loop(); }, "fetch_items_loop" );
       _advertise_inventory_loop_done = async_task( [=]() { advertise_inventory_loop(); }, "advertise_inventory_loop" );
+      _push_transactions_loop_done = async_task( [=]() { push_transactions_loop(); }, "push_transactions_loop" );
       _terminate_inactive_connections_loop_done = async_task( [=]() { terminate_inactive_connections_loop(); }, "terminate_inactive_connections_loop" );
       _fetch_updated_peer_lists_loop_done = async_task([=](){ fetch_updated_peer_lists_loop(); }, "fetch_updated_peer_lists_loop");
       _bandwidth_monitor_loop_done = async_task([=](){ bandwidth_monitor_loop(); }, "bandwidth_monitor_loop");
@@ -4743,11 +5370,14 @@ namespace graphene { namespace net {
 
     void node_impl::initiate_connect_to(const peer_connection_ptr& new_peer)
     {
+      fc::thread* io_thread = get_io_thread_for_new_connection();
+      new_peer->set_io_thread(io_thread);
       new_peer->get_socket().open();
       new_peer->get_socket().set_reuse_address();
       new_peer->connection_initiation_time = fc::time_point::now();
       _handshaking_connections.insert(new_peer);
-      _rate_limiter.add_tcp_socket(&new_peer->get_socket());
+      if (!io_thread)
+        _rate_limiter.add_tcp_socket(&new_peer->get_socket());
 
       if (_node_is_shutting_down)
         return;
@@ -4863,6 +5493,8 @@ namespace graphene { namespace net {
       ilog( "--------- MEMORY USAGE ------------" );
       ilog( "node._active_sync_requests size: ${size}", ("size", _active_sync_requests.size() ) );
       ilog( "node._received_sync_items size: ${size}", ("size", _received_sync_items.size() ) );
+      ilog( "node sync block memory in use: ${bytes} of ${budget} bytes, average block size ${average}",
+            ("bytes", get_sync_block_memory_in_use())("budget", _node_configuration.sync_block_memory_budget)("average", _average_sync_block_size) );
       ilog( "node._new_received_sync_items size: ${size}", ("size", _new_received_sync_items.size() ) );
       ilog( "node._items_to_fetch size: ${size}", ("size", _items_to_fetch.size() ) );
       ilog( "node._new_inventory size: ${size}", ("size", _new_inventory.size() ) );
@@ -5058,7 +5690,9 @@ namespace graphene { namespace net {
 
       _message_cache.cache_message( item_to_broadcast, hash_of_item_to_broadcast, propagation_data, hash_of_message_contents );
       _new_inventory.insert( item_id(item_to_broadcast.msg_type, hash_of_item_to_broadcast ) );
-      trigger_advertise_inventory_loop();
+      // a transaction waits for the current coalescing window, anything else is advertised right away
+      if( !_coalescing_inventory || item_to_broadcast.msg_type != graphene::net::trx_message_type )
+        trigger_advertise_inventory_loop();
     }
 
     void node_impl::broadcast( const message& item_to_broadcast )
@@ -5542,10 +6176,19 @@ namespace graphene { namespace net {
       dlog("node_delegate threw unrecognized exception"); \
       throw; \
     }
+#  define INVOKE_ON_CALLING_THREAD_AND_COLLECT_STATISTICS(statistics_name, method_name, ...) \
+    call_statistics_collector statistics_collector(#statistics_name, \
+       &_ ## statistics_name ## _execution_accumulator, \
+       &_ ## statistics_name ## _delay_before_accumulator, \
+       &_ ## statistics_name ## _delay_after_accumulator); \
+    call_statistics_collector::actual_execution_measurement_helper helper(statistics_collector); \
+    return _node_delegate->method_name(__VA_ARGS__);
 #else
 #define INVOKE_AND_COLLECT_STATISTICS( method_name, ... ) \
    FC_UNUSED( _thread ) \
    return _node_delegate->method_name(__VA_ARGS__);
+#define INVOKE_ON_CALLING_THREAD_AND_COLLECT_STATISTICS( statistics_name, method_name, ... ) \
+   return _node_delegate->method_name(__VA_ARGS__);
 /*
 #  define INVOKE_AND_COLLECT_STATISTICS(method_name, ...) \
     if ( _thread->is_current()) \
@@ -5589,11 +6232,21 @@ namespace graphene { namespace net {
       INVOKE_AND_COLLECT_STATISTICS(handle_block, block_message, sync_mode, contained_transaction_message_ids);
     }
 
+    bool statistics_gathering_node_delegate_wrapper::handle_block_on_calling_thread( const graphene::net::block_message& block_message, bool sync_mode, std::vector<fc::uint160_t>& contained_transaction_message_ids )
+    {
+      INVOKE_ON_CALLING_THREAD_AND_COLLECT_STATISTICS(handle_sync_block, handle_block, block_message, sync_mode, contained_transaction_message_ids);
+    }
+
     void statistics_gathering_node_delegate_wrapper::handle_transaction( const graphene::net::trx_message& transaction_message )
     {
       INVOKE_AND_COLLECT_STATISTICS(handle_transaction, transaction_message);
     }
 
+    std::vector<fc::oexception> statistics_gathering_node_delegate_wrapper::handle_transactions( const std::vector<graphene::net::trx_message>& transaction_messages )
+    {
+      INVOKE_AND_COLLECT_STATISTICS(handle_transactions, transaction_messages);
+    }
+
     std::vector<item_hash_t> statistics_gathering_node_delegate_wrapper::get_block_ids(const std::vector<item_hash_t>& blockchain_synopsis,
                                                                                        uint32_t& remaining_item_count,
                                                                                        uint32_t limit /* = 2000 */)
@@ -5606,6 +6259,11 @@ namespace graphene { namespace net {
       INVOKE_AND_COLLECT_STATISTICS(get_item, id);
     }
 
+    std::vector<signed_transaction> statistics_gathering_node_delegate_wrapper::get_pending_transactions( const std::function<bool(const transaction_id_type&)>& filter )
+    {
+      INVOKE_AND_COLLECT_STATISTICS(get_pending_transactions, filter);
+    }
+
     std::vector<item_hash_t> statistics_gathering_node_delegate_wrapper::get_blockchain_synopsis(const item_hash_t& reference_point, uint32_t number_of_blocks_after_reference_point)
     {
       INVOKE_AND_COLLECT_STATISTICS(get_blockchain_synopsis, reference_point, number_of_blocks_after_reference_point);
@@ -5657,6 +6315,7 @@ namespace graphene { namespace net {
     }
 
 #undef INVOKE_AND_COLLECT_STATISTICS
+#undef INVOKE_ON_CALLING_THREAD_AND_COLLECT_STATISTICS
 
   } // end namespace detail
 
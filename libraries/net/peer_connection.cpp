@@ -30,6 +30,8 @@
 
 #include <boost/scope_exit.hpp>
 
+#include <unordered_map>
+
 #ifdef DEFAULT_LOGGER
 # undef DEFAULT_LOGGER
 #endif
@@ -184,6 +186,12 @@ namespace graphene { namespace net
       return _message_connection.get_socket();
     }
 
+    void peer_connection::set_io_thread(fc::thread* io_thread)
+    {
+      VERIFY_CORRECT_THREAD();
+      _message_connection.set_io_thread(io_thread);
+    }
+
     void peer_connection::accept_connection()
     {
       VERIFY_CORRECT_THREAD();
@@ -480,16 +488,10 @@ namespace graphene { namespace net
       fc::time_point_sec oldest_inventory_to_keep(fc::time_point::now() - fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES));
 
       // expire old items from inventory_advertised_to_peer
-      auto oldest_inventory_to_keep_iter = inventory_advertised_to_peer.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
-      auto begin_iter = inventory_advertised_to_peer.get<timestamp_index>().begin();
-      unsigned number_of_elements_advertised_to_peer_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
-      inventory_advertised_to_peer.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
+      size_t number_of_elements_advertised_to_peer_to_discard = inventory_advertised_to_peer.expire(oldest_inventory_to_keep);
 
       // also expire items from inventory_peer_advertised_to_us
-      oldest_inventory_to_keep_iter = inventory_peer_advertised_to_us.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
-      begin_iter = inventory_peer_advertised_to_us.get<timestamp_index>().begin();
-      unsigned number_of_elements_peer_advertised_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
-      inventory_peer_advertised_to_us.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
+      size_t number_of_elements_peer_advertised_to_discard = inventory_peer_advertised_to_us.expire(oldest_inventory_to_keep);
       dlog("Expiring old inventory for peer ${peer}: removing ${to_peer} items advertised to peer (${remain_to_peer} left), and ${to_us} advertised to us (${remain_to_us} left)",
            ("peer", get_remote_endpoint())
            ("to_peer", number_of_elements_advertised_to_peer_to_discard)("remain_to_peer", inventory_advertised_to_peer.size())
@@ -526,4 +528,93 @@ namespace graphene { namespace net
       return fc::optional<fc::ip::endpoint>();
     }
 
+    std::vector<item_hash_t> peer_connection::expire_compact_blocks_awaiting_transactions(fc::time_point requested_before)
+    {
+      VERIFY_CORRECT_THREAD();
+      std::vector<item_hash_t> expired_block_message_hashes;
+      for (auto iter = compact_blocks_awaiting_transactions.begin(); iter != compact_blocks_awaiting_transactions.end();)
+      {
+        if (iter->second.transactions_requested_time < requested_before)
+        {
+          expired_block_message_hashes.push_back(iter->second.block_message_hash);
+          iter = compact_blocks_awaiting_transactions.erase(iter);
+        }
+        else
+          ++iter;
+      }
+      return expired_block_message_hashes;
+    }
+
+    peer_connection::partial_compact_block::partial_compact_block(const compact_block_message& compact_block) :
+      block_message_hash(compact_block.block_message_hash),
+      short_transaction_ids(compact_block.short_transaction_ids)
+    {
+      static_cast<signed_block_header&>(block) = compact_block.header;
+      block.transactions.resize(short_transaction_ids.size());
+    }
+
+    std::vector<uint32_t> peer_connection::partial_compact_block::get_missing_transaction_indices() const
+    {
+      std::vector<uint32_t> missing_transaction_indices;
+      for (uint32_t i = 0; i < block.transactions.size(); ++i)
+        if (block.transactions[i].operations.empty())
+          missing_transaction_indices.push_back(i);
+      return missing_transaction_indices;
+    }
+
+    std::unordered_set<uint64_t> peer_connection::partial_compact_block::get_missing_short_ids() const
+    {
+      std::unordered_set<uint64_t> missing_short_ids;
+      for (uint32_t index : get_missing_transaction_indices())
+        missing_short_ids.insert(short_transaction_ids[index]);
+      return missing_short_ids;
+    }
+
+    void peer_connection::partial_compact_block::add_transactions(const std::function<fc::optional<signed_transaction>(uint64_t)>& find_transaction)
+    {
+      for (uint32_t index : get_missing_transaction_indices())
+      {
+        fc::optional<signed_transaction> trx = find_transaction(short_transaction_ids[index]);
+        if (trx)
+          block.transactions[index] = std::move(*trx);
+      }
+    }
+
+    void peer_connection::partial_compact_block::add_transactions(std::vector<signed_transaction> transactions)
+    {
+      std::unordered_multimap<uint64_t, uint32_t> missing_transactions; // short id -> index in the block
+      for (uint32_t index : get_missing_transaction_indices())
+        missing_transactions.insert(std::make_pair(short_transaction_ids[index], index));
+
+      for (signed_transaction& trx : transactions)
+      {
+        auto iter = missing_transactions.find(compact_block_message::short_transaction_id(trx.id()));
+        if (iter != missing_transactions.end())
+        {
+          block.transactions[iter->second] = std::move(trx);
+          missing_transactions.erase(iter);
+        }
+      }
+    }
+
+    bool peer_connection::partial_compact_block::add_missing_transactions(const std::vector<signed_transaction>& transactions)
+    {
+      std::vector<uint32_t> missing_transaction_indices = get_missing_transaction_indices();
+      if (transactions.size() != missing_transaction_indices.size())
+        return false;
+      for (uint32_t i = 0; i < transactions.size(); ++i)
+        block.transactions[missing_transaction_indices[i]] = transactions[i];
+      return true;
+    }
+
+    fc::optional<message> peer_connection::partial_compact_block::get_block_message() const
+    {
+      if (block.calculate_merkle_root() != block.transaction_merkle_root)
+        return fc::optional<message>();
+      message block_message_to_process = graphene::net::block_message(block);
+      if (block_message_to_process.id() != block_message_hash)
+        return fc::optional<message>();
+      return block_message_to_process;
+    }
+
 } } // end namespace graphene::net
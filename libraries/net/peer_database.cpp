@@ -36,35 +36,104 @@
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/config.hpp>
 
+#include <fstream>
+#include <unordered_map>
+
 namespace graphene { namespace net {
   namespace detail
   {
     using namespace boost::multi_index;
 
+    /** one line of the journal, a record that was added or changed or the endpoint of one that was erased */
+    struct peer_database_journal_entry
+    {
+      potential_peer_record record;
+      bool                  erased = false;
+    };
+  }
+} } // end namespace graphene::net
+
+FC_REFLECT(graphene::net::detail::peer_database_journal_entry, (record)(erased))
+
+namespace graphene { namespace net {
+
+  int64_t potential_peer_record::score() const
+  {
+    // never tried is worth 500, each success or failure pulls it towards 1000 or 0
+    int64_t result = int64_t(1000) * (uint64_t(number_of_successful_connection_attempts) + 1) /
+                     (uint64_t(number_of_successful_connection_attempts) + number_of_failed_connection_attempts + 2);
+    // 500 at a round trip of 100ms
+    if (round_trip_delay.count() > 0)
+      result += int64_t(1000) * 100000 / (round_trip_delay.count() + 100000);
+    // 500 at 1 MiB/s
+    result += int64_t(1000 * bytes_per_second / (bytes_per_second + 1024 * 1024));
+    // a rejected block or a timed out request outweighs many delivered blocks
+    uint64_t weighted_block_requests = uint64_t(blocks_delivered) + 10 * (uint64_t(blocks_rejected) + requests_timed_out);
+    if (weighted_block_requests)
+      result += int64_t(1000 * uint64_t(blocks_delivered) / weighted_block_requests);
+    return result;
+  }
+
+  void potential_peer_record::record_connection_statistics(fc::microseconds measured_round_trip_delay, uint64_t measured_bytes_per_second,
+                                                           uint32_t new_blocks_delivered, uint32_t new_blocks_rejected,
+                                                           uint32_t new_requests_timed_out)
+  {
+    // moving averages, each measurement counts for a quarter
+    if (measured_round_trip_delay.count() > 0)
+      round_trip_delay = round_trip_delay.count() > 0 ? fc::microseconds((3 * round_trip_delay.count() + measured_round_trip_delay.count()) / 4)
+                                                      : measured_round_trip_delay;
+    bytes_per_second = bytes_per_second ? (3 * bytes_per_second + measured_bytes_per_second) / 4 : measured_bytes_per_second;
+
+    blocks_delivered += new_blocks_delivered;
+    blocks_rejected += new_blocks_rejected;
+    requests_timed_out += new_requests_timed_out;
+    // halve the counters now and then so that what the peer did recently matters most
+    if (blocks_delivered > 100000)
+    {
+      blocks_delivered /= 2;
+      blocks_rejected /= 2;
+      requests_timed_out /= 2;
+    }
+  }
+
+  namespace detail
+  {
     class peer_database_impl
     {
     public:
-      struct last_seen_time_index {};
+      struct score_index {};
       struct endpoint_index {};
-      typedef boost::multi_index_container<potential_peer_record, 
-                                           indexed_by<ordered_non_unique<tag<last_seen_time_index>, 
-                                                                         member<potential_peer_record, 
-                                                                                fc::time_point_sec, 
-                                                                                &potential_peer_record::last_seen_time> >,
-                                                      hashed_unique<tag<endpoint_index>, 
-                                                                    member<potential_peer_record, 
-                                                                           fc::ip::endpoint, 
-                                                                           &potential_peer_record::endpoint>, 
+      typedef boost::multi_index_container<potential_peer_record,
+                                           indexed_by<ordered_non_unique<tag<score_index>,
+                                                                         const_mem_fun<potential_peer_record,
+                                                                                       int64_t,
+                                                                                       &potential_peer_record::score>,
+                                                                         std::greater<int64_t> >,
+                                                      hashed_unique<tag<endpoint_index>,
+                                                                    member<potential_peer_record,
+                                                                           fc::ip::endpoint,
+                                                                           &potential_peer_record::endpoint>,
                                                                     std::hash<fc::ip::endpoint> > > > potential_peer_set;
 
     private:
       potential_peer_set     _potential_peer_set;
       fc::path _peer_database_filename;
+      fc::path _journal_filename;
+      std::ofstream _journal;
+      size_t _journal_entries = 0;
+      /// the last change to each peer since the journal was flushed, a peer changed many times is written once
+      std::unordered_map<fc::ip::endpoint, peer_database_journal_entry> _unwritten_journal_entries;
+      bool _is_open = false;
+
+      void append_to_journal(const peer_database_journal_entry& entry);
+      void apply_journal_entry(const peer_database_journal_entry& entry);
+      void compact();
 
     public:
       void open(const fc::path& databaseFilename);
       void close();
       void clear();
+      void flush();
       void erase(const fc::ip::endpoint& endpointToErase);
       void update_entry(const potential_peer_record& updatedRecord);
       potential_peer_record lookup_or_create_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup);
@@ -78,9 +147,9 @@ namespace graphene { namespace net {
     class peer_database_iterator_impl
     {
     public:
-      typedef peer_database_impl::potential_peer_set::index<peer_database_impl::last_seen_time_index>::type::iterator last_seen_time_index_iterator;
-      last_seen_time_index_iterator _iterator;
-      peer_database_iterator_impl(const last_seen_time_index_iterator& iterator) :
+      typedef peer_database_impl::potential_peer_set::index<peer_database_impl::score_index>::type::iterator score_index_iterator;
+      score_index_iterator _iterator;
+      peer_database_iterator_impl(const score_index_iterator& iterator) :
         _iterator(iterator)
       {}
     };
@@ -90,20 +159,13 @@ namespace graphene { namespace net {
     void peer_database_impl::open(const fc::path& peer_database_filename)
     {
       _peer_database_filename = peer_database_filename;
+      _journal_filename = fc::path(_peer_database_filename.generic_string() + ".journal");
       if (fc::exists(_peer_database_filename))
       {
         try
         {
           std::vector<potential_peer_record> peer_records = fc::json::from_file(_peer_database_filename).as<std::vector<potential_peer_record> >();
           std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
-
-          if (_potential_peer_set.size() > GRAPHENE_NET_MAX_PEERDB_SIZE)
-          {
-            // prune database to a reasonable size
-            auto iter = _potential_peer_set.begin();
-            std::advance(iter, GRAPHENE_NET_MAX_PEERDB_SIZE);
-            _potential_peer_set.erase(iter, _potential_peer_set.end());
-          }
         }
         catch (const fc::exception& e)
         {
@@ -111,25 +173,40 @@ namespace graphene { namespace net {
                ("peer_database_filename", _peer_database_filename));
         }
       }
+
+      // replay the changes made since the file was last written, a crash may have cut the last line short
+      if (fc::exists(_journal_filename))
+      {
+        std::ifstream journal(_journal_filename.generic_string());
+        std::string line;
+        uint32_t replayed_entries = 0;
+        while (std::getline(journal, line))
+        {
+          try
+          {
+            apply_journal_entry(fc::json::from_string(line).as<peer_database_journal_entry>());
+            ++replayed_entries;
+          }
+          catch (const fc::exception& e)
+          {
+            wlog("ignoring the rest of peer database journal ${journal} after ${count} entries",
+                 ("journal", _journal_filename)("count", replayed_entries));
+            break;
+          }
+        }
+      }
+
+      _is_open = true;
+      compact();
     }
 
     void peer_database_impl::close()
     {
-      std::vector<potential_peer_record> peer_records;
-      peer_records.reserve(_potential_peer_set.size());
-      std::copy(_potential_peer_set.begin(), _potential_peer_set.end(), std::back_inserter(peer_records));
-
-      try
+      if (_is_open)
       {
-        fc::path peer_database_filename_dir = _peer_database_filename.parent_path();
-        if (!fc::exists(peer_database_filename_dir))
-          fc::create_directories(peer_database_filename_dir);
-        fc::json::save_to_file(peer_records, _peer_database_filename);
-      }
-      catch (const fc::exception& e)
-      {
-        elog("error saving peer database to file ${peer_database_filename}", 
-             ("peer_database_filename", _peer_database_filename));
+        compact();
+        _journal.close();
+        _is_open = false;
       }
       _potential_peer_set.clear();
     }
@@ -137,22 +214,104 @@ namespace graphene { namespace net {
     void peer_database_impl::clear()
     {
       _potential_peer_set.clear();
+      if (_is_open)
+        compact();
     }
 
     void peer_database_impl::erase(const fc::ip::endpoint& endpointToErase)
     {
       auto iter = _potential_peer_set.get<endpoint_index>().find(endpointToErase);
       if (iter != _potential_peer_set.get<endpoint_index>().end())
+      {
         _potential_peer_set.get<endpoint_index>().erase(iter);
+
+        peer_database_journal_entry entry;
+        entry.record.endpoint = endpointToErase;
+        entry.erased = true;
+        append_to_journal(entry);
+      }
     }
 
     void peer_database_impl::update_entry(const potential_peer_record& updatedRecord)
     {
-      auto iter = _potential_peer_set.get<endpoint_index>().find(updatedRecord.endpoint);
-      if (iter != _potential_peer_set.get<endpoint_index>().end())
-        _potential_peer_set.get<endpoint_index>().modify(iter, [&updatedRecord](potential_peer_record& record) { record = updatedRecord; });
+      peer_database_journal_entry entry;
+      entry.record = updatedRecord;
+      apply_journal_entry(entry);
+      append_to_journal(entry);
+    }
+
+    void peer_database_impl::apply_journal_entry(const peer_database_journal_entry& entry)
+    {
+      auto& index = _potential_peer_set.get<endpoint_index>();
+      auto iter = index.find(entry.record.endpoint);
+      if (entry.erased)
+      {
+        if (iter != index.end())
+          index.erase(iter);
+      }
+      else if (iter != index.end())
+        index.modify(iter, [&entry](potential_peer_record& record) { record = entry.record; });
       else
-        _potential_peer_set.get<endpoint_index>().insert(updatedRecord);
+        index.insert(entry.record);
+    }
+
+    void peer_database_impl::append_to_journal(const peer_database_journal_entry& entry)
+    {
+      if (_journal.is_open())
+        _unwritten_journal_entries[entry.record.endpoint] = entry;
+    }
+
+    void peer_database_impl::flush()
+    {
+      if (_unwritten_journal_entries.empty() || !_journal.is_open())
+        return;
+
+      for (const auto& endpoint_and_entry : _unwritten_journal_entries)
+        _journal << fc::json::to_string(endpoint_and_entry.second) << '\n';
+      _journal.flush();
+      _journal_entries += _unwritten_journal_entries.size();
+      _unwritten_journal_entries.clear();
+
+      if (_journal_entries > std::max<size_t>(GRAPHENE_NET_MAX_PEERDB_SIZE, _potential_peer_set.size()) * GRAPHENE_NET_PEERDB_JOURNAL_ENTRIES_PER_PEER)
+        compact();
+    }
+
+    void peer_database_impl::compact()
+    {
+      if (_potential_peer_set.size() > GRAPHENE_NET_MAX_PEERDB_SIZE)
+      {
+        // prune database to a reasonable size, dropping the worst peers
+        auto iter = _potential_peer_set.get<score_index>().begin();
+        std::advance(iter, GRAPHENE_NET_MAX_PEERDB_SIZE);
+        _potential_peer_set.get<score_index>().erase(iter, _potential_peer_set.get<score_index>().end());
+      }
+
+      std::vector<potential_peer_record> peer_records;
+      peer_records.reserve(_potential_peer_set.size());
+      std::copy(_potential_peer_set.begin(), _potential_peer_set.end(), std::back_inserter(peer_records));
+
+      _journal.close();
+      try
+      {
+        fc::path peer_database_filename_dir = _peer_database_filename.parent_path();
+        if (!fc::exists(peer_database_filename_dir))
+          fc::create_directories(peer_database_filename_dir);
+        // write the new file beside the old one, the journal is only dropped once the new file is complete
+        fc::path temporary_filename(_peer_database_filename.generic_string() + ".tmp");
+        fc::json::save_to_file(peer_records, temporary_filename);
+        fc::rename(temporary_filename, _peer_database_filename);
+        _journal.open(_journal_filename.generic_string(), std::ios::out | std::ios::trunc);
+        _journal_entries = 0;
+        _unwritten_journal_entries.clear();
+      }
+      catch (const fc::exception& e)
+      {
+        elog("error saving peer database to file ${peer_database_filename}", 
+             ("peer_database_filename", _peer_database_filename));
+        _journal.open(_journal_filename.generic_string(), std::ios::out | std::ios::app);
+      }
+      if (!_journal)
+        elog("unable to open peer database journal ${journal}, changes will only be saved on close", ("journal", _journal_filename));
     }
 
     potential_peer_record peer_database_impl::lookup_or_create_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup)
@@ -173,12 +332,12 @@ namespace graphene { namespace net {
 
     peer_database::iterator peer_database_impl::begin() const
     {
-      return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<last_seen_time_index>().begin()));
+      return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<score_index>().begin()));
     }
 
     peer_database::iterator peer_database_impl::end() const
     {
-      return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<last_seen_time_index>().end()));
+      return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<score_index>().end()));
     }
 
     size_t peer_database_impl::size() const
@@ -239,6 +398,11 @@ namespace graphene { namespace net {
     my->clear();
   }
 
+  void peer_database::flush()
+  {
+    my->flush();
+  }
+
   void peer_database::erase(const fc::ip::endpoint& endpointToErase)
   {
     my->erase(endpointToErase);
@@ -28,14 +28,61 @@
 #include <fc/crypto/hex.hpp>
 #include <fc/crypto/aes.hpp>
 #include <fc/crypto/city.hpp>
+#include <fc/crypto/openssl.hpp>
 #include <fc/log/logger.hpp>
 #include <fc/network/ip.hpp>
 #include <fc/exception/exception.hpp>
 
 #include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/config.hpp>
+#include <graphene/net/message.hpp>
+
+#include <openssl/evp.h>
 
 namespace graphene { namespace net {
 
+namespace {
+
+  /** the largest message with its header, padded to 16 bytes, bounds the memory a peer can make us allocate */
+  const size_t max_authenticated_frame_size = MAX_MESSAGE_SIZE + 16;
+  static_assert( sizeof(message_header) <= 16, "frames have no room for the message header" );
+  const size_t authentication_tag_size = stcp_socket::frame_suffix_size;
+
+  const EVP_CIPHER* get_evp_cipher( const std::string& cipher )
+  {
+    if( cipher == "aes-256-gcm" )
+      return EVP_aes_256_gcm();
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L && !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
+    if( cipher == "chacha20-poly1305" )
+      return EVP_chacha20_poly1305();
+#endif
+    return nullptr;
+  }
+
+  /** 96 bit nonce, four zero bytes followed by the little endian frame counter */
+  void make_nonce( uint64_t counter, unsigned char* nonce )
+  {
+    memset( nonce, 0, 4 );
+    for( int i = 0; i < 8; ++i )
+      nonce[4 + i] = (unsigned char)( counter >> ( 8 * i ) );
+  }
+
+  void put_frame_length( uint32_t len, unsigned char* out )
+  {
+    for( int i = 0; i < 4; ++i )
+      out[i] = (unsigned char)( len >> ( 8 * i ) );
+  }
+
+  uint32_t get_frame_length( const unsigned char* in )
+  {
+    return uint32_t(in[0]) | uint32_t(in[1]) << 8 | uint32_t(in[2]) << 16 | uint32_t(in[3]) << 24;
+  }
+
+} // anonymous namespace
+
+const size_t stcp_socket::frame_prefix_size;
+const size_t stcp_socket::frame_suffix_size;
+
 stcp_socket::stcp_socket()
 //:_buf_len(0)
 #ifndef NDEBUG
@@ -66,12 +113,80 @@ void stcp_socket::do_key_exchange()
                   fc::city_hash_crc_128((char*)&_shared_secret,sizeof(_shared_secret) ) );
   _recv_aes.init( fc::sha256::hash( (char*)&_shared_secret, sizeof(_shared_secret) ), 
                   fc::city_hash_crc_128((char*)&_shared_secret,sizeof(_shared_secret) ) );
+
+  _send_cipher_name.clear();
+  _recv_cipher_name.clear();
+  _send_aead.reset();
+  _recv_aead.reset();
+  _read_buffer.clear();
+  _read_buffer_position = 0;
+}
+
+std::vector<std::string> stcp_socket::get_authenticated_ciphers()
+{
+  // AES-GCM first, it is the faster of the two on anything with AES-NI
+  std::vector<std::string> result;
+  for( const char* cipher : { "aes-256-gcm", "chacha20-poly1305" } )
+    if( get_evp_cipher( cipher ) )
+      result.push_back( cipher );
+  return result;
 }
 
+bool stcp_socket::is_authenticated_cipher_supported( const std::string& cipher )
+{
+  return get_evp_cipher( cipher ) != nullptr;
+}
+
+/**
+ *  Each direction gets its own key so that the two counter nonce sequences never
+ *  encrypt under the same key and nonce.
+ */
+void stcp_socket::init_aead( const std::string& cipher, bool sending )
+{
+  const EVP_CIPHER* evp_cipher = get_evp_cipher( cipher );
+  FC_ASSERT( evp_cipher, "unsupported transport cipher ${c}", ("c", cipher) );
+
+  const std::string direction = sending == _is_initiator ? "initiator" : "acceptor";
+  fc::sha256::encoder enc;
+  enc.write( (char*)&_shared_secret, sizeof(_shared_secret) );
+  enc.write( direction.data(), direction.size() );
+  fc::sha256 key = enc.result();
+
+  std::shared_ptr<EVP_CIPHER_CTX> ctx( EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free );
+  FC_ASSERT( ctx, "unable to allocate cipher context" );
+  int result = sending ? EVP_EncryptInit_ex( ctx.get(), evp_cipher, nullptr, (const unsigned char*)key.data(), nullptr )
+                       : EVP_DecryptInit_ex( ctx.get(), evp_cipher, nullptr, (const unsigned char*)key.data(), nullptr );
+  FC_ASSERT( result == 1, "unable to initialize transport cipher ${c}", ("c", cipher) );
+
+  if( sending )
+  {
+    _send_aead = ctx;
+    _send_nonce = 0;
+    _send_cipher_name = cipher;
+  }
+  else
+  {
+    _recv_aead = ctx;
+    _recv_nonce = 0;
+    _recv_cipher_name = cipher;
+  }
+}
+
+void stcp_socket::set_send_cipher( const std::string& cipher )
+{
+  init_aead( cipher, true );
+}
+
+void stcp_socket::set_receive_cipher( const std::string& cipher )
+{
+  FC_ASSERT( _read_buffer_position == _read_buffer.size(), "cannot switch the receive cipher with unread data buffered" );
+  init_aead( cipher, false );
+}
 
 void stcp_socket::connect_to( const fc::ip::endpoint& remote_endpoint )
 {
   _sock.connect_to( remote_endpoint );
+  _is_initiator = true;
   do_key_exchange();
 }
 
@@ -81,14 +196,16 @@ void stcp_socket::bind( const fc::ip::endpoint& local_endpoint )
 }
 
 /**
- *   This method must read at least 16 bytes at a time from
- *   the underlying TCP socket so that it can decrypt them. It
- *   will buffer any left-over.
+ *  With the legacy cipher this reads straight into buffer and decrypts in place.  It
+ *  must read at least 16 bytes at a time from the underlying TCP socket so that it
+ *  can decrypt them, so len must be a multiple of 16.
+ *
+ *  With an authenticated cipher it returns data of one frame at a time.  A frame that
+ *  fits into buffer is decrypted there, a larger one is buffered and handed out by the
+ *  following calls.
  */
 size_t stcp_socket::readsome( char* buffer, size_t len )
 { try {
-    assert( len > 0 && (len % 16) == 0 );
-
 #ifndef NDEBUG
     // This code was written with the assumption that you'd only be making one call to readsome 
     // at a time so it reuses _read_buffer.  If you really need to make concurrent calls to 
@@ -100,22 +217,77 @@ size_t stcp_socket::readsome( char* buffer, size_t len )
     } buffer_in_use_checker(_read_buffer_in_use);
 #endif
 
-    const size_t read_buffer_length = 4096;
-    if (!_read_buffer)
-      _read_buffer.reset(new char[read_buffer_length], [](char* p){ delete[] p; });
+    if( _recv_aead )
+      return read_aead_frame( buffer, len );
 
-    len = std::min<size_t>(read_buffer_length, len);
+    assert( len > 0 && (len % 16) == 0 );
 
-    size_t s = _sock.readsome( _read_buffer, len, 0 );
+    size_t s = _sock.readsome( buffer, len );
     if( s % 16 ) 
     {
-      _sock.read(_read_buffer, 16 - (s%16), s);
+      _sock.read(buffer + s, 16 - (s%16));
       s += 16-(s%16);
     }
-    _recv_aes.decode( _read_buffer.get(), s, buffer );
+    _recv_aes.decode( buffer, s, buffer );
     return s;
 } FC_RETHROW_EXCEPTIONS( warn, "", ("len",len) ) }
 
+size_t stcp_socket::read_aead_frame( char* buffer, size_t len )
+{
+  assert( len > 0 );
+
+  if( _read_buffer_position < _read_buffer.size() )
+  {
+    size_t bytes_to_copy = std::min( len, _read_buffer.size() - _read_buffer_position );
+    memcpy( buffer, _read_buffer.data() + _read_buffer_position, bytes_to_copy );
+    _read_buffer_position += bytes_to_copy;
+    return bytes_to_copy;
+  }
+
+  unsigned char frame_length[frame_prefix_size];
+  _sock.read( (char*)frame_length, frame_prefix_size );
+  uint32_t payload_len = get_frame_length( frame_length );
+  FC_ASSERT( payload_len > 0 && payload_len <= max_authenticated_frame_size,
+             "invalid frame length ${l}", ("l", payload_len) );
+
+  const bool decrypt_in_place = payload_len <= len;
+  char* payload = buffer;
+  if( !decrypt_in_place )
+  {
+    _read_buffer.resize( payload_len );
+    _read_buffer_position = 0;
+    payload = _read_buffer.data();
+  }
+
+  unsigned char tag[authentication_tag_size];
+  _sock.read( payload, payload_len );
+  _sock.read( (char*)tag, authentication_tag_size );
+
+  unsigned char nonce[12];
+  make_nonce( _recv_nonce++, nonce );
+  EVP_CIPHER_CTX* ctx = _recv_aead.get();
+  int out_len = 0;
+  bool authenticated =
+    EVP_DecryptInit_ex( ctx, nullptr, nullptr, nullptr, nonce ) == 1 &&
+    EVP_DecryptUpdate( ctx, nullptr, &out_len, frame_length, frame_prefix_size ) == 1 &&
+    EVP_DecryptUpdate( ctx, (unsigned char*)payload, &out_len, (const unsigned char*)payload, payload_len ) == 1 &&
+    EVP_CIPHER_CTX_ctrl( ctx, EVP_CTRL_GCM_SET_TAG, authentication_tag_size, tag ) == 1 &&
+    EVP_DecryptFinal_ex( ctx, (unsigned char*)payload + out_len, &out_len ) == 1;
+  if( !authenticated )
+  {
+    _read_buffer.clear();
+    _read_buffer_position = 0;
+    FC_THROW( "frame failed authentication" );
+  }
+
+  if( decrypt_in_place )
+    return payload_len;
+
+  _read_buffer_position = len;
+  memcpy( buffer, payload, len );
+  return len;
+}
+
 size_t stcp_socket::readsome( const std::shared_ptr<char>& buf, size_t len, size_t offset ) 
 {
   return readsome(buf.get() + offset, len);
@@ -126,9 +298,45 @@ bool stcp_socket::eof()const
   return _sock.eof();
 }
 
+void stcp_socket::write_frame( char* buffer, size_t len )
+{ try {
+    char* payload = buffer + frame_prefix_size;
+
+    if( !_send_aead )
+    {
+      assert( (len % 16) == 0 );
+      _send_aes.encode( payload, len, payload );
+      _sock.write( payload, len );
+      return;
+    }
+
+    FC_ASSERT( len > 0 && len <= max_authenticated_frame_size, "invalid frame length ${l}", ("l", len) );
+
+    unsigned char* frame_length = (unsigned char*)buffer;
+    put_frame_length( len, frame_length );
+
+    unsigned char nonce[12];
+    make_nonce( _send_nonce++, nonce );
+    EVP_CIPHER_CTX* ctx = _send_aead.get();
+    int out_len = 0;
+    bool encrypted =
+      EVP_EncryptInit_ex( ctx, nullptr, nullptr, nullptr, nonce ) == 1 &&
+      EVP_EncryptUpdate( ctx, nullptr, &out_len, frame_length, frame_prefix_size ) == 1 &&
+      EVP_EncryptUpdate( ctx, (unsigned char*)payload, &out_len, (const unsigned char*)payload, len ) == 1 &&
+      EVP_EncryptFinal_ex( ctx, (unsigned char*)payload + out_len, &out_len ) == 1 &&
+      EVP_CIPHER_CTX_ctrl( ctx, EVP_CTRL_GCM_GET_TAG, authentication_tag_size, payload + len ) == 1;
+    FC_ASSERT( encrypted, "unable to encrypt frame" );
+
+    _sock.write( buffer, frame_prefix_size + len + frame_suffix_size );
+} FC_RETHROW_EXCEPTIONS( warn, "", ("len",len) ) }
+
+/**
+ *  Copies the data once into _write_buffer and encrypts it there.  Callers that own
+ *  a writable buffer should use write_frame() instead.
+ */
 size_t stcp_socket::writesome( const char* buffer, size_t len )
 { try {
-    assert( len > 0 && (len % 16) == 0 );
+    assert( len > 0 && (_send_aead || (len % 16) == 0) );
 
 #ifndef NDEBUG
     // This code was written with the assumption that you'd only be making one call to writesome
@@ -141,21 +349,12 @@ size_t stcp_socket::writesome( const char* buffer, size_t len )
     } buffer_in_use_checker(_write_buffer_in_use);
 #endif
 
-    const std::size_t write_buffer_length = 4096;
-    if (!_write_buffer)
-      _write_buffer.reset(new char[write_buffer_length], [](char* p){ delete[] p; });
-    len = std::min<size_t>(write_buffer_length, len);
-    memset(_write_buffer.get(), 0, len); // just in case aes.encode screws up
-    /**
-     * every sizeof(crypt_buf) bytes the aes channel
-     * has an error and doesn't decrypt properly...  disable
-     * for now because we are going to upgrade to something
-     * better.
-     */
-    uint32_t ciphertext_len = _send_aes.encode( buffer, len, _write_buffer.get() );
-    assert(ciphertext_len == len);
-    _sock.write( _write_buffer, ciphertext_len );
-    return ciphertext_len;
+    if( _send_aead )
+      len = std::min( len, max_authenticated_frame_size );
+    _write_buffer.resize( frame_prefix_size + len + frame_suffix_size );
+    memcpy( _write_buffer.data() + frame_prefix_size, buffer, len );
+    write_frame( _write_buffer.data(), len );
+    return len;
 } FC_RETHROW_EXCEPTIONS( warn, "", ("len",len) ) }
 
 size_t stcp_socket::writesome( const std::shared_ptr<const char>& buf, size_t len, size_t offset )
@@ -179,9 +378,9 @@ void stcp_socket::close()
 
 void stcp_socket::accept()
 {
+  _is_initiator = false;
   do_key_exchange();
 }
 
 
 }} // namespace graphene::net
-
@@ -0,0 +1,50 @@
+#include <graphene/net/timestamped_item_set.hpp>
+
+namespace graphene { namespace net {
+
+  bool timestamped_item_set::insert(const timestamped_item_id& item)
+  {
+    auto result = _items.insert(map_type::value_type(item.item, item.timestamp));
+    if (!result.second)
+      return false;
+
+    // the clock only moves forward in practice, anything older joins the newest bucket
+    if (_buckets.empty() || _buckets.back().timestamp < item.timestamp)
+      _buckets.push_back(bucket{item.timestamp, std::vector<item_id>()});
+    else
+      result.first->second = _buckets.back().timestamp;
+
+    _buckets.back().items.push_back(item.item);
+    return true;
+  }
+
+  size_t timestamped_item_set::expire(fc::time_point_sec oldest_to_keep)
+  {
+    size_t number_removed = 0;
+    while (!_buckets.empty() && _buckets.front().timestamp < oldest_to_keep)
+    {
+      const bucket& oldest_bucket = _buckets.front();
+      for (const item_id& item : oldest_bucket.items)
+      {
+        auto iter = _items.find(item);
+        if (iter != _items.end() && iter->second == oldest_bucket.timestamp)
+        {
+          _items.erase(iter);
+          ++number_removed;
+        }
+      }
+      _buckets.pop_front();
+    }
+
+    if (number_removed)
+      _items.shrink_to_fit();
+    return number_removed;
+  }
+
+  void timestamped_item_set::clear()
+  {
+    _items.clear();
+    _buckets.clear();
+  }
+
+} } // graphene::net
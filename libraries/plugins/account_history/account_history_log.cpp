@@ -0,0 +1,667 @@
+#include <steem/plugins/account_history/account_history_log.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace steem { namespace plugins { namespace account_history {
+
+namespace bfs = boost::filesystem;
+namespace bip = boost::interprocess;
+
+namespace detail {
+
+static const uint64_t npos = std::numeric_limits< uint64_t >::max();
+static const uint64_t INITIAL_INDEX_SIZE = 1024 * 1024;
+static const uint64_t INITIAL_TRX_SLOTS = 1 << 16;
+
+/**
+ * A file mapped in its entirety. Growing the file remaps it, so pointers into the
+ * mapping are only valid until the next call to reserve.
+ */
+class mapped_file
+{
+   public:
+      void open( const bfs::path& p, uint64_t min_size )
+      {
+         _path = p;
+
+         if( !bfs::exists( _path ) )
+            std::ofstream( _path.generic_string().c_str(), std::ios::out | std::ios::binary );
+
+         if( bfs::file_size( _path ) < min_size )
+            bfs::resize_file( _path, min_size );
+
+         map();
+      }
+
+      void close()
+      {
+         if( is_open() )
+            _region.flush();
+
+         bip::mapped_region().swap( _region );
+         bip::file_mapping().swap( _mapping );
+      }
+
+      bool is_open()const { return _region.get_address() != nullptr; }
+
+      char* data()const { return (char*)_region.get_address(); }
+      uint64_t size()const { return _region.get_size(); }
+
+      void reserve( uint64_t required )
+      {
+         if( required <= size() )
+            return;
+
+         uint64_t new_size = std::max< uint64_t >( size(), INITIAL_INDEX_SIZE );
+         while( new_size < required )
+            new_size *= 2;
+
+         _region.flush();
+         bip::mapped_region().swap( _region );
+         bip::file_mapping().swap( _mapping );
+         bfs::resize_file( _path, new_size );
+         map();
+      }
+
+      void flush()
+      {
+         if( is_open() )
+            _region.flush();
+      }
+
+   private:
+      void map()
+      {
+         bip::file_mapping mapping( _path.generic_string().c_str(), bip::read_write );
+         bip::mapped_region region( mapping, bip::read_write );
+         _mapping.swap( mapping );
+         _region.swap( region );
+      }
+
+      bfs::path            _path;
+      bip::file_mapping    _mapping;
+      bip::mapped_region   _region;
+};
+
+struct log_header
+{
+   uint64_t block_count = 0;
+   uint64_t segment_size = 0;
+};
+
+struct block_entry
+{
+   uint64_t op_end = 0;
+   uint64_t account_entry_end = 0;
+};
+
+struct account_entry
+{
+   account_name_type account;
+   uint32_t          sequence = 0;
+   uint32_t          reserved = 0;
+   uint64_t          op_id = npos;
+   uint64_t          prev = npos;
+   uint64_t          skip = npos;
+};
+
+struct account_head
+{
+   uint64_t entry = npos;
+   uint32_t sequence = 0;
+};
+
+struct trx_table_header
+{
+   uint64_t capacity = 0;
+   uint64_t used = 0;
+};
+
+struct trx_slot
+{
+   uint64_t key = 0;
+   uint64_t op_id = 0; ///< op_id + 1, zero marks an empty slot
+};
+
+struct account_head_record
+{
+   account_name_type account;
+   uint32_t          sequence = 0;
+   uint32_t          reserved = 0;
+   uint64_t          entry = npos;
+};
+
+/*
+ * Skip pointer heights as used by bitcoin's CBlockIndex::pskip. Following the skip pointer
+ * from any height reaches any lower height in O(log n) steps.
+ */
+static inline uint32_t invert_lowest_one( uint32_t n ) { return n & ( n - 1 ); }
+
+static inline uint32_t get_skip_height( uint32_t height )
+{
+   if( height < 2 )
+      return 0;
+
+   return ( height & 1 ) ? invert_lowest_one( invert_lowest_one( height - 1 ) ) + 1 : invert_lowest_one( height );
+}
+
+static inline uint64_t trx_key( const transaction_id_type& id )
+{
+   uint64_t key;
+   memcpy( (char*)&key, (const char*)id._hash, sizeof( key ) );
+   return key;
+}
+
+class account_history_log_impl
+{
+   public:
+      const log_header& header()const { return *(const log_header*)_blocks.data(); }
+      log_header& header() { return *(log_header*)_blocks.data(); }
+
+      const block_entry* blocks()const { return (const block_entry*)( _blocks.data() + sizeof( log_header ) ); }
+      block_entry* blocks() { return (block_entry*)( _blocks.data() + sizeof( log_header ) ); }
+
+      const uint64_t* op_positions()const { return (const uint64_t*)_ops.data(); }
+      uint64_t* op_positions() { return (uint64_t*)_ops.data(); }
+
+      const account_entry* account_entries()const { return (const account_entry*)_accounts.data(); }
+      account_entry* account_entries() { return (account_entry*)_accounts.data(); }
+
+      const trx_table_header& trx_header()const { return *(const trx_table_header*)_trx.data(); }
+      const trx_slot* trx_slots()const { return (const trx_slot*)( _trx.data() + sizeof( trx_table_header ) ); }
+
+      bfs::path segment_path( uint64_t segment )const
+      {
+         return _dir / ( "ops." + std::to_string( segment ) + ".log" );
+      }
+
+      /**
+       * Opens the segments up to and including segment.  Only called while opening or appending, under
+       * the write lock, so that readers never see _segments change.
+       */
+      mapped_file& open_segment( uint64_t segment )
+      {
+         while( _segments.size() <= segment )
+         {
+            _segments.emplace_back( new mapped_file() );
+            _segments.back()->open( segment_path( _segments.size() - 1 ), _segment_size );
+         }
+
+         return *_segments[ segment ];
+      }
+
+      const mapped_file& segment( uint64_t segment )const
+      {
+         FC_ASSERT( segment < _segments.size(), "Account history log segment ${s} is not open", ("s", segment) );
+         return *_segments[ segment ];
+      }
+
+      void read_operation( uint64_t op_id, log_operation_object& op )const
+      {
+         FC_ASSERT( op_id < _op_count, "Operation ${o} is not in the account history log", ("o", op_id) );
+
+         uint64_t pos = op_positions()[ op_id ];
+         const char* record = segment( pos / _segment_size ).data() + pos % _segment_size;
+         uint32_t size;
+         memcpy( (char*)&size, record, sizeof( size ) );
+
+         fc::datastream< const char* > ds( record + sizeof( size ), size );
+         fc::raw::unpack( ds, op );
+      }
+
+      uint64_t get_ancestor( uint64_t entry, uint32_t sequence )const
+      {
+         FC_ASSERT( sequence > 0 );
+
+         const account_entry* entries = account_entries();
+         uint32_t height = sequence - 1;
+         uint32_t height_walk = entries[ entry ].sequence - 1;
+
+         while( height_walk > height )
+         {
+            const account_entry& e = entries[ entry ];
+            uint32_t height_skip = get_skip_height( height_walk );
+            uint32_t height_skip_prev = get_skip_height( height_walk - 1 );
+
+            if( e.skip != npos &&
+               ( height_skip == height ||
+                  ( height_skip > height && !( height_skip_prev + 2 < height_skip && height_skip_prev >= height ) ) ) )
+            {
+               entry = e.skip;
+               height_walk = height_skip;
+            }
+            else
+            {
+               entry = e.prev;
+               --height_walk;
+            }
+         }
+
+         return entry;
+      }
+
+      void insert_trx( uint64_t key, uint64_t op_id )
+      {
+         const trx_table_header& th = trx_header();
+
+         if( ( th.used + 1 ) * 2 > th.capacity )
+            grow_trx_table();
+
+         trx_table_header& h = *(trx_table_header*)_trx.data();
+         trx_slot* slots = (trx_slot*)( _trx.data() + sizeof( trx_table_header ) );
+         uint64_t mask = h.capacity - 1;
+
+         for( uint64_t i = key & mask; ; i = ( i + 1 ) & mask )
+         {
+            if( slots[i].op_id == 0 )
+            {
+               slots[i].key = key;
+               slots[i].op_id = op_id + 1;
+               ++h.used;
+               return;
+            }
+         }
+      }
+
+      void grow_trx_table()
+      {
+         std::vector< trx_slot > live;
+         const trx_table_header& th = trx_header();
+         const trx_slot* slots = trx_slots();
+
+         live.reserve( th.used );
+         for( uint64_t i = 0; i < th.capacity; ++i )
+         {
+            if( slots[i].op_id != 0 && slots[i].op_id <= _op_count )
+               live.push_back( slots[i] );
+         }
+
+         uint64_t capacity = th.capacity * 2;
+         _trx.reserve( sizeof( trx_table_header ) + capacity * sizeof( trx_slot ) );
+         memset( _trx.data(), 0, _trx.size() );
+
+         trx_table_header& h = *(trx_table_header*)_trx.data();
+         h.capacity = capacity;
+         h.used = 0;
+
+         for( const auto& s : live )
+            insert_trx( s.key, s.op_id - 1 );
+      }
+
+      void load_heads()
+      {
+         _heads.clear();
+         uint64_t replay_from = 0;
+         bfs::path heads_path = _dir / "accounts.heads";
+
+         if( bfs::exists( heads_path ) )
+         {
+            std::ifstream in( heads_path.generic_string().c_str(), std::ios::in | std::ios::binary );
+            uint64_t entry_count = 0;
+            uint64_t head_count = 0;
+            in.read( (char*)&entry_count, sizeof( entry_count ) );
+            in.read( (char*)&head_count, sizeof( head_count ) );
+
+            if( in && entry_count <= _account_entry_count )
+            {
+               account_head_record r;
+               for( uint64_t i = 0; i < head_count && in.read( (char*)&r, sizeof( r ) ); ++i )
+               {
+                  account_head& h = _heads[ r.account ];
+                  h.entry = r.entry;
+                  h.sequence = r.sequence;
+               }
+
+               if( in )
+               {
+                  replay_from = entry_count;
+               }
+               else
+               {
+                  wlog( "Account history log head snapshot is truncated, rebuilding it" );
+                  _heads.clear();
+               }
+            }
+
+            bfs::remove( heads_path );
+         }
+
+         if( replay_from < _account_entry_count )
+            ilog( "Replaying ${n} account history log entries", ("n", _account_entry_count - replay_from) );
+
+         const account_entry* entries = account_entries();
+         for( uint64_t i = replay_from; i < _account_entry_count; ++i )
+         {
+            account_head& h = _heads[ entries[i].account ];
+            h.entry = i;
+            h.sequence = entries[i].sequence;
+         }
+      }
+
+      void save_heads()
+      {
+         bfs::path heads_path = _dir / "accounts.heads";
+         std::ofstream out( heads_path.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+         uint64_t head_count = _heads.size();
+
+         out.write( (const char*)&_account_entry_count, sizeof( _account_entry_count ) );
+         out.write( (const char*)&head_count, sizeof( head_count ) );
+
+         account_head_record r;
+         for( const auto& h : _heads )
+         {
+            r.account = h.first;
+            r.sequence = h.second.sequence;
+            r.entry = h.second.entry;
+            out.write( (const char*)&r, sizeof( r ) );
+         }
+      }
+
+      bfs::path                                             _dir;
+      uint64_t                                              _segment_size = 0;
+
+      mapped_file                                           _blocks;
+      mapped_file                                           _ops;
+      mapped_file                                           _accounts;
+      mapped_file                                           _trx;
+      std::vector< std::unique_ptr< mapped_file > >         _segments;
+
+      uint64_t                                              _op_count = 0;
+      uint64_t                                              _account_entry_count = 0;
+      uint64_t                                              _write_pos = 0;
+      transaction_id_type                                   _last_trx_id;
+
+      std::map< account_name_type, account_head >           _heads;
+};
+
+} // detail
+
+account_history_log::account_history_log() : my( new detail::account_history_log_impl() ) {}
+
+account_history_log::~account_history_log()
+{
+   close();
+}
+
+void account_history_log::open( const fc::path& dir, uint64_t segment_size )
+{ try {
+   using namespace detail;
+
+   close();
+   FC_ASSERT( segment_size > 0, "Account history log segment size must be positive" );
+
+   my->_dir = dir;
+   if( !bfs::exists( my->_dir ) )
+      bfs::create_directories( my->_dir );
+
+   my->_blocks.open( my->_dir / "blocks.index", INITIAL_INDEX_SIZE );
+
+   log_header& h = my->header();
+   if( h.segment_size == 0 )
+   {
+      h.segment_size = segment_size;
+   }
+   else if( h.segment_size != segment_size )
+   {
+      wlog( "Account history log was created with a segment size of ${s} bytes, ignoring configured ${c} bytes",
+         ("s", h.segment_size)("c", segment_size) );
+   }
+
+   my->_segment_size = h.segment_size;
+
+   if( h.block_count )
+   {
+      const block_entry& last = my->blocks()[ h.block_count - 1 ];
+      my->_op_count = last.op_end;
+      my->_account_entry_count = last.account_entry_end;
+   }
+
+   my->_ops.open( my->_dir / "ops.index", INITIAL_INDEX_SIZE );
+   my->_accounts.open( my->_dir / "accounts.index", INITIAL_INDEX_SIZE );
+
+   bool new_trx_table = !bfs::exists( my->_dir / "trx.index" );
+   my->_trx.open( my->_dir / "trx.index", sizeof( trx_table_header ) + INITIAL_TRX_SLOTS * sizeof( trx_slot ) );
+   if( new_trx_table )
+      ( (trx_table_header*)my->_trx.data() )->capacity = INITIAL_TRX_SLOTS;
+
+   if( my->_op_count )
+   {
+      uint64_t pos = my->op_positions()[ my->_op_count - 1 ];
+      uint32_t size;
+      memcpy( (char*)&size, my->open_segment( pos / my->_segment_size ).data() + pos % my->_segment_size, sizeof( size ) );
+      my->_write_pos = pos + sizeof( size ) + size;
+
+      log_operation_object last_op;
+      my->read_operation( my->_op_count - 1, last_op );
+      my->_last_trx_id = last_op.trx_id;
+   }
+
+   my->load_heads();
+
+   ilog( "Opened account history log at ${d}: ${b} blocks, ${o} operations, ${a} accounts",
+      ("d", dir)("b", h.block_count)("o", my->_op_count)("a", my->_heads.size()) );
+} FC_CAPTURE_LOG_AND_RETHROW( (dir)(segment_size) ) }
+
+void account_history_log::close()
+{
+   if( !is_open() )
+      return;
+
+   my->save_heads();
+   flush();
+
+   my->_segments.clear();
+   my->_trx.close();
+   my->_accounts.close();
+   my->_ops.close();
+   my->_blocks.close();
+
+   auto dir = my->_dir;
+   my.reset( new detail::account_history_log_impl() );
+   my->_dir = dir;
+}
+
+bool account_history_log::is_open()const
+{
+   return my->_blocks.is_open();
+}
+
+void account_history_log::wipe()
+{
+   auto dir = my->_dir;
+   auto segment_size = my->_segment_size;
+
+   close();
+
+   ilog( "Wiping account history log at ${d}", ("d", dir.generic_string()) );
+   bfs::remove_all( dir );
+
+   if( segment_size )
+      open( dir, segment_size );
+}
+
+uint32_t account_history_log::head_block_num()const
+{
+   return is_open() ? uint32_t( my->header().block_count ) : 0;
+}
+
+uint32_t account_history_log::account_head_sequence( const account_name_type& account )const
+{
+   auto itr = my->_heads.find( account );
+   return itr == my->_heads.end() ? 0 : itr->second.sequence;
+}
+
+uint64_t account_history_log::append_operation( const log_operation_object& op )
+{
+   uint32_t size = fc::raw::pack_size( op );
+   uint64_t offset = my->_write_pos % my->_segment_size;
+
+   FC_ASSERT( sizeof( size ) + size <= my->_segment_size,
+      "Operation of ${s} bytes does not fit into an account history log segment", ("s", size) );
+
+   if( offset + sizeof( size ) + size > my->_segment_size )
+      my->_write_pos += my->_segment_size - offset;
+
+   char* record = my->open_segment( my->_write_pos / my->_segment_size ).data() + my->_write_pos % my->_segment_size;
+   memcpy( record, (const char*)&size, sizeof( size ) );
+   fc::datastream< char* > ds( record + sizeof( size ), size );
+   fc::raw::pack( ds, op );
+
+   uint64_t op_id = my->_op_count;
+   my->_ops.reserve( ( op_id + 1 ) * sizeof( uint64_t ) );
+   my->op_positions()[ op_id ] = my->_write_pos;
+
+   my->_write_pos += sizeof( size ) + size;
+   ++my->_op_count;
+
+   if( op.trx_id != transaction_id_type() && op.trx_id != my->_last_trx_id )
+      my->insert_trx( detail::trx_key( op.trx_id ), op_id );
+
+   my->_last_trx_id = op.trx_id;
+
+   return op_id;
+}
+
+void account_history_log::append_account_entry( const account_name_type& account, uint32_t sequence, uint64_t op_id )
+{
+   detail::account_head& head = my->_heads[ account ];
+
+   FC_ASSERT( sequence == head.sequence + 1, "Account history of ${a} is not contiguous, expected sequence ${e}, got ${s}",
+      ("a", account)("e", head.sequence + 1)("s", sequence) );
+
+   uint64_t index = my->_account_entry_count;
+   my->_accounts.reserve( ( index + 1 ) * sizeof( detail::account_entry ) );
+
+   detail::account_entry e;
+   e.account = account;
+   e.sequence = sequence;
+   e.op_id = op_id;
+   e.prev = head.entry;
+
+   if( sequence > 1 )
+      e.skip = my->get_ancestor( head.entry, detail::get_skip_height( sequence - 1 ) + 1 );
+
+   my->account_entries()[ index ] = e;
+   ++my->_account_entry_count;
+
+   head.entry = index;
+   head.sequence = sequence;
+}
+
+void account_history_log::end_block( uint32_t block_num )
+{
+   uint64_t block_count = my->header().block_count;
+
+   FC_ASSERT( block_num > block_count, "Block ${b} is already in the account history log", ("b", block_num) );
+
+   my->_blocks.reserve( sizeof( detail::log_header ) + block_num * sizeof( detail::block_entry ) );
+
+   detail::block_entry* entries = my->blocks();
+   for( uint64_t i = block_count; i < block_num; ++i )
+   {
+      entries[i].op_end = my->_op_count;
+      entries[i].account_entry_end = my->_account_entry_count;
+   }
+
+   my->header().block_count = block_num;
+}
+
+bool account_history_log::read_operation( uint64_t op_id, log_operation_object& op )const
+{
+   if( op_id >= my->_op_count )
+      return false;
+
+   my->read_operation( op_id, op );
+   return true;
+}
+
+void account_history_log::find_operations_by_block( uint32_t block_num, std::function< void( const log_operation_object& ) > processor )const
+{
+   if( block_num == 0 || block_num > head_block_num() )
+      return;
+
+   const detail::block_entry* entries = my->blocks();
+   uint64_t begin = block_num > 1 ? entries[ block_num - 2 ].op_end : 0;
+   uint64_t end = entries[ block_num - 1 ].op_end;
+
+   log_operation_object op;
+   for( uint64_t i = begin; i < end; ++i )
+   {
+      my->read_operation( i, op );
+      processor( op );
+   }
+}
+
+bool account_history_log::find_transaction( const transaction_id_type& trx_id, log_operation_object& op )const
+{
+   if( !is_open() )
+      return false;
+
+   const detail::trx_table_header& h = my->trx_header();
+   const detail::trx_slot* slots = my->trx_slots();
+   uint64_t key = detail::trx_key( trx_id );
+   uint64_t mask = h.capacity - 1;
+
+   for( uint64_t i = key & mask; slots[i].op_id != 0; i = ( i + 1 ) & mask )
+   {
+      // Slots written for blocks that were never committed may point past the end of the log
+      if( slots[i].key != key || slots[i].op_id > my->_op_count )
+         continue;
+
+      my->read_operation( slots[i].op_id - 1, op );
+      if( op.trx_id == trx_id )
+         return true;
+   }
+
+   return false;
+}
+
+uint32_t account_history_log::find_account_history( const account_name_type& account, uint64_t start, uint32_t limit,
+   std::function< void( uint32_t, const log_operation_object& ) > processor )const
+{
+   auto itr = my->_heads.find( account );
+   if( itr == my->_heads.end() || start == 0 )
+      return 0;
+
+   uint32_t sequence = uint32_t( std::min< uint64_t >( start, itr->second.sequence ) );
+   uint64_t entry = my->get_ancestor( itr->second.entry, sequence );
+   const detail::account_entry* entries = my->account_entries();
+
+   uint32_t n = 0;
+   log_operation_object op;
+   while( n < limit && entry != detail::npos )
+   {
+      my->read_operation( entries[ entry ].op_id, op );
+      processor( entries[ entry ].sequence, op );
+      entry = entries[ entry ].prev;
+      ++n;
+   }
+
+   return n;
+}
+
+void account_history_log::flush()
+{
+   for( auto& s : my->_segments )
+   {
+      if( s )
+         s->flush();
+   }
+
+   my->_trx.flush();
+   my->_accounts.flush();
+   my->_ops.flush();
+   my->_blocks.flush();
+}
+
+} } } // steem::plugins::account_history
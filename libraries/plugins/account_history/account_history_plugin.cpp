@@ -1,4 +1,5 @@
 #include <steem/plugins/account_history/account_history_plugin.hpp>
+#include <steem/plugins/account_history/account_history_log.hpp>
 
 #include <steem/chain/util/impacted.hpp>
 
@@ -36,20 +37,27 @@ class account_history_plugin_impl
       virtual ~account_history_plugin_impl() {}
 
       void on_pre_apply_operation( const operation_notification& note );
+      void on_irreversible_block( uint32_t block_num );
 
       flat_map< account_name_type, account_name_type > _tracked_accounts;
       bool                                             _filter_content = false;
       bool                                             _blacklist = false;
       flat_set< string >                               _op_list;
       bool                                             _prune = true;
+      bool                                             _use_log = false;
+      boost::filesystem::path                          _log_dir;
+      uint64_t                                         _log_segment_size = 0;
+      account_history_log                              _log;
       database&                        _db;
       boost::signals2::connection      _pre_apply_operation_conn;
+      boost::signals2::connection      _irreversible_block_conn;
+      boost::signals2::connection      _pre_reindex_conn;
 };
 
 struct operation_visitor
 {
-   operation_visitor( database& db, const operation_notification& note, const operation_object*& n, account_name_type i, bool prune )
-      :_db(db), _note(note), new_obj(n), item(i), _prune(prune) {}
+   operation_visitor( database& db, const operation_notification& note, const operation_object*& n, account_name_type i, bool prune, const account_history_log* log )
+      :_db(db), _note(note), new_obj(n), item(i), _prune(prune), _log(log) {}
 
    typedef void result_type;
 
@@ -58,6 +66,7 @@ struct operation_visitor
    const operation_object*& new_obj;
    account_name_type item;
    bool _prune;
+   const account_history_log* _log;
 
    template<typename Op>
    void operator()( Op&& )const
@@ -85,6 +94,8 @@ struct operation_visitor
       uint32_t sequence = 1;
       if( hist_itr != hist_idx.end() && hist_itr->account == item )
          sequence = hist_itr->sequence + 1;
+      else if( _log )
+         sequence = _log->account_head_sequence( item ) + 1;
 
       _db.create< chain::account_history_object >( [&]( chain::account_history_object& ahist )
       {
@@ -124,8 +135,8 @@ struct operation_visitor
 
 struct operation_visitor_filter : operation_visitor
 {
-   operation_visitor_filter( database& db, const operation_notification& note, const operation_object*& n, account_name_type i, const flat_set< string >& filter, bool p, bool blacklist ):
-      operation_visitor( db, note, n, i, p ), _filter( filter ), _blacklist( blacklist ) {}
+   operation_visitor_filter( database& db, const operation_notification& note, const operation_object*& n, account_name_type i, const flat_set< string >& filter, bool p, bool blacklist, const account_history_log* log ):
+      operation_visitor( db, note, n, i, p, log ), _filter( filter ), _blacklist( blacklist ) {}
 
    const flat_set< string >& _filter;
    bool _blacklist;
@@ -151,6 +162,7 @@ void account_history_plugin_impl::on_pre_apply_operation( const operation_notifi
    flat_set<account_name_type> impacted;
 
    const operation_object* new_obj = nullptr;
+   const account_history_log* log = _use_log ? &_log : nullptr;
    app::operation_get_impacted_accounts( note.op, impacted );
 
    for( const auto& item : impacted ) {
@@ -185,16 +197,75 @@ void account_history_plugin_impl::on_pre_apply_operation( const operation_notifi
       {
          if(_filter_content)
          {
-            note.op.visit( operation_visitor_filter( _db, note, new_obj, item, _op_list, _prune, _blacklist ) );
+            note.op.visit( operation_visitor_filter( _db, note, new_obj, item, _op_list, _prune, _blacklist, log ) );
          }
          else
          {
-            note.op.visit( operation_visitor( _db, note, new_obj, item, _prune ) );
+            note.op.visit( operation_visitor( _db, note, new_obj, item, _prune, log ) );
          }
       }
    }
 }
 
+/**
+ * Moves history of irreversible blocks from chainbase to the account history log. Operations and
+ * account history objects are created in block order, so their id indexes are in block order too.
+ */
+void account_history_plugin_impl::on_irreversible_block( uint32_t block_num )
+{
+   uint32_t log_head = _log.head_block_num();
+
+   if( block_num <= log_head )
+      return;
+
+   const auto& op_idx = _db.get_index< chain::operation_index, chain::by_id >();
+   const auto& hist_idx = _db.get_index< chain::account_history_index, chain::by_id >();
+
+   flat_map< chain::operation_id_type, uint64_t > log_ids;
+   vector< const operation_object* > ops_to_remove;
+   vector< const chain::account_history_object* > hist_to_remove;
+
+   for( auto itr = op_idx.begin(); itr != op_idx.end() && itr->block <= block_num; ++itr )
+   {
+      ops_to_remove.push_back( &(*itr) );
+
+      // History of blocks already in the log reappears when the block that moved it is popped
+      if( itr->block <= log_head )
+         continue;
+
+      log_operation_object obj;
+      obj.trx_id       = itr->trx_id;
+      obj.block        = itr->block;
+      obj.trx_in_block = itr->trx_in_block;
+      obj.op_in_trx    = itr->op_in_trx;
+      obj.virtual_op   = itr->virtual_op;
+      obj.timestamp    = itr->timestamp;
+      obj.serialized_op.assign( itr->serialized_op.begin(), itr->serialized_op.end() );
+
+      log_ids[ itr->id ] = _log.append_operation( obj );
+   }
+
+   for( auto itr = hist_idx.begin(); itr != hist_idx.end() && ops_to_remove.size(); ++itr )
+   {
+      if( itr->op > ops_to_remove.back()->id )
+         break;
+
+      hist_to_remove.push_back( &(*itr) );
+
+      auto log_itr = log_ids.find( itr->op );
+      if( log_itr != log_ids.end() )
+         _log.append_account_entry( itr->account, itr->sequence, log_itr->second );
+   }
+
+   _log.end_block( block_num );
+
+   for( const auto* h : hist_to_remove )
+      _db.remove( *h );
+
+   for( const auto* o : ops_to_remove )
+      _db.remove( *o );
+}
+
 } // detail
 
 account_history_plugin::account_history_plugin() {}
@@ -213,6 +284,9 @@ void account_history_plugin::set_program_options(
          ("account-history-blacklist-ops", boost::program_options::value< vector< string > >()->composing(), "Defines a list of operations which will be explicitly ignored.")
          ("history-blacklist-ops", boost::program_options::value< vector< string > >()->composing(), "Defines a list of operations which will be explicitly ignored. Deprecated in favor of account-history-blacklist-ops.")
          ("history-disable-pruning", boost::program_options::value< bool >()->default_value( false ), "Disables automatic account history trimming" )
+         ("account-history-storage", boost::program_options::value< string >()->default_value( "chainbase" ), "Where irreversible account history is kept. Either chainbase (the shared memory file) or log (an external append only log)." )
+         ("account-history-log-dir", boost::program_options::value< boost::filesystem::path >()->default_value( "blockchain/account-history-log" ), "The location of the account history log. Relative paths are relative to the data directory." )
+         ("account-history-log-segment-size", boost::program_options::value< uint64_t >()->default_value( 1024 ), "Size of account history log segment files in MB." )
          ;
 }
 
@@ -316,13 +390,54 @@ void account_history_plugin::plugin_initialize( const boost::program_options::va
    {
       my->_prune = !options[ "history-disable-pruning" ].as< bool >();
    }
+
+   if( options.count( "account-history-storage" ) )
+   {
+      const auto& storage = options.at( "account-history-storage" ).as< string >();
+      FC_ASSERT( storage == "chainbase" || storage == "log", "Unknown account history storage ${s}", ("s", storage) );
+      my->_use_log = storage == "log";
+   }
+
+   if( my->_use_log )
+   {
+      if( my->_prune )
+      {
+         ilog( "Account History: pruning is not supported by the account history log, keeping full history" );
+         my->_prune = false;
+      }
+
+      my->_log_dir = options.at( "account-history-log-dir" ).as< boost::filesystem::path >();
+      if( my->_log_dir.is_relative() )
+         my->_log_dir = appbase::app().data_dir() / my->_log_dir;
+
+      my->_log_segment_size = options.at( "account-history-log-segment-size" ).as< uint64_t >() * 1024 * 1024;
+      my->_log.open( my->_log_dir, my->_log_segment_size );
+
+      my->_irreversible_block_conn = my->_db.add_irreversible_block_handler(
+         [&]( uint32_t block_num ){ my->on_irreversible_block( block_num ); }, *this );
+      my->_pre_reindex_conn = my->_db.add_pre_reindex_handler(
+         [&]( const chain::reindex_notification& ){ my->_log.wipe(); }, *this );
+   }
 }
 
-void account_history_plugin::plugin_startup() {}
+void account_history_plugin::plugin_startup()
+{
+   if( my->_use_log && my->_log.head_block_num() > my->_db.head_block_num() )
+   {
+      wlog( "Account history log is ahead of the chain state (${l} > ${h}), discarding it",
+         ("l", my->_log.head_block_num())("h", my->_db.head_block_num()) );
+      my->_log.wipe();
+   }
+}
 
 void account_history_plugin::plugin_shutdown()
 {
    chain::util::disconnect_signal( my->_pre_apply_operation_conn );
+   chain::util::disconnect_signal( my->_irreversible_block_conn );
+   chain::util::disconnect_signal( my->_pre_reindex_conn );
+
+   if( my->_use_log )
+      my->_log.close();
 }
 
 flat_map< account_name_type, account_name_type > account_history_plugin::tracked_accounts() const
@@ -330,4 +445,9 @@ flat_map< account_name_type, account_name_type > account_history_plugin::tracked
    return my->_tracked_accounts;
 }
 
+const account_history_log* account_history_plugin::history_log() const
+{
+   return my->_use_log ? &my->_log : nullptr;
+}
+
 } } } // steem::plugins::account_history
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <steem/protocol/types.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace steem { namespace plugins { namespace account_history {
+
+using steem::protocol::account_name_type;
+using steem::protocol::transaction_id_type;
+
+namespace detail { class account_history_log_impl; }
+
+/**
+ * Operation as it is stored in the account history log. The layout mirrors
+ * chain::operation_object so api_operation_object can be built from either.
+ */
+struct log_operation_object
+{
+   transaction_id_type  trx_id;
+   uint32_t             block = 0;
+   uint32_t             trx_in_block = 0;
+   uint32_t             op_in_trx = 0;
+   uint32_t             virtual_op = 0;
+   fc::time_point_sec   timestamp;
+   std::vector< char >  serialized_op;
+};
+
+/* The account history log is an external, append only store for irreversible account history.
+ * It replaces operation_object and account_history_object in the shared memory file once the
+ * block that produced them became irreversible. Reversible history stays in chainbase so that
+ * it is undone together with the rest of the state.
+ *
+ * The log lives in a directory and consists of the following memory mapped files:
+ *
+ *  ops.<N>.log     Segments of fixed maximum size holding length prefixed, packed
+ *                  log_operation_object records. A record never straddles two segments.
+ *
+ *  ops.index       One uint64_t per operation: segment * segment_size + offset of the record.
+ *                  Operation ids are positions in this file.
+ *
+ *  blocks.index    One block_entry per block: the number of operations and account entries
+ *                  in the log after the block has been appended. This is also the commit
+ *                  marker, everything past the last block entry is discarded on open.
+ *
+ *  accounts.index  One account_entry per (account, operation) pair. Entries of an account
+ *                  form a linked list with an additional skip pointer (as in a skip list) so
+ *                  that the entry of any sequence number is found in O(log n).
+ *
+ *  trx.index       Open addressing hash table from transaction id to the first operation
+ *                  of that transaction.
+ *
+ *  accounts.heads  Snapshot of the newest entry of every account, written on close. Entries
+ *                  appended after the snapshot are replayed from accounts.index on open.
+ */
+class account_history_log
+{
+   public:
+      account_history_log();
+      ~account_history_log();
+
+      void open( const fc::path& dir, uint64_t segment_size );
+      void close();
+      bool is_open()const;
+
+      /** Removes all data from the log, used when the chain is reindexed. */
+      void wipe();
+
+      /** Number of the last block fully appended to the log, 0 if the log is empty. */
+      uint32_t head_block_num()const;
+
+      /** Newest sequence number of an account in the log, 0 if the account has no history. */
+      uint32_t account_head_sequence( const account_name_type& account )const;
+
+      /**
+       * Appends an operation, returns its id in the log. Operations must be appended in block order,
+       * followed by the account entries of the block and end_block.
+       */
+      uint64_t append_operation( const log_operation_object& op );
+      void     append_account_entry( const account_name_type& account, uint32_t sequence, uint64_t op_id );
+      void     end_block( uint32_t block_num );
+
+      bool     read_operation( uint64_t op_id, log_operation_object& op )const;
+
+      void     find_operations_by_block( uint32_t block_num, std::function< void( const log_operation_object& ) > processor )const;
+      bool     find_transaction( const transaction_id_type& trx_id, log_operation_object& op )const;
+
+      /**
+       * Calls processor for at most limit entries of the account with a sequence lower or equal to start,
+       * in descending sequence order. Returns the number of processed entries.
+       */
+      uint32_t find_account_history( const account_name_type& account, uint64_t start, uint32_t limit,
+         std::function< void( uint32_t, const log_operation_object& ) > processor )const;
+
+      void flush();
+
+   private:
+      std::unique_ptr< detail::account_history_log_impl > my;
+};
+
+} } } // steem::plugins::account_history
+
+FC_REFLECT( steem::plugins::account_history::log_operation_object, (trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(serialized_op) )
@@ -7,6 +7,8 @@ namespace steem { namespace plugins { namespace account_history {
 
 namespace detail { class account_history_plugin_impl; }
 
+class account_history_log;
+
 using namespace appbase;
 using steem::protocol::account_name_type;
 
@@ -47,6 +49,9 @@ class account_history_plugin : public plugin< account_history_plugin >
 
       flat_map< account_name_type, account_name_type > tracked_accounts()const; /// map start_range to end_range
 
+      /// Store of irreversible history when account-history-storage is log, nullptr otherwise
+      const account_history_log* history_log()const;
+
    private:
       std::unique_ptr< detail::account_history_plugin_impl > my;
 };
@@ -21,6 +21,8 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/container/flat_set.hpp>
 
+#include <atomic>
+#include <deque>
 #include <limits>
 #include <string>
 #include <typeindex>
@@ -358,12 +360,12 @@ public:
       {
       collectOptions(options);
 
-      _mainDb.add_pre_reindex_handler([&]( const steem::chain::reindex_notification& note ) -> void
+      _pre_reindex_conn = _mainDb.add_pre_reindex_handler([&]( const steem::chain::reindex_notification& note ) -> void
          {
             on_pre_reindex( note );
          }, _self, 0);
 
-      _mainDb.add_post_reindex_handler([&]( const steem::chain::reindex_notification& note ) -> void
+      _post_reindex_conn = _mainDb.add_post_reindex_handler([&]( const steem::chain::reindex_notification& note ) -> void
          {
             on_post_reindex( note );
          }, _self, 0);
@@ -373,6 +375,8 @@ public:
 
    ~impl()
    {
+      chain::util::disconnect_signal(_pre_reindex_conn);
+      chain::util::disconnect_signal(_post_reindex_conn);
       shutdownDb();
    }
 
@@ -403,6 +407,18 @@ public:
 
          const auto& rocksdb_plugin = appbase::app().get_plugin< account_history_rocksdb_plugin >();
 
+         if( _async )
+         {
+            _async_subscription = _mainDb.add_async_block_handler(
+               [&]( const chain::applied_block_record_ptr& record )
+               {
+                  on_applied_block( record );
+               },
+               rocksdb_plugin
+            );
+            return;
+         }
+
          _on_post_apply_operation_con = _mainDb.add_post_apply_operation_handler(
             [&]( const operation_notification& note )
             {
@@ -433,6 +449,9 @@ public:
    /// Allows to start immediate data import (outside replay process).
    void importData(unsigned int blockLimit);
 
+   /// In async mode, imports irreversible blocks applied while the plugin was not subscribed.
+   void importMissedBlocks();
+
    void find_account_history_data(const account_name_type& name, uint64_t start, uint32_t limit,
       std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const;
    bool find_operation_object(size_t opId, rocksdb_operation_object* op) const;
@@ -443,10 +462,19 @@ public:
    uint32_t enumVirtualOperationsFromBlockRange(uint32_t blockRangeBegin,
       uint32_t blockRangeEnd, std::function<void(const rocksdb_operation_object&)> processor) const;
 
+   /** In async mode the records of reversible blocks are dropped here.  That loses nothing: on open the
+    *  chain rewinds to its last irreversible block and applies the later blocks again, delivering them anew.
+    *  Blocks applied after the subscription is removed are imported by importMissedBlocks on startup.
+    */
    void shutdownDb()
    {
       chain::util::disconnect_signal(_on_post_apply_operation_con);
       chain::util::disconnect_signal(_on_irreversible_block_conn);
+      if(_async_subscription)
+      {
+         _mainDb.remove_async_block_handler(_async_subscription);
+         _async_subscription.reset();
+      }
       flushStorage();
       cleanupColumnHandles();
       _storage.reset();
@@ -555,6 +583,10 @@ private:
       checkStatus(s);
       s = _writeBuffer.Put(ahSeqIdName, ahId);
       checkStatus(s);
+
+      PrimitiveTypeSlice<uint32_t> lastImportedBlock(_lastImportedBlock);
+      s = _writeBuffer.Put(Slice("LAST_IMPORTED_BLOCK"), lastImportedBlock);
+      checkStatus(s);
    }
 
    void loadSeqIdentifiers(DB* storageDb)
@@ -573,6 +605,18 @@ private:
       checkStatus(s);
       _accountHistorySeqId = id_slice_t::unpackSlice(buffer);
 
+      /// Only maintained by async imports, stores written before know nothing about it.
+      s = storageDb->Get(rOptions, "LAST_IMPORTED_BLOCK", &buffer);
+      if(s.IsNotFound())
+      {
+         _lastImportedBlock = 0;
+      }
+      else
+      {
+         checkStatus(s);
+         _lastImportedBlock = PrimitiveTypeSlice<uint32_t>::unpackSlice(buffer);
+      }
+
       ilog("Loaded OperationObject seqId: ${o}, AccountHistoryObject seqId: ${ah}.",
          ("o", _operationSeqId)("ah", _accountHistorySeqId));
    }
@@ -596,8 +640,8 @@ private:
       if(_storage == nullptr)
          return;
 
-      /// If there are still not yet saved changes let's do it now.
-      if(_collectedOps != 0)
+      /// If there are still not yet saved changes let's do it now. Async imports also save the last imported block.
+      if(_collectedOps != 0 || _async)
          flushWriteBuffer();
 
       ::rocksdb::FlushOptions fOptions;
@@ -612,6 +656,10 @@ private:
 
    void on_irreversible_block( uint32_t block_num );
 
+   /// Runs on the subscription thread when `account-history-rocksdb-async` is set.
+   void on_applied_block( const chain::applied_block_record_ptr& record );
+   void importAppliedBlock( const chain::applied_block_record& record );
+
    void collectOptions(const bpo::variables_map& options);
 
    /** Returns true if given account is tracked.
@@ -649,6 +697,18 @@ private:
    boost::signals2::connection      _on_post_apply_operation_con;
    boost::signals2::connection      _on_irreversible_block_conn;
 
+   /** In async mode operations are imported on the subscription thread once their block becomes irreversible.
+    *  Reversible blocks are kept here instead of in the volatile_operation_index of the chain state.
+    */
+   bool                                                  _async = false;
+   std::shared_ptr< chain::async_block_subscription >    _async_subscription;
+   std::deque< chain::applied_block_record_ptr >         _reversibleBlocks;
+   /// Last block whose operations were imported in async mode, stored with the sequence identifiers.
+   uint32_t                                              _lastImportedBlock = 0;
+
+   boost::signals2::connection      _pre_reindex_conn;
+   boost::signals2::connection      _post_reindex_conn;
+
    /// Helper member to be able to detect another incomming tx and increment tx-counter.
    transaction_id_type              _lastTx;
    size_t                           _txNo = 0;
@@ -675,13 +735,18 @@ private:
    flat_set<std::string>            _op_list;
    flat_set<std::string>            _blacklisted_op_list;
 
-   bool                             _reindexing = false;
+   /// Written on the main thread, atomic as async mode imports on the subscription thread
+   std::atomic< bool >              _reindexing{ false };
 
    bool                             _prune = false;
 };
 
 void account_history_rocksdb_plugin::impl::collectOptions(const boost::program_options::variables_map& options)
 {
+   _async = options.at("account-history-rocksdb-async").as<bool>();
+   if(_async)
+      ilog( "Account History: importing operations asynchronously" );
+
    typedef std::pair< account_name_type, account_name_type > pairstring;
    STEEM_LOAD_VALUE_SET(options, "account-history-rocksdb-track-account-range", _tracked_accounts, pairstring);
 
@@ -1157,6 +1222,7 @@ void account_history_rocksdb_plugin::impl::on_pre_reindex(const steem::chain::re
    ilog("Received onReindexStart request, attempting to clean database storage.");
 
    shutdownDb();
+   _reversibleBlocks.clear();
    std::string strPath = _storagePath.string();
 
    auto s = ::rocksdb::DestroyDB(strPath, ::rocksdb::Options());
@@ -1172,6 +1238,7 @@ void account_history_rocksdb_plugin::impl::on_pre_reindex(const steem::chain::re
    _txNo = 0;
    _totalOps = 0;
    _excludedOps = 0;
+   _lastImportedBlock = 0;
    _reindexing = true;
 
    ilog("onReindexStart request completed successfully.");
@@ -1183,6 +1250,15 @@ void account_history_rocksdb_plugin::impl::on_post_reindex(const steem::chain::r
    ilog("Reindex completed up to block: ${b}. Setting back write limit to non-massive level.",
       ("b", finalBlock));
 
+   if(_async_subscription)
+   {
+      /// Everything replayed is irreversible, blocks not yet imported are imported here.
+      _async_subscription->wait();
+      for(const auto& record : _reversibleBlocks)
+         importAppliedBlock(*record);
+      _reversibleBlocks.clear();
+   }
+
    flushStorage();
    _collectedOpsWriteLimit = 1;
    _reindexing = false;
@@ -1361,6 +1437,141 @@ void account_history_rocksdb_plugin::impl::on_irreversible_block( uint32_t block
    }
 }
 
+void account_history_rocksdb_plugin::impl::on_applied_block( const chain::applied_block_record_ptr& record )
+{
+   /// A block at or below a kept one means the chain switched forks, the undone blocks are dropped.
+   while( _reversibleBlocks.size() && _reversibleBlocks.back()->block_num >= record->block_num )
+      _reversibleBlocks.pop_back();
+
+   _reversibleBlocks.push_back( record );
+
+   /// Also during a reindex, so that the records of a replayed chain are not all kept until on_post_reindex.
+   while( _reversibleBlocks.size() && _reversibleBlocks.front()->block_num <= record->last_irreversible_block )
+   {
+      importAppliedBlock( *_reversibleBlocks.front() );
+      _reversibleBlocks.pop_front();
+   }
+}
+
+void account_history_rocksdb_plugin::impl::importAppliedBlock( const chain::applied_block_record& record )
+{
+   /// Already imported from the block log by importMissedBlocks
+   if( record.block_num <= _lastImportedBlock )
+      return;
+
+   if( record.block_num % 10000 == 0 )
+   {
+      ilog("RocksDb data import processed blocks: ${n}, containing: ${tx} transactions and ${op} operations.\n"
+           " ${ep} operations have been filtered out due to configured options.\n"
+           " ${ea} accounts have been filtered out due to configured options.",
+         ("n", record.block_num)
+         ("tx", _txNo)
+         ("op", _totalOps)
+         ("ep", _excludedOps)
+         ("ea", _excludedAccountCount)
+         );
+   }
+
+   for( const auto& applied : record.operations )
+   {
+      if( !isTrackedOperation(applied.op) )
+      {
+         ++_excludedOps;
+         continue;
+      }
+
+      auto impacted = getImpactedAccounts(applied.op);
+
+      if( impacted.empty() )
+         continue;
+
+      rocksdb_operation_object obj;
+      obj.trx_id = applied.trx_id;
+      obj.block = record.block_num;
+      obj.trx_in_block = applied.trx_in_block;
+      obj.op_in_trx = applied.op_in_trx;
+      obj.virtual_op = applied.virtual_op;
+      obj.timestamp = applied.timestamp;
+      auto size = fc::raw::pack_size( applied.op );
+      obj.serialized_op.resize( size );
+      fc::datastream< char* > ds( obj.serialized_op.data(), size );
+      fc::raw::pack( ds, applied.op );
+
+      importOperation( obj, impacted );
+   }
+
+   /// Saved together with the operations of the block, so that a restart neither skips nor repeats it.
+   _lastImportedBlock = record.block_num;
+   if( _collectedOpsWriteLimit == 1 )
+      flushWriteBuffer();
+}
+
+void account_history_rocksdb_plugin::impl::importMissedBlocks()
+{
+   if( !_async || _storage == nullptr || _lastImportedBlock == 0 )
+      return;
+
+   _mainDb.with_read_lock( [&]()
+   {
+      /// No block can be applied while the read lock is held, the subscription is idle once it caught up.
+      if( _async_subscription )
+         _async_subscription->wait();
+
+      uint32_t lastIrreversible = _mainDb.get_dynamic_global_properties().last_irreversible_block_num;
+      if( _lastImportedBlock >= lastIrreversible )
+         return;
+
+      wlog( "Account History: importing blocks ${f} to ${t} applied while the plugin was not subscribed. "
+            "Their virtual operations are not in the block log, replay the chain to restore them.",
+         ("f", _lastImportedBlock + 1)("t", lastIrreversible) );
+
+      for( uint32_t blockNo = _lastImportedBlock + 1; blockNo <= lastIrreversible; ++blockNo )
+      {
+         auto block = _mainDb.fetch_block_by_number( blockNo );
+         FC_ASSERT( block.valid(), "Block ${b} is missing from the block log", ("b", blockNo) );
+
+         for( uint32_t txInBlock = 0; txInBlock < block->transactions.size(); ++txInBlock )
+         {
+            const auto& tx = block->transactions[ txInBlock ];
+            auto txId = tx.id();
+
+            for( uint16_t opInTx = 0; opInTx < tx.operations.size(); ++opInTx )
+            {
+               const auto& op = tx.operations[ opInTx ];
+
+               if( !isTrackedOperation(op) )
+               {
+                  ++_excludedOps;
+                  continue;
+               }
+
+               auto impacted = getImpactedAccounts( op );
+
+               if( impacted.empty() )
+                  continue;
+
+               rocksdb_operation_object obj;
+               obj.trx_id = txId;
+               obj.block = blockNo;
+               obj.trx_in_block = txInBlock;
+               obj.op_in_trx = opInTx;
+               obj.timestamp = block->timestamp;
+               auto size = fc::raw::pack_size( op );
+               obj.serialized_op.resize( size );
+               fc::datastream< char* > ds( obj.serialized_op.data(), size );
+               fc::raw::pack( ds, op );
+
+               importOperation( obj, impacted );
+            }
+         }
+
+         _lastImportedBlock = blockNo;
+      }
+
+      flushWriteBuffer();
+   });
+}
+
 account_history_rocksdb_plugin::account_history_rocksdb_plugin()
 {
 }
@@ -1380,6 +1591,8 @@ void account_history_rocksdb_plugin::set_program_options(
       ("account-history-rocksdb-track-account-range", boost::program_options::value< std::vector<std::string> >()->composing()->multitoken(), "Defines a range of accounts to track as a json pair [\"from\",\"to\"] [from,to] Can be specified multiple times.")
       ("account-history-rocksdb-whitelist-ops", boost::program_options::value< std::vector<std::string> >()->composing(), "Defines a list of operations which will be explicitly logged.")
       ("account-history-rocksdb-blacklist-ops", boost::program_options::value< std::vector<std::string> >()->composing(), "Defines a list of operations which will be explicitly ignored.")
+      ("account-history-rocksdb-async", bpo::value<bool>()->default_value(false),
+         "Import operations on a thread of the plugin instead of while blocks are applied. Operations are kept in memory, not in the chain state, until irreversible.")
 
    ;
    command_line_options.add_options()
@@ -1420,6 +1633,8 @@ void account_history_rocksdb_plugin::plugin_startup()
 
    if(_doImmediateImport)
       _my->importData(_blockLimit);
+   else
+      _my->importMissedBlocks();
 }
 
 void account_history_rocksdb_plugin::plugin_shutdown()
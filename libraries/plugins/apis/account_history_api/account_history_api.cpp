@@ -1,6 +1,8 @@
 #include <steem/plugins/account_history_api/account_history_api_plugin.hpp>
 #include <steem/plugins/account_history_api/account_history_api.hpp>
 
+#include <steem/plugins/account_history/account_history_log.hpp>
+
 #include <steem/plugins/account_history_rocksdb/account_history_rocksdb_plugin.hpp>
 
 namespace steem { namespace plugins { namespace account_history {
@@ -24,19 +26,37 @@ class abstract_account_history_api_impl
 class account_history_api_chainbase_impl : public abstract_account_history_api_impl
 {
    public:
-      account_history_api_chainbase_impl() : abstract_account_history_api_impl() {}
+      account_history_api_chainbase_impl() :
+         abstract_account_history_api_impl(), _log( appbase::app().get_plugin< steem::plugins::account_history::account_history_plugin >().history_log() ) {}
       ~account_history_api_chainbase_impl() {}
 
       get_ops_in_block_return get_ops_in_block( const get_ops_in_block_args& ) override;
       get_transaction_return get_transaction( const get_transaction_args& ) override;
       get_account_history_return get_account_history( const get_account_history_args& ) override;
       enum_virtual_ops_return enum_virtual_ops( const enum_virtual_ops_args& ) override;
+
+      /// Irreversible history moved out of chainbase, nullptr when everything is kept in chainbase
+      const account_history_log* _log;
 };
 
 DEFINE_API_IMPL( account_history_api_chainbase_impl, get_ops_in_block )
 {
    return _db.with_read_lock( [&]()
    {
+      if( _log && args.block_num <= _log->head_block_num() )
+      {
+         get_ops_in_block_return result;
+
+         _log->find_operations_by_block( args.block_num, [&]( const log_operation_object& op )
+         {
+            api_operation_object temp( op );
+            if( !args.only_virtual || is_virtual_operation( temp.op ) )
+               result.ops.emplace( std::move( temp ) );
+         });
+
+         return result;
+      }
+
       const auto& idx = _db.get_index< chain::operation_index, chain::by_location >();
       auto itr = idx.lower_bound( args.block_num );
 
@@ -77,7 +97,15 @@ DEFINE_API_IMPL( account_history_api_chainbase_impl, get_transaction )
       }
       else
       {
-         FC_ASSERT( false, "Unknown Transaction ${t}", ("t",args.id) );
+         log_operation_object op;
+         FC_ASSERT( _log && _log->find_transaction( args.id, op ), "Unknown Transaction ${t}", ("t",args.id) );
+
+         auto blk = _db.fetch_block_by_number( op.block );
+         FC_ASSERT( blk.valid() );
+         FC_ASSERT( blk->transactions.size() > op.trx_in_block );
+         result = blk->transactions[op.trx_in_block];
+         result.block_num       = op.block;
+         result.transaction_num = op.trx_in_block;
       }
 
       return result;
@@ -110,6 +138,20 @@ DEFINE_API_IMPL( account_history_api_chainbase_impl, get_account_history )
          ++n;
       }
 
+      // Older history of the account continues in the log, below the oldest sequence found in chainbase
+      if( _log && n < args.limit )
+      {
+         uint64_t start = args.start;
+         if( result.history.size() )
+            start = result.history.begin()->first - 1;
+
+         _log->find_account_history( args.account, start, args.limit - n,
+            [&]( uint32_t sequence, const log_operation_object& op )
+            {
+               result.history[ sequence ] = api_operation_object( op );
+            });
+      }
+
       return result;
    });
 }
@@ -33,6 +33,9 @@ class debug_node_api_impl
          (debug_set_hardfork)
          (debug_has_hardfork)
          (debug_get_json_schema)
+         (debug_set_block_profiler)
+         (debug_get_block_profile)
+         (debug_dump_block_trace)
       )
 
       chain::database& _db;
@@ -150,6 +153,43 @@ DEFINE_API_IMPL( debug_node_api_impl, debug_get_json_schema )
    return { _db.get_json_schema() };
 }
 
+DEFINE_API_IMPL( debug_node_api_impl, debug_set_block_profiler )
+{
+   auto& profiler = _db.get_block_profiler();
+   profiler.set_sample_interval( args.sample_interval );
+   profiler.set_max_blocks( args.max_blocks );
+   if( args.clear )
+      profiler.clear();
+   profiler.set_enabled( args.enabled );
+   return {};
+}
+
+DEFINE_API_IMPL( debug_node_api_impl, debug_get_block_profile )
+{
+   const auto& profiler = _db.get_block_profiler();
+
+   debug_get_block_profile_return result;
+   result.enabled = profiler.is_enabled();
+   result.sample_interval = profiler.get_sample_interval();
+   result.max_blocks = profiler.get_max_blocks();
+   result.phases = profiler.get_summary();
+   return result;
+}
+
+DEFINE_API_IMPL( debug_node_api_impl, debug_dump_block_trace )
+{
+   FC_ASSERT( args.filename.size(), "A file name is required" );
+
+   // Only a plain file name is accepted, the trace is always written to the data directory
+   FC_ASSERT( fc::path( args.filename ).filename().string() == args.filename && args.filename != "." && args.filename != "..",
+      "The trace file name cannot contain a directory, it is written to the data directory",
+      ("filename", args.filename) );
+
+   const auto& profiler = _db.get_block_profiler();
+   profiler.save_chrome_trace( fc::path( appbase::app().data_dir() / args.filename ) );
+   return { uint32_t( profiler.get_traces().size() ) };
+}
+
 } // detail
 
 debug_node_api::debug_node_api(): my( new detail::debug_node_api_impl() )
@@ -169,6 +209,9 @@ DEFINE_LOCKLESS_APIS( debug_node_api,
    (debug_set_hardfork)
    (debug_has_hardfork)
    (debug_get_json_schema)
+   (debug_set_block_profiler)
+   (debug_get_block_profile)
+   (debug_dump_block_trace)
 )
 
 } } } // steem::plugins::debug_node
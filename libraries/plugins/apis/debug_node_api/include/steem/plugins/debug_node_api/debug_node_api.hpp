@@ -63,6 +63,36 @@ struct debug_has_hardfork_return
    bool has_hardfork;
 };
 
+struct debug_set_block_profiler_args
+{
+   bool                                      enabled = false;
+   uint32_t                                  sample_interval = 1;
+   uint32_t                                  max_blocks = 1000;
+   bool                                      clear = false;
+};
+
+typedef void_type debug_set_block_profiler_return;
+
+typedef void_type debug_get_block_profile_args;
+
+struct debug_get_block_profile_return
+{
+   bool                                      enabled = false;
+   uint32_t                                  sample_interval = 0;
+   uint32_t                                  max_blocks = 0;
+   vector< chain::util::block_profiler::phase_summary > phases;
+};
+
+struct debug_dump_block_trace_args
+{
+   std::string                               filename;   ///< file name under the data directory
+};
+
+struct debug_dump_block_trace_return
+{
+   uint32_t                                  blocks = 0;
+};
+
 typedef void_type debug_get_json_schema_args;
 
 struct debug_get_json_schema_return
@@ -103,6 +133,21 @@ class debug_node_api
          (debug_set_hardfork)
          (debug_has_hardfork)
          (debug_get_json_schema)
+
+         /**
+         * Enable, configure or disable timing of block application phases.
+         */
+         (debug_set_block_profiler)
+
+         /**
+         * Percentiles of every phase over the blocks traced.
+         */
+         (debug_get_block_profile)
+
+         /**
+         * Write the traced blocks to a file in the Chrome trace event format.
+         */
+         (debug_dump_block_trace)
       )
 
    private:
@@ -131,3 +176,15 @@ FC_REFLECT( steem::plugins::debug_node::debug_has_hardfork_return,
 
 FC_REFLECT( steem::plugins::debug_node::debug_get_json_schema_return,
             (schema) )
+
+FC_REFLECT( steem::plugins::debug_node::debug_set_block_profiler_args,
+            (enabled)(sample_interval)(max_blocks)(clear) )
+
+FC_REFLECT( steem::plugins::debug_node::debug_get_block_profile_return,
+            (enabled)(sample_interval)(max_blocks)(phases) )
+
+FC_REFLECT( steem::plugins::debug_node::debug_dump_block_trace_args,
+            (filename) )
+
+FC_REFLECT( steem::plugins::debug_node::debug_dump_block_trace_return,
+            (blocks) )
@@ -1,6 +1,7 @@
 #include <steem/plugins/follow_api/follow_api_plugin.hpp>
 #include <steem/plugins/follow_api/follow_api.hpp>
 
+#include <steem/plugins/follow/feed_store.hpp>
 #include <steem/plugins/follow/follow_objects.hpp>
 
 namespace steem { namespace plugins { namespace follow {
@@ -18,7 +19,9 @@ inline void set_what( vector< follow::follow_type >& what, uint16_t bitmask )
 class follow_api_impl
 {
    public:
-      follow_api_impl() : _db( appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db() ) {}
+      follow_api_impl() :
+         _db( appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db() ),
+         _feed_store( appbase::app().get_plugin< steem::plugins::follow::follow_plugin >().get_feed_store() ) {}
 
       DECLARE_API_IMPL(
          (get_followers)
@@ -34,6 +37,7 @@ class follow_api_impl
       )
 
       chain::database& _db;
+      const follow::feed_store* _feed_store;
 };
 
 DEFINE_API_IMPL( follow_api_impl, get_followers )
@@ -110,6 +114,32 @@ DEFINE_API_IMPL( follow_api_impl, get_feed_entries )
    get_feed_entries_return result;
    result.feed.reserve( args.limit );
 
+   if( _feed_store != nullptr )
+   {
+      _feed_store->find_feed( args.account, entry_id, args.limit, [&]( const follow::feed_store_entry& e )
+      {
+         // Entries of deleted comments are skipped instead of being removed from the store
+         const auto* comment = _db.find< chain::comment_object >( chain::comment_id_type( e.comment ) );
+         if( comment == nullptr ) return false;
+
+         feed_entry entry;
+         entry.author = comment->author;
+         entry.permlink = chain::to_string( comment->permlink );
+         entry.entry_id = e.account_feed_id;
+
+         if( e.reblogged_by.size() )
+         {
+            entry.reblog_by = e.reblogged_by;
+            entry.reblog_on = e.first_reblogged_on;
+         }
+
+         result.feed.push_back( entry );
+         return true;
+      });
+
+      return result;
+   }
+
    const auto& feed_idx = _db.get_index< follow::feed_index >().indices().get< follow::by_feed >();
    auto itr = feed_idx.lower_bound( boost::make_tuple( args.account, entry_id ) );
 
@@ -147,6 +177,30 @@ DEFINE_API_IMPL( follow_api_impl, get_feed )
    get_feed_return result;
    result.feed.reserve( args.limit );
 
+   if( _feed_store != nullptr )
+   {
+      _feed_store->find_feed( args.account, entry_id, args.limit, [&]( const follow::feed_store_entry& e )
+      {
+         const auto* comment = _db.find< chain::comment_object >( chain::comment_id_type( e.comment ) );
+         if( comment == nullptr ) return false;
+
+         comment_feed_entry entry;
+         entry.comment = database_api::api_comment_object( *comment, _db );
+         entry.entry_id = e.account_feed_id;
+
+         if( e.reblogged_by.size() )
+         {
+            entry.reblog_by = e.reblogged_by;
+            entry.reblog_on = e.first_reblogged_on;
+         }
+
+         result.feed.push_back( entry );
+         return true;
+      });
+
+      return result;
+   }
+
    const auto& feed_idx = _db.get_index< follow::feed_index >().indices().get< follow::by_feed >();
    auto itr = feed_idx.lower_bound( boost::make_tuple( args.account, entry_id ) );
 
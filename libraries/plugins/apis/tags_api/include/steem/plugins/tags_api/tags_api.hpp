@@ -232,6 +232,7 @@ class tags_api
    private:
       friend class tags_api_plugin;
       void api_startup();
+      void set_discussion_cache_size( uint32_t size );
 
       std::unique_ptr< detail::tags_api_impl > my;
 };
@@ -8,6 +8,8 @@
 #include <steem/chain/util/reward.hpp>
 #include <steem/chain/util/uint256.hpp>
 
+#include <boost/thread/mutex.hpp>
+
 namespace steem { namespace plugins { namespace tags {
 
 namespace detail {
@@ -62,8 +64,22 @@ class tags_api_impl
 
       chain::comment_id_type get_parent( const discussion_query& q );
 
+      template< typename Query >
+      discussion_query_result get_cached_discussions( const char* sort, const discussion_query& q, Query&& query );
+
       chain::database& _db;
       std::shared_ptr< steem::plugins::follow::follow_api > _follow_api;
+
+      /**
+       * First pages of the common discussion sorts, keyed by (sort, tag, limit, truncate_body).
+       * The cache is dropped whenever the head block changes, including switches to a fork of the same height.
+       */
+      typedef std::tuple< string, string, uint32_t, uint32_t > discussion_cache_key;
+
+      uint32_t                                                  _discussion_cache_size = 0;
+      chain::block_id_type                                      _discussion_cache_block;
+      std::map< discussion_cache_key, discussion_query_result > _discussion_cache;
+      boost::mutex                                              _discussion_cache_mutex;
 };
 
 DEFINE_API_IMPL( tags_api_impl, get_trending_tags )
@@ -171,37 +187,49 @@ DEFINE_API_IMPL( tags_api_impl, get_comment_discussions_by_payout )
 DEFINE_API_IMPL( tags_api_impl, get_discussions_by_trending )
 {
    args.validate();
-   auto tag = fc::to_lower( args.tag );
-   auto parent = get_parent( args );
 
-   const auto& tidx = _db.get_index< tags::tag_index, tags::by_parent_trending >();
-   auto tidx_itr = tidx.lower_bound( boost::make_tuple( tag, parent, std::numeric_limits< double >::max() )  );
+   return get_cached_discussions( "trending", args, [&]()
+   {
+      auto tag = fc::to_lower( args.tag );
+      auto parent = get_parent( args );
+
+      const auto& tidx = _db.get_index< tags::tag_index, tags::by_parent_trending >();
+      auto tidx_itr = tidx.lower_bound( boost::make_tuple( tag, parent, std::numeric_limits< double >::max() )  );
 
-   return get_discussions( args, tag, parent, tidx, tidx_itr, args.truncate_body, []( const database_api::api_comment_object& c ) { return c.net_rshares <= 0; } );
+      return get_discussions( args, tag, parent, tidx, tidx_itr, args.truncate_body, []( const database_api::api_comment_object& c ) { return c.net_rshares <= 0; } );
+   });
 }
 
 DEFINE_API_IMPL( tags_api_impl, get_discussions_by_created )
 {
    args.validate();
-   auto tag = fc::to_lower( args.tag );
-   auto parent = get_parent( args );
 
-   const auto& tidx = _db.get_index< tags::tag_index, tags::by_parent_created >();
-   auto tidx_itr = tidx.lower_bound( boost::make_tuple( tag, parent, fc::time_point_sec::maximum() )  );
+   return get_cached_discussions( "created", args, [&]()
+   {
+      auto tag = fc::to_lower( args.tag );
+      auto parent = get_parent( args );
 
-   return get_discussions( args, tag, parent, tidx, tidx_itr, args.truncate_body );
+      const auto& tidx = _db.get_index< tags::tag_index, tags::by_parent_created >();
+      auto tidx_itr = tidx.lower_bound( boost::make_tuple( tag, parent, fc::time_point_sec::maximum() )  );
+
+      return get_discussions( args, tag, parent, tidx, tidx_itr, args.truncate_body );
+   });
 }
 
 DEFINE_API_IMPL( tags_api_impl, get_discussions_by_active )
 {
    args.validate();
-   auto tag = fc::to_lower( args.tag );
-   auto parent = get_parent( args );
 
-   const auto& tidx = _db.get_index< tags::tag_index, tags::by_parent_active >();
-   auto tidx_itr = tidx.lower_bound( boost::make_tuple( tag, parent, fc::time_point_sec::maximum() )  );
+   return get_cached_discussions( "active", args, [&]()
+   {
+      auto tag = fc::to_lower( args.tag );
+      auto parent = get_parent( args );
 
-   return get_discussions( args, tag, parent, tidx, tidx_itr, args.truncate_body );
+      const auto& tidx = _db.get_index< tags::tag_index, tags::by_parent_active >();
+      auto tidx_itr = tidx.lower_bound( boost::make_tuple( tag, parent, fc::time_point_sec::maximum() )  );
+
+      return get_discussions( args, tag, parent, tidx, tidx_itr, args.truncate_body );
+   });
 }
 
 DEFINE_API_IMPL( tags_api_impl, get_discussions_by_cashout )
@@ -245,13 +273,17 @@ DEFINE_API_IMPL( tags_api_impl, get_discussions_by_children )
 DEFINE_API_IMPL( tags_api_impl, get_discussions_by_hot )
 {
    args.validate();
-   auto tag = fc::to_lower( args.tag );
-   auto parent = get_parent( args );
 
-   const auto& tidx = _db.get_index< tags::tag_index, tags::by_parent_hot >();
-   auto tidx_itr = tidx.lower_bound( boost::make_tuple( tag, parent, std::numeric_limits< double >::max() )  );
+   return get_cached_discussions( "hot", args, [&]()
+   {
+      auto tag = fc::to_lower( args.tag );
+      auto parent = get_parent( args );
+
+      const auto& tidx = _db.get_index< tags::tag_index, tags::by_parent_hot >();
+      auto tidx_itr = tidx.lower_bound( boost::make_tuple( tag, parent, std::numeric_limits< double >::max() )  );
 
-   return get_discussions( args, tag, parent, tidx, tidx_itr, args.truncate_body, []( const database_api::api_comment_object& c ) { return c.net_rshares <= 0; } );
+      return get_discussions( args, tag, parent, tidx, tidx_itr, args.truncate_body, []( const database_api::api_comment_object& c ) { return c.net_rshares <= 0; } );
+   });
 }
 
 DEFINE_API_IMPL( tags_api_impl, get_discussions_by_feed )
@@ -417,13 +449,17 @@ DEFINE_API_IMPL( tags_api_impl, get_discussions_by_comments )
 DEFINE_API_IMPL( tags_api_impl, get_discussions_by_promoted )
 {
    args.validate();
-   auto tag = fc::to_lower( args.tag );
-   auto parent = get_parent( args );
 
-   const auto& tidx = _db.get_index< tags::tag_index, tags::by_parent_promoted >();
-   auto tidx_itr = tidx.lower_bound( boost::make_tuple( tag, parent, share_type( STEEM_MAX_SHARE_SUPPLY ) )  );
+   return get_cached_discussions( "promoted", args, [&]()
+   {
+      auto tag = fc::to_lower( args.tag );
+      auto parent = get_parent( args );
+
+      const auto& tidx = _db.get_index< tags::tag_index, tags::by_parent_promoted >();
+      auto tidx_itr = tidx.lower_bound( boost::make_tuple( tag, parent, share_type( STEEM_MAX_SHARE_SUPPLY ) )  );
 
-   return get_discussions( args, tag, parent, tidx, tidx_itr, args.truncate_body, filter_default, exit_default, []( const tags::tag_object& t ){ return t.promoted_balance == 0; }  );
+      return get_discussions( args, tag, parent, tidx, tidx_itr, args.truncate_body, filter_default, exit_default, []( const tags::tag_object& t ){ return t.promoted_balance == 0; }  );
+   });
 }
 
 DEFINE_API_IMPL( tags_api_impl, get_replies_by_last_update )
@@ -696,6 +732,41 @@ discussion_query_result tags_api_impl::get_discussions( const discussion_query&
    return result;
 }
 
+template< typename Query >
+discussion_query_result tags_api_impl::get_cached_discussions( const char* sort, const discussion_query& q, Query&& query )
+{
+   if( _discussion_cache_size == 0 || q.start_author || q.start_permlink || q.parent_author || q.parent_permlink )
+      return query();
+
+   auto key = std::make_tuple( string( sort ), fc::to_lower( q.tag ), q.limit, q.truncate_body );
+   auto head_block = _db.head_block_id();
+
+   {
+      boost::mutex::scoped_lock lock( _discussion_cache_mutex );
+
+      if( _discussion_cache_block != head_block )
+      {
+         _discussion_cache.clear();
+         _discussion_cache_block = head_block;
+      }
+
+      auto itr = _discussion_cache.find( key );
+      if( itr != _discussion_cache.end() )
+         return itr->second;
+   }
+
+   auto result = query();
+
+   {
+      boost::mutex::scoped_lock lock( _discussion_cache_mutex );
+
+      if( _discussion_cache_block == head_block && _discussion_cache.size() < _discussion_cache_size )
+         _discussion_cache.emplace( std::move( key ), result );
+   }
+
+   return result;
+}
+
 chain::comment_id_type tags_api_impl::get_parent( const discussion_query& query )
 {
    chain::comment_id_type parent;
@@ -742,6 +813,11 @@ void tags_api::set_pending_payout( discussion& d )
    my->set_pending_payout( d );
 }
 
+void tags_api::set_discussion_cache_size( uint32_t size )
+{
+   my->_discussion_cache_size = size;
+}
+
 void tags_api::api_startup()
 {
    auto follow_api_plugin = appbase::app().find_plugin< steem::plugins::follow::follow_api_plugin >();
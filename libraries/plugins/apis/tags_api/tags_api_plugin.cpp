@@ -7,11 +7,18 @@ namespace steem { namespace plugins { namespace tags {
 tags_api_plugin::tags_api_plugin() {}
 tags_api_plugin::~tags_api_plugin() {}
 
-void tags_api_plugin::set_program_options( options_description& cli, options_description& cfg ) {}
+void tags_api_plugin::set_program_options( options_description& cli, options_description& cfg )
+{
+   cfg.add_options()
+      ("tags-api-discussion-cache-size", boost::program_options::value< uint32_t >()->default_value( 1000 ),
+         "Maximum number of discussion pages (trending, hot, created, active and promoted first pages) cached per block. 0 disables the cache." )
+      ;
+}
 
 void tags_api_plugin::plugin_initialize( const variables_map& options )
 {
    api = std::make_shared< tags_api >();
+   api->set_discussion_cache_size( options.at( "tags-api-discussion-cache-size" ).as< uint32_t >() );
 }
 
 void tags_api_plugin::plugin_startup() { api->api_startup(); }
@@ -6,14 +6,17 @@
 #include <steem/utilities/benchmark_dumper.hpp>
 
 #include <fc/string.hpp>
+#include <fc/thread/future.hpp>
 
 #include <boost/asio.hpp>
 #include <boost/optional.hpp>
 #include <boost/bind.hpp>
 #include <boost/preprocessor/stringize.hpp>
 #include <boost/thread/future.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/lockfree/queue.hpp>
 
+#include <atomic>
 #include <thread>
 #include <memory>
 #include <iostream>
@@ -42,7 +45,27 @@ struct generate_block_request
    signed_block block;
 };
 
-typedef fc::static_variant< const signed_block*, const signed_transaction*, generate_block_request* > write_request_ptr;
+struct transaction_batch_request
+{
+   transaction_batch_request( const std::vector< signed_transaction >& t ) :
+      trxs( t ),
+      results( t.size() ) {}
+
+   const std::vector< signed_transaction >&        trxs;
+   std::vector< fc::optional< fc::exception > >    results;
+   /// The transactions before next were pushed, the rest wait for the write thread to take the lock again
+   size_t                                          next = 0;
+};
+
+/// The stateless checks of one transaction, done before it is queued for the write thread
+struct prevalidated_transaction
+{
+   bool                                valid = false;
+   steem::chain::transaction_id_type   id;
+   flat_set< public_key_type >         signature_keys;
+};
+
+typedef fc::static_variant< const signed_block*, const signed_transaction*, generate_block_request*, transaction_batch_request* > write_request_ptr;
 typedef fc::static_variant< boost::promise< void >*, fc::future< void >* > promise_ptr;
 
 struct write_context
@@ -52,6 +75,8 @@ struct write_context
    bool                          success = true;
    fc::optional< fc::exception > except;
    promise_ptr                   prom_ptr;
+   /// One entry per transaction of the request, in order, or empty
+   std::vector< prevalidated_transaction > prevalidated;
 };
 
 namespace detail {
@@ -59,12 +84,23 @@ namespace detail {
 class chain_plugin_impl
 {
    public:
-      chain_plugin_impl() : write_queue( 64 ) {}
-      ~chain_plugin_impl() { stop_write_processing(); }
+      chain_plugin_impl() : write_queue( 64 ), validation_work( validation_ios ) {}
+      ~chain_plugin_impl() { stop_write_processing(); stop_validation_threads(); }
 
       void start_write_processing();
       void stop_write_processing();
 
+      void start_validation_threads();
+      void stop_validation_threads();
+
+      /**
+       * Runs validate() and signature recovery for every transaction, spread over the validation threads
+       * and the calling thread.  A transaction that fails is left invalid, the write thread checks it
+       * again and reports the error.
+       */
+      std::vector< prevalidated_transaction > prevalidate_transactions( const std::vector< signed_transaction >& trxs );
+      std::vector< prevalidated_transaction > prevalidate_transactions( const signed_transaction& trx );
+
       uint64_t                         shared_memory_size = 0;
       uint16_t                         shared_file_full_threshold = 0;
       uint16_t                         shared_file_scale_rate = 0;
@@ -89,6 +125,11 @@ class chain_plugin_impl
       boost::lockfree::queue< write_context* > write_queue;
       int16_t                          write_lock_hold_time = 500;
 
+      uint32_t                         validation_thread_pool_size = 0;
+      boost::thread_group              validation_threads;
+      asio::io_service                 validation_ios;
+      asio::io_service::work           validation_work;
+
       database  db;
 };
 
@@ -99,18 +140,66 @@ struct write_request_visitor
    database* db;
    uint32_t  skip = 0;
    fc::optional< fc::exception >* except;
+   const std::vector< prevalidated_transaction >* prevalidated = nullptr;
+   /// A batch pushes no more transactions after this time, and sets requeue if some are left
+   fc::time_point deadline = fc::time_point::maximum();
+   bool           requeue = false;
 
    typedef bool result_type;
 
+   void add_prevalidated( const signed_transaction& trx, size_t index )
+   {
+      if( index < prevalidated->size() && (*prevalidated)[ index ].valid )
+         db->add_validated_transaction( (*prevalidated)[ index ].id, trx, (*prevalidated)[ index ].signature_keys );
+   }
+
+   void remove_prevalidated( size_t index )
+   {
+      if( index < prevalidated->size() && (*prevalidated)[ index ].valid )
+         db->remove_validated_transaction( (*prevalidated)[ index ].id );
+   }
+
    bool operator()( const signed_block* block )
    {
       bool result = false;
 
+      for( size_t i = 0; i < block->transactions.size(); ++i )
+         add_prevalidated( block->transactions[i], i );
+
       try
       {
          STATSD_START_TIMER( chain, write_time, push_block, 1.0f )
          result = db->push_block( *block, skip );
          STATSD_STOP_TIMER( chain, write_time, push_block )
+
+         if( result )
+         {
+            const auto& fork_switch = db->get_last_fork_switch();
+            if( fork_switch.undone_blocks )
+            {
+               STATSD_INCREMENT( chain, fork, switches, 1.0f )
+               STATSD_COUNT( chain, fork, undone_blocks, fork_switch.undone_blocks, 1.0f )
+               STATSD_COUNT( chain, fork, applied_blocks, fork_switch.applied_blocks, 1.0f )
+               STATSD_TIMING( chain, fork, switch_time, fork_switch.time.count() / 1000, 1.0f )
+            }
+            else
+            {
+               // Not a switch, the block linked blocks waiting in the unlinked pool that extend head
+               STATSD_COUNT( chain, fork_db, linked_blocks, fork_switch.applied_blocks, 1.0f )
+            }
+         }
+         STATSD_GAUGE( chain, fork_db, unlinked_blocks, db->get_fork_db().unlinked_block_count(), 1.0f )
+
+         if( steem::plugins::statsd::util::statsd_enabled() )
+         {
+            uint32_t head = db->head_block_num();
+            for( const auto& subscription : db->get_async_block_subscriptions() )
+            {
+               uint32_t handled = subscription->last_block_num();
+               steem::plugins::statsd::util::get_statsd().gauge( "chain", "async_lag", subscription->name(), head > handled ? head - handled : 0 );
+               steem::plugins::statsd::util::get_statsd().gauge( "chain", "async_queue", subscription->name(), subscription->queued_blocks() );
+            }
+         }
       }
       catch( fc::exception& e )
       {
@@ -122,6 +211,10 @@ struct write_request_visitor
                                            std::current_exception() );
       }
 
+      // Applied transactions are already gone, the rest were not applied (fork block, failure)
+      for( size_t i = 0; i < block->transactions.size(); ++i )
+         remove_prevalidated( i );
+
       return result;
    }
 
@@ -129,6 +222,8 @@ struct write_request_visitor
    {
       bool result = false;
 
+      add_prevalidated( *trx, 0 );
+
       try
       {
          STATSD_START_TIMER( chain, write_time, push_tx, 1.0f )
@@ -147,9 +242,56 @@ struct write_request_visitor
                                            std::current_exception() );
       }
 
+      if( !result )
+         remove_prevalidated( 0 );
+
       return result;
    }
 
+   bool operator()( transaction_batch_request* req )
+   {
+      STATSD_START_TIMER( chain, write_time, push_tx_batch, 1.0f )
+
+      // At least one transaction is pushed per write lock, so that a batch always makes progress
+      size_t first = req->next;
+
+      // A rejected transaction doesn't fail the batch, its exception is returned in its place
+      for( ; req->next < req->trxs.size(); ++req->next )
+      {
+         if( req->next > first && fc::time_point::now() > deadline )
+         {
+            requeue = true;
+            break;
+         }
+
+         size_t i = req->next;
+         add_prevalidated( req->trxs[i], i );
+
+         try
+         {
+            STATSD_START_TIMER( chain, write_time, push_tx, 1.0f )
+            db->push_transaction( req->trxs[i] );
+            STATSD_STOP_TIMER( chain, write_time, push_tx )
+         }
+         catch( fc::exception& e )
+         {
+            req->results[i] = e;
+         }
+         catch( ... )
+         {
+            req->results[i] = fc::unhandled_exception( FC_LOG_MESSAGE( warn, "Unexpected exception while pushing transaction." ),
+                                                       std::current_exception() );
+         }
+
+         if( req->results[i] )
+            remove_prevalidated( i );
+      }
+
+      STATSD_STOP_TIMER( chain, write_time, push_tx_batch )
+
+      return true;
+   }
+
    bool operator()( generate_block_request* req )
    {
       bool result = false;
@@ -220,7 +362,8 @@ void chain_plugin_impl::start_write_processing()
        *
        * Live mode needs to balance between processing pending writes and allowing readers access
        * to the database. It will batch writes together as much as possible to minimize lock
-       * overhead but will willingly give up the write lock after 500ms. The thread then sleeps for
+       * overhead but will willingly give up the write lock after 500ms, splitting a transaction batch
+       * at that point and queueing the rest of it again. The thread then sleeps for
        * 10ms. This allows time for readers to access the database as well as more writes to come
        * in. When the node is live the rate at which writes come in is slower and busy waiting is
        * not an optimal use of system resources when we could give CPU time to read threads.
@@ -239,7 +382,19 @@ void chain_plugin_impl::start_write_processing()
                {
                   req_visitor.skip = cxt->skip;
                   req_visitor.except = &(cxt->except);
+                  req_visitor.prevalidated = &(cxt->prevalidated);
+                  req_visitor.deadline = !is_syncing && write_lock_hold_time >= 0 ?
+                     start + fc::milliseconds( write_lock_hold_time ) : fc::time_point::maximum();
+                  req_visitor.requeue = false;
                   cxt->success = cxt->req_ptr.visit( req_visitor );
+
+                  if( req_visitor.requeue )
+                  {
+                     // The rest of the batch goes behind the requests already queued
+                     write_queue.push( cxt );
+                     break;
+                  }
+
                   cxt->prom_ptr.visit( prom_visitor );
 
                   if( is_syncing && start - db.head_block_time() < fc::minutes(1) )
@@ -277,6 +432,103 @@ void chain_plugin_impl::stop_write_processing()
    write_processor_thread.reset();
 }
 
+void chain_plugin_impl::start_validation_threads()
+{
+   for( uint32_t i = 0; i < validation_thread_pool_size; ++i )
+      validation_threads.create_thread( boost::bind( &asio::io_service::run, &validation_ios ) );
+}
+
+void chain_plugin_impl::stop_validation_threads()
+{
+   validation_ios.stop();
+   validation_threads.join_all();
+}
+
+/**
+ * The state shared by the threads validating one request.  Tasks still queued when the caller returns
+ * find nothing left to do, they only keep the state alive.
+ *
+ * The transactions belong to the caller and may be gone by the time such a task runs, so they are only
+ * read through an index claimed below count, and the caller waits until every claimed index completes.
+ */
+struct prevalidation_batch
+{
+   prevalidation_batch( const std::vector< signed_transaction >& t, const steem::chain::chain_id_type& c ) :
+      trxs( t.data() ), count( t.size() ), chain_id( c ), results( t.size() ) {}
+
+   /// Validates transactions until there are none left
+   void run()
+   {
+      size_t done = 0;
+
+      for( size_t i = next++; i < count; i = next++ )
+      {
+         try
+         {
+            trxs[i].validate();
+            results[i].signature_keys = trxs[i].get_signature_keys( chain_id );
+            results[i].id = trxs[i].id();
+            results[i].valid = true;
+         }
+         catch( ... ) {}
+
+         ++done;
+      }
+
+      if( done )
+      {
+         boost::unique_lock< boost::mutex > lock( mtx );
+         completed += done;
+         if( completed == count )
+            all_done.notify_one();
+      }
+   }
+
+   const signed_transaction* const           trxs;
+   const size_t                              count;
+   const steem::chain::chain_id_type         chain_id;
+   std::vector< prevalidated_transaction >   results;
+
+   std::atomic< size_t >                     next{ 0 };
+   size_t                                    completed = 0;
+   boost::mutex                              mtx;
+   boost::condition_variable                 all_done;
+};
+
+std::vector< prevalidated_transaction > chain_plugin_impl::prevalidate_transactions( const std::vector< signed_transaction >& trxs )
+{
+   auto batch = std::make_shared< prevalidation_batch >( trxs, db.get_chain_id() );
+
+   // The calling thread takes its share too
+   size_t helpers = trxs.size() > 1 ? std::min< size_t >( validation_thread_pool_size, trxs.size() - 1 ) : 0;
+   for( size_t i = 0; i < helpers; ++i )
+      validation_ios.post( [batch]() { batch->run(); } );
+
+   batch->run();
+
+   boost::unique_lock< boost::mutex > lock( batch->mtx );
+   while( batch->completed < batch->count )
+      batch->all_done.wait( lock );
+
+   return std::move( batch->results );
+}
+
+std::vector< prevalidated_transaction > chain_plugin_impl::prevalidate_transactions( const signed_transaction& trx )
+{
+   std::vector< prevalidated_transaction > results( 1 );
+
+   try
+   {
+      trx.validate();
+      results[0].signature_keys = trx.get_signature_keys( db.get_chain_id() );
+      results[0].id = trx.id();
+      results[0].valid = true;
+   }
+   catch( ... ) {}
+
+   return results;
+}
+
 } // detail
 
 
@@ -304,6 +556,8 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          ("checkpoint,c", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
          ("flush-state-interval", bpo::value<uint32_t>(),
             "flush shared memory changes to disk every N blocks")
+         ("validation-thread-pool-size", bpo::value<uint32_t>()->default_value(4),
+            "Number of threads that validate and recover the signatures of incoming transactions before they are applied. Setting this to 0 does these checks while holding the write lock." )
          ;
    cli.add_options()
          ("replay-blockchain", bpo::bool_switch()->default_value(false), "clear chain database and replay all blocks" )
@@ -349,6 +603,8 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
    my->check_locks         = options.at( "check-locks" ).as< bool >();
    my->validate_invariants = options.at( "validate-database-invariants" ).as<bool>();
    my->dump_memory_details = options.at( "dump-memory-details" ).as<bool>();
+   my->validation_thread_pool_size = options.at( "validation-thread-pool-size" ).as< uint32_t >();
+
    if( options.count( "flush-state-interval" ) )
       my->flush_interval = options.at( "flush-state-interval" ).as<uint32_t>();
    else
@@ -394,6 +650,7 @@ void chain_plugin::plugin_startup()
    ilog( "Starting chain with shared_file_size: ${n} bytes", ("n", my->shared_memory_size) );
 
    my->start_write_processing();
+   my->start_validation_threads();
 
    if(my->resync)
    {
@@ -531,6 +788,7 @@ void chain_plugin::plugin_shutdown()
 {
    ilog("closing chain database");
    my->stop_write_processing();
+   my->stop_validation_threads();
    my->db.close();
    ilog("database closed successfully");
 }
@@ -552,6 +810,13 @@ bool chain_plugin::accept_block( const steem::chain::signed_block& block, bool c
    cxt.skip = skip;
    cxt.prom_ptr = &prom;
 
+   if( my->validation_thread_pool_size && !( skip & ( database::skip_validate | database::skip_transaction_signatures ) ) )
+   {
+      STATSD_START_TIMER( chain, prevalidate, block, 1.0f )
+      cxt.prevalidated = my->prevalidate_transactions( block.transactions );
+      STATSD_STOP_TIMER( chain, prevalidate, block )
+   }
+
    my->write_queue.push( &cxt );
 
    prom.get_future().get();
@@ -568,6 +833,9 @@ void chain_plugin::accept_transaction( const steem::chain::signed_transaction& t
    cxt.req_ptr = &trx;
    cxt.prom_ptr = &prom;
 
+   if( my->validation_thread_pool_size )
+      cxt.prevalidated = my->prevalidate_transactions( trx );
+
    my->write_queue.push( &cxt );
 
    prom.get_future().get();
@@ -577,6 +845,44 @@ void chain_plugin::accept_transaction( const steem::chain::signed_transaction& t
    return;
 }
 
+std::vector< fc::optional< fc::exception > > chain_plugin::accept_transactions( const std::vector< steem::chain::signed_transaction >& trxs )
+{
+   transaction_batch_request req( trxs );
+   if( trxs.empty() )
+      return req.results;
+
+   // The p2p thread calls this, an fc promise lets its other tasks run while the batch is pushed
+   fc::future< void > fut( fc::promise< void >::ptr( new fc::promise< void >( "chain_plugin::accept_transactions" ) ) );
+   write_context cxt;
+   cxt.req_ptr = &req;
+   cxt.prom_ptr = &fut;
+
+   if( my->validation_thread_pool_size )
+   {
+      STATSD_START_TIMER( chain, prevalidate, transactions, 1.0f )
+      cxt.prevalidated = my->prevalidate_transactions( trxs );
+      STATSD_STOP_TIMER( chain, prevalidate, transactions )
+   }
+
+   my->write_queue.push( &cxt );
+
+   try
+   {
+      fut.wait();
+   }
+   catch( const fc::canceled_exception& )
+   {
+      // The write thread still uses cxt and req, they must outlive the batch
+      while( !fut.ready() )
+         std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+      throw;
+   }
+
+   if( cxt.except ) throw *(cxt.except);
+
+   return std::move( req.results );
+}
+
 steem::chain::signed_block chain_plugin::generate_block(
    const fc::time_point_sec when,
    const account_name_type& witness_owner,
@@ -35,6 +35,15 @@ public:
 
    bool accept_block( const steem::chain::signed_block& block, bool currently_syncing, uint32_t skip );
    void accept_transaction( const steem::chain::signed_transaction& trx );
+
+   /**
+    * Pushes several transactions under a single acquisition of the write lock, or a few if
+    * the batch takes longer than the write lock hold time.
+    * Each transaction is pushed on its own, the result holds the exception that
+    * rejected the transaction at the same position or nothing if it was accepted.
+    * Waits on an fc promise, other tasks of the calling fc thread keep running meanwhile.
+    */
+   std::vector< fc::optional< fc::exception > > accept_transactions( const std::vector< steem::chain::signed_transaction >& trxs );
    steem::chain::signed_block generate_block(
       const fc::time_point_sec when,
       const account_name_type& witness_owner,
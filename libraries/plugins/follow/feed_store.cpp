@@ -0,0 +1,418 @@
+#include <steem/plugins/follow/feed_store.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <boost/container/flat_map.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+namespace steem { namespace plugins { namespace follow {
+
+namespace detail {
+
+struct feed_ring
+{
+   std::vector< feed_store_entry >  entries;
+   uint32_t                         begin = 0;        // Position of the oldest entry once the ring is full
+   uint32_t                         next_feed_id = 0;
+   /// Feed id of every entry by comment, not stored in the file but rebuilt by reindex() on open
+   boost::container::flat_map< int64_t, uint32_t > by_comment;
+
+   uint32_t oldest_feed_id()const { return next_feed_id - entries.size(); }
+
+   uint32_t position( uint32_t feed_id )const
+   {
+      return ( begin + ( feed_id - oldest_feed_id() ) ) % entries.size();
+   }
+
+   const feed_store_entry& at( uint32_t feed_id )const
+   {
+      return entries[ position( feed_id ) ];
+   }
+
+   feed_store_entry* find( int64_t comment )
+   {
+      auto itr = by_comment.find( comment );
+      return itr == by_comment.end() ? nullptr : &entries[ position( itr->second ) ];
+   }
+
+   /** Appends an entry, returns true and the overwritten entry when the ring is full. */
+   bool push( feed_store_entry&& e, uint32_t capacity, feed_store_entry& evicted )
+   {
+      e.account_feed_id = next_feed_id++;
+
+      if( entries.size() < capacity )
+      {
+         by_comment[ e.comment ] = e.account_feed_id;
+         entries.push_back( std::move( e ) );
+         return false;
+      }
+
+      by_comment.erase( entries[ begin ].comment );
+      by_comment[ e.comment ] = e.account_feed_id;
+
+      evicted = std::move( entries[ begin ] );
+      entries[ begin ] = std::move( e );
+      begin = ( begin + 1 ) % entries.size();
+      return true;
+   }
+
+   void pop( const fc::optional< feed_store_entry >& evicted )
+   {
+      --next_feed_id;
+
+      if( evicted.valid() )
+      {
+         begin = ( begin + entries.size() - 1 ) % entries.size();
+         by_comment.erase( entries[ begin ].comment );
+         by_comment[ evicted->comment ] = evicted->account_feed_id;
+         entries[ begin ] = *evicted;
+      }
+      else
+      {
+         by_comment.erase( entries.back().comment );
+         entries.pop_back();
+      }
+   }
+
+   /** Rotates the ring so that the oldest entry is first and keeps at most capacity entries. */
+   void normalize( uint32_t capacity )
+   {
+      std::rotate( entries.begin(), entries.begin() + begin, entries.end() );
+      begin = 0;
+
+      if( entries.size() > capacity )
+         entries.erase( entries.begin(), entries.begin() + ( entries.size() - capacity ) );
+   }
+
+   void reindex()
+   {
+      by_comment.clear();
+      by_comment.reserve( entries.size() );
+
+      for( const auto& e : entries )
+         by_comment[ e.comment ] = e.account_feed_id;
+   }
+};
+
+struct feed_undo_item
+{
+   account_name_type                   account;
+   int64_t                             comment = 0;
+   bool                                reblog = false;   // Reblogger added to an existing entry
+   fc::optional< feed_store_entry >    evicted;
+};
+
+struct feed_undo_block
+{
+   uint32_t                            block_num = 0;
+   block_id_type                       block_id;
+   std::vector< feed_undo_item >       items;
+};
+
+struct feed_store_state
+{
+   uint32_t                                        max_feed_size = 0;
+   uint32_t                                        head_block_num = 0;
+   block_id_type                                   head_block_id;
+   std::map< account_name_type, feed_ring >        rings;
+   std::deque< feed_undo_block >                   undo;
+};
+
+} } } } // steem::plugins::follow::detail
+
+FC_REFLECT( steem::plugins::follow::detail::feed_ring, (entries)(begin)(next_feed_id) )
+FC_REFLECT( steem::plugins::follow::detail::feed_undo_item, (account)(comment)(reblog)(evicted) )
+FC_REFLECT( steem::plugins::follow::detail::feed_undo_block, (block_num)(block_id)(items) )
+FC_REFLECT( steem::plugins::follow::detail::feed_store_state, (max_feed_size)(head_block_num)(head_block_id)(rings)(undo) )
+
+namespace steem { namespace plugins { namespace follow {
+
+namespace detail {
+
+class feed_store_impl
+{
+   public:
+      void undo_block();
+      void apply_event( const feed_event& e, feed_undo_block& undo );
+
+      fc::path                      _file;
+      bool                          _is_open = false;
+      bool                          _is_valid = true;
+      feed_store_state              _state;
+      mutable boost::shared_mutex   _mutex;
+};
+
+void feed_store_impl::undo_block()
+{
+   const auto& block = _state.undo.back();
+   uint32_t block_num = block.block_num;
+
+   for( auto itr = block.items.rbegin(); itr != block.items.rend(); ++itr )
+   {
+      auto& ring = _state.rings[ itr->account ];
+
+      if( itr->reblog )
+      {
+         auto* entry = ring.find( itr->comment );
+         FC_ASSERT( entry != nullptr && entry->reblogged_by.size(), "Feed undo journal does not match feed of ${a}", ("a", itr->account) );
+         entry->reblogged_by.pop_back();
+      }
+      else
+      {
+         ring.pop( itr->evicted );
+      }
+   }
+
+   _state.undo.pop_back();
+
+   if( _state.undo.size() )
+   {
+      _state.head_block_num = _state.undo.back().block_num;
+      _state.head_block_id = _state.undo.back().block_id;
+   }
+   else
+   {
+      _state.head_block_num = block_num - 1;
+      _state.head_block_id = block_id_type();
+   }
+}
+
+void feed_store_impl::apply_event( const feed_event& e, feed_undo_block& undo )
+{
+   feed_undo_item item;
+   item.comment = e.comment;
+
+   for( const auto& follower : e.followers )
+   {
+      auto& ring = _state.rings[ follower ];
+      auto* existing = ring.find( e.comment );
+
+      item.account = follower;
+      item.evicted.reset();
+
+      if( existing != nullptr )
+      {
+         // A post is only added once, subsequent reblogs are recorded on the existing entry
+         if( e.reblogged_by == account_name_type() )
+            continue;
+
+         existing->reblogged_by.push_back( e.reblogged_by );
+         item.reblog = true;
+      }
+      else
+      {
+         feed_store_entry entry;
+         entry.comment = e.comment;
+
+         if( e.reblogged_by != account_name_type() )
+         {
+            entry.reblogged_by.push_back( e.reblogged_by );
+            entry.first_reblogged_on = e.time;
+         }
+
+         feed_store_entry evicted;
+         if( ring.push( std::move( entry ), _state.max_feed_size, evicted ) )
+            item.evicted = std::move( evicted );
+
+         item.reblog = false;
+      }
+
+      undo.items.push_back( item );
+   }
+}
+
+} // detail
+
+feed_store::feed_store() : my( new detail::feed_store_impl() ) {}
+
+feed_store::~feed_store()
+{
+   close();
+}
+
+void feed_store::open( const fc::path& file, uint32_t max_feed_size )
+{
+   boost::unique_lock< boost::shared_mutex > lock( my->_mutex );
+
+   FC_ASSERT( !my->_is_open, "Feed store is already open" );
+   FC_ASSERT( max_feed_size > 0, "Feed size must be positive" );
+
+   my->_file = file;
+   my->_state = detail::feed_store_state();
+
+   if( fc::exists( file ) )
+   {
+      std::ifstream in( file.generic_string(), std::ios::binary );
+      std::vector< char > data( ( std::istreambuf_iterator< char >( in ) ), std::istreambuf_iterator< char >() );
+
+      try
+      {
+         my->_state = fc::raw::unpack_from_vector< detail::feed_store_state >( data );
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "Could not read feed store ${f}, starting with empty feeds: ${e}", ("f", file)("e", e.to_detail_string()) );
+         my->_state = detail::feed_store_state();
+      }
+
+      if( my->_state.max_feed_size != 0 && my->_state.max_feed_size != max_feed_size )
+      {
+         // Journaled positions are meaningless once rings are resized, the reversible blocks can no longer be undone.
+         for( auto& r : my->_state.rings )
+            r.second.normalize( max_feed_size );
+
+         my->_state.undo.clear();
+      }
+
+      for( auto& r : my->_state.rings )
+         r.second.reindex();
+   }
+   else if( file.parent_path().string().size() )
+   {
+      fc::create_directories( file.parent_path() );
+   }
+
+   my->_state.max_feed_size = max_feed_size;
+   my->_is_open = true;
+   my->_is_valid = true;
+}
+
+void feed_store::close()
+{
+   boost::unique_lock< boost::shared_mutex > lock( my->_mutex );
+
+   if( !my->_is_open )
+      return;
+
+   if( !my->_is_valid )
+   {
+      // Opening the store again finds no file and starts empty, the plugin then discards it
+      if( fc::exists( my->_file ) )
+         fc::remove( my->_file );
+
+      my->_state = detail::feed_store_state();
+      my->_is_open = false;
+      return;
+   }
+
+   fc::path tmp = my->_file.generic_string() + ".tmp";
+
+   {
+      std::ofstream out( tmp.generic_string(), std::ios::binary | std::ios::trunc );
+      auto data = fc::raw::pack_to_vector( my->_state );
+      out.write( data.data(), data.size() );
+      FC_ASSERT( out.good(), "Could not write feed store ${f}", ("f", tmp) );
+   }
+
+   fc::rename( tmp, my->_file );
+
+   my->_state = detail::feed_store_state();
+   my->_is_open = false;
+}
+
+bool feed_store::is_open()const
+{
+   boost::shared_lock< boost::shared_mutex > lock( my->_mutex );
+   return my->_is_open;
+}
+
+void feed_store::wipe()
+{
+   boost::unique_lock< boost::shared_mutex > lock( my->_mutex );
+
+   auto max_feed_size = my->_state.max_feed_size;
+   my->_state = detail::feed_store_state();
+   my->_state.max_feed_size = max_feed_size;
+   my->_is_valid = true;
+}
+
+void feed_store::invalidate()
+{
+   boost::unique_lock< boost::shared_mutex > lock( my->_mutex );
+
+   auto max_feed_size = my->_state.max_feed_size;
+   my->_state = detail::feed_store_state();
+   my->_state.max_feed_size = max_feed_size;
+   my->_is_valid = false;
+}
+
+bool feed_store::is_valid()const
+{
+   boost::shared_lock< boost::shared_mutex > lock( my->_mutex );
+   return my->_is_valid;
+}
+
+uint32_t feed_store::head_block_num()const
+{
+   boost::shared_lock< boost::shared_mutex > lock( my->_mutex );
+   return my->_state.head_block_num;
+}
+
+block_id_type feed_store::head_block_id()const
+{
+   boost::shared_lock< boost::shared_mutex > lock( my->_mutex );
+   return my->_state.head_block_id;
+}
+
+void feed_store::apply_block( const feed_block& block )
+{
+   boost::unique_lock< boost::shared_mutex > lock( my->_mutex );
+   auto& state = my->_state;
+
+   FC_ASSERT( my->_is_open, "Feed store is not open" );
+
+   if( !my->_is_valid )
+      return;
+
+   while( state.undo.size() && state.undo.back().block_num >= block.block_num )
+      my->undo_block();
+
+   if( block.block_num <= state.head_block_num )
+   {
+      wlog( "Cannot undo feeds to block ${b}, feed store head is ${h}", ("b", block.block_num)("h", state.head_block_num) );
+   }
+
+   detail::feed_undo_block undo;
+   undo.block_num = block.block_num;
+   undo.block_id = block.block_id;
+
+   for( const auto& e : block.events )
+      my->apply_event( e, undo );
+
+   state.head_block_num = block.block_num;
+   state.head_block_id = block.block_id;
+
+   if( block.block_num > block.last_irreversible_block )
+      state.undo.push_back( std::move( undo ) );
+
+   while( state.undo.size() && state.undo.front().block_num <= block.last_irreversible_block )
+      state.undo.pop_front();
+}
+
+void feed_store::find_feed( const account_name_type& account, uint32_t start_entry_id, uint32_t limit,
+   std::function< bool( const feed_store_entry& ) > processor )const
+{
+   boost::shared_lock< boost::shared_mutex > lock( my->_mutex );
+
+   auto itr = my->_state.rings.find( account );
+   if( itr == my->_state.rings.end() || itr->second.entries.empty() )
+      return;
+
+   const auto& ring = itr->second;
+   int64_t feed_id = std::min< int64_t >( start_entry_id, int64_t( ring.next_feed_id ) - 1 );
+   uint32_t accepted = 0;
+
+   for( ; feed_id >= int64_t( ring.oldest_feed_id() ) && accepted < limit; --feed_id )
+   {
+      if( processor( ring.at( uint32_t( feed_id ) ) ) )
+         ++accepted;
+   }
+}
+
+} } } // steem::plugins::follow
@@ -69,6 +69,10 @@ void follow_evaluator::do_apply( const follow_operation& o )
          });
       }
 
+      // Follow counts are rebuilt from the follow graph once the reindex is done
+      if( _plugin->in_reindex_fast_path() )
+         return;
+
       const auto& follower = _db.find< follow_count_object, by_account >( o.follower );
 
       if( follower == nullptr )
@@ -163,53 +167,60 @@ void reblog_evaluator::do_apply( const reblog_operation& o )
          });
       }
 
-      const auto& comment_idx = _db.get_index< feed_index >().indices().get< by_comment >();
-      const auto& idx = _db.get_index< follow_index >().indices().get< by_following_follower >();
-      const auto& old_feed_idx = _db.get_index< feed_index >().indices().get< by_feed >();
-      auto itr = idx.find( o.account );
-
-      performance_data pd;
-
       if( _db.head_block_time() >= _plugin->start_feeds )
       {
-         while( itr != idx.end() && itr->following == o.account )
+         if( _plugin->get_feed_store() )
          {
-            if( itr->what & ( 1 << blog ) )
-            {
-               auto feed_itr = comment_idx.find( boost::make_tuple( c.id, itr->follower ) );
-               bool is_empty = feed_itr == comment_idx.end();
+            _plugin->queue_feed_event( o.account, c.id, true );
+         }
+         else
+         {
+            const auto& comment_idx = _db.get_index< feed_index >().indices().get< by_comment >();
+            const auto& idx = _db.get_index< follow_index >().indices().get< by_following_follower >();
+            const auto& old_feed_idx = _db.get_index< feed_index >().indices().get< by_feed >();
+            auto itr = idx.find( o.account );
 
-               pd.init( o.account, _db.head_block_time(), c.id, is_empty, is_empty ? 0 : feed_itr->account_feed_id );
-               uint32_t next_id = perf.delete_old_objects< performance_data::t_creation_type::full_feed >( old_feed_idx, itr->follower, _plugin->max_feed_size, pd );
+            performance_data pd;
 
-               if( pd.s.creation )
+            while( itr != idx.end() && itr->following == o.account )
+            {
+               if( itr->what & ( 1 << blog ) )
                {
-                  if( is_empty )
-                  {
-                     _db.create< feed_object >( [&]( feed_object& f )
-                     {
-                        f.account = itr->follower;
-                        f.reblogged_by.push_back( o.account );
-                        f.first_reblogged_by = o.account;
-                        f.first_reblogged_on = _db.head_block_time();
-                        f.comment = c.id;
-                        f.account_feed_id = next_id;
-                     });
-                  }
-                  else
+                  auto feed_itr = comment_idx.find( boost::make_tuple( c.id, itr->follower ) );
+                  bool is_empty = feed_itr == comment_idx.end();
+
+                  pd.init( o.account, _db.head_block_time(), c.id, is_empty, is_empty ? 0 : feed_itr->account_feed_id );
+                  uint32_t next_id = perf.delete_old_objects< performance_data::t_creation_type::full_feed >( old_feed_idx, itr->follower, _plugin->max_feed_size, pd );
+
+                  if( pd.s.creation )
                   {
-                     if( pd.s.allow_modify )
+                     if( is_empty )
                      {
-                        _db.modify( *feed_itr, [&]( feed_object& f )
+                        _db.create< feed_object >( [&]( feed_object& f )
                         {
+                           f.account = itr->follower;
                            f.reblogged_by.push_back( o.account );
+                           f.first_reblogged_by = o.account;
+                           f.first_reblogged_on = _db.head_block_time();
+                           f.comment = c.id;
+                           f.account_feed_id = next_id;
                         });
                      }
+                     else
+                     {
+                        if( pd.s.allow_modify )
+                        {
+                           _db.modify( *feed_itr, [&]( feed_object& f )
+                           {
+                              f.reblogged_by.push_back( o.account );
+                           });
+                        }
+                     }
                   }
-               }
 
+               }
+               ++itr;
             }
-            ++itr;
          }
       }
    }
@@ -1,4 +1,5 @@
 #include <steem/plugins/follow/follow_plugin.hpp>
+#include <steem/plugins/follow/feed_store.hpp>
 #include <steem/plugins/follow/follow_objects.hpp>
 #include <steem/plugins/follow/follow_operations.hpp>
 #include <steem/plugins/follow/inc_performance.hpp>
@@ -8,6 +9,7 @@
 #include <steem/protocol/config.hpp>
 
 #include <steem/chain/database.hpp>
+#include <steem/chain/block_notification.hpp>
 #include <steem/chain/index.hpp>
 #include <steem/chain/operation_notification.hpp>
 #include <steem/chain/account_object.hpp>
@@ -16,6 +18,12 @@
 #include <fc/smart_ref_impl.hpp>
 #include <fc/thread/thread.hpp>
 
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <deque>
+#include <map>
 #include <memory>
 
 namespace steem { namespace plugins { namespace follow {
@@ -35,10 +43,55 @@ class follow_plugin_impl
       void pre_operation( const operation_notification& op_obj );
       void post_operation( const operation_notification& op_obj );
 
+      /** Reputation of an account, nullptr if it has no reputation object. */
+      const share_type* find_reputation( const account_name_type& account )const;
+      void set_reputation( const account_name_type& account, share_type reputation );
+      void remove_reputation( const account_name_type& account );
+
+      void on_pre_reindex( const chain::reindex_notification& note );
+      void on_post_reindex( const chain::reindex_notification& note );
+      void flush_reputation_cache();
+      void rebuild_follow_counts();
+
+      void queue_feed_event( const account_name_type& poster, comment_id_type comment, bool reblog );
+      void on_pre_apply_block( const block_notification& note );
+      void on_post_apply_block( const block_notification& note );
+
+      void start_feed_thread();
+      void stop_feed_thread();
+      void wait_for_feed_thread();
+      void feed_thread_main();
+
       chain::database&     _db;
       follow_plugin&                _self;
       boost::signals2::connection   _pre_apply_operation_conn;
       boost::signals2::connection   _post_apply_operation_conn;
+      boost::signals2::connection   _pre_apply_block_conn;
+      boost::signals2::connection   _post_apply_block_conn;
+      boost::signals2::connection   _pre_reindex_conn;
+      boost::signals2::connection   _reindex_fast_path_pre_conn;
+      boost::signals2::connection   _reindex_fast_path_post_conn;
+
+      bool                          _reindex_fast_path = true;
+      bool                          _reindexing = false;
+
+      /// Reputation changes during a reindex, an empty optional marks a removed reputation object
+      std::map< account_name_type, fc::optional< share_type > >
+                                    _reputation_cache;
+
+      std::unique_ptr< feed_store > _feed_store;
+      boost::filesystem::path       _feed_store_file;
+      feed_block                    _current_feed_block;
+
+      size_t                        _max_feed_queue_size = 1000;
+      std::deque< std::shared_ptr< feed_block > >
+                                    _feed_queue;
+      bool                          _feed_thread_busy = false;
+      bool                          _feed_thread_stop = false;
+      boost::mutex                  _feed_queue_mutex;
+      boost::condition_variable     _feed_queue_cond;
+      std::shared_ptr< boost::thread >
+                                    _feed_thread;
 };
 
 struct pre_operation_visitor
@@ -69,28 +122,24 @@ struct pre_operation_visitor
          {
             auto rep_delta = ( cv->rshares >> 6 );
 
-            const auto& rep_idx = db.get_index< reputation_index >().indices().get< by_account >();
-            auto voter_rep = rep_idx.find( op.voter );
-            auto author_rep = rep_idx.find( op.author );
+            const share_type* voter_rep = _plugin.find_reputation( op.voter );
+            const share_type* author_rep = _plugin.find_reputation( op.author );
 
-            if( author_rep != rep_idx.end() )
+            if( author_rep != nullptr )
             {
                // Rule #1: Must have non-negative reputation to effect another user's reputation
-               if( voter_rep != rep_idx.end() && voter_rep->reputation < 0 ) return;
+               if( voter_rep != nullptr && *voter_rep < 0 ) return;
 
                // Rule #2: If you are down voting another user, you must have more reputation than them to impact their reputation
-               if( cv->rshares < 0 && !( voter_rep != rep_idx.end() && voter_rep->reputation > author_rep->reputation - rep_delta ) ) return;
+               if( cv->rshares < 0 && !( voter_rep != nullptr && *voter_rep > *author_rep - rep_delta ) ) return;
 
-               if( rep_delta == author_rep->reputation )
+               if( rep_delta == *author_rep )
                {
-                  db.remove( *author_rep );
+                  _plugin.remove_reputation( op.author );
                }
                else
                {
-                  db.modify( *author_rep, [&]( reputation_object& r )
-                  {
-                     r.reputation -= ( cv->rshares >> 6 ); // Shift away precision from vests. It is noise
-                  });
+                  _plugin.set_reputation( op.author, *author_rep - ( cv->rshares >> 6 ) ); // Shift away precision from vests. It is noise
                }
             }
          }
@@ -187,37 +236,44 @@ struct post_operation_visitor
 
          if( c.created != db.head_block_time() ) return;
 
-         const auto& idx = db.get_index< follow_index >().indices().get< by_following_follower >();
-         const auto& comment_idx = db.get_index< feed_index >().indices().get< by_comment >();
-         const auto& old_feed_idx = db.get_index< feed_index >().indices().get< by_feed >();
-         auto itr = idx.find( op.author );
-
          performance_data pd;
 
          if( db.head_block_time() >= _plugin._self.start_feeds )
          {
-            while( itr != idx.end() && itr->following == op.author )
+            if( _plugin._feed_store )
+            {
+               _plugin.queue_feed_event( op.author, c.id, false );
+            }
+            else
             {
-               if( itr->what & ( 1 << blog ) )
+               const auto& idx = db.get_index< follow_index >().indices().get< by_following_follower >();
+               const auto& comment_idx = db.get_index< feed_index >().indices().get< by_comment >();
+               const auto& old_feed_idx = db.get_index< feed_index >().indices().get< by_feed >();
+               auto itr = idx.find( op.author );
+
+               while( itr != idx.end() && itr->following == op.author )
                {
-                  auto feed_itr = comment_idx.find( boost::make_tuple( c.id, itr->follower ) );
-                  bool is_empty = feed_itr == comment_idx.end();
+                  if( itr->what & ( 1 << blog ) )
+                  {
+                     auto feed_itr = comment_idx.find( boost::make_tuple( c.id, itr->follower ) );
+                     bool is_empty = feed_itr == comment_idx.end();
 
-                  pd.init( c.id, is_empty );
-                  uint32_t next_id = perf.delete_old_objects< performance_data::t_creation_type::part_feed >( old_feed_idx, itr->follower, _plugin._self.max_feed_size, pd );
+                     pd.init( c.id, is_empty );
+                     uint32_t next_id = perf.delete_old_objects< performance_data::t_creation_type::part_feed >( old_feed_idx, itr->follower, _plugin._self.max_feed_size, pd );
 
-                  if( pd.s.creation && is_empty )
-                  {
-                     db.create< feed_object >( [&]( feed_object& f )
+                     if( pd.s.creation && is_empty )
                      {
-                        f.account = itr->follower;
-                        f.comment = c.id;
-                        f.account_feed_id = next_id;
-                     });
-                  }
+                        db.create< feed_object >( [&]( feed_object& f )
+                        {
+                           f.account = itr->follower;
+                           f.comment = c.id;
+                           f.account_feed_id = next_id;
+                        });
+                     }
 
+                  }
+                  ++itr;
                }
-               ++itr;
             }
          }
 
@@ -255,35 +311,27 @@ struct post_operation_visitor
          const auto& cv_idx = db.get_index< comment_vote_index >().indices().get< by_comment_voter >();
          auto cv = cv_idx.find( boost::make_tuple( comment.id, db.get_account( op.voter ).id ) );
 
-         const auto& rep_idx = db.get_index< reputation_index >().indices().get< by_account >();
-         auto voter_rep = rep_idx.find( op.voter );
-         auto author_rep = rep_idx.find( op.author );
+         const share_type* voter_rep = _plugin.find_reputation( op.voter );
+         const share_type* author_rep = _plugin.find_reputation( op.author );
 
          // Rules are a plugin, do not effect consensus, and are subject to change.
          // Rule #1: Must have non-negative reputation to effect another user's reputation
-         if( voter_rep != rep_idx.end() && voter_rep->reputation < 0 ) return;
+         if( voter_rep != nullptr && *voter_rep < 0 ) return;
 
-         if( author_rep == rep_idx.end() )
+         if( author_rep == nullptr )
          {
             // Rule #2: If you are down voting another user, you must have more reputation than them to impact their reputation
             // User rep is 0, so requires voter having positive rep
-            if( cv->rshares < 0 && !( voter_rep != rep_idx.end() && voter_rep->reputation > 0 )) return;
+            if( cv->rshares < 0 && !( voter_rep != nullptr && *voter_rep > 0 )) return;
 
-            db.create< reputation_object >( [&]( reputation_object& r )
-            {
-               r.account = op.author;
-               r.reputation = ( cv->rshares >> 6 ); // Shift away precision from vests. It is noise
-            });
+            _plugin.set_reputation( op.author, ( cv->rshares >> 6 ) ); // Shift away precision from vests. It is noise
          }
          else
          {
             // Rule #2: If you are down voting another user, you must have more reputation than them to impact their reputation
-            if( cv->rshares < 0 && !( voter_rep != rep_idx.end() && voter_rep->reputation > author_rep->reputation ) ) return;
+            if( cv->rshares < 0 && !( voter_rep != nullptr && *voter_rep > *author_rep ) ) return;
 
-            db.modify( *author_rep, [&]( reputation_object& r )
-            {
-               r.reputation += ( cv->rshares >> 6 ); // Shift away precision from vests. It is noise
-            });
+            _plugin.set_reputation( op.author, *author_rep + ( cv->rshares >> 6 ) ); // Shift away precision from vests. It is noise
          }
       }
       FC_CAPTURE_AND_RETHROW()
@@ -314,6 +362,328 @@ void follow_plugin_impl::post_operation( const operation_notification& note )
    }
 }
 
+const share_type* follow_plugin_impl::find_reputation( const account_name_type& account )const
+{
+   if( _reindexing )
+   {
+      auto itr = _reputation_cache.find( account );
+      if( itr != _reputation_cache.end() )
+         return itr->second.valid() ? &( *itr->second ) : nullptr;
+   }
+
+   const auto* rep = _db.find< reputation_object, by_account >( account );
+   return rep != nullptr ? &rep->reputation : nullptr;
+}
+
+void follow_plugin_impl::set_reputation( const account_name_type& account, share_type reputation )
+{
+   if( _reindexing )
+   {
+      _reputation_cache[ account ] = reputation;
+      return;
+   }
+
+   const auto* rep = _db.find< reputation_object, by_account >( account );
+
+   if( rep == nullptr )
+   {
+      _db.create< reputation_object >( [&]( reputation_object& r )
+      {
+         r.account = account;
+         r.reputation = reputation;
+      });
+   }
+   else
+   {
+      _db.modify( *rep, [&]( reputation_object& r )
+      {
+         r.reputation = reputation;
+      });
+   }
+}
+
+void follow_plugin_impl::remove_reputation( const account_name_type& account )
+{
+   if( _reindexing )
+   {
+      _reputation_cache[ account ].reset();
+      return;
+   }
+
+   const auto* rep = _db.find< reputation_object, by_account >( account );
+   if( rep != nullptr )
+      _db.remove( *rep );
+}
+
+void follow_plugin_impl::on_pre_reindex( const chain::reindex_notification& note )
+{
+   _reputation_cache.clear();
+   _reindexing = true;
+}
+
+void follow_plugin_impl::on_post_reindex( const chain::reindex_notification& note )
+{
+   if( !_reindexing ) return;
+
+   auto start = fc::time_point::now();
+
+   _db.with_write_lock( [&]()
+   {
+      flush_reputation_cache();
+      rebuild_follow_counts();
+   });
+
+   _reindexing = false;
+
+   ilog( "Follow: applied reputation and follow counts of reindex in ${t} ms",
+      ("t", ( fc::time_point::now() - start ).count() / 1000) );
+}
+
+void follow_plugin_impl::flush_reputation_cache()
+{
+   const auto& rep_idx = _db.get_index< reputation_index >().indices().get< by_account >();
+   auto rep_itr = rep_idx.begin();
+
+   // Both containers are ordered by account, a single merge pass applies all changes
+   for( const auto& entry : _reputation_cache )
+   {
+      while( rep_itr != rep_idx.end() && rep_itr->account < entry.first )
+         ++rep_itr;
+
+      bool exists = rep_itr != rep_idx.end() && rep_itr->account == entry.first;
+
+      if( !entry.second.valid() )
+      {
+         if( exists )
+         {
+            const auto& old_rep = *rep_itr;
+            ++rep_itr;
+            _db.remove( old_rep );
+         }
+      }
+      else if( exists )
+      {
+         _db.modify( *rep_itr, [&]( reputation_object& r )
+         {
+            r.reputation = *entry.second;
+         });
+      }
+      else
+      {
+         _db.create< reputation_object >( [&]( reputation_object& r )
+         {
+            r.account = entry.first;
+            r.reputation = *entry.second;
+         });
+      }
+   }
+
+   _reputation_cache.clear();
+}
+
+namespace {
+
+/**
+ * Counts follow objects with the blog flag per account of the index key prefix. Every account in
+ * the index gets an entry, mirroring the follow_count_object created by follow_evaluator.
+ */
+template< typename Index, typename KeyGetter >
+void count_blog_follows( const Index& idx, KeyGetter key, std::vector< std::pair< account_name_type, uint32_t > >& counts )
+{
+   for( auto itr = idx.begin(); itr != idx.end(); ++itr )
+   {
+      const auto& account = key( *itr );
+
+      if( counts.empty() || counts.back().first != account )
+         counts.emplace_back( account, 0 );
+
+      if( itr->what & ( 1 << blog ) )
+         ++counts.back().second;
+   }
+}
+
+}
+
+void follow_plugin_impl::rebuild_follow_counts()
+{
+   std::vector< std::pair< account_name_type, uint32_t > > follower_counts;
+   std::vector< std::pair< account_name_type, uint32_t > > following_counts;
+
+   const auto& following_idx = _db.get_index< follow_index >().indices().get< by_following_follower >();
+   const auto& follower_idx = _db.get_index< follow_index >().indices().get< by_follower_following >();
+
+   // The follow graph is final at this point, both directions are counted concurrently (read only)
+   boost::thread follower_thread( [&]()
+   {
+      count_blog_follows( following_idx, []( const follow_object& f ) -> const account_name_type& { return f.following; }, follower_counts );
+   });
+
+   count_blog_follows( follower_idx, []( const follow_object& f ) -> const account_name_type& { return f.follower; }, following_counts );
+   follower_thread.join();
+
+   const auto& count_idx = _db.get_index< follow_count_index >().indices().get< by_account >();
+   auto follower_itr = follower_counts.begin();
+   auto following_itr = following_counts.begin();
+
+   while( follower_itr != follower_counts.end() || following_itr != following_counts.end() )
+   {
+      account_name_type account;
+
+      if( following_itr == following_counts.end() || ( follower_itr != follower_counts.end() && follower_itr->first < following_itr->first ) )
+         account = follower_itr->first;
+      else
+         account = following_itr->first;
+
+      uint32_t follower_count = 0;
+      uint32_t following_count = 0;
+
+      if( follower_itr != follower_counts.end() && follower_itr->first == account )
+         follower_count = ( follower_itr++ )->second;
+
+      if( following_itr != following_counts.end() && following_itr->first == account )
+         following_count = ( following_itr++ )->second;
+
+      auto count_itr = count_idx.find( account );
+
+      if( count_itr == count_idx.end() )
+      {
+         _db.create< follow_count_object >( [&]( follow_count_object& obj )
+         {
+            obj.account = account;
+            obj.follower_count = follower_count;
+            obj.following_count = following_count;
+         });
+      }
+      else
+      {
+         _db.modify( *count_itr, [&]( follow_count_object& obj )
+         {
+            obj.follower_count = follower_count;
+            obj.following_count = following_count;
+         });
+      }
+   }
+}
+
+void follow_plugin_impl::queue_feed_event( const account_name_type& poster, comment_id_type comment, bool reblog )
+{
+   // Pending transactions are not fanned out, their operations are applied again with the block
+   if( !_db.is_processing_block() ) return;
+
+   feed_event e;
+   e.comment = comment._id;
+   e.time = _db.head_block_time();
+
+   if( reblog )
+      e.reblogged_by = poster;
+
+   const auto& idx = _db.get_index< follow_index >().indices().get< by_following_follower >();
+   auto itr = idx.find( poster );
+
+   while( itr != idx.end() && itr->following == poster )
+   {
+      if( itr->what & ( 1 << blog ) )
+         e.followers.push_back( itr->follower );
+
+      ++itr;
+   }
+
+   if( e.followers.size() )
+      _current_feed_block.events.push_back( std::move( e ) );
+}
+
+void follow_plugin_impl::on_pre_apply_block( const block_notification& note )
+{
+   _current_feed_block.events.clear();
+}
+
+void follow_plugin_impl::on_post_apply_block( const block_notification& note )
+{
+   auto block = std::make_shared< feed_block >();
+   block->block_num = note.block_num;
+   block->block_id = note.block_id;
+   block->last_irreversible_block = _db.get_dynamic_global_properties().last_irreversible_block_num;
+   block->events = std::move( _current_feed_block.events );
+   _current_feed_block.events.clear();
+
+   boost::unique_lock< boost::mutex > lock( _feed_queue_mutex );
+
+   // Block application waits when the feed thread falls too far behind, for instance during a reindex
+   while( _feed_queue.size() >= _max_feed_queue_size && !_feed_thread_stop )
+      _feed_queue_cond.wait( lock );
+
+   _feed_queue.push_back( block );
+   _feed_queue_cond.notify_all();
+}
+
+void follow_plugin_impl::start_feed_thread()
+{
+   _feed_thread_stop = false;
+   _feed_thread = std::make_shared< boost::thread >( [this]() { feed_thread_main(); } );
+}
+
+void follow_plugin_impl::stop_feed_thread()
+{
+   if( !_feed_thread ) return;
+
+   {
+      boost::unique_lock< boost::mutex > lock( _feed_queue_mutex );
+      _feed_thread_stop = true;
+      _feed_queue_cond.notify_all();
+   }
+
+   _feed_thread->join();
+   _feed_thread.reset();
+}
+
+void follow_plugin_impl::wait_for_feed_thread()
+{
+   boost::unique_lock< boost::mutex > lock( _feed_queue_mutex );
+
+   while( _feed_queue.size() || _feed_thread_busy )
+      _feed_queue_cond.wait( lock );
+}
+
+void follow_plugin_impl::feed_thread_main()
+{
+   while( true )
+   {
+      std::shared_ptr< feed_block > block;
+
+      {
+         boost::unique_lock< boost::mutex > lock( _feed_queue_mutex );
+
+         while( _feed_queue.empty() && !_feed_thread_stop )
+            _feed_queue_cond.wait( lock );
+
+         // Remaining blocks are applied before stopping so that the store matches the chain state
+         if( _feed_queue.empty() )
+            break;
+
+         block = _feed_queue.front();
+         _feed_queue.pop_front();
+         _feed_thread_busy = true;
+         _feed_queue_cond.notify_all();
+      }
+
+      try
+      {
+         _feed_store->apply_block( *block );
+      }
+      catch( const fc::exception& e )
+      {
+         // Later blocks would build on feeds that no longer match the chain state
+         elog( "Error applying block ${b} to the feed store, discarding the feeds. Replay the chain to rebuild them: ${e}",
+            ("b", block->block_num)("e", e.to_detail_string()) );
+         _feed_store->invalidate();
+      }
+
+      boost::unique_lock< boost::mutex > lock( _feed_queue_mutex );
+      _feed_thread_busy = false;
+      _feed_queue_cond.notify_all();
+   }
+}
+
 } // detail
 
 follow_plugin::follow_plugin() {}
@@ -328,6 +698,9 @@ void follow_plugin::set_program_options(
    cfg.add_options()
       ("follow-max-feed-size", boost::program_options::value< uint32_t >()->default_value( 500 ), "Set the maximum size of cached feed for an account" )
       ("follow-start-feeds", boost::program_options::value< uint32_t >()->default_value( 0 ), "Block time (in epoch seconds) when to start calculating feeds" )
+      ("follow-reindex-fast-path", boost::program_options::value< bool >()->default_value( true ), "Keep reputation changes in memory and rebuild follow counts from the follow graph once a reindex is done" )
+      ("follow-feed-storage", boost::program_options::value< string >()->default_value( "chainbase" ), "Where feeds are stored: 'chainbase' or 'ring' (per account ring buffers outside of chainbase, filled asynchronously)" )
+      ("follow-feed-store-file", boost::program_options::value< boost::filesystem::path >()->default_value( "blockchain/follow-feeds" ), "The location of the feed store file when follow-feed-storage is 'ring' (absolute path or relative to application data dir)" )
       ;
 }
 
@@ -369,16 +742,98 @@ void follow_plugin::plugin_initialize( const boost::program_options::variables_m
       {
          start_feeds = fc::time_point_sec( options[ "follow-start-feeds" ].as< uint32_t >() );
       }
+
+      if( options.count( "follow-reindex-fast-path" ) )
+      {
+         my->_reindex_fast_path = options.at( "follow-reindex-fast-path" ).as< bool >();
+      }
+
+      if( my->_reindex_fast_path )
+      {
+         my->_reindex_fast_path_pre_conn = my->_db.add_pre_reindex_handler(
+            [&]( const chain::reindex_notification& note ){ my->on_pre_reindex( note ); }, *this, 0 );
+         my->_reindex_fast_path_post_conn = my->_db.add_post_reindex_handler(
+            [&]( const chain::reindex_notification& note ){ my->on_post_reindex( note ); }, *this, 0 );
+      }
+
+      if( options.count( "follow-feed-storage" ) )
+      {
+         const auto& storage = options.at( "follow-feed-storage" ).as< string >();
+         FC_ASSERT( storage == "chainbase" || storage == "ring", "Unknown feed storage ${s}", ("s", storage) );
+
+         if( storage == "ring" )
+         {
+            my->_feed_store_file = options.at( "follow-feed-store-file" ).as< boost::filesystem::path >();
+            if( my->_feed_store_file.is_relative() )
+               my->_feed_store_file = appbase::app().data_dir() / my->_feed_store_file;
+
+            my->_feed_store = std::make_unique< feed_store >();
+            my->_feed_store->open( my->_feed_store_file, max_feed_size );
+            my->start_feed_thread();
+
+            my->_pre_apply_block_conn = my->_db.add_pre_apply_block_handler(
+               [&]( const block_notification& note ){ my->on_pre_apply_block( note ); }, *this, 0 );
+            my->_post_apply_block_conn = my->_db.add_post_apply_block_handler(
+               [&]( const block_notification& note ){ my->on_post_apply_block( note ); }, *this, 0 );
+            my->_pre_reindex_conn = my->_db.add_pre_reindex_handler(
+               [&]( const chain::reindex_notification& )
+               {
+                  my->wait_for_feed_thread();
+                  my->_feed_store->wipe();
+               }, *this, 0 );
+         }
+      }
    }
    FC_CAPTURE_AND_RETHROW()
 }
 
-void follow_plugin::plugin_startup() {}
+void follow_plugin::plugin_startup()
+{
+   if( my->_feed_store )
+   {
+      my->wait_for_feed_thread();
+
+      if( my->_feed_store->head_block_id() != my->_db.head_block_id() )
+      {
+         wlog( "Follow feed store does not match the chain state (store head ${s}, chain head ${h}), discarding it. "
+               "Replay the chain to rebuild feeds of past blocks.",
+            ("s", my->_feed_store->head_block_num())("h", my->_db.head_block_num()) );
+         my->_feed_store->wipe();
+      }
+   }
+}
 
 void follow_plugin::plugin_shutdown()
 {
    chain::util::disconnect_signal( my->_pre_apply_operation_conn );
    chain::util::disconnect_signal( my->_post_apply_operation_conn );
+   chain::util::disconnect_signal( my->_reindex_fast_path_pre_conn );
+   chain::util::disconnect_signal( my->_reindex_fast_path_post_conn );
+
+   if( my->_feed_store )
+   {
+      chain::util::disconnect_signal( my->_pre_apply_block_conn );
+      chain::util::disconnect_signal( my->_post_apply_block_conn );
+      chain::util::disconnect_signal( my->_pre_reindex_conn );
+
+      my->stop_feed_thread();
+      my->_feed_store->close();
+   }
+}
+
+bool follow_plugin::in_reindex_fast_path()const
+{
+   return my->_reindexing;
+}
+
+const feed_store* follow_plugin::get_feed_store()const
+{
+   return my->_feed_store.get();
+}
+
+void follow_plugin::queue_feed_event( const account_name_type& poster, comment_id_type comment, bool reblog )
+{
+   my->queue_feed_event( poster, comment, reblog );
 }
 
 } } } // steem::plugins::follow
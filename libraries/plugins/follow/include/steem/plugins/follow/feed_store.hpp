@@ -0,0 +1,101 @@
+#pragma once
+
+#include <steem/protocol/types.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace steem { namespace plugins { namespace follow {
+
+using steem::protocol::account_name_type;
+using steem::protocol::block_id_type;
+
+namespace detail { class feed_store_impl; }
+
+/** A post reference in the feed of a single account, comment is the id of the comment_object. */
+struct feed_store_entry
+{
+   int64_t                             comment = 0;
+   uint32_t                            account_feed_id = 0;
+   fc::time_point_sec                  first_reblogged_on;
+   std::vector< account_name_type >    reblogged_by;
+};
+
+/**
+ * A top level post (reblogged_by empty) or reblog that has to be written to the
+ * feeds of followers. The followers are resolved while the block is applied.
+ */
+struct feed_event
+{
+   int64_t                             comment = 0;
+   account_name_type                   reblogged_by;
+   fc::time_point_sec                  time;
+   std::vector< account_name_type >    followers;
+};
+
+struct feed_block
+{
+   uint32_t                            block_num = 0;
+   block_id_type                       block_id;
+   uint32_t                            last_irreversible_block = 0;
+   std::vector< feed_event >           events;
+};
+
+/* The feed store keeps the feeds of all accounts outside of chainbase. Every account has a ring
+ * buffer of at most max_feed_size entries, the oldest entry is overwritten when a new post arrives.
+ * Feed ids within a ring are contiguous, so an entry id is found without searching.
+ *
+ * Blocks are applied in order. Changes of reversible blocks are journaled so that they can be
+ * undone when the chain switches forks: applying a block that is not above the head of the store
+ * first undoes all blocks from that number on.
+ *
+ * Deleted comments are not removed from the rings. Readers must skip entries whose comment no
+ * longer exists.
+ *
+ * The store is kept in memory and written to a single file on close. After an unclean shutdown the
+ * file is that of an earlier head block; the follow plugin then discards it on startup and feeds are
+ * rebuilt by replaying the chain. The same happens once a block could not be applied: the store is
+ * invalidated, stops applying blocks and removes its file on close. All methods are thread safe.
+ */
+class feed_store
+{
+   public:
+      feed_store();
+      ~feed_store();
+
+      void open( const fc::path& file, uint32_t max_feed_size );
+      void close();
+      bool is_open()const;
+
+      /** Removes all feeds, used when the chain is reindexed. */
+      void wipe();
+
+      /** Removes all feeds and ignores further blocks until wiped, used when a block could not be applied. */
+      void invalidate();
+      bool is_valid()const;
+
+      uint32_t      head_block_num()const;
+      block_id_type head_block_id()const;
+
+      void apply_block( const feed_block& block );
+
+      /**
+       * Calls processor for entries of the account with a feed id lower or equal to start_entry_id in
+       * descending order, until processor has accepted limit entries.
+       */
+      void find_feed( const account_name_type& account, uint32_t start_entry_id, uint32_t limit,
+         std::function< bool( const feed_store_entry& ) > processor )const;
+
+   private:
+      std::unique_ptr< detail::feed_store_impl > my;
+};
+
+} } } // steem::plugins::follow
+
+FC_REFLECT( steem::plugins::follow::feed_store_entry, (comment)(account_feed_id)(first_reblogged_on)(reblogged_by) )
+FC_REFLECT( steem::plugins::follow::feed_event, (comment)(reblogged_by)(time)(followers) )
+FC_REFLECT( steem::plugins::follow::feed_block, (block_num)(block_id)(last_irreversible_block)(events) )
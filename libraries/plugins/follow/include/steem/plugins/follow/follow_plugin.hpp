@@ -13,6 +13,8 @@ namespace steem { namespace plugins{ namespace follow {
 
 namespace detail { class follow_plugin_impl; }
 
+class feed_store;
+
 using namespace appbase;
 using steem::chain::generic_custom_operation_interpreter;
 
@@ -33,6 +35,15 @@ class follow_plugin : public appbase::plugin< follow_plugin >
       virtual void plugin_startup() override;
       virtual void plugin_shutdown() override;
 
+      /** True while a reindex runs and follow counts are rebuilt when it is done. */
+      bool in_reindex_fast_path()const;
+
+      /** The feed store when feeds are kept outside of chainbase, nullptr otherwise. */
+      const feed_store* get_feed_store()const;
+
+      /** Records a post (or reblog) of poster to be written to the feeds of its followers by the feed store. */
+      void queue_feed_event( const steem::protocol::account_name_type& poster, steem::chain::comment_id_type comment, bool reblog );
+
       uint32_t max_feed_size = 500;
       fc::time_point_sec start_feeds;
 
@@ -38,6 +38,8 @@ using steem::protocol::block_header;
 using steem::protocol::signed_block_header;
 using steem::protocol::signed_block;
 using steem::protocol::block_id_type;
+using steem::protocol::signed_transaction;
+using steem::protocol::transaction_id_type;
 
 namespace detail {
 
@@ -91,9 +93,11 @@ public:
    virtual bool has_item( const graphene::net::item_id& ) override;
    virtual bool handle_block( const graphene::net::block_message&, bool, std::vector<fc::uint160_t>& ) override;
    virtual void handle_transaction( const graphene::net::trx_message& ) override;
+   virtual std::vector< fc::oexception > handle_transactions( const std::vector< graphene::net::trx_message >& ) override;
    virtual void handle_message( const graphene::net::message& ) override;
    virtual std::vector< graphene::net::item_hash_t > get_block_ids( const std::vector< graphene::net::item_hash_t >&, uint32_t&, uint32_t ) override;
    virtual graphene::net::message get_item( const graphene::net::item_id& ) override;
+   virtual std::vector< signed_transaction > get_pending_transactions( const std::function< bool( const transaction_id_type& ) >& ) override;
    virtual std::vector< graphene::net::item_hash_t > get_blockchain_synopsis( const graphene::net::item_hash_t&, uint32_t ) override;
    virtual void sync_status( uint32_t, uint32_t ) override;
    virtual void connection_count_changed( uint32_t ) override;
@@ -260,6 +264,29 @@ void p2p_plugin_impl::handle_transaction( const graphene::net::trx_message& trx_
    }
 }
 
+std::vector< fc::oexception > p2p_plugin_impl::handle_transactions( const std::vector< graphene::net::trx_message >& trx_msgs )
+{
+   if(running.load())
+   {
+      shutdown_helper helper(*this, activeHandleTx, handleTxFinished);
+
+      vector< signed_transaction > trxs;
+      trxs.reserve( trx_msgs.size() );
+      for( const auto& trx_msg : trx_msgs )
+         trxs.push_back( trx_msg.trx );
+
+      return chain.accept_transactions( trxs );
+   }
+   else
+   {
+      ilog("Transactions ignored due to started p2p_plugin shutdown");
+      if(handleTxFinished.second.valid() == false)
+         handleTxFinished.first.set_value();
+
+      FC_THROW("Preventing further processing of ignored transactions...");
+   }
+}
+
 void p2p_plugin_impl::handle_message( const graphene::net::message& message_to_process )
 {
    // not a transaction, not a block
@@ -341,6 +368,21 @@ graphene::net::message p2p_plugin_impl::get_item( const graphene::net::item_id&
    });
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
+std::vector< signed_transaction > p2p_plugin_impl::get_pending_transactions( const std::function< bool( const transaction_id_type& ) >& filter )
+{ try {
+   std::vector< signed_transaction > result;
+   chain.db().with_read_lock( [&]()
+   {
+      const auto& pending = chain.db()._pending_tx;
+      const auto& ids = chain.db()._pending_tx_ids;
+
+      for( size_t i = 0; i < pending.size(); ++i )
+         if( filter( ids[i] ) )
+            result.push_back( pending[i] );
+   });
+   return result;
+} FC_CAPTURE_AND_RETHROW() }
+
 steem::protocol::chain_id_type p2p_plugin_impl::get_chain_id() const
 {
    return chain.db().get_chain_id();
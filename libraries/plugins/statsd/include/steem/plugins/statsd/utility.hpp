@@ -92,6 +92,14 @@ if( steem::plugins::statsd::util::statsd_enabled() )     \
    );                                                    \
 }
 
+#define STATSD_TIMING( NAMESPACE, STAT, KEY, MS, FREQ )  \
+if( steem::plugins::statsd::util::statsd_enabled() )     \
+{                                                        \
+   steem::plugins::statsd::util::get_statsd().timing(    \
+      #NAMESPACE, #STAT, #KEY, MS, FREQ                  \
+   );                                                    \
+}
+
 #define STATSD_START_TIMER( NAMESPACE, STAT, KEY, FREQ )                                              \
 fc::optional< steem::plugins::statsd::util::statsd_timer_helper > NAMESPACE ## STAT ## KEY ## _timer; \
 if( steem::plugins::statsd::util::statsd_enabled() )                                                  \
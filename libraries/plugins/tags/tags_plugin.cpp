@@ -5,6 +5,7 @@
 #include <steem/chain/database.hpp>
 #include <steem/chain/index.hpp>
 #include <steem/chain/operation_notification.hpp>
+#include <steem/chain/block_notification.hpp>
 #include <steem/chain/account_object.hpp>
 #include <steem/chain/comment_object.hpp>
 
@@ -58,14 +59,24 @@ class tags_plugin_impl
 
       void on_pre_apply_operation( const operation_notification& note );
       void on_post_apply_operation( const operation_notification& note );
+      void on_pre_apply_block( const block_notification& note );
+      void on_post_apply_block( const block_notification& note );
 
       chain::database&     _db;
       fc::time_point_sec   _promoted_start_time;
       bool                 _started = false;
       boost::signals2::connection   _pre_apply_operation_conn;
       boost::signals2::connection   _post_apply_operation_conn;
+      boost::signals2::connection   _pre_apply_block_conn;
+      boost::signals2::connection   _post_apply_block_conn;
       boost::signals2::connection   on_sync_connection;
 
+      /**
+       * Comments whose tags are out of date, mapped to whether their tags must be parsed again.
+       * Votes and replies only queue the comment here, the tags are updated once per block.
+       */
+      std::map< comment_id_type, bool > _pending_updates;
+
       void remove_stats( const tag_object& tag, const tag_stats_object& stats )const;
       void add_stats( const tag_object& tag, const tag_stats_object& stats )const;
       void remove_tag( const tag_object& tag )const;
@@ -74,6 +85,8 @@ class tags_plugin_impl
       void update_tag( const tag_object& current, const comment_object& comment, double hot, double trending )const;
       void create_tag( const string& tag, const comment_object& comment, double hot, double trending )const;
       void update_tags( const comment_object& c, bool parse_tags = false )const;
+      void queue_tags_update( const comment_object& c, bool parse_tags = false );
+      void flush_tags_updates();
 };
 
 tags_plugin_impl::tags_plugin_impl() :
@@ -190,13 +203,22 @@ comment_metadata tags_plugin_impl::filter_tags( const comment_object& c, const c
 
 void tags_plugin_impl::update_tag( const tag_object& current, const comment_object& comment, double hot, double trending )const
 {
-    const auto& stats = get_stats( current.tag );
-    remove_stats( current, stats );
-
     if( comment.cashout_time != fc::time_point_sec::maximum() ) {
+       auto cashout = _db.calculate_discussion_payout_time( comment );
+
+       /// Avoid re-sorting the tag indices when nothing they depend on has changed
+       if( current.active == comment.active && current.cashout == cashout
+          && current.children == comment.children && current.net_rshares == comment.net_rshares.value
+          && current.net_votes == comment.net_votes && current.hot == hot && current.trending == trending
+          && ( cashout != fc::time_point_sec() || current.promoted_balance == 0 ) )
+          return;
+
+       const auto& stats = get_stats( current.tag );
+       remove_stats( current, stats );
+
        _db.modify( current, [&]( tag_object& obj ) {
           obj.active            = comment.active;
-          obj.cashout           = _db.calculate_discussion_payout_time( comment );
+          obj.cashout           = cashout;
           obj.children          = comment.children;
           obj.net_rshares       = comment.net_rshares.value;
           obj.net_votes         = comment.net_votes;
@@ -207,6 +229,7 @@ void tags_plugin_impl::update_tag( const tag_object& current, const comment_obje
       });
       add_stats( current, stats );
     } else {
+       remove_stats( current, get_stats( current.tag ) );
        _db.remove( current );
     }
 }
@@ -257,7 +280,7 @@ void tags_plugin_impl::create_tag( const string& tag, const comment_object& comm
    }
 }
 
-/** finds tags that have been added or removed or updated */
+/** finds tags that have been added or removed or updated, the parents are queued by queue_tags_update */
 void tags_plugin_impl::update_tags( const comment_object& c, bool parse_tags )const
 {
    try {
@@ -320,18 +343,53 @@ void tags_plugin_impl::update_tags( const comment_object& c, bool parse_tags )co
       }
    }
 
-   if( c.parent_author.size() )
+   } FC_CAPTURE_LOG_AND_RETHROW( (c) )
+}
+
+void tags_plugin_impl::queue_tags_update( const comment_object& c, bool parse_tags )
+{
+   const comment_object* current = &c;
+
+   while( true )
    {
-      update_tags( _db.get_comment( c.parent_author, c.parent_permlink ) );
+      auto itr = _pending_updates.find( current->id );
+
+      if( itr != _pending_updates.end() )
+      {
+         itr->second |= parse_tags;
+         break; /// the parents have been queued along with the comment
+      }
+
+      _pending_updates[ current->id ] = parse_tags;
+
+      if( current->parent_author.size() == 0 )
+         break;
+
+      current = &_db.get_comment( current->parent_author, current->parent_permlink );
+      parse_tags = false;
    }
-   } FC_CAPTURE_LOG_AND_RETHROW( (c) )
+}
+
+void tags_plugin_impl::flush_tags_updates()
+{
+   for( const auto& item : _pending_updates )
+   {
+      const auto* c = _db.find< comment_object >( item.first );
+
+      /// the comment may have been deleted after it was queued
+      if( c != nullptr )
+         update_tags( *c, item.second );
+   }
+
+   _pending_updates.clear();
 }
 
 struct pre_apply_operation_visitor
 {
-   pre_apply_operation_visitor( database& db ) : _db( db ) {};
+   pre_apply_operation_visitor( tags_plugin_impl& my ) : _my( my ), _db( my._db ) {};
    typedef void result_type;
 
+   tags_plugin_impl& _my;
    database& _db;
 
    void operator()( const delete_comment_operation& op )const
@@ -341,6 +399,10 @@ struct pre_apply_operation_visitor
       if( comment == nullptr )
          return;
 
+      /// The tags are removed without touching the tag stats, bring them (and the parents, which the
+      /// delete is about to modify) up to date first as updating them on every operation did
+      _my.flush_tags_updates();
+
       const auto& idx = _db.get_index< tag_index, by_author_comment >();
       const auto& auth = _db.get_account( op.author );
 
@@ -376,7 +438,7 @@ struct operation_visitor
    {
       if( _my._started )
       {
-         _my.update_tags( _my._db.get_comment( op.author, op.permlink ), op.json_metadata.size() );
+         _my.queue_tags_update( _my._db.get_comment( op.author, op.permlink ), op.json_metadata.size() );
       }
    }
 
@@ -419,14 +481,14 @@ struct operation_visitor
    {
       if( _my._started )
       {
-         _my.update_tags( _my._db.get_comment( op.author, op.permlink ) );
+         _my.queue_tags_update( _my._db.get_comment( op.author, op.permlink ) );
       }
    }
 
    void operator()( const comment_reward_operation& op )const
    {
          const auto& c = _my._db.get_comment( op.author, op.permlink );
-         _my.update_tags( c );
+         _my.queue_tags_update( c );
 
 #ifndef IS_LOW_MEM
          comment_metadata meta = _my.filter_tags( c, _my._db.get< comment_content_object, chain::by_comment >( c.id ) );
@@ -444,7 +506,7 @@ struct operation_visitor
    void operator()( const comment_payout_update_operation& op )const
    {
       const auto& c = _my._db.get_comment( op.author, op.permlink );
-      _my.update_tags( c, !_my._started );
+      _my.queue_tags_update( c, !_my._started );
    }
 
    template<typename Op>
@@ -456,7 +518,7 @@ void tags_plugin_impl::on_pre_apply_operation( const operation_notification& not
    try
    {
       /// plugins shouldn't ever throw
-      note.op.visit( pre_apply_operation_visitor( _db ) );
+      note.op.visit( pre_apply_operation_visitor( *this ) );
    }
    catch ( const fc::exception& e )
    {
@@ -474,6 +536,32 @@ void tags_plugin_impl::on_post_apply_operation( const operation_notification& no
    {
       /// plugins shouldn't ever throw
       note.op.visit( operation_visitor( *this ) );
+
+      /// Outside of a block (pending transactions) there is no block end to wait for
+      if( !_db.is_processing_block() )
+         flush_tags_updates();
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+   }
+   catch ( ... )
+   {
+      elog( "unhandled exception" );
+   }
+}
+
+void tags_plugin_impl::on_pre_apply_block( const block_notification& note )
+{
+   /// Left over from a block that failed to apply, the comments may no longer exist
+   _pending_updates.clear();
+}
+
+void tags_plugin_impl::on_post_apply_block( const block_notification& note )
+{
+   try
+   {
+      flush_tags_updates();
    }
    catch ( const fc::exception& e )
    {
@@ -508,6 +596,8 @@ void tags_plugin::plugin_initialize(const boost::program_options::variables_map&
 
    my->_pre_apply_operation_conn = my->_db.add_pre_apply_operation_handler( [&]( const operation_notification& note ){ my->on_pre_apply_operation( note ); }, *this, 0 );
    my->_post_apply_operation_conn = my->_db.add_post_apply_operation_handler( [&]( const operation_notification& note ){ my->on_post_apply_operation( note ); }, *this, 0 );
+   my->_pre_apply_block_conn = my->_db.add_pre_apply_block_handler( [&]( const block_notification& note ){ my->on_pre_apply_block( note ); }, *this, 0 );
+   my->_post_apply_block_conn = my->_db.add_post_apply_block_handler( [&]( const block_notification& note ){ my->on_post_apply_block( note ); }, *this, 0 );
 
    if( !options.at( "tags-skip-startup-update" ).as< bool >() )
    {
@@ -520,8 +610,10 @@ void tags_plugin::plugin_initialize(const boost::program_options::variables_map&
             const auto& comment_idx = my->_db.get_index< comment_index, by_cashout_time >();
             for( auto itr = comment_idx.begin(); itr != comment_idx.end() && itr->cashout_time != fc::time_point_sec::maximum(); ++itr )
             {
-               my->update_tags( *itr, true );
+               my->queue_tags_update( *itr, true );
             }
+
+            my->flush_tags_updates();
          });
       });
    }
@@ -547,6 +639,8 @@ void tags_plugin::plugin_startup()
 {
    chain::util::disconnect_signal( my->_pre_apply_operation_conn );
    chain::util::disconnect_signal( my->_post_apply_operation_conn );
+   chain::util::disconnect_signal( my->_pre_apply_block_conn );
+   chain::util::disconnect_signal( my->_post_apply_block_conn );
 }
 
 } } } /// steem::plugins::tags
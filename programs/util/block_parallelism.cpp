@@ -0,0 +1,71 @@
+/**
+ * Measures how many transactions of a block log could be applied in parallel.
+ *
+ * Every block is partitioned with util::schedule_transactions into waves of transactions that share no
+ * impacted account.  A block with n transactions in w waves could apply at most n / w transactions at
+ * once, with as many workers and equal transaction costs; transactions with an operation that is not
+ * reorderable count as serial.
+ *
+ * usage: block_parallelism <block_log> [first block] [last block]
+ */
+#include <steem/chain/block_log.hpp>
+#include <steem/chain/util/transaction_schedule.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      FC_ASSERT( argc > 1, "usage: block_parallelism <block_log> [first block] [last block]" );
+
+      steem::chain::block_log log;
+      log.open( fc::path( std::string( argv[1] ) ) );
+      FC_ASSERT( log.head(), "Block log is empty" );
+
+      uint32_t first = argc > 2 ? std::stoul( argv[2] ) : 1;
+      uint32_t last = argc > 3 ? std::stoul( argv[3] ) : log.head()->block_num();
+      last = std::min( last, log.head()->block_num() );
+      FC_ASSERT( first > 0 && first <= last );
+
+      uint64_t blocks = 0;
+      uint64_t transactions = 0;
+      uint64_t serial = 0;
+      uint64_t waves = 0;
+      uint32_t widest = 0;
+
+      for( uint32_t num = first; num <= last; ++num )
+      {
+         auto block = log.read_block_by_num( num );
+         FC_ASSERT( block, "Block ${n} is missing", ("n", num) );
+
+         auto schedule = steem::chain::util::schedule_transactions( block->transactions );
+
+         ++blocks;
+         transactions += block->transactions.size();
+         serial += schedule.serial_count;
+         waves += schedule.wave_count;
+         widest = std::max( widest, schedule.max_wave_size() );
+
+         if( num % 1000000 == 0 )
+            std::cerr << "block " << num << "\n";
+      }
+
+      std::cout << blocks << " blocks, " << transactions << " transactions\n";
+      std::cout << "serial transactions:      " << serial << " (" << ( transactions ? 100.0 * serial / transactions : 0 ) << " %)\n";
+      std::cout << "waves per block:          " << ( blocks ? double( waves ) / blocks : 0 ) << "\n";
+      std::cout << "transactions per wave:    " << ( waves ? double( transactions ) / waves : 0 ) << "\n";
+      std::cout << "widest wave:              " << widest << "\n";
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * Replays a flood of transaction inventory through the per-peer inventory sets the p2p node keeps,
+ * once with the boost::multi_index sets the node used before and once with timestamped_item_set.
+ *
+ * Every item is advertised to us by every peer and advertised by us to every peer, the way a
+ * transaction spreads through a well connected node.  The clock moves one second per `rate` items
+ * and old inventory is expired every block, as in node_impl.
+ *
+ * usage: inventory_benchmark [recorded item ids] [peers] [rate]
+ *
+ * The recording is a text file of hex item hashes, one per line, in the order they were received.
+ * Without one, 2 million random hashes are replayed.
+ */
+#include <graphene/net/config.hpp>
+#include <graphene/net/timestamped_item_set.hpp>
+
+#include <steem/protocol/config.hpp>
+
+#include <fc/crypto/hex.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/time.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/tag.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace graphene::net;
+
+namespace {
+
+struct timestamp_index{};
+typedef boost::multi_index_container<timestamped_item_id,
+   boost::multi_index::indexed_by<
+      boost::multi_index::hashed_unique<boost::multi_index::member<timestamped_item_id, item_id, &timestamped_item_id::item>, std::hash<item_id> >,
+      boost::multi_index::ordered_non_unique<boost::multi_index::tag<timestamp_index>,
+         boost::multi_index::member<timestamped_item_id, fc::time_point_sec, &timestamped_item_id::timestamp> > > > multi_index_item_set;
+
+size_t expire( multi_index_item_set& items, fc::time_point_sec oldest_to_keep )
+{
+   auto& by_time = items.get<timestamp_index>();
+   auto end = by_time.lower_bound( oldest_to_keep );
+   size_t removed = std::distance( by_time.begin(), end );
+   by_time.erase( by_time.begin(), end );
+   return removed;
+}
+
+size_t expire( timestamped_item_set& items, fc::time_point_sec oldest_to_keep )
+{
+   return items.expire( oldest_to_keep );
+}
+
+template< typename Set >
+struct peer_inventory
+{
+   Set advertised_to_us;
+   Set advertised_to_peer;
+};
+
+template< typename Set >
+double replay( const std::vector< item_hash_t >& flood, uint32_t peer_count, uint32_t rate, size_t& lookups )
+{
+   std::vector< peer_inventory< Set > > peers( peer_count );
+   Set recently_failed;
+   fc::time_point_sec now( 1000000 );
+   lookups = 0;
+
+   auto start = fc::time_point::now();
+   for( size_t i = 0; i < flood.size(); ++i )
+   {
+      item_id item( 1000, flood[i] );
+
+      // every peer announces the item, we fetch it from the first one
+      for( auto& peer : peers )
+      {
+         lookups += 2;
+         if( recently_failed.find( item ) != recently_failed.end() )
+            continue;
+         if( peer.advertised_to_us.find( item ) == peer.advertised_to_us.end() )
+            peer.advertised_to_us.insert( timestamped_item_id( item, now ) );
+      }
+
+      // and then advertise it to every peer that doesn't know it yet
+      for( auto& peer : peers )
+      {
+         lookups += 2;
+         if( peer.advertised_to_peer.find( item ) == peer.advertised_to_peer.end() &&
+             peer.advertised_to_us.find( item ) == peer.advertised_to_us.end() )
+            peer.advertised_to_peer.insert( timestamped_item_id( item, now ) );
+      }
+
+      if( i % 1000 == 0 )
+         recently_failed.insert( timestamped_item_id( item, now ) );
+
+      if( ( i + 1 ) % rate == 0 )
+      {
+         now += 1;
+         if( now.sec_since_epoch() % STEEM_BLOCK_INTERVAL == 0 )
+         {
+            fc::time_point_sec oldest_to_keep = now - GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES * 60;
+            for( auto& peer : peers )
+            {
+               expire( peer.advertised_to_us, oldest_to_keep );
+               expire( peer.advertised_to_peer, oldest_to_keep );
+            }
+            expire( recently_failed, now - GRAPHENE_NET_PRUNE_FAILED_IDS_MINUTES * 60 );
+         }
+      }
+   }
+   return double( ( fc::time_point::now() - start ).count() ) / 1000000;
+}
+
+std::vector< item_hash_t > load_flood( const std::string& path )
+{
+   std::vector< item_hash_t > result;
+   std::ifstream in( path );
+   FC_ASSERT( in, "Could not open ${p}", ("p", path) );
+
+   std::string line;
+   while( std::getline( in, line ) )
+   {
+      if( line.size() < 2 * sizeof( item_hash_t ) )
+         continue;
+      item_hash_t hash;
+      fc::from_hex( line.substr( 0, 2 * sizeof( item_hash_t ) ), (char*)&hash, sizeof( hash ) );
+      result.push_back( hash );
+   }
+   return result;
+}
+
+std::vector< item_hash_t > random_flood( size_t count )
+{
+   std::mt19937 rng( 42 );
+   std::vector< item_hash_t > result( count );
+   for( auto& hash : result )
+      for( auto& word : hash._hash )
+         word = rng();
+   return result;
+}
+
+} // anonymous namespace
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      std::vector< item_hash_t > flood = argc > 1 && std::string( argv[1] ) != "-" ? load_flood( argv[1] ) : random_flood( 2000000 );
+      uint32_t peer_count = argc > 2 ? std::stoul( argv[2] ) : 8;
+      uint32_t rate = argc > 3 ? std::stoul( argv[3] ) : GRAPHENE_NET_MAX_TRX_PER_SECOND;
+      FC_ASSERT( peer_count > 0 && rate > 0 );
+
+      std::cout << flood.size() << " items, " << peer_count << " peers, " << rate << " items per second\n";
+
+      size_t lookups = 0;
+      double seconds = replay< multi_index_item_set >( flood, peer_count, rate, lookups );
+      std::cout << "multi_index:          " << seconds << " s, " << lookups / seconds / 1000000 << " M lookups/s\n";
+
+      seconds = replay< timestamped_item_set >( flood, peer_count, rate, lookups );
+      std::cout << "timestamped_item_set: " << seconds << " s, " << lookups / seconds / 1000000 << " M lookups/s\n";
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+
+   return 0;
+}
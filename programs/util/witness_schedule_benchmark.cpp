@@ -0,0 +1,115 @@
+/**
+ * Times the witness schedule update done at the end of every round, with many registered witnesses.
+ *
+ * A fresh database gets `witnesses` witnesses with random votes, properties and signing keys, one in
+ * `disabled` of them without a key.  Between rounds the votes of `churn` random witnesses change, as
+ * they do when accounts vote, unvote or power down.
+ *
+ * usage: witness_schedule_benchmark [witnesses] [rounds] [churn] [disabled]
+ */
+#include <steem/chain/database.hpp>
+#include <steem/chain/witness_objects.hpp>
+#include <steem/chain/witness_schedule.hpp>
+
+#include <steem/protocol/config.hpp>
+
+#include <fc/crypto/elliptic.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace steem::chain;
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      uint32_t witness_count = argc > 1 ? std::stoul( argv[1] ) : 10000;
+      uint32_t rounds = argc > 2 ? std::stoul( argv[2] ) : 1000;
+      uint32_t churn = argc > 3 ? std::stoul( argv[3] ) : 100;
+      uint32_t disabled = argc > 4 ? std::stoul( argv[4] ) : 10;
+      FC_ASSERT( witness_count > 0 && rounds > 0 && disabled > 0 );
+
+      fc::temp_directory dir( fc::temp_directory_path() );
+
+      database db;
+      database::open_args args;
+      args.data_dir = dir.path();
+      args.shared_mem_dir = dir.path();
+      args.initial_supply = STEEM_INIT_SUPPLY;
+      args.shared_file_size = 1024ull * 1024 * 1024;
+      db.open( args );
+      db.set_hardfork( STEEM_BLOCKCHAIN_VERSION.minor() );
+
+      std::mt19937_64 rng( 42 );
+      std::uniform_int_distribution< int64_t > votes( 0, 1000000000000ll );
+      std::uniform_int_distribution< int64_t > fees( 1, 10000 );
+      std::uniform_int_distribution< uint32_t > sizes( STEEM_MIN_BLOCK_SIZE_LIMIT, STEEM_MAX_BLOCK_SIZE );
+      std::uniform_int_distribution< uint16_t > rates( 0, STEEM_100_PERCENT );
+
+      public_key_type signing_key = fc::ecc::private_key::regenerate( fc::sha256::hash( std::string( "benchmark" ) ) ).get_public_key();
+      std::vector< witness_id_type > witnesses;
+      witnesses.reserve( witness_count );
+
+      for( uint32_t i = 0; i < witness_count; ++i )
+      {
+         witnesses.push_back( db.create< witness_object >( [&]( witness_object& w )
+         {
+            w.owner = "witness" + std::to_string( i );
+            w.signing_key = i % disabled == 0 ? public_key_type() : signing_key;
+            w.votes = votes( rng );
+            w.virtual_scheduled_time = STEEM_VIRTUAL_SCHEDULE_LAP_LENGTH2 / ( w.votes.value + 1 );
+            w.props.account_creation_fee = asset( fees( rng ), STEEM_SYMBOL );
+            w.props.maximum_block_size = sizes( rng );
+            w.props.sbd_interest_rate = rates( rng );
+            w.props.account_subsidy_limit = fees( rng );
+         }).id );
+      }
+
+      std::uniform_int_distribution< size_t > pick( 0, witnesses.size() - 1 );
+      std::vector< int64_t > round_us;
+      round_us.reserve( rounds );
+
+      for( uint32_t r = 0; r < rounds; ++r )
+      {
+         for( uint32_t i = 0; i < churn; ++i )
+         {
+            db.modify( db.get( witnesses[ pick( rng ) ] ), [&]( witness_object& w )
+            {
+               w.votes = votes( rng );
+            });
+         }
+
+         // The schedule is updated when the head block number is a multiple of STEEM_MAX_WITNESSES, here 0
+         auto start = fc::time_point::now();
+         update_witness_schedule( db );
+         round_us.push_back( ( fc::time_point::now() - start ).count() );
+      }
+
+      std::sort( round_us.begin(), round_us.end() );
+      int64_t total = 0;
+      for( int64_t us : round_us )
+         total += us;
+
+      std::cout << witness_count << " witnesses, " << rounds << " rounds, " << churn << " vote changes per round\n";
+      std::cout << "mean: " << total / int64_t( round_us.size() ) << " us, "
+                << "p50: " << round_us[ round_us.size() / 2 ] << " us, "
+                << "p99: " << round_us[ round_us.size() * 99 / 100 ] << " us, "
+                << "max: " << round_us.back() << " us\n";
+
+      db.close();
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+
+   return 0;
+}
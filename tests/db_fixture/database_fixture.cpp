@@ -34,7 +34,7 @@ namespace steem { namespace chain {
 using std::cout;
 using std::cerr;
 
-clean_database_fixture::clean_database_fixture()
+clean_database_fixture::clean_database_fixture( uint32_t hardfork )
 {
    try {
    int argc = boost::unit_test::framework::master_test_suite().argc;
@@ -67,7 +67,7 @@ clean_database_fixture::clean_database_fixture()
    open_database();
 
    generate_block();
-   db->set_hardfork( STEEM_BLOCKCHAIN_VERSION.minor() );
+   db->set_hardfork( hardfork );
    generate_block();
 
    vest( "initminer", 10000 );
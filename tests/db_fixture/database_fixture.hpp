@@ -275,7 +275,8 @@ struct database_fixture {
 
 struct clean_database_fixture : public database_fixture
 {
-   clean_database_fixture();
+   /// Starts the chain at the given hardfork, the latest one by default
+   clean_database_fixture( uint32_t hardfork = STEEM_BLOCKCHAIN_VERSION.minor() );
    virtual ~clean_database_fixture();
 
    void resize_shared_mem( uint64_t size );
@@ -0,0 +1,114 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/plugins/account_history/account_history_log.hpp>
+
+#include <steem/utilities/tempdir.hpp>
+
+#include <fc/filesystem.hpp>
+
+using namespace steem::protocol;
+using namespace steem::plugins::account_history;
+
+BOOST_AUTO_TEST_SUITE( account_history_log_tests )
+
+BOOST_AUTO_TEST_CASE( append_and_query )
+{
+   try
+   {
+      fc::temp_directory dir( steem::utilities::temp_directory_path() );
+      account_history_log log;
+
+      // Small segments so that records roll over into several segment files
+      log.open( dir.path() / "ah", 4096 );
+
+      const uint32_t blocks = 200;
+      transaction_id_type trx_id;
+
+      for( uint32_t b = 1; b <= blocks; ++b )
+      {
+         // Every third block is empty
+         if( b % 3 == 0 )
+         {
+            log.end_block( b );
+            continue;
+         }
+
+         log_operation_object op;
+         op.trx_id = transaction_id_type( fc::ripemd160::hash( std::to_string( b ) ) );
+         op.block = b;
+         op.serialized_op.resize( 100 + b, char( b ) );
+
+         uint64_t id = log.append_operation( op );
+         log.append_account_entry( "alice", log.account_head_sequence( "alice" ) + 1, id );
+
+         if( b % 2 == 0 )
+            log.append_account_entry( "bob", log.account_head_sequence( "bob" ) + 1, id );
+
+         log.end_block( b );
+
+         if( b == 100 )
+            trx_id = op.trx_id;
+      }
+
+      BOOST_REQUIRE_EQUAL( log.head_block_num(), blocks );
+      BOOST_REQUIRE_EQUAL( log.account_head_sequence( "alice" ), 134u );
+
+      auto check = [&]()
+      {
+         std::vector< uint32_t > found;
+         log_operation_object op;
+
+         log.find_operations_by_block( 3, [&]( const log_operation_object& ){ found.push_back( 0 ); } );
+         BOOST_REQUIRE( found.empty() );
+
+         log.find_operations_by_block( 4, [&]( const log_operation_object& o ){ found.push_back( o.block ); } );
+         BOOST_REQUIRE_EQUAL( found.size(), 1u );
+         BOOST_REQUIRE_EQUAL( found[0], 4u );
+
+         BOOST_REQUIRE( log.find_transaction( trx_id, op ) );
+         BOOST_REQUIRE_EQUAL( op.block, 100u );
+         BOOST_REQUIRE_EQUAL( op.serialized_op.size(), 200u );
+         BOOST_REQUIRE( !log.find_transaction( transaction_id_type( fc::ripemd160::hash( std::string( "none" ) ) ), op ) );
+
+         // Every sequence must be reachable through the skip pointers
+         for( uint32_t start = 1; start <= 134; ++start )
+         {
+            found.clear();
+            uint32_t n = log.find_account_history( "alice", start, 3,
+               [&]( uint32_t seq, const log_operation_object& ){ found.push_back( seq ); } );
+
+            BOOST_REQUIRE_EQUAL( n, std::min( start, 3u ) );
+            for( uint32_t i = 0; i < n; ++i )
+               BOOST_REQUIRE_EQUAL( found[i], start - i );
+         }
+
+         found.clear();
+         log.find_account_history( "bob", uint64_t(-1), 2,
+            [&]( uint32_t seq, const log_operation_object& o ){ found.push_back( o.block ); } );
+         BOOST_REQUIRE_EQUAL( found.size(), 2u );
+         BOOST_REQUIRE_EQUAL( found[0], 200u );
+         BOOST_REQUIRE_EQUAL( found[1], 196u );
+
+         BOOST_REQUIRE_EQUAL( log.find_account_history( "carol", uint64_t(-1), 10,
+            []( uint32_t, const log_operation_object& ){} ), 0u );
+      };
+
+      check();
+
+      // Head snapshot is written on close, reopening must give the same answers
+      log.close();
+      log.open( dir.path() / "ah", 4096 );
+      BOOST_REQUIRE_EQUAL( log.head_block_num(), blocks );
+      check();
+
+      log.wipe();
+      BOOST_REQUIRE_EQUAL( log.head_block_num(), 0u );
+      BOOST_REQUIRE_EQUAL( log.account_head_sequence( "alice" ), 0u );
+      log.close();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
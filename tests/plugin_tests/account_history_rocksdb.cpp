@@ -0,0 +1,196 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/chain/account_object.hpp>
+
+#include <steem/plugins/account_history_rocksdb/account_history_rocksdb_plugin.hpp>
+#include <steem/plugins/debug_node/debug_node_plugin.hpp>
+#include <steem/plugins/witness/witness_plugin.hpp>
+
+#include <steem/utilities/tempdir.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace steem::chain;
+using namespace steem::protocol;
+using steem::plugins::account_history_rocksdb::account_history_rocksdb_plugin;
+using steem::plugins::account_history_rocksdb::rocksdb_operation_object;
+
+/**
+ * Runs account_history_rocksdb in async mode on a chain kept in directories that outlive the fixture,
+ * so that a test can stop the node and start it again on the same data.
+ */
+struct async_rocksdb_fixture : public database_fixture
+{
+   async_rocksdb_fixture( const fc::path& dir, bool genesis )
+   {
+      try
+      {
+         std::vector< std::string > args = {
+            "plugin_test",
+            "--data-dir", ( dir / "app" ).string(),
+            "--account-history-rocksdb-path", ( dir / "ah" ).string(),
+            "--account-history-rocksdb-async", "true"
+         };
+         std::vector< char* > argv;
+         for( auto& a : args )
+            argv.push_back( &a[0] );
+
+         ah_plugin = &appbase::app().register_plugin< account_history_rocksdb_plugin >();
+         db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+         appbase::app().register_plugin< steem::plugins::witness::witness_plugin >();
+
+         db_plugin->logging = false;
+         appbase::app().initialize<
+            account_history_rocksdb_plugin,
+            steem::plugins::debug_node::debug_node_plugin,
+            steem::plugins::witness::witness_plugin
+            >( argv.size(), argv.data() );
+
+         db = &appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db();
+         BOOST_REQUIRE( db );
+
+         db->_log_hardforks = false;
+
+         database::open_args open_args;
+         open_args.data_dir = dir / "chain";
+         open_args.shared_mem_dir = open_args.data_dir;
+         open_args.initial_supply = INITIAL_TEST_SUPPLY;
+         open_args.shared_file_size = 1024 * 1024 * 8;
+         db->open( open_args );
+
+         ah_plugin->plugin_startup();
+
+         if( genesis )
+         {
+            generate_block();
+            db->set_hardfork( STEEM_BLOCKCHAIN_VERSION.minor() );
+            generate_block();
+
+            vest( STEEM_INIT_MINER_NAME, 10000 );
+
+            for( int i = STEEM_NUM_INIT_MINERS; i < STEEM_MAX_WITNESSES; i++ )
+            {
+               account_create( STEEM_INIT_MINER_NAME + fc::to_string( i ), init_account_pub_key );
+               fund( STEEM_INIT_MINER_NAME + fc::to_string( i ), STEEM_MIN_PRODUCER_REWARD.amount.value );
+               witness_create( STEEM_INIT_MINER_NAME + fc::to_string( i ), init_account_priv_key, "foo.bar", init_account_pub_key, STEEM_MIN_PRODUCER_REWARD.amount );
+            }
+
+            account_create( "alice", init_account_pub_key );
+            generate_block();
+         }
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   ~async_rocksdb_fixture()
+   {
+      ah_plugin->plugin_shutdown();
+      db->close();
+   }
+
+   /// Transfers to alice in a block of its own and returns the number of that block
+   uint32_t transfer_block()
+   {
+      transfer( STEEM_INIT_MINER_NAME, "alice", ASSET( "0.001 TESTS" ) );
+      generate_block();
+      return db->head_block_num();
+   }
+
+   void generate_until_irreversible( uint32_t block_num )
+   {
+      for( int i = 0; db->get_dynamic_global_properties().last_irreversible_block_num < block_num; ++i )
+      {
+         BOOST_REQUIRE( i < 200 );
+         generate_block();
+      }
+   }
+
+   void wait_for_import()
+   {
+      for( const auto& subscription : db->get_async_block_subscriptions() )
+         subscription->wait();
+   }
+
+   uint32_t count_transfers( uint32_t block_num )
+   {
+      uint32_t count = 0;
+      ah_plugin->find_operations_by_block( block_num, [&]( const rocksdb_operation_object& obj )
+      {
+         if( fc::raw::unpack_from_vector< operation >( obj.serialized_op ).which() == operation::tag< transfer_operation >::value )
+            ++count;
+      } );
+      return count;
+   }
+
+   account_history_rocksdb_plugin* ah_plugin = nullptr;
+};
+
+BOOST_AUTO_TEST_SUITE( account_history_rocksdb_tests )
+
+BOOST_AUTO_TEST_CASE( async_import_across_restarts )
+{
+   try
+   {
+      fc::temp_directory dir( steem::utilities::temp_directory_path() );
+
+      uint32_t irreversible = 0;
+      uint32_t reversible = 0;
+      uint32_t missed = 0;
+      std::vector< signed_block > reversible_blocks;
+
+      {
+         BOOST_TEST_MESSAGE( "Operations are imported once their block is irreversible" );
+         async_rocksdb_fixture f( dir.path(), true );
+
+         irreversible = f.transfer_block();
+         f.generate_until_irreversible( irreversible );
+         reversible = f.transfer_block();
+         f.wait_for_import();
+
+         BOOST_REQUIRE_EQUAL( f.count_transfers( irreversible ), 1u );
+         BOOST_REQUIRE_EQUAL( f.count_transfers( reversible ), 0u );
+
+         // The chain rewinds to its last irreversible block on open, these are pushed again after the restart
+         uint32_t lib = f.db->get_dynamic_global_properties().last_irreversible_block_num;
+         BOOST_REQUIRE( lib < reversible );
+         for( uint32_t b = lib + 1; b <= f.db->head_block_num(); ++b )
+            reversible_blocks.push_back( *f.db->fetch_block_by_number( b ) );
+      }
+
+      {
+         BOOST_TEST_MESSAGE( "Reversible operations dropped on shutdown are imported after the restart" );
+         async_rocksdb_fixture f( dir.path(), false );
+
+         BOOST_REQUIRE_EQUAL( f.db->head_block_num(), reversible_blocks.front().block_num() - 1 );
+         for( const auto& b : reversible_blocks )
+            f.db->push_block( b, database::skip_witness_signature );
+
+         f.generate_until_irreversible( reversible );
+         f.wait_for_import();
+
+         BOOST_REQUIRE_EQUAL( f.count_transfers( irreversible ), 1u );
+         BOOST_REQUIRE_EQUAL( f.count_transfers( reversible ), 1u );
+
+         BOOST_TEST_MESSAGE( "Blocks applied while the plugin is not subscribed are left for the next startup" );
+         f.ah_plugin->plugin_shutdown();
+         missed = f.transfer_block();
+         f.generate_until_irreversible( missed );
+      }
+
+      {
+         async_rocksdb_fixture f( dir.path(), false );
+         f.wait_for_import();
+
+         BOOST_REQUIRE_EQUAL( f.count_transfers( irreversible ), 1u );
+         BOOST_REQUIRE_EQUAL( f.count_transfers( reversible ), 1u );
+         BOOST_REQUIRE_EQUAL( f.count_transfers( missed ), 1u );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
@@ -0,0 +1,121 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/plugins/chain/chain_plugin.hpp>
+#include <steem/plugins/debug_node/debug_node_plugin.hpp>
+
+#include <steem/utilities/tempdir.hpp>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace steem::chain;
+using namespace steem::protocol;
+using steem::plugins::chain::chain_plugin;
+
+/**
+ * Starts chain_plugin, and with it the write thread, on a chain of its own.  Every transaction batch
+ * takes longer than the write lock hold time, so the write thread splits it once the node is live.
+ */
+struct chain_plugin_fixture : public database_fixture
+{
+   chain_plugin_fixture() : dir( steem::utilities::temp_directory_path() )
+   {
+      try
+      {
+         std::vector< std::string > args = {
+            "plugin_test",
+            "--data-dir", dir.path().string(),
+            "--shared-file-size", "8M"
+         };
+         std::vector< char* > argv;
+         for( auto& a : args )
+            argv.push_back( &a[0] );
+
+         db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+         db_plugin->logging = false;
+         appbase::app().initialize< steem::plugins::debug_node::debug_node_plugin >( argv.size(), argv.data() );
+
+         chain = &appbase::app().get_plugin< chain_plugin >();
+         chain->set_write_lock_hold_time( 0 );
+         chain->plugin_startup();
+
+         db = &chain->db();
+         db->_log_hardforks = false;
+
+         generate_block();
+         db->set_hardfork( STEEM_BLOCKCHAIN_VERSION.minor() );
+         // The write thread leaves sync mode once the head block is recent
+         generate_blocks( fc::time_point::now() );
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   ~chain_plugin_fixture()
+   {
+      chain->plugin_shutdown();
+   }
+
+   signed_transaction make_transfer( uint32_t n )
+   {
+      transfer_operation op;
+      op.from = STEEM_INIT_MINER_NAME;
+      op.to = STEEM_NULL_ACCOUNT;
+      op.amount = ASSET( "0.001 TESTS" );
+      op.memo = fc::to_string( n );
+
+      signed_transaction tx;
+      tx.operations.push_back( op );
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      tx.sign( init_account_priv_key, db->get_chain_id() );
+      return tx;
+   }
+
+   fc::temp_directory dir;
+   chain_plugin*      chain = nullptr;
+};
+
+BOOST_FIXTURE_TEST_SUITE( chain_plugin_tests, chain_plugin_fixture )
+
+BOOST_AUTO_TEST_CASE( accept_transactions_results )
+{
+   try
+   {
+      BOOST_REQUIRE( chain->accept_transactions( {} ).empty() );
+
+      // Processed in sync mode, the write thread is live afterwards
+      auto first = chain->accept_transactions( { make_transfer( 0 ) } );
+      BOOST_REQUIRE_EQUAL( first.size(), 1u );
+      BOOST_REQUIRE( !first[0] );
+
+      BOOST_TEST_MESSAGE( "A batch split by the write thread returns once, with a result per transaction" );
+
+      std::vector< signed_transaction > trxs;
+      for( uint32_t i = 1; i <= 50; ++i )
+         trxs.push_back( make_transfer( i ) );
+      // Rejected as a duplicate of the transaction pushed before it
+      trxs.insert( trxs.begin() + 25, trxs[ 10 ] );
+
+      auto results = chain->accept_transactions( trxs );
+      BOOST_REQUIRE_EQUAL( results.size(), trxs.size() );
+      for( size_t i = 0; i < results.size(); ++i )
+         BOOST_REQUIRE_EQUAL( results[i].valid(), i == 25 );
+
+      // Every transaction is pushed by the time the call returns
+      BOOST_REQUIRE_EQUAL( db->_pending_tx.size(), 51u );
+
+      BOOST_TEST_MESSAGE( "Transactions pushed by an earlier batch are rejected as duplicates" );
+
+      auto again = chain->accept_transactions( { trxs[ 0 ], make_transfer( 51 ) } );
+      BOOST_REQUIRE_EQUAL( again.size(), 2u );
+      BOOST_REQUIRE( again[0].valid() );
+      BOOST_REQUIRE( !again[1] );
+      BOOST_REQUIRE_EQUAL( db->_pending_tx.size(), 52u );
+
+      generate_block();
+      BOOST_REQUIRE_EQUAL( db->fetch_block_by_number( db->head_block_num() )->transactions.size(), 52u );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
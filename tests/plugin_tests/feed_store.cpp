@@ -0,0 +1,158 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/plugins/follow/feed_store.hpp>
+
+#include <steem/utilities/tempdir.hpp>
+
+#include <fc/filesystem.hpp>
+
+using namespace steem::protocol;
+using namespace steem::plugins::follow;
+
+namespace {
+
+feed_block make_block( uint32_t num, uint32_t lib, std::vector< feed_event > events = {} )
+{
+   feed_block b;
+   b.block_num = num;
+   b.block_id._hash[0] = num;
+   b.last_irreversible_block = lib;
+   b.events = std::move( events );
+   return b;
+}
+
+feed_event make_event( int64_t comment, std::vector< account_name_type > followers, account_name_type reblogged_by = account_name_type() )
+{
+   feed_event e;
+   e.comment = comment;
+   e.reblogged_by = reblogged_by;
+   e.time = fc::time_point_sec( comment );
+   e.followers = std::move( followers );
+   return e;
+}
+
+std::vector< feed_store_entry > get_feed( const feed_store& store, const account_name_type& account, uint32_t start = ~0, uint32_t limit = 100 )
+{
+   std::vector< feed_store_entry > result;
+   store.find_feed( account, start, limit, [&]( const feed_store_entry& e ){ result.push_back( e ); return true; } );
+   return result;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( feed_store_tests )
+
+BOOST_AUTO_TEST_CASE( ring_buffer_and_undo )
+{
+   try
+   {
+      fc::temp_directory dir( steem::utilities::temp_directory_path() );
+      feed_store store;
+      store.open( dir.path() / "feeds", 3 );
+
+      for( int64_t c = 1; c <= 4; ++c )
+         store.apply_block( make_block( c, 0, { make_event( c, { "alice", "bob" } ) } ) );
+
+      // The ring keeps the newest three posts, feed ids keep counting
+      auto feed = get_feed( store, "alice" );
+      BOOST_REQUIRE_EQUAL( feed.size(), 3u );
+      BOOST_REQUIRE_EQUAL( feed[0].comment, 4 );
+      BOOST_REQUIRE_EQUAL( feed[0].account_feed_id, 3u );
+      BOOST_REQUIRE_EQUAL( feed[2].comment, 2 );
+
+      feed = get_feed( store, "alice", 2, 1 );
+      BOOST_REQUIRE_EQUAL( feed.size(), 1u );
+      BOOST_REQUIRE_EQUAL( feed[0].account_feed_id, 2u );
+
+      // Reblog of a post already in the feed only records the reblogger
+      store.apply_block( make_block( 5, 0, { make_event( 4, { "alice" }, "carol" ), make_event( 5, { "alice" }, "carol" ) } ) );
+      feed = get_feed( store, "alice" );
+      BOOST_REQUIRE_EQUAL( feed[0].comment, 5 );
+      BOOST_REQUIRE_EQUAL( feed[0].reblogged_by.size(), 1u );
+      BOOST_REQUIRE( feed[0].first_reblogged_on == fc::time_point_sec( 5 ) );
+      BOOST_REQUIRE_EQUAL( feed[1].comment, 4 );
+      BOOST_REQUIRE_EQUAL( feed[1].reblogged_by.size(), 1u );
+      BOOST_REQUIRE_EQUAL( feed[2].comment, 3 );
+
+      // Switching to a fork at block 4 undoes blocks 4 and 5, including evicted entries
+      store.apply_block( make_block( 4, 0, { make_event( 6, { "bob" } ) } ) );
+      BOOST_REQUIRE_EQUAL( store.head_block_num(), 4u );
+
+      feed = get_feed( store, "alice" );
+      BOOST_REQUIRE_EQUAL( feed.size(), 3u );
+      BOOST_REQUIRE_EQUAL( feed[0].comment, 3 );
+      BOOST_REQUIRE_EQUAL( feed[0].account_feed_id, 2u );
+      BOOST_REQUIRE_EQUAL( feed[2].comment, 1 );
+
+      feed = get_feed( store, "bob" );
+      BOOST_REQUIRE_EQUAL( feed[0].comment, 6 );
+      BOOST_REQUIRE_EQUAL( feed[0].account_feed_id, 3u );
+
+      // Irreversible blocks are dropped from the journal and persisted on close
+      store.apply_block( make_block( 5, 4 ) );
+      auto head_id = store.head_block_id();
+      store.close();
+
+      store.open( dir.path() / "feeds", 3 );
+      BOOST_REQUIRE( store.head_block_id() == head_id );
+      BOOST_REQUIRE_EQUAL( get_feed( store, "bob" )[0].comment, 6 );
+
+      store.apply_block( make_block( 4, 4 ) );
+      BOOST_REQUIRE_EQUAL( get_feed( store, "bob" )[0].comment, 6 );
+
+      store.wipe();
+      BOOST_REQUIRE( get_feed( store, "bob" ).empty() );
+      store.close();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( reopen_and_invalidate )
+{
+   try
+   {
+      fc::temp_directory dir( steem::utilities::temp_directory_path() );
+      feed_store store;
+      store.open( dir.path() / "feeds", 3 );
+
+      for( int64_t c = 1; c <= 4; ++c )
+         store.apply_block( make_block( c, c - 1, { make_event( c, { "alice" } ) } ) );
+
+      store.close();
+      store.open( dir.path() / "feeds", 3 );
+
+      // Posts of the reopened feed are found again, a reblog is recorded on the existing entry and undone
+      store.apply_block( make_block( 5, 3, { make_event( 3, { "alice" }, "bob" ) } ) );
+      auto feed = get_feed( store, "alice" );
+      BOOST_REQUIRE_EQUAL( feed.size(), 3u );
+      BOOST_REQUIRE_EQUAL( feed[1].comment, 3 );
+      BOOST_REQUIRE_EQUAL( feed[1].reblogged_by.size(), 1u );
+
+      store.apply_block( make_block( 5, 3 ) );
+      feed = get_feed( store, "alice" );
+      BOOST_REQUIRE_EQUAL( feed.size(), 3u );
+      BOOST_REQUIRE( feed[1].reblogged_by.empty() );
+
+      // An invalidated store ignores blocks and leaves no file to be opened again
+      store.invalidate();
+      BOOST_REQUIRE( !store.is_valid() );
+      BOOST_REQUIRE( get_feed( store, "alice" ).empty() );
+
+      store.apply_block( make_block( 6, 5, { make_event( 6, { "alice" } ) } ) );
+      BOOST_REQUIRE( get_feed( store, "alice" ).empty() );
+      BOOST_REQUIRE_EQUAL( store.head_block_num(), 0u );
+
+      store.close();
+      BOOST_REQUIRE( !fc::exists( dir.path() / "feeds" ) );
+
+      store.open( dir.path() / "feeds", 3 );
+      BOOST_REQUIRE( store.is_valid() );
+      BOOST_REQUIRE_EQUAL( store.head_block_num(), 0u );
+      store.close();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
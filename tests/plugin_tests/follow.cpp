@@ -0,0 +1,296 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/chain/account_object.hpp>
+#include <steem/chain/comment_object.hpp>
+#include <steem/chain/util/signal.hpp>
+
+#include <steem/plugins/follow/follow_plugin.hpp>
+#include <steem/plugins/follow/follow_objects.hpp>
+#include <steem/plugins/follow/follow_operations.hpp>
+#include <steem/plugins/debug_node/debug_node_plugin.hpp>
+#include <steem/plugins/witness/witness_plugin.hpp>
+
+#include <steem/utilities/tempdir.hpp>
+
+#include <fc/io/json.hpp>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace steem::chain;
+using namespace steem::protocol;
+using namespace steem::plugins::follow;
+
+/**
+ * Runs the follow plugin on a chain kept in a directory that outlives the fixture, so that
+ * the blocks of one fixture can be reindexed by the next with different plugin options.
+ */
+struct follow_reindex_fixture : public database_fixture
+{
+   follow_reindex_fixture( const fc::path& dir, bool fast_path )
+   {
+      try
+      {
+         std::vector< std::string > args = {
+            "plugin_test",
+            "--data-dir", ( dir / "app" ).string(),
+            "--follow-reindex-fast-path", fast_path ? "true" : "false"
+         };
+         std::vector< char* > argv;
+         for( auto& a : args )
+            argv.push_back( &a[0] );
+
+         appbase::app().register_plugin< follow_plugin >();
+         db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+         appbase::app().register_plugin< steem::plugins::witness::witness_plugin >();
+
+         db_plugin->logging = false;
+         appbase::app().initialize<
+            follow_plugin,
+            steem::plugins::debug_node::debug_node_plugin,
+            steem::plugins::witness::witness_plugin
+            >( argv.size(), argv.data() );
+
+         db = &appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db();
+         BOOST_REQUIRE( db );
+
+         db->_log_hardforks = false;
+
+         open_args.data_dir = dir / "chain";
+         open_args.shared_mem_dir = open_args.data_dir;
+         open_args.initial_supply = INITIAL_TEST_SUPPLY;
+         open_args.shared_file_size = 1024 * 1024 * 8;
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   ~follow_reindex_fixture()
+   {
+      db->close();
+   }
+
+   /// Starts a new chain like the clean fixture, with nothing in it that is not in a block
+   void start_chain()
+   {
+      db->open( open_args );
+
+      generate_block();
+      db->set_hardfork( STEEM_BLOCKCHAIN_VERSION.minor() );
+      generate_block();
+
+      vest( STEEM_INIT_MINER_NAME, 10000 );
+
+      for( int i = STEEM_NUM_INIT_MINERS; i < STEEM_MAX_WITNESSES; i++ )
+      {
+         account_create( STEEM_INIT_MINER_NAME + fc::to_string( i ), init_account_pub_key );
+         fund( STEEM_INIT_MINER_NAME + fc::to_string( i ), STEEM_MIN_PRODUCER_REWARD.amount.value );
+         witness_create( STEEM_INIT_MINER_NAME + fc::to_string( i ), init_account_priv_key, "foo.bar", init_account_pub_key, STEEM_MIN_PRODUCER_REWARD.amount );
+      }
+
+      generate_block();
+   }
+
+   void reindex()
+   {
+      // start_chain() set the hardfork between the first two blocks, outside of any block
+      auto conn = db->add_pre_apply_block_handler( [&]( const block_notification& note )
+      {
+         if( note.block_num == 2 )
+            db->set_hardfork( STEEM_BLOCKCHAIN_VERSION.minor() );
+      }, *db_plugin );
+
+      db->reindex( open_args );
+      steem::chain::util::disconnect_signal( conn );
+   }
+
+   void generate_until_irreversible( uint32_t block_num )
+   {
+      for( int i = 0; db->get_dynamic_global_properties().last_irreversible_block_num < block_num; ++i )
+      {
+         BOOST_REQUIRE( i < 200 );
+         generate_block();
+      }
+   }
+
+   void post( const string& author, const string& permlink, const fc::ecc::private_key& key )
+   {
+      comment_operation op;
+      op.author = author;
+      op.permlink = permlink;
+      op.parent_permlink = "test";
+      op.title = permlink;
+      op.body = permlink;
+      PUSH_OP( op, key )
+   }
+
+   void vote( const string& voter, const string& author, const string& permlink, int16_t weight, const fc::ecc::private_key& key )
+   {
+      vote_operation op;
+      op.voter = voter;
+      op.author = author;
+      op.permlink = permlink;
+      op.weight = weight;
+      PUSH_OP( op, key )
+   }
+
+   void follow( const string& follower, const string& following, const std::set< string >& what, const fc::ecc::private_key& key )
+   {
+      follow_operation fop;
+      fop.follower = follower;
+      fop.following = following;
+      fop.what = what;
+
+      custom_json_operation op;
+      op.id = STEEM_FOLLOW_PLUGIN_NAME;
+      op.json = fc::json::to_string( follow_plugin_operation( fop ) );
+      op.required_posting_auths.insert( follower );
+      PUSH_OP( op, key )
+   }
+
+   const reputation_object* find_reputation( const string& account )const
+   {
+      return db->find< reputation_object, steem::plugins::follow::by_account >( account_name_type( account ) );
+   }
+
+   const follow_count_object& get_follow_count( const string& account )const
+   {
+      return db->get< follow_count_object, steem::plugins::follow::by_account >( account_name_type( account ) );
+   }
+
+   /// Everything but the object ids, which the fast path does not preserve
+   typedef std::vector< std::pair< string, int64_t > > reputations_type;
+   typedef std::vector< std::tuple< string, uint32_t, uint32_t > > follow_counts_type;
+
+   reputations_type get_reputations()const
+   {
+      reputations_type result;
+      for( const auto& r : db->get_index< reputation_index, steem::plugins::follow::by_account >() )
+         result.emplace_back( r.account, r.reputation.value );
+      return result;
+   }
+
+   follow_counts_type get_follow_counts()const
+   {
+      follow_counts_type result;
+      for( const auto& c : db->get_index< follow_count_index, steem::plugins::follow::by_account >() )
+         result.emplace_back( c.account, c.follower_count, c.following_count );
+      return result;
+   }
+
+   database::open_args open_args;
+};
+
+BOOST_AUTO_TEST_SUITE( follow_tests )
+
+BOOST_AUTO_TEST_CASE( reindex_fast_path )
+{
+   try
+   {
+      fc::temp_directory dir( steem::utilities::temp_directory_path() );
+
+      follow_reindex_fixture::reputations_type reputations;
+      follow_reindex_fixture::follow_counts_type follow_counts;
+
+      {
+         BOOST_TEST_MESSAGE( "Building the chain, reputations and follow counts are updated on every operation" );
+         follow_reindex_fixture f( dir.path(), true );
+         f.start_chain();
+
+         auto alice_post_key = database_fixture::generate_private_key( "alice_post" );
+         auto bob_post_key = database_fixture::generate_private_key( "bob_post" );
+         auto carol_post_key = database_fixture::generate_private_key( "carol_post" );
+         auto dave_post_key = database_fixture::generate_private_key( "dave_post" );
+         auto eve_post_key = database_fixture::generate_private_key( "eve_post" );
+         const std::vector< std::pair< string, share_type > > accounts = {
+            { "alice", 1000000 }, { "bob", 1000000 }, { "carol", 10000 }, { "dave", 10000 }, { "eve", 10000 }
+         };
+         for( const auto& a : accounts )
+         {
+            f.account_create( a.first, f.generate_private_key( a.first ).get_public_key(), f.generate_private_key( a.first + "_post" ).get_public_key() );
+            f.fund( a.first, a.second );
+            f.vest( a.first, a.second );
+         }
+         f.generate_block();
+
+         f.follow( "alice", "bob", { "blog" }, alice_post_key );
+         f.follow( "carol", "bob", { "blog" }, carol_post_key );
+         f.follow( "dave", "alice", { "blog" }, dave_post_key );
+         f.follow( "dave", "bob", { "blog" }, dave_post_key );
+         f.follow( "bob", "alice", { "ignore" }, bob_post_key );
+         f.follow( "eve", "bob", { "blog" }, eve_post_key );
+         f.post( "alice", "a", alice_post_key );
+         f.post( "bob", "b", bob_post_key );
+         f.post( "carol", "c", carol_post_key );
+         f.post( "eve", "e", eve_post_key );
+         f.generate_block();
+
+         // Unfollow, ignore to blog, blog to ignore, no change and a new ignore
+         f.follow( "carol", "bob", {}, carol_post_key );
+         f.follow( "bob", "alice", { "blog" }, bob_post_key );
+         f.follow( "eve", "bob", { "ignore" }, eve_post_key );
+         f.follow( "dave", "alice", { "blog" }, dave_post_key );
+         f.follow( "alice", "carol", { "ignore" }, alice_post_key );
+         f.vote( "alice", "bob", "b", STEEM_100_PERCENT, alice_post_key );
+         f.vote( "bob", "alice", "a", STEEM_100_PERCENT, bob_post_key );
+         f.vote( "carol", "eve", "e", STEEM_100_PERCENT, carol_post_key );
+         f.vote( "dave", "carol", "c", STEEM_100_PERCENT, dave_post_key );
+         f.generate_block();
+
+         // Outweighs carol's upvote, eve's reputation turns negative
+         f.vote( "alice", "eve", "e", -STEEM_100_PERCENT, alice_post_key );
+         f.generate_block();
+
+         auto alice_rep = f.find_reputation( "alice" )->reputation;
+         auto bob_rep = f.find_reputation( "bob" )->reputation;
+         BOOST_REQUIRE( f.find_reputation( "eve" )->reputation < 0 );
+
+         // Rule #1, eve's reputation is negative
+         f.vote( "eve", "bob", "b", STEEM_100_PERCENT, eve_post_key );
+         // Rule #2, dave has no reputation to downvote alice with
+         f.vote( "dave", "alice", "a", -STEEM_100_PERCENT, dave_post_key );
+         f.generate_block();
+
+         BOOST_REQUIRE( f.find_reputation( "alice" )->reputation == alice_rep );
+         BOOST_REQUIRE( f.find_reputation( "bob" )->reputation == bob_rep );
+         BOOST_REQUIRE( f.find_reputation( "dave" ) == nullptr );
+
+         // The downvote is taken back, eve's reputation is positive again
+         f.vote( "alice", "eve", "e", STEEM_100_PERCENT, alice_post_key );
+         // Carol's reputation only came from this vote, it is removed before the new vote sets it
+         f.vote( "dave", "carol", "c", 0, dave_post_key );
+         f.generate_block();
+
+         BOOST_REQUIRE( f.find_reputation( "eve" )->reputation > 0 );
+         BOOST_REQUIRE( f.find_reputation( "carol" )->reputation == 0 );
+
+         // Now counted, taking back the earlier vote that was not
+         f.vote( "eve", "bob", "b", 50 * STEEM_1_PERCENT, eve_post_key );
+         f.generate_block();
+
+         f.generate_until_irreversible( f.db->head_block_num() );
+         reputations = f.get_reputations();
+         follow_counts = f.get_follow_counts();
+
+         BOOST_REQUIRE_EQUAL( reputations.size(), 4u );
+         BOOST_REQUIRE_EQUAL( f.get_follow_count( "alice" ).follower_count, 2u );
+         BOOST_REQUIRE_EQUAL( f.get_follow_count( "bob" ).follower_count, 2u );
+         BOOST_REQUIRE_EQUAL( f.get_follow_count( "carol" ).follower_count, 0u );
+         BOOST_REQUIRE_EQUAL( f.get_follow_count( "carol" ).following_count, 0u );
+         BOOST_REQUIRE_EQUAL( f.get_follow_count( "dave" ).following_count, 2u );
+      }
+
+      for( bool fast_path : { false, true } )
+      {
+         BOOST_TEST_MESSAGE( std::string( "Reindexing with the fast path " ) + ( fast_path ? "on" : "off" ) );
+         follow_reindex_fixture f( dir.path(), fast_path );
+         f.reindex();
+
+         BOOST_REQUIRE( f.get_reputations() == reputations );
+         BOOST_REQUIRE( f.get_follow_counts() == follow_counts );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
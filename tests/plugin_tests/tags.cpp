@@ -0,0 +1,370 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/chain/account_object.hpp>
+#include <steem/chain/comment_object.hpp>
+#include <steem/chain/util/signal.hpp>
+
+#include <steem/plugins/tags/tags_plugin.hpp>
+#include <steem/plugins/tags_api/tags_api_plugin.hpp>
+#include <steem/plugins/tags_api/tags_api.hpp>
+#include <steem/plugins/debug_node/debug_node_plugin.hpp>
+#include <steem/plugins/witness/witness_plugin.hpp>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace steem::chain;
+using namespace steem::protocol;
+using namespace steem::plugins::tags;
+
+/**
+ * Like the clean fixture, with the tags plugin started so that votes and replies update the tags,
+ * and the tags API to read them back.
+ */
+struct tags_fixture : public database_fixture
+{
+   tags_fixture()
+   {
+      try
+      {
+         int argc = boost::unit_test::framework::master_test_suite().argc;
+         char** argv = boost::unit_test::framework::master_test_suite().argv;
+
+         auto& tags = appbase::app().register_plugin< tags_plugin >();
+         appbase::app().register_plugin< tags_api_plugin >();
+         db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+         appbase::app().register_plugin< steem::plugins::witness::witness_plugin >();
+
+         db_plugin->logging = false;
+         appbase::app().initialize<
+            tags_plugin,
+            tags_api_plugin,
+            steem::plugins::debug_node::debug_node_plugin,
+            steem::plugins::witness::witness_plugin
+            >( argc, argv );
+
+         db = &appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db();
+         BOOST_REQUIRE( db );
+
+         open_database();
+         tags.plugin_startup();
+         api = appbase::app().get_plugin< tags_api_plugin >().api.get();
+
+         generate_block();
+         db->set_hardfork( STEEM_BLOCKCHAIN_VERSION.minor() );
+         generate_block();
+
+         vest( STEEM_INIT_MINER_NAME, 10000 );
+
+         for( int i = STEEM_NUM_INIT_MINERS; i < STEEM_MAX_WITNESSES; i++ )
+         {
+            account_create( STEEM_INIT_MINER_NAME + fc::to_string( i ), init_account_pub_key );
+            fund( STEEM_INIT_MINER_NAME + fc::to_string( i ), STEEM_MIN_PRODUCER_REWARD.amount.value );
+            witness_create( STEEM_INIT_MINER_NAME + fc::to_string( i ), init_account_priv_key, "foo.bar", init_account_pub_key, STEEM_MIN_PRODUCER_REWARD.amount );
+         }
+
+         generate_block();
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   ~tags_fixture()
+   {
+      if( data_dir )
+         db->wipe( data_dir->path(), data_dir->path(), true );
+   }
+
+   void comment( const string& author, const string& permlink, const string& parent_author, const string& parent_permlink,
+      const string& json_metadata, const fc::ecc::private_key& key )
+   {
+      comment_operation op;
+      op.author = author;
+      op.permlink = permlink;
+      op.parent_author = parent_author;
+      op.parent_permlink = parent_permlink;
+      op.title = parent_author.size() ? "" : permlink;
+      op.body = permlink;
+      op.json_metadata = json_metadata;
+      PUSH_OP( op, key )
+   }
+
+   void vote( const string& voter, const string& author, const string& permlink, int16_t weight, const fc::ecc::private_key& key )
+   {
+      vote_operation op;
+      op.voter = voter;
+      op.author = author;
+      op.permlink = permlink;
+      op.weight = weight;
+      PUSH_OP( op, key )
+   }
+
+   void delete_comment( const string& author, const string& permlink, const fc::ecc::private_key& key )
+   {
+      delete_comment_operation op;
+      op.author = author;
+      op.permlink = permlink;
+      PUSH_OP( op, key )
+   }
+
+   /// Changes the body of a comment without a block, so only a query that misses the cache sees it
+   void set_body( const string& author, const string& permlink, const string& body )
+   {
+      const auto& c = db->get_comment( author, permlink );
+      db->modify( db->get< comment_content_object, steem::chain::by_comment >( c.id ), [&]( comment_content_object& con )
+      {
+         from_string( con.body, body );
+      });
+   }
+
+   tags_api* api = nullptr;
+};
+
+/// The hot and trending scores the tags plugin computes for a comment
+template< int64_t S, int32_t T >
+double expected_score( const share_type& score, const fc::time_point_sec& created )
+{
+   auto mod_score = score.value / S;
+   double order = log10( std::max< int64_t >( std::abs( mod_score ), 1 ) );
+   int sign = mod_score > 0 ? 1 : mod_score < 0 ? -1 : 0;
+   return sign * order + double( created.sec_since_epoch() ) / double( T );
+}
+
+/// Sums kept by tag_stats_object
+struct tag_sums
+{
+   int64_t     top_posts = 0;
+   int64_t     comments = 0;
+   int64_t     net_votes = 0;
+   fc::uint128 total_trending = 0;
+
+   void add( bool is_post, int32_t votes, double trending )
+   {
+      if( is_post )
+         ++top_posts;
+      else
+         ++comments;
+      net_votes += votes;
+      total_trending += static_cast< uint32_t >( trending );
+   }
+
+   bool operator == ( const tag_sums& o )const
+   {
+      return top_posts == o.top_posts && comments == o.comments && net_votes == o.net_votes && total_trending == o.total_trending;
+   }
+};
+
+BOOST_FIXTURE_TEST_SUITE( tags_tests, tags_fixture )
+
+BOOST_AUTO_TEST_CASE( tags_updated_once_per_block )
+{
+   try
+   {
+      ACTORS( (alice)(bob)(sam)(dave)(carol)(eve) )
+      for( const auto& name : { "alice", "bob", "sam", "dave", "carol", "eve" } )
+         vest( name, ASSET( "100.000 TESTS" ) );
+      generate_block();
+
+      /// Every comment is created with no rshares and so gets the universal tag as well
+      std::map< string, std::set< string > > comment_tags = {
+         { "p1", { "", "steem", "food" } },
+         { "p2", { "", "steem" } },
+         { "x",  { "", "food" } },
+         { "r1", { "", "food" } },
+         { "r2", { "", "steem" } },
+         { "r3", { "", "steem" } }
+      };
+
+      comment( "alice", "p1", "", "steem", "{\"tags\":[\"steem\",\"food\"]}", alice_post_key );
+      comment( "bob", "p2", "", "steem", "{\"tags\":[\"steem\"]}", bob_post_key );
+      comment( "sam", "x", "", "food", "{\"tags\":[\"food\"]}", sam_post_key );
+      generate_block();
+
+      std::map< string, tag_sums > stats_before, rows_before, deleted;
+      for( const auto& s : db->get_index< tag_stats_index, by_tag >() )
+      {
+         auto& sums = stats_before[ string( s.tag ) ];
+         sums.top_posts = s.top_posts;
+         sums.comments = s.comments;
+         sums.net_votes = s.net_votes;
+         sums.total_trending = s.total_trending;
+      }
+      for( const auto& t : db->get_index< tag_index, steem::plugins::tags::by_comment >() )
+         rows_before[ string( t.tag ) ].add( t.is_post(), t.net_votes, t.trending );
+
+      /// The tags of a deleted comment are removed without updating the stats, which keep its last values
+      auto conn = db->add_pre_apply_operation_handler( [&]( const operation_notification& note )
+      {
+         if( !db->is_processing_block() || note.op.which() != operation::tag< delete_comment_operation >::value )
+            return;
+
+         const auto& op = note.op.get< delete_comment_operation >();
+         const auto& c = db->get_comment( op.author, op.permlink );
+         for( const auto& tag : comment_tags[ op.permlink ] )
+            deleted[ tag ].add( c.parent_author.size() == 0, c.net_votes, expected_score< 10000000, 480000 >( c.net_rshares, c.created ) );
+      }, *db_plugin );
+
+      BOOST_TEST_MESSAGE( "Applying votes, replies and deletes in one block" );
+
+      vote( "dave", "alice", "p1", STEEM_100_PERCENT, dave_post_key );
+      vote( "carol", "alice", "p1", 50 * STEEM_1_PERCENT, carol_post_key );
+      comment( "bob", "r1", "alice", "p1", "{\"tags\":[\"food\"]}", bob_post_key );
+      comment( "dave", "r2", "bob", "r1", "{\"tags\":[\"steem\"]}", dave_post_key );
+      vote( "sam", "bob", "p2", STEEM_100_PERCENT, sam_post_key );
+      // Queued by the downvote, then deleted
+      vote( "eve", "sam", "x", -STEEM_100_PERCENT, eve_post_key );
+      delete_comment( "sam", "x", sam_post_key );
+      // Queued along with its parents when it is created, then deleted
+      comment( "carol", "r3", "bob", "r1", "{\"tags\":[\"steem\"]}", carol_post_key );
+      delete_comment( "carol", "r3", carol_post_key );
+      // Brings the parents up to date after the delete
+      vote( "alice", "bob", "r1", STEEM_100_PERCENT, alice_post_key );
+      generate_block();
+
+      steem::chain::util::disconnect_signal( conn );
+
+      BOOST_REQUIRE_EQUAL( db->fetch_block_by_number( db->head_block_num() )->transactions.size(), 10u );
+      BOOST_REQUIRE( db->find_comment( "sam", string( "x" ) ) == nullptr );
+      BOOST_REQUIRE( db->find_comment( "carol", string( "r3" ) ) == nullptr );
+      BOOST_REQUIRE_EQUAL( deleted[ "" ].top_posts, 1 );
+      BOOST_REQUIRE_EQUAL( deleted[ "" ].comments, 1 );
+
+      BOOST_TEST_MESSAGE( "--- Tag rows match the comments they were last updated from" );
+
+      std::map< string, tag_sums > rows_after;
+      for( const auto& t : db->get_index< tag_index, steem::plugins::tags::by_comment >() )
+      {
+         BOOST_REQUIRE( db->find< comment_object >( t.comment ) != nullptr );
+         rows_after[ string( t.tag ) ].add( t.is_post(), t.net_votes, t.trending );
+      }
+
+      const auto& comment_idx = db->get_index< tag_index, steem::plugins::tags::by_comment >();
+      for( const auto& item : std::vector< std::pair< string, string > >{ { "alice", "p1" }, { "bob", "p2" }, { "bob", "r1" }, { "dave", "r2" } } )
+      {
+         const auto& c = db->get_comment( item.first, item.second );
+         std::set< string > tags;
+
+         for( auto itr = comment_idx.lower_bound( c.id ); itr != comment_idx.end() && itr->comment == c.id; ++itr )
+         {
+            tags.insert( string( itr->tag ) );
+            BOOST_REQUIRE( itr->active == c.active );
+            BOOST_REQUIRE( itr->cashout == db->calculate_discussion_payout_time( c ) );
+            BOOST_REQUIRE_EQUAL( itr->children, c.children );
+            BOOST_REQUIRE_EQUAL( itr->net_votes, c.net_votes );
+            BOOST_REQUIRE_EQUAL( itr->net_rshares, c.net_rshares.value );
+            BOOST_REQUIRE_EQUAL( itr->hot, ( expected_score< 10000000, 10000 >( c.net_rshares, c.created ) ) );
+            BOOST_REQUIRE_EQUAL( itr->trending, ( expected_score< 10000000, 480000 >( c.net_rshares, c.created ) ) );
+         }
+
+         BOOST_REQUIRE( tags == comment_tags[ item.second ] );
+      }
+
+      const auto& p1 = db->get_comment( "alice", string( "p1" ) );
+      BOOST_REQUIRE_EQUAL( p1.children, 2 );
+      BOOST_REQUIRE_EQUAL( p1.net_votes, 2 );
+      BOOST_REQUIRE_EQUAL( db->get_comment( "bob", string( "r1" ) ).net_votes, 1 );
+
+      BOOST_TEST_MESSAGE( "--- Tag stats changed by the rows as if each operation had updated them" );
+
+      std::set< string > all_tags;
+      for( const auto& item : comment_tags )
+         all_tags.insert( item.second.begin(), item.second.end() );
+
+      for( const auto& tag : all_tags )
+      {
+         const auto& s = db->get< tag_stats_object, by_tag >( tag_name_type( tag ) );
+         tag_sums after;
+         after.top_posts = s.top_posts + rows_before[ tag ].top_posts;
+         after.comments = s.comments + rows_before[ tag ].comments;
+         after.net_votes = s.net_votes + rows_before[ tag ].net_votes;
+         after.total_trending = s.total_trending + rows_before[ tag ].total_trending;
+
+         tag_sums expected = stats_before[ tag ];
+         expected.top_posts += rows_after[ tag ].top_posts + deleted[ tag ].top_posts;
+         expected.comments += rows_after[ tag ].comments + deleted[ tag ].comments;
+         expected.net_votes += rows_after[ tag ].net_votes + deleted[ tag ].net_votes;
+         expected.total_trending += rows_after[ tag ].total_trending + deleted[ tag ].total_trending;
+
+         BOOST_REQUIRE( after == expected );
+      }
+
+      validate_database();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( discussion_cache )
+{
+   try
+   {
+      ACTORS( (alice)(bob)(carol) )
+      generate_block();
+
+      comment( "alice", "p1", "", "steem", "{\"tags\":[\"steem\"]}", alice_post_key );
+      generate_block();
+      comment( "bob", "p2", "", "steem", "{\"tags\":[\"steem\"]}", bob_post_key );
+      generate_block();
+
+      discussion_query q;
+      q.tag = "steem";
+      q.limit = 10;
+
+      auto first = api->get_discussions_by_created( q );
+      BOOST_REQUIRE_EQUAL( first.discussions.size(), 2u );
+      BOOST_REQUIRE_EQUAL( first.discussions[0].permlink, "p2" );
+      BOOST_REQUIRE_EQUAL( first.discussions[0].body, "p2" );
+
+      set_body( "bob", "p2", "changed" );
+
+      BOOST_TEST_MESSAGE( "--- The same query in the same block is answered from the cache" );
+
+      auto cached = api->get_discussions_by_created( q );
+      BOOST_REQUIRE_EQUAL( cached.discussions.size(), 2u );
+      BOOST_REQUIRE_EQUAL( cached.discussions[0].body, "p2" );
+
+      // Pages that do not start at the top are never cached
+      auto paged = q;
+      paged.start_author = "bob";
+      paged.start_permlink = "p2";
+      BOOST_REQUIRE_EQUAL( api->get_discussions_by_created( paged ).discussions[0].body, "changed" );
+
+      BOOST_TEST_MESSAGE( "--- Different limit and truncate_body values are cached apart" );
+
+      auto truncated = q;
+      truncated.truncate_body = 1;
+      auto truncated_result = api->get_discussions_by_created( truncated );
+      BOOST_REQUIRE_EQUAL( truncated_result.discussions.size(), 2u );
+      BOOST_REQUIRE_EQUAL( truncated_result.discussions[0].body, "c" );
+      BOOST_REQUIRE_EQUAL( truncated_result.discussions[0].body_length, 7u );
+
+      auto limited = q;
+      limited.limit = 1;
+      auto limited_result = api->get_discussions_by_created( limited );
+      BOOST_REQUIRE_EQUAL( limited_result.discussions.size(), 1u );
+      BOOST_REQUIRE_EQUAL( limited_result.discussions[0].body, "changed" );
+
+      // Other sorts are cached under their own keys as well
+      BOOST_REQUIRE_EQUAL( api->get_discussions_by_active( q ).discussions[0].body, "changed" );
+
+      // Every key keeps the page it was first built with
+      BOOST_REQUIRE_EQUAL( api->get_discussions_by_created( q ).discussions[0].body, "p2" );
+      BOOST_REQUIRE_EQUAL( api->get_discussions_by_created( truncated ).discussions[0].body, "c" );
+
+      BOOST_TEST_MESSAGE( "--- A new block drops the cache" );
+
+      comment( "carol", "p3", "", "steem", "{\"tags\":[\"steem\"]}", carol_post_key );
+      generate_block();
+
+      auto after_block = api->get_discussions_by_created( q );
+      BOOST_REQUIRE_EQUAL( after_block.discussions.size(), 3u );
+      BOOST_REQUIRE_EQUAL( after_block.discussions[0].permlink, "p3" );
+      BOOST_REQUIRE_EQUAL( after_block.discussions[1].body, "changed" );
+
+      auto limited_after_block = api->get_discussions_by_created( limited );
+      BOOST_REQUIRE_EQUAL( limited_after_block.discussions.size(), 1u );
+      BOOST_REQUIRE_EQUAL( limited_after_block.discussions[0].permlink, "p3" );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
@@ -24,6 +24,7 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <steem/chain/applied_block_record.hpp>
 #include <steem/chain/database.hpp>
 #include <steem/protocol/protocol.hpp>
 
@@ -324,4 +325,106 @@ BOOST_AUTO_TEST_CASE( merkle_root )
    BOOST_CHECK( block.calculate_merkle_root() == c(dO) );
 }
 
+BOOST_AUTO_TEST_CASE( async_block_subscription_test )
+{
+   try
+   {
+      auto make_record = []( uint32_t block_num )
+      {
+         auto record = std::make_shared< applied_block_record >();
+         record->block_num = block_num;
+         return applied_block_record_ptr( record );
+      };
+
+      BOOST_TEST_MESSAGE( "Records are handled in order and wait() returns once all of them are" );
+
+      std::vector< uint32_t > handled;
+      boost::mutex gate;
+      {
+         async_block_subscription sub( "ordered", [&]( const applied_block_record_ptr& r )
+         {
+            boost::unique_lock< boost::mutex > lock( gate );
+            handled.push_back( r->block_num );
+         }, 1000 );
+
+         for( uint32_t b = 1; b <= 100; ++b )
+            sub.push( make_record( b ) );
+
+         sub.wait();
+         BOOST_REQUIRE_EQUAL( sub.queued_blocks(), 0u );
+         BOOST_REQUIRE_EQUAL( sub.last_block_num(), 100u );
+         BOOST_REQUIRE_EQUAL( handled.size(), 100u );
+         for( uint32_t b = 1; b <= 100; ++b )
+            BOOST_REQUIRE_EQUAL( handled[ b - 1 ], b );
+      }
+
+      BOOST_TEST_MESSAGE( "The queue is bounded and push waits for the handler" );
+
+      handled.clear();
+      {
+         boost::unique_lock< boost::mutex > hold( gate );
+
+         std::atomic< bool > entered( false );
+         async_block_subscription sub( "bounded", [&]( const applied_block_record_ptr& r )
+         {
+            entered = true;
+            boost::unique_lock< boost::mutex > lock( gate );
+            handled.push_back( r->block_num );
+         }, 2 );
+
+         // The first record is taken by the handler, which blocks on the gate, two more fill the queue
+         sub.push( make_record( 1 ) );
+         while( !entered )
+            boost::this_thread::sleep_for( boost::chrono::milliseconds( 1 ) );
+
+         sub.push( make_record( 2 ) );
+         sub.push( make_record( 3 ) );
+         BOOST_REQUIRE_EQUAL( sub.queued_blocks(), 3u );
+
+         std::atomic< bool > pushed( false );
+         boost::thread pusher( [&]()
+         {
+            sub.push( make_record( 4 ) );
+            pushed = true;
+         } );
+
+         boost::this_thread::sleep_for( boost::chrono::milliseconds( 50 ) );
+         BOOST_REQUIRE( !pushed );
+
+         hold.unlock();
+         pusher.join();
+         BOOST_REQUIRE( pushed );
+
+         sub.wait();
+         BOOST_REQUIRE_EQUAL( sub.last_block_num(), 4u );
+      }
+      BOOST_REQUIRE_EQUAL( handled.size(), 4u );
+
+      BOOST_TEST_MESSAGE( "stop() handles the remaining records, failing handlers do not stop the thread" );
+
+      handled.clear();
+      {
+         boost::unique_lock< boost::mutex > hold( gate );
+
+         async_block_subscription sub( "stopped", [&]( const applied_block_record_ptr& r )
+         {
+            boost::unique_lock< boost::mutex > lock( gate );
+            handled.push_back( r->block_num );
+            FC_ASSERT( r->block_num != 2 );
+         }, 10 );
+
+         for( uint32_t b = 1; b <= 5; ++b )
+            sub.push( make_record( b ) );
+
+         hold.unlock();
+         sub.stop();
+
+         BOOST_REQUIRE_EQUAL( handled.size(), 5u );
+         BOOST_REQUIRE_EQUAL( sub.last_block_num(), 5u );
+         BOOST_REQUIRE_THROW( sub.push( make_record( 6 ) ), fc::exception );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
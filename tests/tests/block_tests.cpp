@@ -27,13 +27,16 @@
 #include <steem/protocol/exceptions.hpp>
 
 #include <steem/chain/database.hpp>
+#include <steem/chain/database_exceptions.hpp>
 #include <steem/chain/steem_objects.hpp>
 #include <steem/chain/history_object.hpp>
+#include <steem/chain/util/transaction_schedule.hpp>
 
 #include <steem/plugins/account_history/account_history_plugin.hpp>
 
 #include <steem/utilities/tempdir.hpp>
 
+#include <fc/bitutil.hpp>
 #include <fc/crypto/digest.hpp>
 
 #include "../db_fixture/database_fixture.hpp"
@@ -233,8 +236,161 @@ BOOST_AUTO_TEST_CASE( fork_blocks )
 
       // assert that db1 switches to new fork with good block
       BOOST_CHECK_EQUAL(db2.head_block_num(), 14);
-      PUSH_BLOCK( db1, good_block );
+      BOOST_CHECK( PUSH_BLOCK( db1, good_block ) );
       BOOST_CHECK_EQUAL(db1.head_block_id().str(), db2.head_block_id().str());
+      BOOST_CHECK_EQUAL(db1.get_last_fork_switch().undone_blocks, 3);
+      BOOST_CHECK_EQUAL(db1.get_last_fork_switch().applied_blocks, 4);
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( unlinked_blocks )
+{
+   try {
+      fc::temp_directory data_dir1( steem::utilities::temp_directory_path() );
+      fc::temp_directory data_dir2( steem::utilities::temp_directory_path() );
+
+      database db1;
+      db1._log_hardforks = false;
+      open_test_database( db1, data_dir1.path() );
+      database db2;
+      db2._log_hardforks = false;
+      open_test_database( db2, data_dir2.path() );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      vector< signed_block > blocks;
+      for( uint32_t i = 0; i < 6; ++i )
+         blocks.push_back( db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing) );
+
+      PUSH_BLOCK( db2, blocks[0] );
+      PUSH_BLOCK( db2, blocks[1] );
+
+      // Blocks arriving ahead of their previous block wait in the fork database
+      STEEM_CHECK_THROW( PUSH_BLOCK( db2, blocks[3] ), unlinkable_block_exception );
+      STEEM_CHECK_THROW( PUSH_BLOCK( db2, blocks[4] ), unlinkable_block_exception );
+      BOOST_CHECK( db2.is_known_block( blocks[4].id() ) );
+      BOOST_CHECK_EQUAL( db2.get_fork_db().unlinked_block_count(), 2u );
+      BOOST_CHECK_EQUAL( db2.head_block_num(), 2u );
+
+      // and are applied once it arrives
+      PUSH_BLOCK( db2, blocks[2] );
+      BOOST_CHECK_EQUAL( db2.get_fork_db().unlinked_block_count(), 0u );
+      BOOST_CHECK_EQUAL( db2.head_block_id().str(), blocks[4].id().str() );
+
+      PUSH_BLOCK( db2, blocks[5] );
+      BOOST_CHECK_EQUAL( db2.head_block_id().str(), db1.head_block_id().str() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( unlinked_blocks_bounded )
+{
+   try {
+      fc::temp_directory data_dir( steem::utilities::temp_directory_path() );
+
+      database db;
+      db._log_hardforks = false;
+      open_test_database( db, data_dir.path() );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      vector< signed_block > blocks;
+      for( uint32_t i = 0; i < 10; ++i )
+         blocks.push_back( db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing) );
+
+      // empty blocks of the same witness all have the same size
+      const uint64_t block_size = fc::raw::pack_size( blocks[3] );
+      BOOST_REQUIRE_EQUAL( fc::raw::pack_size( blocks[9] ), block_size );
+
+      fork_database fork_db;
+      fork_db.start_block( blocks[0] );
+      fork_db.push_block( blocks[1] );
+      fork_db.set_max_unlinked_size( 4 * block_size );
+
+      // Blocks furthest ahead of head are evicted first, they are the last to link
+      for( uint32_t i = 3; i < 10; ++i )
+         STEEM_CHECK_THROW( fork_db.push_block( blocks[i] ), unlinkable_block_exception );
+      BOOST_CHECK_EQUAL( fork_db.unlinked_block_count(), 4u );
+      BOOST_CHECK_EQUAL( fork_db.unlinked_size(), 4 * block_size );
+
+      // Pushed again, an unlinked block is only counted once
+      STEEM_CHECK_THROW( fork_db.push_block( blocks[4] ), unlinkable_block_exception );
+      BOOST_CHECK_EQUAL( fork_db.unlinked_block_count(), 4u );
+      BOOST_CHECK_EQUAL( fork_db.unlinked_size(), 4 * block_size );
+
+      fork_db.set_max_unlinked_size( 2 * block_size );
+      BOOST_CHECK_EQUAL( fork_db.unlinked_block_count(), 2u );
+      BOOST_CHECK_EQUAL( fork_db.unlinked_size(), 2 * block_size );
+
+      // A block too far ahead of head to ever link before it is evicted is not kept
+      signed_block far_ahead = blocks[9];
+      far_ahead.previous = block_id_type();
+      far_ahead.previous._hash[0] = fc::endian_reverse_u32( blocks[1].block_num() + fork_database::MAX_BLOCK_REORDERING + 1 );
+      BOOST_REQUIRE_EQUAL( far_ahead.block_num(), blocks[1].block_num() + fork_database::MAX_BLOCK_REORDERING + 2 );
+      fork_db.set_max_unlinked_size( fork_database::DEFAULT_MAX_UNLINKED_SIZE );
+      STEEM_CHECK_THROW( fork_db.push_block( far_ahead ), unlinkable_block_exception );
+      BOOST_CHECK_EQUAL( fork_db.unlinked_block_count(), 2u );
+
+      // The blocks that were kept link, the evicted ones have to be pushed again
+      BOOST_CHECK( fork_db.push_block( blocks[2] )->id == blocks[4].id() );
+      BOOST_CHECK_EQUAL( fork_db.unlinked_block_count(), 0u );
+      BOOST_CHECK_EQUAL( fork_db.unlinked_size(), 0u );
+      BOOST_CHECK( !fork_db.is_known_block( blocks[5].id() ) );
+      for( uint32_t i = 5; i < 10; ++i )
+         BOOST_CHECK( fork_db.push_block( blocks[i] )->id == blocks[i].id() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( invalid_block_linked_from_unlinked_pool )
+{
+   try {
+      fc::temp_directory data_dir1( steem::utilities::temp_directory_path() );
+      fc::temp_directory data_dir2( steem::utilities::temp_directory_path() );
+
+      database db1;
+      db1._log_hardforks = false;
+      open_test_database( db1, data_dir1.path() );
+      database db2;
+      db2._log_hardforks = false;
+      open_test_database( db2, data_dir2.path() );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      vector< signed_block > blocks;
+      for( uint32_t i = 0; i < 5; ++i )
+         blocks.push_back( db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing) );
+
+      PUSH_BLOCK( db2, blocks[0] );
+      PUSH_BLOCK( db2, blocks[1] );
+
+      // Links to blocks[3] but doesn't match its merkle root
+      signed_block invalid = blocks[4];
+      invalid.transactions.emplace_back( signed_transaction() );
+      invalid.transactions.back().operations.emplace_back( transfer_operation() );
+      invalid.sign( init_account_priv_key );
+
+      STEEM_CHECK_THROW( PUSH_BLOCK( db2, blocks[3] ), unlinkable_block_exception );
+      STEEM_CHECK_THROW( PUSH_BLOCK( db2, invalid ), unlinkable_block_exception );
+      BOOST_CHECK_EQUAL( db2.get_fork_db().unlinked_block_count(), 2u );
+
+      // The chain up to blocks[3] is kept, only the invalid block is dropped
+      BOOST_CHECK( PUSH_BLOCK( db2, blocks[2] ) );
+      BOOST_CHECK_EQUAL( db2.head_block_id().str(), blocks[3].id().str() );
+      BOOST_CHECK_EQUAL( db2.get_fork_db().head()->id.str(), blocks[3].id().str() );
+      BOOST_CHECK( !db2.is_known_block( invalid.id() ) );
+      BOOST_CHECK_EQUAL( db2.get_fork_db().unlinked_block_count(), 0u );
+
+      // Nothing was undone, head was only extended
+      BOOST_CHECK_EQUAL( db2.get_last_fork_switch().undone_blocks, 0u );
+      BOOST_CHECK_EQUAL( db2.get_last_fork_switch().applied_blocks, 2u );
+
+      PUSH_BLOCK( db2, blocks[4] );
+      BOOST_CHECK_EQUAL( db2.head_block_id().str(), db1.head_block_id().str() );
    } catch (fc::exception& e) {
       edump((e.to_detail_string()));
       throw;
@@ -354,6 +510,141 @@ BOOST_AUTO_TEST_CASE( duplicate_transactions )
    }
 }
 
+BOOST_AUTO_TEST_CASE( prevalidated_transactions )
+{
+   try {
+      fc::temp_directory dir1( steem::utilities::temp_directory_path() ),
+                         dir2( steem::utilities::temp_directory_path() ),
+                         dir3( steem::utilities::temp_directory_path() );
+      database db1,
+               db2,
+               db3;
+      db1._log_hardforks = false;
+      open_test_database( db1, dir1.path() );
+      db2._log_hardforks = false;
+      open_test_database( db2, dir2.path() );
+      db3._log_hardforks = false;
+      open_test_database( db3, dir3.path() );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      public_key_type init_account_pub_key  = init_account_priv_key.get_public_key();
+      auto other_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("other_key")) );
+
+      // What the chain plugin does on its validation threads, nothing is cached for a transaction that fails
+      auto prevalidate = [&]( database& db, const signed_transaction& trx )
+      {
+         try
+         {
+            trx.validate();
+            db.add_validated_transaction( trx.id(), trx, trx.get_signature_keys( db.get_chain_id() ) );
+            return true;
+         }
+         catch( const fc::exception& ) {}
+
+         return false;
+      };
+
+      BOOST_TEST_MESSAGE( "--- Pushing a block to db2 with prevalidated transactions and to db3 without" );
+
+      signed_transaction trx;
+      account_create_operation cop;
+      cop.new_account_name = "alice";
+      cop.creator = STEEM_INIT_MINER_NAME;
+      cop.owner = authority(1, init_account_pub_key, 1);
+      cop.active = cop.owner;
+      trx.operations.push_back(cop);
+      trx.set_expiration( db1.head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      trx.sign( init_account_priv_key, db1.get_chain_id() );
+      PUSH_TX( db1, trx );
+
+      trx = decltype(trx)();
+      transfer_operation t;
+      t.from = STEEM_INIT_MINER_NAME;
+      t.to = "alice";
+      t.amount = asset(1000,STEEM_SYMBOL);
+      trx.operations.push_back(t);
+      trx.set_expiration( db1.head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      trx.sign( init_account_priv_key, db1.get_chain_id() );
+      PUSH_TX( db1, trx );
+
+      auto b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+      BOOST_REQUIRE( b.transactions.size() == 2 );
+
+      for( const auto& block_trx : b.transactions )
+         BOOST_REQUIRE( prevalidate( db2, block_trx ) );
+
+      PUSH_BLOCK( db2, b );
+      PUSH_BLOCK( db3, b );
+
+      for( const auto& block_trx : b.transactions )
+         db2.remove_validated_transaction( block_trx.id() );
+
+      BOOST_REQUIRE( db2.head_block_id() == db3.head_block_id() );
+      BOOST_REQUIRE( db2.get_balance( "alice", STEEM_SYMBOL ) == db3.get_balance( "alice", STEEM_SYMBOL ) );
+
+      BOOST_TEST_MESSAGE( "--- Pushing a transaction batch to db2 with prevalidated transactions and to db3 without" );
+
+      std::vector< signed_transaction > batch;
+
+      t.from = "alice";
+      t.to = STEEM_INIT_MINER_NAME;
+      t.amount = asset(100,STEEM_SYMBOL);
+      trx.clear();
+      trx.operations.push_back(t);
+      trx.set_expiration( db2.head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      trx.sign( init_account_priv_key, db2.get_chain_id() );
+      batch.push_back( trx );
+
+      // Signed with a key that has no authority over alice
+      t.amount = asset(200,STEEM_SYMBOL);
+      trx.clear();
+      trx.operations.push_back(t);
+      trx.sign( other_priv_key, db2.get_chain_id() );
+      batch.push_back( trx );
+
+      // Fails validate()
+      t.amount = asset(-300,STEEM_SYMBOL);
+      trx.clear();
+      trx.operations.push_back(t);
+      trx.sign( init_account_priv_key, db2.get_chain_id() );
+      batch.push_back( trx );
+
+      // Overdraws alice after the first transfer
+      t.amount = asset(950,STEEM_SYMBOL);
+      trx.clear();
+      trx.operations.push_back(t);
+      trx.sign( init_account_priv_key, db2.get_chain_id() );
+      batch.push_back( trx );
+
+      for( const auto& batch_trx : batch )
+      {
+         bool cached = prevalidate( db2, batch_trx );
+         bool failed2 = false, failed3 = false;
+
+         try { db2.push_transaction( batch_trx ); } catch( const fc::exception& ) { failed2 = true; }
+         try { db3.push_transaction( batch_trx ); } catch( const fc::exception& ) { failed3 = true; }
+
+         if( cached && failed2 )
+            db2.remove_validated_transaction( batch_trx.id() );
+
+         BOOST_REQUIRE( failed2 == failed3 );
+      }
+
+      BOOST_REQUIRE( db2.get_balance( "alice", STEEM_SYMBOL ) == db3.get_balance( "alice", STEEM_SYMBOL ) );
+      BOOST_REQUIRE( db2.get_balance( "alice", STEEM_SYMBOL ).amount.value == 900 );
+
+      b = db2.generate_block(db2.get_slot_time(1), db2.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+      auto b3 = db3.generate_block(db3.get_slot_time(1), db3.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+
+      BOOST_REQUIRE( b.transactions.size() == 1 );
+      BOOST_REQUIRE( b.transaction_merkle_root == b3.transaction_merkle_root );
+      BOOST_REQUIRE( db2.get_balance( "alice", STEEM_SYMBOL ) == db3.get_balance( "alice", STEEM_SYMBOL ) );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( tapos )
 {
    try {
@@ -561,6 +852,148 @@ BOOST_FIXTURE_TEST_CASE( pop_block_twice, clean_database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( pending_block_assembly, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      fund( "alice", 10000 );
+      generate_block();
+
+      BOOST_TEST_MESSAGE( "The pending transactions become the next block" );
+
+      signed_transaction tx;
+      for( int i = 1; i <= 3; ++i )
+      {
+         transfer_operation op;
+         op.from = "alice";
+         op.to = "bob";
+         op.amount = asset( i, STEEM_SYMBOL );
+         tx.clear();
+         tx.operations.push_back( op );
+         tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+         tx.sign( alice_private_key, db->get_chain_id() );
+         PUSH_TX( *db, tx, database::skip_authority_check );
+      }
+
+      generate_block();
+
+      auto block = db->fetch_block_by_number( db->head_block_num() );
+      BOOST_REQUIRE( block.valid() );
+      BOOST_REQUIRE_EQUAL( block->transactions.size(), 3u );
+      BOOST_REQUIRE( block->transactions[2].id() == tx.id() );
+      BOOST_REQUIRE_EQUAL( db->get_balance( "bob", STEEM_SYMBOL ).amount.value, 6 );
+
+      BOOST_TEST_MESSAGE( "A transaction expiring before the block is left out" );
+
+      transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = asset( 10, STEEM_SYMBOL );
+      tx.clear();
+      tx.operations.push_back( op );
+      tx.set_expiration( db->head_block_time() + STEEM_BLOCK_INTERVAL );
+      tx.sign( alice_private_key, db->get_chain_id() );
+      PUSH_TX( *db, tx, database::skip_authority_check );
+
+      op.amount = asset( 20, STEEM_SYMBOL );
+      tx.clear();
+      tx.operations.push_back( op );
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      tx.sign( alice_private_key, db->get_chain_id() );
+      PUSH_TX( *db, tx, database::skip_authority_check );
+
+      generate_block( 0, init_account_priv_key, 1 );
+
+      block = db->fetch_block_by_number( db->head_block_num() );
+      BOOST_REQUIRE( block.valid() );
+      BOOST_REQUIRE_EQUAL( block->transactions.size(), 1u );
+      BOOST_REQUIRE( block->transactions[0].id() == tx.id() );
+      BOOST_REQUIRE_EQUAL( db->get_balance( "bob", STEEM_SYMBOL ).amount.value, 26 );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( recent_transactions, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      fund( "alice", 10000 );
+      generate_block();
+
+      transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = asset( 1, STEEM_SYMBOL );
+      signed_transaction tx;
+      tx.operations.push_back( op );
+      tx.set_expiration( db->head_block_time() + 2 * STEEM_BLOCK_INTERVAL );
+      tx.sign( alice_private_key, db->get_chain_id() );
+
+      BOOST_TEST_MESSAGE( "A pending transaction can be served to peers" );
+      PUSH_TX( *db, tx, 0 );
+      BOOST_REQUIRE( db->is_known_transaction( tx.id() ) );
+      BOOST_REQUIRE( db->get_recent_transaction( tx.id() ).signatures == tx.signatures );
+
+      BOOST_TEST_MESSAGE( "And once in a block, where it cannot be pushed again" );
+      generate_block();
+      BOOST_REQUIRE( db->get_recent_transaction( tx.id() ).id() == tx.id() );
+      STEEM_REQUIRE_THROW( PUSH_TX( *db, tx, 0 ), fc::exception );
+
+      BOOST_TEST_MESSAGE( "Both are forgotten when it expires" );
+      generate_blocks( 3 );
+      BOOST_REQUIRE( !db->is_known_transaction( tx.id() ) );
+      STEEM_REQUIRE_THROW( db->get_recent_transaction( tx.id() ), fc::exception );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( scheduled_events, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice) );
+      fund( "alice", 10000 );
+      generate_block();
+
+      const auto& stats = db->get_scheduled_event_stats()[ limit_order_expiration_event ];
+      uint64_t dispatches = stats.dispatches;
+
+      BOOST_TEST_MESSAGE( "Creating an order schedules its expiration" );
+      limit_order_create_operation op;
+      op.owner = "alice";
+      op.orderid = 1;
+      op.amount_to_sell = ASSET( "1.000 TESTS" );
+      op.min_to_receive = ASSET( "1.000 TBD" );
+      op.expiration = db->head_block_time() + 2 * STEEM_BLOCK_INTERVAL;
+      signed_transaction tx;
+      tx.operations.push_back( op );
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      tx.sign( alice_private_key, db->get_chain_id() );
+      PUSH_TX( *db, tx, 0 );
+
+      const auto& event = db->get< scheduled_event_object, by_type >( limit_order_expiration_event );
+      BOOST_REQUIRE( event.next_due == op.expiration + 1 );
+
+      BOOST_TEST_MESSAGE( "Nothing is processed before it is due" );
+      generate_blocks( 2 );
+      BOOST_REQUIRE( ( db->find< limit_order_object, by_account >( boost::make_tuple( "alice", 1 ) ) != nullptr ) );
+      BOOST_REQUIRE_EQUAL( stats.dispatches, dispatches );
+
+      BOOST_TEST_MESSAGE( "The order is cancelled in the first block past its expiration" );
+      generate_block();
+      BOOST_REQUIRE( ( db->find< limit_order_object, by_account >( boost::make_tuple( "alice", 1 ) ) == nullptr ) );
+      BOOST_REQUIRE_EQUAL( stats.dispatches, dispatches + 1 );
+      BOOST_REQUIRE_EQUAL( stats.processed, 1u );
+      BOOST_REQUIRE( ( db->get< scheduled_event_object, by_type >( limit_order_expiration_event ).next_due == fc::time_point_sec::maximum() ) );
+
+      generate_blocks( 2 );
+      BOOST_REQUIRE_EQUAL( stats.dispatches, dispatches + 1 );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_FIXTURE_TEST_CASE( rsf_missed_blocks, clean_database_fixture )
 {
    try
@@ -720,6 +1153,182 @@ BOOST_FIXTURE_TEST_CASE( skip_block, clean_database_fixture )
    FC_LOG_AND_RETHROW();
 }
 
+BOOST_FIXTURE_TEST_CASE( block_profiler, clean_database_fixture )
+{
+   try
+   {
+      auto& profiler = db->get_block_profiler();
+
+      BOOST_TEST_MESSAGE( "Nothing is traced while disabled" );
+      generate_block();
+      BOOST_REQUIRE( profiler.get_traces().empty() );
+
+      BOOST_TEST_MESSAGE( "Every other block is traced, the last three kept" );
+      profiler.set_enabled( true );
+      profiler.set_sample_interval( 2 );
+      profiler.set_max_blocks( 3 );
+      generate_blocks( 10 );
+
+      auto traces = profiler.get_traces();
+      BOOST_REQUIRE_EQUAL( traces.size(), 3u );
+      BOOST_REQUIRE_EQUAL( traces.back().block_num, db->head_block_num() - db->head_block_num() % 2 );
+      BOOST_REQUIRE_EQUAL( traces.back().block_num - traces.front().block_num, 4u );
+
+      const auto& phases = traces.back().phases;
+      auto has_phase = [&]( const std::string& name )
+      {
+         return std::find_if( phases.begin(), phases.end(), [&]( const chain::util::block_profiler::phase_event& e ) { return e.name == name; } ) != phases.end();
+      };
+      BOOST_REQUIRE( has_phase( "transactions" ) );
+      BOOST_REQUIRE( has_phase( "process_comment_cashout" ) );
+      BOOST_REQUIRE( has_phase( "push_undo_session" ) );
+
+      for( size_t i = 1; i < phases.size(); ++i )
+         BOOST_REQUIRE( phases[i].start_us >= phases[i-1].start_us + phases[i-1].duration_us );
+
+      BOOST_TEST_MESSAGE( "Summary covers the block and every phase" );
+      auto summary = profiler.get_summary();
+      BOOST_REQUIRE( summary.size() == phases.size() + 1 );
+      BOOST_REQUIRE( summary.front().name == "block" );
+      BOOST_REQUIRE_EQUAL( summary.front().count, 3u );
+      for( const auto& s : summary )
+         BOOST_REQUIRE( s.p50_us <= s.p90_us && s.p90_us <= s.p99_us && s.p99_us <= s.max_us );
+
+      auto trace = profiler.to_chrome_trace().get_object();
+      BOOST_REQUIRE_EQUAL( trace[ "traceEvents" ].get_array().size(), 3 * ( phases.size() + 1 ) );
+
+      profiler.set_enabled( false );
+      profiler.clear();
+      generate_blocks( 2 );
+      BOOST_REQUIRE( profiler.get_traces().empty() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( transaction_schedule, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob)(carol)(dave) );
+      fund( "alice", 10000 );
+      fund( "bob", 10000 );
+      fund( "carol", 10000 );
+      fund( "dave", 10000 );
+      generate_block();
+
+      std::vector< signed_transaction > trxs;
+      auto add_trx = [&]( const operation& op, const fc::ecc::private_key& key )
+      {
+         signed_transaction tx;
+         tx.operations.push_back( op );
+         tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+         tx.sign( key, db->get_chain_id() );
+         trxs.push_back( tx );
+      };
+      auto transfer = [&]( const string& from, const string& to, int64_t amount, const fc::ecc::private_key& key )
+      {
+         transfer_operation op;
+         op.from = from;
+         op.to = to;
+         op.amount = asset( amount, STEEM_SYMBOL );
+         add_trx( op, key );
+      };
+      auto update = [&]( const string& name, const fc::ecc::private_key& key )
+      {
+         account_update_operation op;
+         op.account = name;
+         op.memo_key = generate_private_key( name + "_memo" ).get_public_key();
+         op.json_metadata = "{\"name\":\"" + name + "\"}";
+         add_trx( op, key );
+      };
+
+      transfer( "alice", "bob", 1000, alice_private_key );
+      transfer( "bob", "carol", 3000, bob_private_key );
+      update( "dave", dave_private_key );
+
+      limit_order_create_operation order;
+      order.owner = "dave";
+      order.orderid = 1;
+      order.amount_to_sell = ASSET( "1.000 TESTS" );
+      order.min_to_receive = ASSET( "1.000 TBD" );
+      order.expiration = db->head_block_time() + fc::hours( 1 );
+      add_trx( order, dave_private_key );
+
+      update( "alice", alice_private_key );
+      transfer( "bob", "carol", 500, bob_private_key );
+
+      BOOST_TEST_MESSAGE( "Transactions on disjoint accounts share a wave, serial ones are alone in theirs" );
+      auto schedule = chain::util::schedule_transactions( trxs );
+      BOOST_REQUIRE( ( schedule.waves == std::vector< uint32_t >{ 0, 1, 0, 2, 3, 3 } ) );
+      BOOST_REQUIRE_EQUAL( schedule.wave_count, 4u );
+      BOOST_REQUIRE_EQUAL( schedule.serial_count, 1u );
+      BOOST_REQUIRE_EQUAL( schedule.max_wave_size(), 2u );
+
+      BOOST_TEST_MESSAGE( "Applying wave by wave leaves the same state as applying in order" );
+      auto apply = [&]( const std::vector< uint32_t >& order )
+      {
+         std::vector< std::string > state;
+
+         for( uint32_t i : order )
+            PUSH_TX( *db, trxs[i], 0 );
+
+         for( const string& name : { "alice", "bob", "carol", "dave" } )
+         {
+            const auto& account = db->get_account( name );
+            const auto& auth = db->get< account_authority_object, by_account >( name );
+            state.push_back( fc::json::to_string( account.balance ) + fc::json::to_string( account.sbd_balance )
+               + fc::json::to_string( account.memo_key ) + to_string( account.json_metadata )
+               + fc::json::to_string( auth.active ) );
+         }
+
+         db->clear_pending();
+         return state;
+      };
+
+      std::vector< uint32_t > block_order( trxs.size() );
+      for( uint32_t i = 0; i < block_order.size(); ++i )
+         block_order[i] = i;
+
+      auto execution_order = schedule.execution_order();
+      BOOST_REQUIRE( execution_order != block_order );
+      BOOST_REQUIRE( apply( block_order ) == apply( execution_order ) );
+      validate_database();
+
+      BOOST_TEST_MESSAGE( "An authority change is serial, other accounts may be signed for through it" );
+      account_update_operation auth_update;
+      auth_update.account = "carol";
+      auth_update.active = authority( 1, account_name_type( "dave" ), 1 );
+      auth_update.memo_key = carol_private_key.get_public_key();
+      trxs.clear();
+      add_trx( auth_update, carol_private_key );
+      PUSH_TX( *db, trxs[0], 0 );
+      generate_block();
+
+      // carol's transfer is signed by dave, whose active key the following update replaces
+      trxs.clear();
+      transfer( "carol", "alice", 100, dave_private_key );
+      auth_update.account = "dave";
+      auth_update.active = authority( 1, generate_private_key( "dave_active" ).get_public_key(), 1 );
+      auth_update.memo_key = dave_private_key.get_public_key();
+      add_trx( auth_update, dave_private_key );
+
+      BOOST_REQUIRE( !chain::util::is_reorderable_operation( trxs[1].operations[0] ) );
+      schedule = chain::util::schedule_transactions( trxs );
+      BOOST_REQUIRE( ( schedule.waves == std::vector< uint32_t >{ 0, 1 } ) );
+      BOOST_REQUIRE_EQUAL( schedule.serial_count, 1u );
+
+      PUSH_TX( *db, trxs[1], 0 );
+      STEEM_REQUIRE_THROW( PUSH_TX( *db, trxs[0], 0 ), fc::exception );
+      db->clear_pending();
+
+      PUSH_TX( *db, trxs[0], 0 );
+      PUSH_TX( *db, trxs[1], 0 );
+      db->clear_pending();
+      validate_database();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_FIXTURE_TEST_CASE( hardfork_test, database_fixture )
 {
    try
@@ -0,0 +1,1111 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/net/config.hpp>
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/message_oriented_connection.hpp>
+#include <graphene/net/open_hash_map.hpp>
+#include <graphene/net/peer_connection.hpp>
+#include <graphene/net/peer_database.hpp>
+#include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/timestamped_item_set.hpp>
+
+#include <steem/utilities/tempdir.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/network/ip.hpp>
+#include <fc/network/tcp_socket.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using graphene::net::stcp_socket;
+using namespace graphene::net;
+using namespace steem::protocol;
+
+/**
+ * Two stcp sockets connected to each other over the loopback interface, with the key
+ * exchange done.  The raw TCP sockets underneath are used to look at and forge frames.
+ */
+struct stcp_pair
+{
+   stcp_pair()
+   {
+      server.listen( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), 0 ) );
+      fc::future< void > accepted = fc::async( [&]()
+      {
+         server.accept( acceptor.get_socket() );
+         acceptor.accept();
+      }, "stcp_pair accept" );
+      initiator.connect_to( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), server.get_port() ) );
+      accepted.wait();
+   }
+
+   ~stcp_pair()
+   {
+      initiator.close();
+      acceptor.close();
+      server.close();
+   }
+
+   void set_cipher( const std::string& cipher )
+   {
+      initiator.set_send_cipher( cipher );
+      acceptor.set_receive_cipher( cipher );
+   }
+
+   /// Sends payload from the initiator in a frame of its own
+   void send_frame( const std::string& payload )
+   {
+      std::vector< char > frame( stcp_socket::frame_prefix_size + payload.size() + stcp_socket::frame_suffix_size );
+      memcpy( frame.data() + stcp_socket::frame_prefix_size, payload.data(), payload.size() );
+      initiator.write_frame( frame.data(), payload.size() );
+   }
+
+   std::string receive( size_t len )
+   {
+      std::string result( len, '\0' );
+      acceptor.read( &result[0], len );
+      return result;
+   }
+
+   /// What arrived on the wire, without decrypting it
+   std::vector< char > receive_raw( size_t len )
+   {
+      std::vector< char > result( len );
+      acceptor.get_socket().read( result.data(), len );
+      return result;
+   }
+
+   /// Puts bytes on the wire as if the initiator had sent them
+   void send_raw( const std::vector< char >& bytes )
+   {
+      initiator.get_socket().write( bytes.data(), bytes.size() );
+   }
+
+   fc::tcp_server server;
+   stcp_socket    initiator;
+   stcp_socket    acceptor;
+};
+
+static std::vector< char > frame_length( uint32_t len )
+{
+   return { char( len ), char( len >> 8 ), char( len >> 16 ), char( len >> 24 ) };
+}
+
+static signed_transaction make_transaction( uint32_t n )
+{
+   transfer_operation op;
+   op.from = "alice";
+   op.to = "bob";
+   op.amount = asset( 1, STEEM_SYMBOL );
+   op.memo = fc::to_string( n );
+
+   signed_transaction trx;
+   trx.operations.push_back( op );
+   trx.expiration = fc::time_point_sec( 1000000 );
+   return trx;
+}
+
+/**
+ * A block with a few transactions and the compact block a peer sends for it.  Nothing checks the
+ * block is valid on the chain, only that the rebuilt block_message is the one that was requested.
+ */
+struct compact_block_fixture
+{
+   compact_block_fixture() :
+      full_block( make_block() ),
+      full_block_message( block_message( full_block ) ),
+      compact_block( block_message( full_block ), full_block_message.id() )
+   {}
+
+   static signed_block make_block()
+   {
+      signed_block block;
+      block.previous = block_id_type( "0000000100000000000000000000000000000000" );
+      block.timestamp = fc::time_point_sec( 1000000 );
+      block.witness = "initminer";
+      for( uint32_t i = 0; i < 5; ++i )
+         block.transactions.push_back( make_transaction( i ) );
+      block.transaction_merkle_root = block.calculate_merkle_root();
+      return block;
+   }
+
+   /// Looks transactions up by short id, as the message cache does
+   std::function< fc::optional< signed_transaction >( uint64_t ) > cache( const std::vector< uint32_t >& indices )const
+   {
+      std::map< uint64_t, signed_transaction > transactions;
+      for( uint32_t i : indices )
+         transactions[ compact_block_message::short_transaction_id( full_block.transactions[i].id() ) ] = full_block.transactions[i];
+
+      return [transactions]( uint64_t short_id )
+      {
+         auto itr = transactions.find( short_id );
+         return itr == transactions.end() ? fc::optional< signed_transaction >() : fc::optional< signed_transaction >( itr->second );
+      };
+   }
+
+   bool rebuilds_full_block( const peer_connection::partial_compact_block& partial_block )const
+   {
+      fc::optional< message > rebuilt = partial_block.get_block_message();
+      return rebuilt && rebuilt->id() == full_block_message.id() && rebuilt->as< block_message >().block_id == full_block.id();
+   }
+
+   signed_block          full_block;
+   message               full_block_message;
+   compact_block_message compact_block;
+};
+
+struct dummy_peer_connection_delegate : public peer_connection_delegate
+{
+   void on_message( peer_connection*, const message& ) override {}
+   void on_connection_closed( peer_connection* ) override {}
+   message get_message_for_item( const item_id& ) override { return message(); }
+};
+
+/// A peer database file in a directory of its own, read back without going through peer_database
+struct peer_database_files
+{
+   peer_database_files() :
+      dir( steem::utilities::temp_directory_path() ),
+      database( dir.path() / "peers.json" ),
+      journal( dir.path() / "peers.json.journal" ),
+      temporary( dir.path() / "peers.json.tmp" )
+   {}
+
+   std::vector< potential_peer_record > saved_records()const
+   {
+      return fc::json::from_file( database ).as< std::vector< potential_peer_record > >();
+   }
+
+   std::vector< std::string > journal_lines()const
+   {
+      std::vector< std::string > lines;
+      std::ifstream in( journal.generic_string() );
+      std::string line;
+      while( std::getline( in, line ) )
+         lines.push_back( line );
+      return lines;
+   }
+
+   void append_to_journal( const std::string& text )
+   {
+      std::ofstream out( journal.generic_string(), std::ios::out | std::ios::app );
+      out << text;
+   }
+
+   fc::temp_directory dir;
+   fc::path           database;
+   fc::path           journal;
+   fc::path           temporary;
+};
+
+static fc::ip::endpoint make_endpoint( uint32_t n )
+{
+   return fc::ip::endpoint( fc::ip::address( 0x0a000000 + n ), 2001 );
+}
+
+/**
+ * Counts the messages a connection delivers, which carry their sequence number in the time
+ * of a current_time_request_message.  Set blocked to hold the next on_message until released.
+ */
+struct recording_connection_delegate : public message_oriented_connection_delegate
+{
+   void on_message( message_oriented_connection*, const message& received_message ) override
+   {
+      on_delivery_thread &= &fc::thread::current() == delivery_thread;
+      sequence.push_back( received_message.as< current_time_request_message >().request_sent_time.time_since_epoch().count() );
+      if( blocked )
+      {
+         blocked->wait();
+         blocked.reset();
+      }
+   }
+
+   void on_connection_closed( message_oriented_connection* ) override
+   {
+      on_delivery_thread &= &fc::thread::current() == delivery_thread;
+      closed_after = sequence.size();
+      closed = true;
+   }
+
+   bool in_order()const
+   {
+      for( size_t i = 0; i < sequence.size(); ++i )
+         if( sequence[i] != int64_t( i ) )
+            return false;
+      return true;
+   }
+
+   fc::thread*                delivery_thread = &fc::thread::current();
+   bool                       on_delivery_thread = true;
+   std::vector< int64_t >     sequence;
+   fc::promise< void >::ptr   blocked;
+   bool                       closed = false;
+   size_t                     closed_after = 0;
+};
+
+/**
+ * A connection whose socket I/O runs on an I/O thread, receiving from a connection that
+ * stays on this thread.  Messages are still delivered on this thread.
+ */
+struct io_thread_connection_pair
+{
+   io_thread_connection_pair() :
+      io_thread( "net_tests io" ),
+      receiver( &delegate ),
+      sender( &sender_delegate )
+   {
+      receiver.set_io_thread( &io_thread );
+      server.listen( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), 0 ) );
+      fc::future< void > accepted = fc::async( [&]()
+      {
+         server.accept( receiver.get_socket() );
+         receiver.accept();
+      }, "io_thread_connection_pair accept" );
+      sender.connect_to( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), server.get_port() ) );
+      accepted.wait();
+   }
+
+   void send( int64_t first, int64_t count )
+   {
+      for( int64_t i = first; i < first + count; ++i )
+         sender.send_message( current_time_request_message( fc::time_point( fc::microseconds( i ) ) ) );
+   }
+
+   /// Lets the deliveries run until the receiver has count messages, or gives up after a while
+   bool wait_for( size_t count )
+   {
+      for( int i = 0; i < 5000 && delegate.sequence.size() < count; ++i )
+         fc::usleep( fc::milliseconds( 1 ) );
+      return delegate.sequence.size() == count;
+   }
+
+   fc::thread                     io_thread;
+   recording_connection_delegate  delegate;
+   recording_connection_delegate  sender_delegate;
+   fc::tcp_server                 server;
+   message_oriented_connection    receiver;
+   message_oriented_connection    sender;
+};
+
+/// Keys that say which slot they hash to, so tests can build probe runs across the end of the table
+struct home_slot_hash
+{
+   size_t operator()( uint64_t key )const { return size_t( key >> 8 ); }
+};
+
+static uint64_t key_with_home( uint64_t home, uint64_t n )
+{
+   return ( home << 8 ) | n;
+}
+
+struct mixed_hash
+{
+   size_t operator()( uint64_t key )const { return size_t( graphene::net::detail::open_hash_mix( key ) ); }
+};
+
+typedef open_hash_map< uint64_t, uint64_t, home_slot_hash > home_slot_map;
+
+/// Every key of the reference is found with its value, and nothing else is in the map
+template< typename Map >
+static bool same_contents( const Map& map, const std::unordered_map< uint64_t, uint64_t >& reference )
+{
+   if( map.size() != reference.size() || map.empty() != reference.empty() )
+      return false;
+   for( const auto& item : reference )
+   {
+      auto itr = map.find( item.first );
+      if( itr == map.end() || itr->first != item.first || itr->second != item.second )
+         return false;
+   }
+   size_t iterated = 0;
+   for( const auto& item : map )
+   {
+      auto itr = reference.find( item.first );
+      if( itr == reference.end() || itr->second != item.second )
+         return false;
+      ++iterated;
+   }
+   return iterated == reference.size();
+}
+
+static item_id make_item_id( uint32_t n )
+{
+   return item_id( trx_message_type, fc::ripemd160::hash( fc::to_string( n ) ) );
+}
+
+/// A record that scores higher the larger n is
+static potential_peer_record make_peer_record( uint32_t n )
+{
+   potential_peer_record record( make_endpoint( n ), fc::time_point_sec( 1000000 ) );
+   record.number_of_successful_connection_attempts = n;
+   return record;
+}
+
+BOOST_AUTO_TEST_SUITE( net_tests )
+
+BOOST_AUTO_TEST_CASE( stcp_authenticated_ciphers )
+{
+   try
+   {
+      auto ciphers = stcp_socket::get_authenticated_ciphers();
+      BOOST_REQUIRE( !ciphers.empty() );
+      BOOST_REQUIRE_EQUAL( ciphers.front(), "aes-256-gcm" );
+      for( const auto& cipher : ciphers )
+         BOOST_REQUIRE( stcp_socket::is_authenticated_cipher_supported( cipher ) );
+      BOOST_REQUIRE( !stcp_socket::is_authenticated_cipher_supported( "aes-256-cbc" ) );
+      BOOST_REQUIRE( !stcp_socket::is_authenticated_cipher_supported( "" ) );
+
+      stcp_pair p;
+      BOOST_REQUIRE_THROW( p.initiator.set_send_cipher( "aes-256-cbc" ), fc::exception );
+      BOOST_REQUIRE( p.initiator.get_send_cipher().empty() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( stcp_cipher_switch )
+{
+   try
+   {
+      for( const auto& cipher : stcp_socket::get_authenticated_ciphers() )
+      {
+         BOOST_TEST_MESSAGE( "Switching to " + cipher );
+         stcp_pair p;
+         BOOST_REQUIRE( p.initiator.get_send_cipher().empty() );
+         BOOST_REQUIRE( p.acceptor.get_receive_cipher().empty() );
+
+         // The legacy cipher only works on 16 byte blocks
+         const std::string legacy = "sixteen bytes!!!sixteen bytes!!!";
+         p.send_frame( legacy );
+         BOOST_REQUIRE_EQUAL( p.receive( legacy.size() ), legacy );
+
+         p.set_cipher( cipher );
+         BOOST_REQUIRE_EQUAL( p.initiator.get_send_cipher(), cipher );
+         BOOST_REQUIRE_EQUAL( p.acceptor.get_receive_cipher(), cipher );
+         // The other direction is switched separately
+         BOOST_REQUIRE( p.acceptor.get_send_cipher().empty() );
+         BOOST_REQUIRE( p.initiator.get_receive_cipher().empty() );
+
+         p.send_frame( "any length" );
+         p.send_frame( "a second frame" );
+         BOOST_REQUIRE_EQUAL( p.receive( 10 ), "any length" );
+         BOOST_REQUIRE_EQUAL( p.receive( 14 ), "a second frame" );
+
+         p.acceptor.set_send_cipher( cipher );
+         p.initiator.set_receive_cipher( cipher );
+         const char reply[] = "reply";
+         p.acceptor.write( reply, 5 );
+         std::string received( 5, '\0' );
+         p.initiator.read( &received[0], 5 );
+         BOOST_REQUIRE_EQUAL( received, "reply" );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( stcp_frame_encoding )
+{
+   try
+   {
+      stcp_pair p;
+      p.set_cipher( "aes-256-gcm" );
+
+      const std::string payload = "a frame longer than the buffer it is read into";
+      p.send_frame( payload );
+
+      BOOST_TEST_MESSAGE( "--- Little endian length, ciphertext and tag" );
+      auto raw = p.receive_raw( stcp_socket::frame_prefix_size + payload.size() + stcp_socket::frame_suffix_size );
+      BOOST_REQUIRE( std::vector< char >( raw.begin(), raw.begin() + 4 ) == frame_length( payload.size() ) );
+      BOOST_REQUIRE( std::string( raw.data() + 4, payload.size() ) != payload );
+
+      BOOST_TEST_MESSAGE( "--- A frame larger than the read is handed out over several reads" );
+      p.send_raw( raw );
+      std::string received;
+      char buffer[16];
+      while( received.size() < payload.size() )
+      {
+         size_t len = p.acceptor.readsome( buffer, sizeof( buffer ) );
+         BOOST_REQUIRE( len > 0 && len <= sizeof( buffer ) );
+         received.append( buffer, len );
+      }
+      BOOST_REQUIRE_EQUAL( received, payload );
+
+      BOOST_TEST_MESSAGE( "--- The same plaintext encrypts differently in the next frame" );
+      p.send_frame( payload );
+      auto next = p.receive_raw( raw.size() );
+      BOOST_REQUIRE( next != raw );
+
+      BOOST_TEST_MESSAGE( "--- Frames are decrypted in order, a replayed frame fails" );
+      p.send_raw( raw );
+      BOOST_REQUIRE_THROW( p.receive( payload.size() ), fc::exception );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( stcp_corrupted_frames )
+{
+   try
+   {
+      const std::string payload = "authenticated payload";
+      const size_t frame_size = stcp_socket::frame_prefix_size + payload.size() + stcp_socket::frame_suffix_size;
+
+      // Flips a bit in the length, the ciphertext and the tag in turn
+      for( size_t offset : { size_t( 0 ), stcp_socket::frame_prefix_size + 3, frame_size - 1 } )
+      {
+         stcp_pair p;
+         p.set_cipher( "aes-256-gcm" );
+         p.send_frame( payload );
+         auto raw = p.receive_raw( frame_size );
+         raw[ offset ] ^= 1;
+         p.send_raw( raw );
+         // One byte more is read when the length is off, make sure it is there
+         p.send_raw( std::vector< char >( 1, 0 ) );
+         BOOST_REQUIRE_THROW( p.receive( payload.size() ), fc::exception );
+      }
+
+      stcp_pair p;
+      p.set_cipher( "aes-256-gcm" );
+      p.send_frame( payload );
+      p.send_raw( p.receive_raw( frame_size ) );
+      BOOST_REQUIRE_EQUAL( p.receive( payload.size() ), payload );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( stcp_frame_size_limits )
+{
+   try
+   {
+      // A message header and the message, padded to 16 bytes
+      const size_t max_frame_size = MAX_MESSAGE_SIZE + 16;
+
+      BOOST_TEST_MESSAGE( "--- The largest message fits in a frame" );
+      {
+         stcp_pair p;
+         p.set_cipher( "aes-256-gcm" );
+         std::string payload( max_frame_size, 'x' );
+         fc::future< void > sent = fc::async( [&]() { p.send_frame( payload ); }, "stcp_frame_size_limits send" );
+         BOOST_REQUIRE( p.receive( payload.size() ) == payload );
+         sent.wait();
+      }
+
+      BOOST_TEST_MESSAGE( "--- Larger frames are not sent" );
+      {
+         stcp_pair p;
+         p.set_cipher( "aes-256-gcm" );
+         BOOST_REQUIRE_THROW( p.send_frame( std::string( max_frame_size + 1, 'x' ) ), fc::exception );
+         BOOST_REQUIRE_THROW( p.send_frame( std::string() ), fc::exception );
+      }
+
+      BOOST_TEST_MESSAGE( "--- Nor read, before anything is allocated for them" );
+      for( uint32_t len : { uint32_t( max_frame_size + 1 ), uint32_t( 32 * 1024 * 1024 ), uint32_t( 0xffffffff ), uint32_t( 0 ) } )
+      {
+         stcp_pair p;
+         p.set_cipher( "aes-256-gcm" );
+         p.send_raw( frame_length( len ) );
+         BOOST_REQUIRE_THROW( p.receive( 16 ), fc::exception );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( compact_block_rebuilt_from_cache_and_pool, compact_block_fixture )
+{
+   try
+   {
+      BOOST_REQUIRE_EQUAL( compact_block.short_transaction_ids.size(), 5u );
+      BOOST_REQUIRE( compact_block.block_id == full_block.id() );
+
+      peer_connection::partial_compact_block partial_block( compact_block );
+      BOOST_REQUIRE( partial_block.get_missing_transaction_indices() == std::vector< uint32_t >( { 0, 1, 2, 3, 4 } ) );
+      BOOST_REQUIRE( !partial_block.get_block_message() );
+
+      BOOST_TEST_MESSAGE( "--- Transactions found in the message cache" );
+      partial_block.add_transactions( cache( { 0, 2, 4 } ) );
+      BOOST_REQUIRE( partial_block.get_missing_transaction_indices() == std::vector< uint32_t >( { 1, 3 } ) );
+      auto missing_short_ids = partial_block.get_missing_short_ids();
+      BOOST_REQUIRE_EQUAL( missing_short_ids.size(), 2u );
+      BOOST_REQUIRE( missing_short_ids.count( compact_block.short_transaction_ids[1] ) );
+      BOOST_REQUIRE( missing_short_ids.count( compact_block.short_transaction_ids[3] ) );
+
+      BOOST_TEST_MESSAGE( "--- The rest in the pending pool, along with transactions that aren't in the block" );
+      partial_block.add_transactions( std::vector< signed_transaction >{ make_transaction( 7 ), full_block.transactions[3], full_block.transactions[1] } );
+      BOOST_REQUIRE( partial_block.get_missing_transaction_indices().empty() );
+      BOOST_REQUIRE( rebuilds_full_block( partial_block ) );
+
+      BOOST_TEST_MESSAGE( "--- An empty block has nothing to rebuild" );
+      signed_block empty_block = full_block;
+      empty_block.transactions.clear();
+      empty_block.transaction_merkle_root = empty_block.calculate_merkle_root();
+      message empty_block_message = block_message( empty_block );
+      peer_connection::partial_compact_block empty_partial_block( compact_block_message( block_message( empty_block ), empty_block_message.id() ) );
+      BOOST_REQUIRE( empty_partial_block.get_missing_transaction_indices().empty() );
+      BOOST_REQUIRE( empty_partial_block.get_block_message() );
+      BOOST_REQUIRE( empty_partial_block.get_block_message()->id() == empty_block_message.id() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( compact_block_missing_transactions_fetched, compact_block_fixture )
+{
+   try
+   {
+      peer_connection::partial_compact_block partial_block( compact_block );
+      partial_block.add_transactions( cache( { 1, 2 } ) );
+
+      get_compact_block_transactions_message request( compact_block.block_id, partial_block.get_missing_transaction_indices() );
+      BOOST_REQUIRE( request.transaction_indices == std::vector< uint32_t >( { 0, 3, 4 } ) );
+
+      compact_block_transactions_message reply( block_message( full_block ), request.transaction_indices );
+      BOOST_REQUIRE( reply.block_id == full_block.id() );
+      BOOST_REQUIRE_EQUAL( reply.transactions.size(), 3u );
+      BOOST_REQUIRE( reply.transactions[0].id() == full_block.transactions[0].id() );
+      BOOST_REQUIRE( reply.transactions[1].id() == full_block.transactions[3].id() );
+      BOOST_REQUIRE( reply.transactions[2].id() == full_block.transactions[4].id() );
+
+      BOOST_TEST_MESSAGE( "--- A reply with the wrong number of transactions is rejected" );
+      peer_connection::partial_compact_block short_reply = partial_block;
+      BOOST_REQUIRE( !short_reply.add_missing_transactions( std::vector< signed_transaction >( reply.transactions.begin(), reply.transactions.begin() + 2 ) ) );
+      BOOST_REQUIRE( !short_reply.add_missing_transactions( std::vector< signed_transaction >() ) );
+      BOOST_REQUIRE_EQUAL( short_reply.get_missing_transaction_indices().size(), 3u );
+
+      BOOST_REQUIRE( partial_block.add_missing_transactions( reply.transactions ) );
+      BOOST_REQUIRE( partial_block.get_missing_transaction_indices().empty() );
+      BOOST_REQUIRE( rebuilds_full_block( partial_block ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( compact_block_wrong_transactions, compact_block_fixture )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "--- A short id colliding with a transaction that isn't in the block" );
+      {
+         peer_connection::partial_compact_block partial_block( compact_block );
+         signed_transaction colliding = make_transaction( 7 );
+         uint64_t colliding_short_id = compact_block.short_transaction_ids[2];
+         auto c = cache( { 0, 1, 3, 4 } );
+         partial_block.add_transactions( [&]( uint64_t short_id )
+         {
+            return short_id == colliding_short_id ? fc::optional< signed_transaction >( colliding ) : c( short_id );
+         } );
+         BOOST_REQUIRE( partial_block.get_missing_transaction_indices().empty() );
+         BOOST_REQUIRE( !partial_block.get_block_message() );
+      }
+
+      BOOST_TEST_MESSAGE( "--- A reply with the transactions in the wrong order" );
+      {
+         peer_connection::partial_compact_block partial_block( compact_block );
+         partial_block.add_transactions( cache( { 0, 2, 4 } ) );
+         BOOST_REQUIRE( partial_block.add_missing_transactions( { full_block.transactions[3], full_block.transactions[1] } ) );
+         BOOST_REQUIRE( !partial_block.get_block_message() );
+      }
+
+      BOOST_TEST_MESSAGE( "--- The transactions of the block, but not the block message that was requested" );
+      {
+         signed_block other_block = full_block;
+         other_block.timestamp += 3;
+         compact_block_message other = compact_block;
+         other.header = other_block;
+         peer_connection::partial_compact_block partial_block( other );
+         partial_block.add_transactions( cache( { 0, 1, 2, 3, 4 } ) );
+         BOOST_REQUIRE( partial_block.get_missing_transaction_indices().empty() );
+         BOOST_REQUIRE( !partial_block.get_block_message() );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( compact_block_transactions_reply_limits, compact_block_fixture )
+{
+   try
+   {
+      block_message full = block_message( full_block );
+      auto reply_size = [&]( const std::vector< uint32_t >& indices )
+      {
+         return compact_block_transactions_message( full, indices ).transactions.size();
+      };
+
+      BOOST_REQUIRE_EQUAL( reply_size( {} ), 0u );
+      BOOST_REQUIRE_EQUAL( reply_size( { 4 } ), 1u );
+      BOOST_REQUIRE_EQUAL( reply_size( { 0, 1, 2, 3, 4 } ), 5u );
+
+      BOOST_TEST_MESSAGE( "--- A transaction can only be requested once, so a reply is never larger than the block" );
+      BOOST_REQUIRE_EQUAL( reply_size( { 1, 1 } ), 0u );
+      BOOST_REQUIRE_EQUAL( reply_size( std::vector< uint32_t >( 1000, 0 ) ), 0u );
+      BOOST_REQUIRE_EQUAL( reply_size( { 3, 1 } ), 0u );
+      BOOST_REQUIRE_EQUAL( reply_size( { 0, 5 } ), 0u );
+      BOOST_REQUIRE_EQUAL( reply_size( { 0xffffffff } ), 0u );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( compact_blocks_awaiting_transactions_expire, compact_block_fixture )
+{
+   try
+   {
+      dummy_peer_connection_delegate delegate;
+      peer_connection_ptr peer = peer_connection::make_shared( &delegate );
+      const fc::time_point now = fc::time_point::now();
+
+      signed_block other_block = full_block;
+      other_block.timestamp += 3;
+      message other_block_message = block_message( other_block );
+
+      peer_connection::partial_compact_block unanswered( compact_block );
+      unanswered.transactions_requested_time = now - fc::seconds( 10 );
+      peer_connection::partial_compact_block recent( compact_block_message( block_message( other_block ), other_block_message.id() ) );
+      recent.transactions_requested_time = now;
+      peer->compact_blocks_awaiting_transactions[ full_block.id() ] = unanswered;
+      peer->compact_blocks_awaiting_transactions[ other_block.id() ] = recent;
+
+      auto expired = peer->expire_compact_blocks_awaiting_transactions( now - fc::seconds( 3 ) );
+      BOOST_REQUIRE_EQUAL( expired.size(), 1u );
+      BOOST_REQUIRE( expired[0] == full_block_message.id() );
+      BOOST_REQUIRE_EQUAL( peer->compact_blocks_awaiting_transactions.size(), 1u );
+      BOOST_REQUIRE( peer->compact_blocks_awaiting_transactions.count( other_block.id() ) );
+
+      BOOST_REQUIRE( peer->expire_compact_blocks_awaiting_transactions( now - fc::seconds( 3 ) ).empty() );
+
+      expired = peer->expire_compact_blocks_awaiting_transactions( now + fc::seconds( 1 ) );
+      BOOST_REQUIRE_EQUAL( expired.size(), 1u );
+      BOOST_REQUIRE( expired[0] == other_block_message.id() );
+      BOOST_REQUIRE( peer->compact_blocks_awaiting_transactions.empty() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( peer_database_journal_replayed_after_crash )
+{
+   try
+   {
+      peer_database_files files;
+
+      {
+         peer_database db;
+         db.open( files.database );
+         BOOST_REQUIRE_EQUAL( db.size(), 0u );
+         BOOST_REQUIRE( fc::exists( files.database ) );
+         BOOST_REQUIRE( fc::exists( files.journal ) );
+
+         for( uint32_t i = 1; i <= 3; ++i )
+            db.update_entry( make_peer_record( i ) );
+         auto changed = make_peer_record( 2 );
+         changed.number_of_failed_connection_attempts = 5;
+         db.update_entry( changed );
+         db.erase( make_endpoint( 3 ) );
+
+         BOOST_TEST_MESSAGE( "--- Changes are only written when flushed, once per peer" );
+         BOOST_REQUIRE( files.journal_lines().empty() );
+         db.flush();
+         BOOST_REQUIRE_EQUAL( files.journal_lines().size(), 3u );
+         BOOST_REQUIRE( files.saved_records().empty() );
+         db.flush();
+         BOOST_REQUIRE_EQUAL( files.journal_lines().size(), 3u );
+
+         // lost in the crash
+         db.update_entry( make_peer_record( 4 ) );
+
+         // crashes without closing, the database file was never rewritten
+      }
+      BOOST_REQUIRE( files.saved_records().empty() );
+
+      BOOST_TEST_MESSAGE( "--- The journal is replayed and folded into the database file when it is opened" );
+      {
+         peer_database db;
+         db.open( files.database );
+         BOOST_REQUIRE_EQUAL( db.size(), 2u );
+         BOOST_REQUIRE( db.lookup_entry_for_endpoint( make_endpoint( 1 ) ) );
+         BOOST_REQUIRE_EQUAL( db.lookup_entry_for_endpoint( make_endpoint( 2 ) )->number_of_failed_connection_attempts, 5u );
+         BOOST_REQUIRE( !db.lookup_entry_for_endpoint( make_endpoint( 3 ) ) );
+         BOOST_REQUIRE( !db.lookup_entry_for_endpoint( make_endpoint( 4 ) ) );
+
+         BOOST_REQUIRE_EQUAL( files.saved_records().size(), 2u );
+         BOOST_REQUIRE( files.journal_lines().empty() );
+         BOOST_REQUIRE( !fc::exists( files.temporary ) );
+
+         db.update_entry( make_peer_record( 5 ) );
+         db.close();
+      }
+
+      BOOST_TEST_MESSAGE( "--- Closing writes what wasn't flushed to the database file" );
+      BOOST_REQUIRE_EQUAL( files.saved_records().size(), 3u );
+      BOOST_REQUIRE( files.journal_lines().empty() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( peer_database_truncated_journal )
+{
+   try
+   {
+      peer_database_files files;
+
+      {
+         peer_database db;
+         db.open( files.database );
+         db.update_entry( make_peer_record( 1 ) );
+         db.flush();
+         db.update_entry( make_peer_record( 2 ) );
+         db.flush();
+      }
+
+      // the crash cut the last line short, and left a compaction unfinished
+      auto line = files.journal_lines().back();
+      files.append_to_journal( line.substr( 0, line.size() / 2 ) );
+      fc::json::save_to_file( std::vector< potential_peer_record >{ make_peer_record( 9 ) }, files.temporary );
+
+      peer_database db;
+      db.open( files.database );
+      BOOST_REQUIRE_EQUAL( db.size(), 2u );
+      BOOST_REQUIRE( db.lookup_entry_for_endpoint( make_endpoint( 1 ) ) );
+      BOOST_REQUIRE( db.lookup_entry_for_endpoint( make_endpoint( 2 ) ) );
+      BOOST_REQUIRE( !db.lookup_entry_for_endpoint( make_endpoint( 9 ) ) );
+
+      // the compaction on open went through the temporary file
+      BOOST_REQUIRE( !fc::exists( files.temporary ) );
+      BOOST_REQUIRE_EQUAL( files.saved_records().size(), 2u );
+      BOOST_REQUIRE( files.journal_lines().empty() );
+      db.close();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( peer_database_compaction )
+{
+   try
+   {
+      peer_database_files files;
+
+      BOOST_TEST_MESSAGE( "--- A long journal is folded into the database file" );
+      {
+         peer_database db;
+         db.open( files.database );
+         const size_t journal_limit = GRAPHENE_NET_MAX_PEERDB_SIZE * GRAPHENE_NET_PEERDB_JOURNAL_ENTRIES_PER_PEER;
+         for( uint32_t i = 0; i < journal_limit; ++i )
+         {
+            db.update_entry( make_peer_record( i % 10 ) );
+            db.flush();
+         }
+         BOOST_REQUIRE_EQUAL( files.journal_lines().size(), journal_limit );
+         BOOST_REQUIRE( files.saved_records().empty() );
+
+         db.update_entry( make_peer_record( 10 ) );
+         db.flush();
+         BOOST_REQUIRE( files.journal_lines().empty() );
+         BOOST_REQUIRE_EQUAL( files.saved_records().size(), 11u );
+         BOOST_REQUIRE( !fc::exists( files.temporary ) );
+         db.close();
+      }
+
+      BOOST_TEST_MESSAGE( "--- The lowest scoring peers are pruned, the rest iterate best first" );
+      {
+         peer_database db;
+         db.open( files.database );
+         db.clear();
+         for( uint32_t i = 1; i <= GRAPHENE_NET_MAX_PEERDB_SIZE + 10; ++i )
+            db.update_entry( make_peer_record( i ) );
+         db.close();
+      }
+
+      peer_database db;
+      db.open( files.database );
+      BOOST_REQUIRE_EQUAL( db.size(), size_t( GRAPHENE_NET_MAX_PEERDB_SIZE ) );
+      BOOST_REQUIRE_EQUAL( files.saved_records().size(), size_t( GRAPHENE_NET_MAX_PEERDB_SIZE ) );
+      for( uint32_t i = 1; i <= 10; ++i )
+         BOOST_REQUIRE( !db.lookup_entry_for_endpoint( make_endpoint( i ) ) );
+
+      int64_t last_score = std::numeric_limits< int64_t >::max();
+      for( const potential_peer_record& record : db )
+      {
+         BOOST_REQUIRE( record.score() <= last_score );
+         last_score = record.score();
+      }
+      BOOST_REQUIRE_EQUAL( db.begin()->score(), make_peer_record( GRAPHENE_NET_MAX_PEERDB_SIZE + 10 ).score() );
+      db.close();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( open_hash_map_erase_across_wrap_point )
+{
+   try
+   {
+      // the smallest table has 16 slots and holds up to 12 entries before it grows
+      home_slot_map map;
+      std::unordered_map< uint64_t, uint64_t > reference;
+      auto insert = [&]( uint64_t key )
+      {
+         BOOST_REQUIRE( map.insert( std::make_pair( key, key + 1 ) ).second );
+         reference[ key ] = key + 1;
+      };
+      auto erase = [&]( uint64_t key )
+      {
+         BOOST_REQUIRE_EQUAL( map.erase( key ), 1u );
+         reference.erase( key );
+         BOOST_REQUIRE( map.find( key ) == map.end() );
+         BOOST_REQUIRE( same_contents( map, reference ) );
+      };
+
+      BOOST_TEST_MESSAGE( "--- One probe run from slot 14 through slot 3" );
+      insert( key_with_home( 14, 0 ) );  // 14
+      insert( key_with_home( 15, 0 ) );  // 15
+      insert( key_with_home( 14, 1 ) );  // 0
+      insert( key_with_home( 0, 0 ) );   // 1
+      insert( key_with_home( 15, 1 ) );  // 2
+      insert( key_with_home( 1, 0 ) );   // 3
+      insert( key_with_home( 5, 0 ) );   // 5, a run of its own
+      BOOST_REQUIRE( same_contents( map, reference ) );
+      BOOST_REQUIRE( !map.insert( std::make_pair( key_with_home( 14, 1 ), 0 ) ).second );
+      BOOST_REQUIRE_EQUAL( map.find( key_with_home( 14, 1 ) )->second, key_with_home( 14, 1 ) + 1 );
+      BOOST_REQUIRE( map.find( key_with_home( 14, 2 ) ) == map.end() );
+      BOOST_REQUIRE_EQUAL( map.erase( key_with_home( 14, 2 ) ), 0u );
+
+      BOOST_TEST_MESSAGE( "--- Erasing before the wrap point moves entries back over it" );
+      erase( key_with_home( 14, 0 ) );
+      erase( key_with_home( 15, 0 ) );
+
+      BOOST_TEST_MESSAGE( "--- Erasing after the wrap point leaves entries whose home is before it" );
+      insert( key_with_home( 14, 3 ) );
+      insert( key_with_home( 15, 3 ) );
+      erase( key_with_home( 0, 0 ) );
+      erase( key_with_home( 14, 1 ) );
+
+      BOOST_TEST_MESSAGE( "--- Erasing through an iterator and inserting through operator[]" );
+      map.erase( home_slot_map::const_iterator( map.find( key_with_home( 15, 1 ) ) ) );
+      reference.erase( key_with_home( 15, 1 ) );
+      BOOST_REQUIRE( same_contents( map, reference ) );
+      map[ key_with_home( 15, 4 ) ] = 7;
+      reference[ key_with_home( 15, 4 ) ] = 7;
+      BOOST_REQUIRE( same_contents( map, reference ) );
+
+      while( !reference.empty() )
+         erase( reference.begin()->first );
+      BOOST_REQUIRE( map.begin() == map.end() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( open_hash_map_random_erase_and_find )
+{
+   try
+   {
+      // 11 keys never grow the table, homes around the end of it keep every run wrapping
+      std::vector< uint64_t > keys;
+      for( uint64_t home : { 13, 14, 15, 0, 1 } )
+         for( uint64_t n = 0; n < 3 && keys.size() < 11; ++n )
+            keys.push_back( key_with_home( home, n ) );
+
+      home_slot_map map;
+      std::unordered_map< uint64_t, uint64_t > reference;
+      std::mt19937 random( 1 );
+      for( uint32_t i = 0; i < 20000; ++i )
+      {
+         uint64_t key = keys[ random() % keys.size() ];
+         if( random() % 2 )
+         {
+            BOOST_REQUIRE_EQUAL( map.insert( std::make_pair( key, uint64_t( i ) ) ).second, reference.count( key ) == 0 );
+            reference.insert( std::make_pair( key, uint64_t( i ) ) );
+         }
+         else
+            BOOST_REQUIRE_EQUAL( map.erase( key ), reference.erase( key ) );
+         BOOST_REQUIRE( same_contents( map, reference ) );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( open_hash_map_rehash_and_shrink )
+{
+   try
+   {
+      open_hash_map< uint64_t, uint64_t, mixed_hash > map;
+      std::unordered_map< uint64_t, uint64_t > reference;
+
+      BOOST_TEST_MESSAGE( "--- Growing through many rehashes" );
+      for( uint64_t i = 0; i < 10000; ++i )
+      {
+         map[ i ] = i * 3;
+         reference[ i ] = i * 3;
+      }
+      BOOST_REQUIRE( same_contents( map, reference ) );
+
+      BOOST_TEST_MESSAGE( "--- Shrinking after most entries are erased" );
+      for( uint64_t i = 0; i < 10000; ++i )
+         if( i % 10 )
+         {
+            map.erase( i );
+            reference.erase( i );
+         }
+      map.shrink_to_fit();
+      BOOST_REQUIRE( same_contents( map, reference ) );
+      for( uint64_t i = 1; i < 10; ++i )
+         BOOST_REQUIRE( map.find( i ) == map.end() );
+
+      // a table that isn't mostly empty is left alone
+      map.shrink_to_fit();
+      BOOST_REQUIRE( same_contents( map, reference ) );
+
+      BOOST_TEST_MESSAGE( "--- Growing again after shrinking" );
+      for( uint64_t i = 10000; i < 12000; ++i )
+      {
+         map[ i ] = i;
+         reference[ i ] = i;
+      }
+      BOOST_REQUIRE( same_contents( map, reference ) );
+
+      BOOST_TEST_MESSAGE( "--- Shrinking a table whose entries share one home" );
+      home_slot_map colliding;
+      std::unordered_map< uint64_t, uint64_t > colliding_reference;
+      for( uint64_t n = 0; n < 200; ++n )
+      {
+         colliding[ key_with_home( 3, n ) ] = n;
+         colliding_reference[ key_with_home( 3, n ) ] = n;
+      }
+      for( uint64_t n = 0; n < 195; ++n )
+      {
+         colliding.erase( key_with_home( 3, n ) );
+         colliding_reference.erase( key_with_home( 3, n ) );
+      }
+      colliding.shrink_to_fit();
+      BOOST_REQUIRE( same_contents( colliding, colliding_reference ) );
+
+      map.clear();
+      colliding.clear();
+      BOOST_REQUIRE( map.empty() && map.begin() == map.end() );
+      BOOST_REQUIRE( map.find( 10 ) == map.end() );
+      map.shrink_to_fit();
+      map[ 10 ] = 1;
+      BOOST_REQUIRE_EQUAL( map.size(), 1u );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( timestamped_item_set_expire )
+{
+   try
+   {
+      const fc::time_point_sec t( 1000000 );
+      timestamped_item_set items;
+
+      BOOST_TEST_MESSAGE( "--- Adding an item again keeps its first timestamp" );
+      BOOST_REQUIRE( items.insert( timestamped_item_id( make_item_id( 1 ), t ) ) );
+      BOOST_REQUIRE( items.insert( timestamped_item_id( make_item_id( 2 ), t ) ) );
+      BOOST_REQUIRE( !items.insert( timestamped_item_id( make_item_id( 1 ), t + 5 ) ) );
+      BOOST_REQUIRE( items.find( make_item_id( 1 ) )->second == t );
+      BOOST_REQUIRE( items.insert( timestamped_item_id( make_item_id( 3 ), t + 1 ) ) );
+      // an older timestamp joins the newest second
+      BOOST_REQUIRE( items.insert( timestamped_item_id( make_item_id( 4 ), t ) ) );
+      BOOST_REQUIRE( items.find( make_item_id( 4 ) )->second == t + 1 );
+      BOOST_REQUIRE_EQUAL( items.size(), 4u );
+
+      BOOST_TEST_MESSAGE( "--- An item erased and added again later isn't expired with its first timestamp" );
+      BOOST_REQUIRE_EQUAL( items.erase( make_item_id( 2 ) ), 1u );
+      BOOST_REQUIRE_EQUAL( items.erase( make_item_id( 2 ) ), 0u );
+      BOOST_REQUIRE( items.find( make_item_id( 2 ) ) == items.end() );
+      BOOST_REQUIRE( items.insert( timestamped_item_id( make_item_id( 2 ), t + 2 ) ) );
+
+      // erased and added again within the same second, named twice in its bucket
+      BOOST_REQUIRE_EQUAL( items.erase( make_item_id( 3 ) ), 1u );
+      BOOST_REQUIRE( items.insert( timestamped_item_id( make_item_id( 3 ), t + 2 ) ) );
+      BOOST_REQUIRE_EQUAL( items.erase( make_item_id( 3 ) ), 1u );
+      BOOST_REQUIRE( items.insert( timestamped_item_id( make_item_id( 3 ), t + 2 ) ) );
+
+      BOOST_REQUIRE_EQUAL( items.expire( t ), 0u );
+      BOOST_REQUIRE_EQUAL( items.expire( t + 1 ), 1u );
+      BOOST_REQUIRE( items.find( make_item_id( 1 ) ) == items.end() );
+      BOOST_REQUIRE( items.find( make_item_id( 2 ) ) != items.end() );
+      BOOST_REQUIRE_EQUAL( items.size(), 3u );
+
+      BOOST_REQUIRE_EQUAL( items.expire( t + 2 ), 1u );
+      BOOST_REQUIRE( items.find( make_item_id( 4 ) ) == items.end() );
+      BOOST_REQUIRE( items.find( make_item_id( 3 ) ) != items.end() );
+
+      BOOST_REQUIRE_EQUAL( items.expire( t + 3 ), 2u );
+      BOOST_REQUIRE( items.empty() );
+      BOOST_REQUIRE_EQUAL( items.expire( t + 10 ), 0u );
+
+      BOOST_TEST_MESSAGE( "--- Expiring most of a flood shrinks the set, the rest is still found" );
+      for( uint32_t i = 0; i < 5000; ++i )
+         BOOST_REQUIRE( items.insert( timestamped_item_id( make_item_id( i ), t + 20 + i / 1000 ) ) );
+      BOOST_REQUIRE_EQUAL( items.expire( t + 24 ), 4000u );
+      BOOST_REQUIRE_EQUAL( items.size(), 1000u );
+      for( uint32_t i = 0; i < 5000; ++i )
+         BOOST_REQUIRE_EQUAL( items.find( make_item_id( i ) ) != items.end(), i >= 4000 );
+      size_t iterated = 0;
+      for( auto itr = items.begin(); itr != items.end(); ++itr )
+         ++iterated;
+      BOOST_REQUIRE_EQUAL( iterated, 1000u );
+
+      items.clear();
+      BOOST_REQUIRE( items.empty() );
+      BOOST_REQUIRE_EQUAL( items.expire( t + 100 ), 0u );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( io_thread_messages_delivered_in_order )
+{
+   try
+   {
+      io_thread_connection_pair p;
+
+      p.send( 0, 500 );
+      BOOST_REQUIRE( p.wait_for( 500 ) );
+      BOOST_REQUIRE( p.delegate.in_order() );
+      BOOST_REQUIRE( p.delegate.on_delivery_thread );
+      BOOST_REQUIRE_EQUAL( p.receiver.get_total_bytes_received(), p.sender.get_total_bytes_sent() );
+      BOOST_REQUIRE( p.receiver.get_last_message_received_time() >= p.receiver.get_connection_time() );
+
+      BOOST_TEST_MESSAGE( "--- The connection is reported closed after the messages read before it" );
+      p.send( 500, 20 );
+      p.sender.close_connection();
+      for( int i = 0; i < 5000 && !p.delegate.closed; ++i )
+         fc::usleep( fc::milliseconds( 1 ) );
+      BOOST_REQUIRE( p.delegate.closed );
+      BOOST_REQUIRE_EQUAL( p.delegate.closed_after, 520u );
+      BOOST_REQUIRE( p.delegate.in_order() );
+      BOOST_REQUIRE( p.delegate.on_delivery_thread );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( io_thread_back_pressure )
+{
+   try
+   {
+      io_thread_connection_pair p;
+      // a current_time_request_message is one 16 byte frame
+      const uint64_t message_size = 16;
+
+      p.delegate.blocked = fc::promise< void >::ptr( new fc::promise< void >( "io_thread_back_pressure" ) );
+      fc::promise< void >::ptr release = p.delegate.blocked;
+      p.send( 0, 100 );
+      BOOST_REQUIRE_EQUAL( p.sender.get_total_bytes_sent(), 100 * message_size );
+
+      fc::usleep( fc::milliseconds( 200 ) );
+      BOOST_TEST_MESSAGE( "--- The I/O thread stops reading while the first message is being handled" );
+      BOOST_REQUIRE_EQUAL( p.delegate.sequence.size(), 1u );
+      // the message being handled, those waiting to be delivered and the one the I/O thread holds
+      BOOST_REQUIRE_LE( p.receiver.get_total_bytes_received(), ( GRAPHENE_NET_MAX_PENDING_MESSAGE_DELIVERIES + 2 ) * message_size );
+      BOOST_REQUIRE_GE( p.receiver.get_total_bytes_received(), ( GRAPHENE_NET_MAX_PENDING_MESSAGE_DELIVERIES + 1 ) * message_size );
+
+      BOOST_TEST_MESSAGE( "--- And reads the rest once the message is handled" );
+      release->set_value();
+      BOOST_REQUIRE( p.wait_for( 100 ) );
+      BOOST_REQUIRE( p.delegate.in_order() );
+      BOOST_REQUIRE_EQUAL( p.receiver.get_total_bytes_received(), 100 * message_size );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
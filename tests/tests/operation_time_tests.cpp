@@ -1296,6 +1296,70 @@ BOOST_AUTO_TEST_CASE( vesting_withdrawals )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( vesting_withdrawal_proxied_votes )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "Testing: withdrawals of accounts sharing a proxy in the same block" );
+
+      ACTORS( (alice)(bob)(carol)(sam) )
+      generate_block();
+      vest( "alice", ASSET( "100.000 TESTS" ) );
+      vest( "bob", ASSET( "100.000 TESTS" ) );
+      vest( "carol", ASSET( "100.000 TESTS" ) );
+
+      witness_create( "sam", sam_private_key, "foo.bar", sam_private_key.get_public_key(), 1000 );
+
+      account_witness_vote_operation vote;
+      vote.account = "bob";
+      vote.witness = "sam";
+      vote.approve = true;
+
+      signed_transaction tx;
+      tx.operations.push_back( vote );
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      sign( tx, bob_private_key );
+      db->push_transaction( tx, 0 );
+
+      proxy( "alice", "bob" );
+      proxy( "carol", "bob" );
+
+      BOOST_TEST_MESSAGE( "--- Starting both withdrawals in the same block" );
+
+      withdraw_vesting_operation op;
+      op.account = "alice";
+      op.vesting_shares = asset( db->get_account( "alice" ).vesting_shares.amount / 2, VESTS_SYMBOL );
+
+      tx.clear();
+      tx.operations.push_back( op );
+      sign( tx, alice_private_key );
+      db->push_transaction( tx, 0 );
+
+      op.account = "carol";
+      op.vesting_shares = asset( db->get_account( "carol" ).vesting_shares.amount / 3, VESTS_SYMBOL );
+
+      tx.clear();
+      tx.operations.push_back( op );
+      sign( tx, carol_private_key );
+      db->push_transaction( tx, 0 );
+
+      generate_block();
+
+      auto original_votes = db->get_witness( "sam" ).votes;
+
+      generate_blocks( db->get_account( "alice" ).next_vesting_withdrawal, true );
+
+      const auto& bob_account = db->get_account( "bob" );
+
+      BOOST_REQUIRE( db->get_witness( "sam" ).votes < original_votes );
+      BOOST_REQUIRE( bob_account.proxied_vsf_votes[0] == db->get_account( "alice" ).vesting_shares.amount + db->get_account( "carol" ).vesting_shares.amount );
+      BOOST_REQUIRE( db->get_witness( "sam" ).votes == bob_account.witness_vote_weight() );
+
+      validate_database();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( vesting_withdraw_route )
 {
    try
@@ -1410,6 +1474,169 @@ BOOST_AUTO_TEST_CASE( vesting_withdraw_route )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( vesting_withdraw_route_batch )
+{
+   try
+   {
+      ACTORS( (alice)(bob)(sam) )
+
+      fund( "alice", 1040000 );
+      vest( "alice", 1040000 );
+      fund( "bob", 520000 );
+      vest( "bob", 520000 );
+
+      BOOST_TEST_MESSAGE( "Alice and bob withdraw in the same block and route to each other and to themselves" );
+
+      signed_transaction tx;
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+
+      withdraw_vesting_operation wv;
+      wv.account = "alice";
+      wv.vesting_shares = db->get_account( "alice" ).vesting_shares;
+      tx.operations.push_back( wv );
+
+      set_withdraw_vesting_route_operation op;
+      op.from_account = "alice";
+      op.to_account = "alice";
+      op.percent = STEEM_1_PERCENT * 20;
+      op.auto_vest = true;
+      tx.operations.push_back( op );
+
+      op.to_account = "bob";
+      op.percent = STEEM_1_PERCENT * 30;
+      op.auto_vest = false;
+      tx.operations.push_back( op );
+
+      op.to_account = "sam";
+      op.percent = STEEM_1_PERCENT * 25;
+      op.auto_vest = true;
+      tx.operations.push_back( op );
+      tx.sign( alice_private_key, db->get_chain_id() );
+      db->push_transaction( tx, 0 );
+
+      tx.operations.clear();
+      tx.signatures.clear();
+
+      wv.account = "bob";
+      wv.vesting_shares = db->get_account( "bob" ).vesting_shares;
+      tx.operations.push_back( wv );
+
+      op.from_account = "bob";
+      op.to_account = "alice";
+      op.percent = STEEM_1_PERCENT * 40;
+      op.auto_vest = false;
+      tx.operations.push_back( op );
+
+      op.to_account = "bob";
+      op.percent = STEEM_1_PERCENT * 10;
+      op.auto_vest = false;
+      tx.operations.push_back( op );
+      tx.sign( bob_private_key, db->get_chain_id() );
+      db->push_transaction( tx, 0 );
+
+      generate_block();
+
+      BOOST_REQUIRE( db->get_account( "alice" ).next_vesting_withdrawal == db->get_account( "bob" ).next_vesting_withdrawal );
+      generate_blocks( db->get_account( "alice" ).next_vesting_withdrawal - STEEM_BLOCK_INTERVAL, true );
+
+      const vector< string > names = { "alice", "bob", "sam" };
+      std::map< string, asset > old_balance, old_vesting, rate;
+      std::map< string, share_type > old_withdrawn;
+      for( const auto& name : names )
+      {
+         const auto& a = db->get_account( name );
+         old_balance[ name ] = a.balance;
+         old_vesting[ name ] = a.vesting_shares;
+         old_withdrawn[ name ] = a.withdrawn;
+         rate[ name ] = a.vesting_withdraw_rate;
+      }
+
+      vector< fill_vesting_withdraw_operation > fills;
+      auto conn = db->add_post_apply_operation_handler( [&]( const operation_notification& note )
+      {
+         if( note.op.which() == operation::tag< fill_vesting_withdraw_operation >::value )
+            fills.push_back( note.op.get< fill_vesting_withdraw_operation >() );
+      }, *db_plugin );
+
+      generate_block();
+      chain::util::disconnect_signal( conn );
+
+      BOOST_TEST_MESSAGE( "Every route is paid its share of the withdrawal, the withdrawer keeps the rest" );
+
+      std::map< std::pair< string, string >, share_type > percent = {
+         { { "alice", "alice" }, STEEM_1_PERCENT * 20 },
+         { { "alice", "bob" }, STEEM_1_PERCENT * 30 },
+         { { "alice", "sam" }, STEEM_1_PERCENT * 25 },
+         { { "bob", "alice" }, STEEM_1_PERCENT * 40 },
+         { { "bob", "bob" }, STEEM_1_PERCENT * 10 } };
+      std::set< std::pair< string, string > > auto_vest = { { "alice", "alice" }, { "alice", "sam" } };
+
+      std::map< string, asset > steem_deposited, vests_deposited;
+      std::map< string, share_type > routed, remainder;
+      std::map< std::pair< string, string >, int > route_fills;
+      for( const auto& name : names )
+      {
+         steem_deposited[ name ] = asset( 0, STEEM_SYMBOL );
+         vests_deposited[ name ] = asset( 0, VESTS_SYMBOL );
+      }
+
+      for( const auto& fill : fills )
+      {
+         string from = fill.from_account;
+         string to = fill.to_account;
+
+         if( fill.deposited.symbol == VESTS_SYMBOL )
+         {
+            BOOST_REQUIRE( fill.deposited == fill.withdrawn );
+            vests_deposited[ to ] += fill.deposited;
+         }
+         else
+         {
+            steem_deposited[ to ] += fill.deposited;
+         }
+
+         // The last fill of a withdrawer is what it converts for itself
+         if( from == to && route_fills[ { from, to } ] == ( percent.count( { from, to } ) ? 1 : 0 ) )
+         {
+            remainder[ from ] = fill.withdrawn.amount;
+            BOOST_REQUIRE( fill.deposited.symbol == STEEM_SYMBOL );
+         }
+         else
+         {
+            BOOST_REQUIRE( percent.count( { from, to } ) );
+            BOOST_REQUIRE( ( fill.deposited.symbol == VESTS_SYMBOL ) == ( auto_vest.count( { from, to } ) == 1 ) );
+            BOOST_REQUIRE_EQUAL( fill.withdrawn.amount.value,
+               ( ( fc::uint128_t( rate[ from ].amount.value ) * percent[ { from, to } ].value ) / STEEM_100_PERCENT ).to_uint64() );
+            routed[ from ] += fill.withdrawn.amount;
+         }
+
+         ++route_fills[ { from, to } ];
+      }
+
+      BOOST_REQUIRE_EQUAL( fills.size(), 7u );
+
+      for( const auto& from : { "alice", "bob" } )
+      {
+         BOOST_REQUIRE_EQUAL( ( routed[ from ] + remainder[ from ] ).value, rate[ from ].amount.value );
+         BOOST_REQUIRE_EQUAL( db->get_account( from ).withdrawn.value, ( old_withdrawn[ from ] + rate[ from ].amount ).value );
+      }
+
+      BOOST_TEST_MESSAGE( "Balances match the fills, including destinations that withdraw in the same block" );
+
+      for( const auto& name : names )
+      {
+         const auto& a = db->get_account( name );
+         asset withdrawn = name == "sam" ? asset( 0, VESTS_SYMBOL ) : rate[ name ];
+
+         BOOST_REQUIRE( a.vesting_shares == old_vesting[ name ] - withdrawn + vests_deposited[ name ] );
+         BOOST_REQUIRE( a.balance == old_balance[ name ] + steem_deposited[ name ] );
+      }
+
+      validate_database();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( feed_publish_mean )
 {
    try
@@ -2950,5 +3177,337 @@ BOOST_AUTO_TEST_CASE( clear_null_account )
    FC_LOG_AND_RETHROW()
 }
 
+/**
+ * Cashes out several comments in one block.  The same accounts are authors, curators and beneficiaries,
+ * so their payouts are summed over comments before they are written.  Every payout is checked against
+ * the virtual operations reporting it and against the payout values stored on the comments.
+ */
+struct comment_cashout_batch_fixture : public clean_database_fixture
+{
+   comment_cashout_batch_fixture( uint32_t hardfork ) : clean_database_fixture( hardfork ) {}
+
+   struct balances
+   {
+      asset       balance;
+      asset       sbd_balance;
+      asset       vesting_shares;
+      asset       reward_steem_balance;
+      asset       reward_sbd_balance;
+      asset       reward_vesting_balance;
+      asset       reward_vesting_steem;
+      share_type  curation_rewards;
+      share_type  posting_rewards;
+   };
+
+   balances get_balances( const string& name )
+   {
+      const auto& a = db->get_account( name );
+      return balances{ a.balance, a.sbd_balance, a.vesting_shares, a.reward_steem_balance, a.reward_sbd_balance,
+         a.reward_vesting_balance, a.reward_vesting_steem, a.curation_rewards, a.posting_rewards };
+   }
+
+   void post( const string& author, const fc::ecc::private_key& key, const string& permlink,
+      const string& parent_author, const string& parent_permlink, const vector< beneficiary_route_type >& beneficiaries )
+   {
+      signed_transaction tx;
+      comment_operation com;
+      com.author = author;
+      com.permlink = permlink;
+      com.parent_author = parent_author;
+      com.parent_permlink = parent_permlink;
+      com.title = "title";
+      com.body = "body";
+      tx.operations.push_back( com );
+
+      if( beneficiaries.size() )
+      {
+         comment_options_operation opt;
+         opt.author = author;
+         opt.permlink = permlink;
+         comment_payout_beneficiaries b;
+         b.beneficiaries = beneficiaries;
+         opt.extensions.insert( b );
+         tx.operations.push_back( opt );
+      }
+
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      tx.sign( key, db->get_chain_id() );
+      db->push_transaction( tx, 0 );
+   }
+
+   void vote( const string& voter, const fc::ecc::private_key& key, const string& author, const string& permlink )
+   {
+      signed_transaction tx;
+      vote_operation op;
+      op.voter = voter;
+      op.author = author;
+      op.permlink = permlink;
+      op.weight = STEEM_100_PERCENT;
+      tx.operations.push_back( op );
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      tx.sign( key, db->get_chain_id() );
+      db->push_transaction( tx, 0 );
+   }
+
+   void check_cashout_batch()
+   {
+      ACTORS( (alice)(bob)(sam)(dave)(carol) )
+
+      for( const auto& name : { "alice", "bob", "sam", "dave" } )
+      {
+         fund( name, 10000 );
+         vest( name, 10000 );
+      }
+
+      // Shared authors, curators and beneficiaries: bob writes, curates and is a beneficiary of alice
+      post( "alice", alice_private_key, "post", STEEM_ROOT_POST_PARENT, "test",
+         { beneficiary_route_type( "bob", STEEM_1_PERCENT * 10 ), beneficiary_route_type( "carol", STEEM_1_PERCENT * 25 ) } );
+      post( "bob", bob_private_key, "post", STEEM_ROOT_POST_PARENT, "test",
+         { beneficiary_route_type( "alice", STEEM_1_PERCENT * 5 ) } );
+      post( "sam", sam_private_key, "reply", "alice", "post",
+         { beneficiary_route_type( "dave", STEEM_1_PERCENT * 50 ) } );
+      generate_block();
+
+      // An account votes once per block
+      vote( "alice", alice_private_key, "bob", "post" );
+      vote( "bob", bob_private_key, "alice", "post" );
+      vote( "sam", sam_private_key, "alice", "post" );
+      vote( "dave", dave_private_key, "alice", "post" );
+      generate_block();
+      vote( "alice", alice_private_key, "sam", "reply" );
+      vote( "bob", bob_private_key, "sam", "reply" );
+      vote( "sam", sam_private_key, "bob", "post" );
+      vote( "dave", dave_private_key, "bob", "post" );
+      generate_block();
+      vote( "dave", dave_private_key, "sam", "reply" );
+
+      generate_blocks( db->get_comment( "alice", string( "post" ) ).cashout_time - STEEM_BLOCK_INTERVAL, true );
+
+      // At one STEEM per SBD payout values in SBD are the STEEM amounts paid
+      db_plugin->debug_update( [=]( database& db )
+      {
+         db.modify( db.get_feed_history(), [&]( feed_history_object& fho )
+         {
+            fho.current_median_history = price( ASSET( "1.000 TBD" ), ASSET( "1.000 TESTS" ) );
+         });
+      });
+
+      const vector< string > names = { "alice", "bob", "sam", "dave", "carol" };
+      const vector< std::pair< string, string > > comments = { { "alice", "post" }, { "bob", "post" }, { "sam", "reply" } };
+
+      std::map< string, balances > before;
+      for( const auto& name : names )
+         before[ name ] = get_balances( name );
+
+      // Curators are paid by descending vote weight, ties in account order.  Votes may be removed by the payout.
+      std::map< std::pair< string, string >, vector< account_name_type > > expected_curators;
+      for( const auto& c : comments )
+      {
+         const auto& comment = db->get_comment( c.first, c.second );
+         vector< const comment_vote_object* > votes;
+         const auto& vote_idx = db->get_index< comment_vote_index, by_comment_voter >();
+         for( auto itr = vote_idx.lower_bound( comment.id ); itr != vote_idx.end() && itr->comment == comment.id; ++itr )
+         {
+            if( itr->weight > 0 )
+               votes.push_back( &*itr );
+         }
+         std::stable_sort( votes.begin(), votes.end(), []( const comment_vote_object* a, const comment_vote_object* b )
+         {
+            return a->weight > b->weight;
+         });
+         for( const auto* v : votes )
+            expected_curators[ c ].push_back( db->get( v->voter ).name );
+         BOOST_REQUIRE( expected_curators[ c ].size() );
+      }
+
+      vector< operation > vops;
+      auto conn = db->add_post_apply_operation_handler( [&]( const operation_notification& note )
+      {
+         if( is_virtual_operation( note.op ) )
+            vops.push_back( note.op );
+      }, *db_plugin );
+
+      BOOST_TEST_MESSAGE( "Cashing out all comments in one block" );
+      generate_block();
+      chain::util::disconnect_signal( conn );
+
+      for( const auto& c : comments )
+         BOOST_REQUIRE( db->get_comment( c.first, c.second ).last_payout == db->head_block_time() );
+
+      bool to_reward_balance = db->has_hardfork( STEEM_HARDFORK_0_17__659 );
+
+      std::map< string, asset > vests_paid, sbd_paid, steem_paid;
+      std::map< std::pair< string, string >, vector< account_name_type > > curators;
+      std::map< std::pair< string, string >, vector< std::pair< account_name_type, asset > > > benefactors;
+      std::map< std::pair< string, string >, author_reward_operation > author_rewards;
+      for( const auto& name : names )
+      {
+         vests_paid[ name ] = asset( 0, VESTS_SYMBOL );
+         sbd_paid[ name ] = asset( 0, SBD_SYMBOL );
+         steem_paid[ name ] = asset( 0, STEEM_SYMBOL );
+      }
+
+      BOOST_TEST_MESSAGE( "Each comment reports curators, beneficiaries, author and payout update, in that order" );
+
+      std::pair< string, string > current;
+      int stage = 0;
+      std::set< std::pair< string, string > > finished;
+      auto enter = [&]( const std::pair< string, string >& c, int s )
+      {
+         if( c != current )
+         {
+            // The operations of one comment are not interleaved with those of another
+            BOOST_REQUIRE( finished.insert( current ).second || current.first.empty() );
+            BOOST_REQUIRE( finished.find( c ) == finished.end() );
+            current = c;
+            stage = 0;
+         }
+         BOOST_REQUIRE( s >= stage );
+         stage = s;
+      };
+
+      for( const auto& op : vops )
+      {
+         if( op.which() == operation::tag< curation_reward_operation >::value )
+         {
+            const auto& cur = op.get< curation_reward_operation >();
+            enter( { cur.comment_author, cur.comment_permlink }, 0 );
+            curators[ current ].push_back( cur.curator );
+            vests_paid[ cur.curator ] += cur.reward;
+         }
+         else if( op.which() == operation::tag< comment_benefactor_reward_operation >::value )
+         {
+            const auto& ben = op.get< comment_benefactor_reward_operation >();
+            enter( { ben.author, ben.permlink }, 1 );
+            benefactors[ current ].emplace_back( ben.benefactor, ben.reward );
+            vests_paid[ ben.benefactor ] += ben.reward;
+         }
+         else if( op.which() == operation::tag< author_reward_operation >::value )
+         {
+            const auto& aut = op.get< author_reward_operation >();
+            enter( { aut.author, aut.permlink }, 2 );
+            BOOST_REQUIRE( author_rewards.emplace( current, aut ).second );
+            vests_paid[ aut.author ] += aut.vesting_payout;
+            sbd_paid[ aut.author ] += aut.sbd_payout;
+            steem_paid[ aut.author ] += aut.steem_payout;
+         }
+         else if( op.which() == operation::tag< comment_reward_operation >::value )
+         {
+            const auto& rew = op.get< comment_reward_operation >();
+            enter( { rew.author, rew.permlink }, 3 );
+         }
+         else if( op.which() == operation::tag< comment_payout_update_operation >::value )
+         {
+            const auto& upd = op.get< comment_payout_update_operation >();
+            enter( { upd.author, upd.permlink }, 4 );
+            BOOST_REQUIRE_EQUAL( stage, 4 );
+         }
+      }
+
+      share_type total_curation = 0;
+      share_type total_vesting_steem = 0;
+
+      for( const auto& c : comments )
+      {
+         const auto& comment = db->get_comment( c.first, c.second );
+         BOOST_REQUIRE( author_rewards.find( c ) != author_rewards.end() );
+         const auto& aut = author_rewards[ c ];
+
+         BOOST_REQUIRE( curators[ c ] == expected_curators[ c ] );
+
+         // The author keeps what is left after beneficiaries, half of it in SBD
+         share_type author_tokens = comment.author_rewards;
+         BOOST_REQUIRE( author_tokens > 0 );
+         BOOST_REQUIRE_EQUAL( comment.total_payout_value.amount.value, author_tokens.value );
+         BOOST_REQUIRE_EQUAL( aut.sbd_payout.amount.value, ( author_tokens / 2 ).value );
+         BOOST_REQUIRE_EQUAL( aut.steem_payout.amount.value, 0 );
+
+         share_type before_beneficiaries = author_tokens + comment.beneficiary_payout_value.amount;
+         share_type total_beneficiary = 0;
+         BOOST_REQUIRE_EQUAL( benefactors[ c ].size(), comment.beneficiaries.size() );
+         for( size_t i = 0; i < comment.beneficiaries.size(); ++i )
+         {
+            BOOST_REQUIRE( benefactors[ c ][ i ].first == comment.beneficiaries[ i ].account );
+            total_beneficiary += ( before_beneficiaries * comment.beneficiaries[ i ].weight ) / STEEM_100_PERCENT;
+         }
+         BOOST_REQUIRE_EQUAL( total_beneficiary.value, comment.beneficiary_payout_value.amount.value );
+
+         total_curation += comment.curator_payout_value.amount;
+         total_vesting_steem += comment.curator_payout_value.amount + comment.beneficiary_payout_value.amount
+            + author_tokens - aut.sbd_payout.amount;
+
+         BOOST_REQUIRE_EQUAL( get_balances( c.first ).posting_rewards.value,
+            ( before[ c.first ].posting_rewards + author_tokens ).value );
+      }
+
+      BOOST_TEST_MESSAGE( "Account balances match the virtual operations" );
+
+      share_type curation_paid = 0;
+      share_type vesting_steem_paid = 0;
+
+      for( const auto& name : names )
+      {
+         auto b = before[ name ];
+         auto a = get_balances( name );
+
+         curation_paid += a.curation_rewards - b.curation_rewards;
+
+         if( to_reward_balance )
+         {
+            BOOST_REQUIRE( a.reward_vesting_balance == b.reward_vesting_balance + vests_paid[ name ] );
+            BOOST_REQUIRE( a.reward_sbd_balance == b.reward_sbd_balance + sbd_paid[ name ] );
+            BOOST_REQUIRE( a.reward_steem_balance == b.reward_steem_balance + steem_paid[ name ] );
+            BOOST_REQUIRE( a.vesting_shares == b.vesting_shares );
+            BOOST_REQUIRE( a.sbd_balance == b.sbd_balance );
+            BOOST_REQUIRE( a.balance == b.balance );
+            vesting_steem_paid += a.reward_vesting_steem.amount - b.reward_vesting_steem.amount;
+         }
+         else
+         {
+            BOOST_REQUIRE( a.vesting_shares == b.vesting_shares + vests_paid[ name ] );
+            BOOST_REQUIRE( a.sbd_balance == b.sbd_balance + sbd_paid[ name ] );
+            BOOST_REQUIRE( a.balance == b.balance + steem_paid[ name ] );
+            BOOST_REQUIRE( a.reward_vesting_balance == b.reward_vesting_balance );
+            BOOST_REQUIRE( a.reward_sbd_balance == b.reward_sbd_balance );
+            BOOST_REQUIRE( a.reward_steem_balance == b.reward_steem_balance );
+         }
+      }
+
+      BOOST_REQUIRE_EQUAL( curation_paid.value, total_curation.value );
+      if( to_reward_balance )
+         BOOST_REQUIRE_EQUAL( vesting_steem_paid.value, total_vesting_steem.value );
+
+      validate_database();
+   }
+};
+
+struct comment_cashout_batch_hf16_fixture : public comment_cashout_batch_fixture
+{
+   comment_cashout_batch_hf16_fixture() : comment_cashout_batch_fixture( STEEM_HARDFORK_0_16 ) {}
+};
+
+struct comment_cashout_batch_latest_fixture : public comment_cashout_batch_fixture
+{
+   comment_cashout_batch_latest_fixture() : comment_cashout_batch_fixture( STEEM_BLOCKCHAIN_VERSION.minor() ) {}
+};
+
+BOOST_FIXTURE_TEST_CASE( comment_cashout_batch_pre_hf17, comment_cashout_batch_hf16_fixture )
+{
+   try
+   {
+      check_cashout_batch();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( comment_cashout_batch, comment_cashout_batch_latest_fixture )
+{
+   try
+   {
+      check_cashout_batch();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif